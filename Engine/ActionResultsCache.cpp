@@ -0,0 +1,328 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ActionResultsCache.h"
+
+#include <list>
+#include <cassert>
+
+#include <QtCore/QMutex>
+
+#include "Engine/CacheEntryBase.h"
+#include "Engine/CacheEntryKeyBase.h"
+
+// Number of independently locked shards. Must be a power of 2.
+#define NATRON_ACTION_RESULTS_CACHE_N_SHARDS 16
+
+// Default budget of the cache. Entries report a size of a few hundred bytes, this is several hundred thousands entries.
+#define NATRON_ACTION_RESULTS_CACHE_DEFAULT_SIZE ((std::size_t)64 * 1024 * 1024)
+
+// Unique IDs of the keys are in [1, NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID], see CacheEntryKeyBase.h
+#define NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID kCacheKeyUniqueIDDistortionWarpGrid
+
+NATRON_NAMESPACE_ENTER;
+
+struct ActionResultsCacheEntry
+{
+    CacheEntryBasePtr entry;
+    std::size_t size;
+    int uniqueID;
+
+    // Position of the entry in the LRU list of its shard
+    std::list<U64>::iterator lruIt;
+};
+
+typedef std::map<U64, ActionResultsCacheEntry> ActionResultsCacheEntryMap;
+
+struct ActionResultsCacheShard
+{
+    QMutex lock;
+
+    ActionResultsCacheEntryMap entries;
+
+    // Hashes of the entries, least recently used first
+    std::list<U64> lru;
+
+    std::size_t size;
+
+    // Statistics, indexed by unique ID. Protected by lock.
+    ActionResultsCacheStats stats[NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID + 1];
+
+    ActionResultsCacheShard()
+    : lock()
+    , entries()
+    , lru()
+    , size(0)
+    {
+
+    }
+
+    void removeEntry(ActionResultsCacheEntryMap::iterator it)
+    {
+        // Private - lock is assumed to be taken
+        assert(!lock.tryLock());
+        ActionResultsCacheStats& typeStats = stats[it->second.uniqueID];
+        --typeStats.nEntries;
+        typeStats.nBytes -= it->second.size;
+        size -= it->second.size;
+        lru.erase(it->second.lruIt);
+        entries.erase(it);
+    }
+};
+
+struct ActionResultsCachePrivate
+{
+    // Shards are only accessed under their own lock, hence mutable so that get() may update the LRU list
+    mutable ActionResultsCacheShard shards[NATRON_ACTION_RESULTS_CACHE_N_SHARDS];
+
+    mutable QMutex maximumSizeMutex;
+    std::size_t maximumSize;
+
+    ActionResultsCachePrivate()
+    : maximumSizeMutex()
+    , maximumSize(NATRON_ACTION_RESULTS_CACHE_DEFAULT_SIZE)
+    {
+
+    }
+
+    ActionResultsCacheShard& getShard(U64 hash) const
+    {
+        // The low bits of the hash are as well distributed as the high bits
+        return shards[hash & (NATRON_ACTION_RESULTS_CACHE_N_SHARDS - 1)];
+    }
+
+    std::size_t getShardMaximumSize() const
+    {
+        QMutexLocker k(&maximumSizeMutex);
+        return maximumSize / NATRON_ACTION_RESULTS_CACHE_N_SHARDS;
+    }
+
+    void evictLRUEntries(ActionResultsCacheShard& shard, std::size_t shardMaximumSize);
+};
+
+ActionResultsCache::ActionResultsCache()
+: _imp(new ActionResultsCachePrivate)
+{
+
+}
+
+ActionResultsCache::~ActionResultsCache()
+{
+
+}
+
+static bool
+isValidUniqueID(int uniqueID)
+{
+    return uniqueID > 0 && uniqueID <= NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID;
+}
+
+CacheEntryBasePtr
+ActionResultsCache::get(U64 hash,
+                        int uniqueID) const
+{
+    assert( isValidUniqueID(uniqueID) );
+    if ( !isValidUniqueID(uniqueID) ) {
+        uniqueID = 0;
+    }
+
+    ActionResultsCacheShard& shard = _imp->getShard(hash);
+    QMutexLocker k(&shard.lock);
+
+    ActionResultsCacheEntryMap::iterator found = shard.entries.find(hash);
+    if ( found == shard.entries.end() ) {
+        ++shard.stats[uniqueID].nMisses;
+
+        return CacheEntryBasePtr();
+    }
+    ++shard.stats[uniqueID].nHits;
+
+    // Move the entry to the back of the LRU list
+    shard.lru.splice(shard.lru.end(), shard.lru, found->second.lruIt);
+
+    return found->second.entry;
+} // get
+
+void
+ActionResultsCachePrivate::evictLRUEntries(ActionResultsCacheShard& shard,
+                                           std::size_t shardMaximumSize)
+{
+    // Private - the shard lock is assumed to be taken
+    while ( shard.size > shardMaximumSize && !shard.lru.empty() ) {
+        ActionResultsCacheEntryMap::iterator it = shard.entries.find( shard.lru.front() );
+        assert( it != shard.entries.end() );
+        if ( it == shard.entries.end() ) {
+            shard.lru.pop_front();
+            continue;
+        }
+        shard.removeEntry(it);
+    }
+}
+
+bool
+ActionResultsCache::insert(const CacheEntryBasePtr& entry)
+{
+    assert(entry);
+    CacheEntryKeyBasePtr key = entry->getKey();
+    assert(key);
+    if (!key) {
+        return false;
+    }
+    const U64 hash = key->getHash();
+    int uniqueID = key->getUniqueID();
+    assert( isValidUniqueID(uniqueID) );
+    if ( !isValidUniqueID(uniqueID) ) {
+        uniqueID = 0;
+    }
+    const std::size_t size = entry->getMetadataSize();
+    const std::size_t shardMaximumSize = _imp->getShardMaximumSize();
+    if (size > shardMaximumSize) {
+        return false;
+    }
+
+    ActionResultsCacheShard& shard = _imp->getShard(hash);
+    QMutexLocker k(&shard.lock);
+
+    // Another thread may have computed the same entry concurrently: replace it
+    ActionResultsCacheEntryMap::iterator found = shard.entries.find(hash);
+    if ( found != shard.entries.end() ) {
+        shard.removeEntry(found);
+    }
+
+    ActionResultsCacheEntry& e = shard.entries[hash];
+    e.entry = entry;
+    e.size = size;
+    e.uniqueID = uniqueID;
+    e.lruIt = shard.lru.insert(shard.lru.end(), hash);
+
+    shard.size += size;
+    ActionResultsCacheStats& typeStats = shard.stats[uniqueID];
+    ++typeStats.nEntries;
+    typeStats.nBytes += size;
+
+    _imp->evictLRUEntries(shard, shardMaximumSize);
+
+    return true;
+} // insert
+
+void
+ActionResultsCache::setMaximumSize(std::size_t size)
+{
+    {
+        QMutexLocker k(&_imp->maximumSizeMutex);
+        _imp->maximumSize = size;
+    }
+    const std::size_t shardMaximumSize = _imp->getShardMaximumSize();
+    for (int i = 0; i < NATRON_ACTION_RESULTS_CACHE_N_SHARDS; ++i) {
+        QMutexLocker k(&_imp->shards[i].lock);
+        _imp->evictLRUEntries(_imp->shards[i], shardMaximumSize);
+    }
+}
+
+std::size_t
+ActionResultsCache::getMaximumSize() const
+{
+    QMutexLocker k(&_imp->maximumSizeMutex);
+
+    return _imp->maximumSize;
+}
+
+std::size_t
+ActionResultsCache::getCurrentSize() const
+{
+    std::size_t ret = 0;
+    for (int i = 0; i < NATRON_ACTION_RESULTS_CACHE_N_SHARDS; ++i) {
+        QMutexLocker k(&_imp->shards[i].lock);
+        ret += _imp->shards[i].size;
+    }
+
+    return ret;
+}
+
+void
+ActionResultsCache::clear()
+{
+    for (int i = 0; i < NATRON_ACTION_RESULTS_CACHE_N_SHARDS; ++i) {
+        ActionResultsCacheShard& shard = _imp->shards[i];
+
+        // Release the entries outside of the lock
+        ActionResultsCacheEntryMap entries;
+        {
+            QMutexLocker k(&shard.lock);
+            entries.swap(shard.entries);
+            shard.lru.clear();
+            shard.size = 0;
+            for (int j = 0; j <= NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID; ++j) {
+                shard.stats[j].nEntries = 0;
+                shard.stats[j].nBytes = 0;
+            }
+        }
+    }
+}
+
+static std::string
+getUniqueIDName(int uniqueID)
+{
+    switch (uniqueID) {
+    case kCacheKeyUniqueIDGetRoDResults:
+        return "GetRegionOfDefinition";
+    case kCacheKeyUniqueIDIsIdentityResults:
+        return "IsIdentity";
+    case kCacheKeyUniqueIDFramesNeededResults:
+        return "GetFramesNeeded";
+    case kCacheKeyUniqueIDGetTimeInvariantMetaDatasResults:
+        return "GetMetadata";
+    case kCacheKeyUniqueIDGetComponentsResults:
+        return "GetComponents";
+    case kCacheKeyUniqueIDGetFrameRangeResults:
+        return "GetFrameRange";
+    case kCacheKeyUniqueIDExpressionResult:
+        return "KnobExpression";
+    case kCacheKeyUniqueIDDistortionWarpGrid:
+        return "DistortionWarpGrid";
+    default:
+        return "Other";
+    }
+}
+
+void
+ActionResultsCache::getStats(std::map<std::string, ActionResultsCacheStats>* stats) const
+{
+    for (int i = 0; i < NATRON_ACTION_RESULTS_CACHE_N_SHARDS; ++i) {
+        QMutexLocker k(&_imp->shards[i].lock);
+        for (int j = 0; j <= NATRON_ACTION_RESULTS_CACHE_MAX_UNIQUE_ID; ++j) {
+            const ActionResultsCacheStats& shardStats = _imp->shards[i].stats[j];
+            if (shardStats.nHits == 0 && shardStats.nMisses == 0 && shardStats.nEntries == 0) {
+                continue;
+            }
+            ActionResultsCacheStats& typeStats = (*stats)[getUniqueIDName(j)];
+            typeStats.nHits += shardStats.nHits;
+            typeStats.nMisses += shardStats.nMisses;
+            typeStats.nEntries += shardStats.nEntries;
+            typeStats.nBytes += shardStats.nBytes;
+        }
+    }
+} // getStats
+
+NATRON_NAMESPACE_EXIT;
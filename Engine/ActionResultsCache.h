@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_ActionResultsCache_h
+#define Engine_ActionResultsCache_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <map>
+#include <string>
+#include <cstddef>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Hits and misses of the action results cache for one type of entry
+ **/
+struct ActionResultsCacheStats
+{
+    U64 nHits;
+    U64 nMisses;
+    int nEntries;
+    std::size_t nBytes;
+
+    ActionResultsCacheStats()
+    : nHits(0)
+    , nMisses(0)
+    , nEntries(0)
+    , nBytes(0)
+    {
+
+    }
+};
+
+/**
+ * @brief A process-local cache for the small results of the actions (RoD, isIdentity, frames needed, components,
+ * frame range, metadata), of the knob expressions and of the distortion warp grids.
+ * These results are a few dozen bytes and are looked up thousands of times per frame on big graphs: going through
+ * the shared memory of the main Cache for each of them costs more than computing most of them.
+ * Entries are spread on several shards according to their hash, each shard having its own mutex and LRU list
+ * so that render threads rarely contend. Pixel tiles remain in the main Cache.
+ *
+ * Unlike the main Cache, there is no pending state: if 2 threads miss the same entry, both compute it and
+ * the last one to insert it wins. Entries are immutable once inserted, hence shared with the callers without copy.
+ **/
+struct ActionResultsCachePrivate;
+class ActionResultsCache
+{
+public:
+
+    ActionResultsCache();
+
+    ~ActionResultsCache();
+
+    /**
+     * @brief Returns the entry with the given key hash, or NULL if it is not cached.
+     * The uniqueID is the one of the key (e.g: kCacheKeyUniqueIDGetRoDResults) and is used for statistics only.
+     **/
+    CacheEntryBasePtr get(U64 hash, int uniqueID) const;
+
+    /**
+     * @brief Insert a computed entry. Evicts the least recently used entries of the shard if the
+     * cache is over budget. The entry must not be modified afterwards.
+     * Entries larger than the budget of a shard (getMaximumSize() / number of shards) are not inserted
+     * since they would evict all the other entries of their shard: returns false in that case.
+     **/
+    bool insert(const CacheEntryBasePtr& entry);
+
+    /**
+     * @brief Set the maximum amount of memory (estimated from CacheEntryBase::getMetadataSize()) the cache may use.
+     **/
+    void setMaximumSize(std::size_t size);
+
+    std::size_t getMaximumSize() const;
+
+    std::size_t getCurrentSize() const;
+
+    /**
+     * @brief Remove all entries. Statistics are kept.
+     **/
+    void clear();
+
+    /**
+     * @brief Returns the statistics for each type of entry, indexed by a human readable name.
+     **/
+    void getStats(std::map<std::string, ActionResultsCacheStats>* stats) const;
+
+private:
+
+    boost::scoped_ptr<ActionResultsCachePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_ActionResultsCache_h
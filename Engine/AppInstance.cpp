@@ -26,6 +26,8 @@
 
 #include <fstream>
 #include <list>
+#include <map>
+#include <set>
 #include <cassert>
 #include <stdexcept>
 #include <sstream> // stringstream
@@ -59,6 +61,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 
 #include "Engine/CLArgs.h"
 #include "Engine/CreateNodeArgs.h"
+#include "Engine/EffectInstance.h"
 #include "Engine/FileDownloader.h"
 #include "Engine/GroupOutput.h"
 #include "Engine/DiskCacheNode.h"
@@ -74,6 +77,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/Settings.h"
 #include "Engine/PyPanelI.h"
 #include "Engine/TabWidgetI.h"
+#include "Engine/TimeLine.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/WriteNode.h"
 
@@ -200,6 +204,20 @@ struct CreateNodeStack {
     CreateNodeStackItemPtr root;
 };
 
+struct DeferredNodeEvaluation
+{
+    bool isSignificant;
+    bool refreshMetadatas;
+
+    DeferredNodeEvaluation()
+    : isSignificant(false)
+    , refreshMetadatas(false)
+    {
+    }
+};
+
+typedef std::map<NodeWPtr, DeferredNodeEvaluation> DeferredNodeEvaluationMap;
+
 struct AppInstancePrivate
 {
     Q_DECLARE_TR_FUNCTIONS(AppInstance)
@@ -226,6 +244,14 @@ public:
     mutable QMutex invalidExprKnobsMutex;
     std::list<KnobIWPtr> invalidExprKnobs;
 
+    // Nesting level of knob changes transactions and the nodes to evaluate when the outer-most ends.
+    // Only accessed on the main thread
+    int knobChangesTransactionLevel;
+    DeferredNodeEvaluationMap deferredEvaluations;
+
+    // Number of the transactions above that were opened from Python. Only accessed on the main thread
+    int scriptKnobChangesTransactionLevel;
+
     mutable QMutex uiInfoMutex;
 
     SerializableWindow* mainWindow;
@@ -244,6 +270,9 @@ public:
         , createNodeStack()
         , invalidExprKnobsMutex()
         , invalidExprKnobs()
+        , knobChangesTransactionLevel(0)
+        , deferredEvaluations()
+        , scriptKnobChangesTransactionLevel(0)
         , mainWindow(0)
         , floatingWindows()
         , tabWidgets()
@@ -258,6 +287,8 @@ public:
 
     void checkNumberOfNonFloatingPanes();
 
+    void commitKnobChangesTransaction();
+
 };
 
 AppInstance::AppInstance(int appID)
@@ -1520,6 +1551,188 @@ AppInstance::isCreatingNode() const
     return _imp->createNodeStack.root.get() != 0;
 }
 
+void
+AppInstance::beginKnobChangesTransaction()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    ++_imp->knobChangesTransactionLevel;
+}
+
+void
+AppInstance::endKnobChangesTransaction()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    assert(_imp->knobChangesTransactionLevel > 0);
+    if (_imp->knobChangesTransactionLevel == 0) {
+        qDebug() << "[BUG]: Call to endKnobChangesTransaction without a matching call to beginKnobChangesTransaction";
+        return;
+    }
+    --_imp->knobChangesTransactionLevel;
+    if (_imp->knobChangesTransactionLevel == 0) {
+        _imp->commitKnobChangesTransaction();
+    }
+}
+
+bool
+AppInstance::isKnobChangesTransactionOpened() const
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    return _imp->knobChangesTransactionLevel > 0;
+}
+
+void
+AppInstance::beginScriptKnobChangesTransaction()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    ++_imp->scriptKnobChangesTransactionLevel;
+    beginKnobChangesTransaction();
+}
+
+bool
+AppInstance::endScriptKnobChangesTransaction()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    if (_imp->scriptKnobChangesTransactionLevel == 0) {
+        return false;
+    }
+    --_imp->scriptKnobChangesTransactionLevel;
+    endKnobChangesTransaction();
+    return true;
+}
+
+void
+AppInstance::endAllScriptKnobChangesTransactions()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    while ( endScriptKnobChangesTransaction() ) {
+    }
+}
+
+bool
+AppInstance::deferEvaluationToKnobChangesTransaction(const NodePtr& node,
+                                                     bool isSignificant,
+                                                     bool refreshMetadatas)
+{
+    if ( !node || (_imp->knobChangesTransactionLevel == 0) || (QThread::currentThread() != qApp->thread()) ) {
+        return false;
+    }
+    DeferredNodeEvaluation& evaluation = _imp->deferredEvaluations[node];
+    evaluation.isSignificant |= isSignificant;
+    evaluation.refreshMetadatas |= refreshMetadatas;
+    return true;
+}
+
+KnobChangesTransaction_RAII::KnobChangesTransaction_RAII(const AppInstancePtr& app)
+    : _app()
+{
+    if ( app && (QThread::currentThread() == qApp->thread()) ) {
+        _app = app;
+        _app->beginKnobChangesTransaction();
+    }
+}
+
+KnobChangesTransaction_RAII::~KnobChangesTransaction_RAII()
+{
+    if (_app) {
+        _app->endKnobChangesTransaction();
+    }
+}
+
+/**
+ * @brief Prepends node and all nodes downstream that were not visited yet to sortedNodes, so that each node
+ * comes before all its outputs (reverse post-order of a depth-first traversal).
+ **/
+static void
+sortDownstreamNodesTopologically(const NodePtr& node,
+                                 std::set<NodePtr>* visitedNodes,
+                                 std::list<NodePtr>* sortedNodes)
+{
+    if ( !visitedNodes->insert(node).second ) {
+        return;
+    }
+    NodesList outputs;
+    node->getOutputsWithGroupRedirection(outputs);
+    for (NodesList::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+        sortDownstreamNodesTopologically(*it, visitedNodes, sortedNodes);
+    }
+    sortedNodes->push_front(node);
+}
+
+static void
+insertOutputs(const NodePtr& node,
+              std::set<NodePtr>* nodes)
+{
+    NodesList outputs;
+    node->getOutputsWithGroupRedirection(outputs);
+    nodes->insert( outputs.begin(), outputs.end() );
+}
+
+void
+AppInstancePrivate::commitKnobChangesTransaction()
+{
+    DeferredNodeEvaluationMap evaluations;
+    evaluations.swap(deferredEvaluations);
+    if ( evaluations.empty() ) {
+        return;
+    }
+
+    // Do the same work as EffectInstance::evaluate() would have done for each node, but only once per node
+    std::set<NodePtr> visitedNodes;
+    std::list<NodePtr> sortedNodes;
+    std::set<NodePtr> metadataDirtyNodes;
+    std::set<NodePtr> previewDirtyNodes;
+    std::list<NodePtr> evaluatedNodes;
+    for (DeferredNodeEvaluationMap::const_iterator it = evaluations.begin(); it != evaluations.end(); ++it) {
+        NodePtr node = it->first.lock();
+        if ( !node || !node->getEffectInstance() ) {
+            continue;
+        }
+        evaluatedNodes.push_back(node);
+        if ( it->second.refreshMetadatas && node->isNodeCreated() ) {
+            metadataDirtyNodes.insert(node);
+        }
+        if (it->second.isSignificant) {
+            previewDirtyNodes.insert(node);
+        }
+        sortDownstreamNodesTopologically(node, &visitedNodes, &sortedNodes);
+    }
+
+    // Refresh the meta-data of each node after those of its inputs: if they changed, the outputs, which come
+    // later in the list, must be refreshed too
+    for (std::list<NodePtr>::const_iterator it = sortedNodes.begin(); it != sortedNodes.end(); ++it) {
+        if ( metadataDirtyNodes.find(*it) == metadataDirtyNodes.end() ) {
+            continue;
+        }
+        if ( (*it)->getEffectInstance()->onMetadataChanged_nonRecursive_public() ) {
+            insertOutputs(*it, &metadataDirtyNodes);
+        }
+    }
+
+    for (std::list<NodePtr>::const_iterator it = evaluatedNodes.begin(); it != evaluatedNodes.end(); ++it) {
+        (*it)->refreshIdentityState();
+    }
+
+    if ( previewDirtyNodes.empty() ) {
+        _publicInterface->redrawAllViewers();
+        return;
+    }
+
+    _publicInterface->triggerAutoSave();
+    _publicInterface->renderAllViewers();
+
+    // Refresh the previews of all nodes downstream of a significant change once
+    TimeValue time( _publicInterface->getTimeLine()->currentFrame() );
+    for (std::list<NodePtr>::const_iterator it = sortedNodes.begin(); it != sortedNodes.end(); ++it) {
+        if ( previewDirtyNodes.find(*it) == previewDirtyNodes.end() ) {
+            continue;
+        }
+        if ( (*it)->getNodeGui() && (*it)->isPreviewEnabled() ) {
+            (*it)->refreshPreviewImage(time);
+        }
+        insertOutputs(*it, &previewDirtyNodes);
+    }
+} // commitKnobChangesTransaction
+
 void
 AppInstance::appendToScriptEditor(const std::string& str)
 {
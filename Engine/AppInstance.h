@@ -286,6 +286,34 @@ public:
      **/
     bool isCreatingNode() const;
 
+    /**
+     * @brief Opens a knob changes transaction. Until the matching endKnobChangesTransaction() call, the evaluation
+     * of all nodes whose knobs or inputs change (meta-data refresh, viewers render, previews refresh) is deferred.
+     * When the outer-most transaction ends, the meta-data of each node are refreshed at most once, after those of
+     * its inputs, and the viewers are rendered once.
+     * Unlike KnobHolder::beginChanges() this spans any number of nodes. Calls may be nested. Main thread only.
+     **/
+    void beginKnobChangesTransaction();
+    void endKnobChangesTransaction();
+
+    bool isKnobChangesTransactionOpened() const;
+
+    /**
+     * @brief Same as beginKnobChangesTransaction()/endKnobChangesTransaction() for transactions opened from Python
+     * (App.beginChanges()). endScriptKnobChangesTransaction() returns false if no transaction was opened from Python.
+     * endAllScriptKnobChangesTransactions() ends the transactions a script left opened, e.g: because it raised an
+     * exception before calling App.endChanges(). It is called when the outer-most Python script returns.
+     **/
+    void beginScriptKnobChangesTransaction();
+    bool endScriptKnobChangesTransaction();
+    void endAllScriptKnobChangesTransactions();
+
+    /**
+     * @brief If a knob changes transaction is opened, records that the given node must be evaluated
+     * when it ends and returns true. Returns false otherwise, in which case the caller should evaluate now.
+     **/
+    bool deferEvaluationToKnobChangesTransaction(const NodePtr& node, bool isSignificant, bool refreshMetadatas);
+
 
     virtual void appendToScriptEditor(const std::string& str);
     virtual void printAutoDeclaredVariable(const std::string& str);
@@ -448,6 +476,21 @@ private:
     boost::scoped_ptr<AppInstancePrivate> _imp;
 };
 
+/**
+ * @brief Brackets a scope with a knob changes transaction on the given app. Does nothing if the app is NULL
+ * or when not on the main thread.
+ **/
+class KnobChangesTransaction_RAII
+{
+    AppInstancePtr _app;
+
+public:
+
+    KnobChangesTransaction_RAII(const AppInstancePtr& app);
+
+    ~KnobChangesTransaction_RAII();
+};
+
 
 NATRON_NAMESPACE_EXIT;
 
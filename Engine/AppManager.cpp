@@ -112,6 +112,8 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/Project.h"
 #include "Engine/PrecompNode.h"
 #include "Engine/ReadNode.h"
+#include "Engine/RenderTrace.h"
+#include "Engine/RenderWorkers.h"
 #include "Engine/RotoPaint.h"
 #include "Engine/RotoShapeRenderNode.h"
 #include "Engine/RotoShapeRenderCairo.h"
@@ -614,6 +616,9 @@ AppManager::~AppManager()
 
     // Ensure the cache is synced on disk when exiting.
     _imp->cache->flushCacheOnDisk(false /*async*/);
+    _imp->cacheReuseStats->saveToDirectory( _imp->cache->getCacheDirectoryPath() );
+
+    _imp->memoryGovernor->quitThread();
 
     _imp->storageDeleteThread->quitThread();
 
@@ -880,7 +885,31 @@ AppManager::loadInternal(const CLArgs& cl)
     if (cl.isCacheClearRequestedOnLaunch()) {
         _imp->cache->clear();
     }
+    _imp->cacheReuseStats->loadFromDirectory( _imp->cache->getCacheDirectoryPath() );
     _imp->storageDeleteThread.reset(new StorageDeleterThread);
+    _imp->memoryGovernor.reset(new MemoryGovernor);
+    _imp->memoryGovernor->startIfMemoryLimited();
+
+    // Enable tracing before any render may start
+    if ( !cl.getRenderTraceFilePath().isEmpty() ) {
+        RenderTrace::enable( cl.getRenderTraceFilePath().toStdString() );
+    }
+
+    _imp->renderWorkerIndex = cl.getRenderWorkerIndex();
+    _imp->nRenderWorkers = cl.getNumRenderWorkers();
+
+    // With --workers, this process only launches the worker processes and waits for them to finish: they load
+    // the project and render, sharing the cache created above.
+    if ( cl.isBackgroundMode() && (_imp->nRenderWorkers > 1) && (_imp->renderWorkerIndex == -1) ) {
+        if ( !cl.getIPCPipeName().isEmpty() ) {
+            std::cerr << tr("--workers cannot be used for a render launched from the GUI, rendering in a single process.").toStdString() << std::endl;
+            _imp->nRenderWorkers = 0;
+        } else {
+            RenderWorkers workers(_imp->nRenderWorkers);
+
+            return workers.run();
+        }
+    }
 
     _imp->declareSettingsToPython();
 
@@ -1316,6 +1345,7 @@ AppManager::clearAllCaches()
     }
 
     _imp->cache->clear();
+    _imp->actionResultsCache->clear();
     
     ///for each app instance clear all its nodes cache
     for (AppInstanceVec::iterator it = copy.begin(); it != copy.end(); ++it) {
@@ -2474,6 +2504,32 @@ AppManager::getCache() const
     return _imp->cache;
 }
 
+ActionResultsCache*
+AppManager::getActionResultsCache() const
+{
+    return _imp->actionResultsCache.get();
+}
+
+CacheReuseStats*
+AppManager::getCacheReuseStats() const
+{
+    return _imp->cacheReuseStats.get();
+}
+
+MemoryGovernor*
+AppManager::getMemoryGovernor() const
+{
+    return _imp->memoryGovernor.get();
+}
+
+void
+AppManager::getRenderWorkerIndex(int* index,
+                                 int* nWorkers) const
+{
+    *index = _imp->renderWorkerIndex;
+    *nWorkers = _imp->nRenderWorkers;
+}
+
 void
 AppManager::deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete)
 {
@@ -2518,6 +2574,27 @@ AppManager::printCacheMemoryStats() const
     reportStr += QLatin1String("--> ");
     reportStr += printAsRAM(totalBytes);
     reportStr += tr(" taken by %1 cache entries.").arg(QString::number(totalNEntries));
+    reportStr += QLatin1String("\n");
+
+    std::map<std::string, ActionResultsCacheStats> actionStats;
+    _imp->actionResultsCache->getStats(&actionStats);
+    if (!actionStats.empty()) {
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Action results cache:");
+        reportStr += QLatin1String("\n");
+        for (std::map<std::string, ActionResultsCacheStats>::iterator it = actionStats.begin(); it != actionStats.end(); ++it) {
+            U64 nLookups = it->second.nHits + it->second.nMisses;
+            double hitRate = nLookups > 0 ? (double)it->second.nHits * 100. / nLookups : 0.;
+            reportStr += QString::fromUtf8(it->first.c_str());
+            reportStr += QLatin1String("--> ");
+            reportStr += tr("Hit rate: %1% (%2 hits / %3 lookups)").arg(hitRate, 0, 'f', 1).arg( (qulonglong)it->second.nHits ).arg( (qulonglong)nLookups );
+            reportStr += tr(" Number of Cache Entries: ");
+            reportStr += QString::number(it->second.nEntries);
+            reportStr += QLatin1String(" (");
+            reportStr += printAsRAM(it->second.nBytes);
+            reportStr += QLatin1String(")\n");
+        }
+    }
 
     appPTR->writeToErrorLog_mt_safe(tr("Cache Report"), QDateTime::currentDateTime(), reportStr);
 
@@ -3765,12 +3842,31 @@ NATRON_PYTHON_NAMESPACE::interpretPythonScript(const std::string& script,
     PyObject* mainModule = NATRON_PYTHON_NAMESPACE::getMainModule();
     PyObject* dict = PyModule_GetDict(mainModule);
 
+    // Scripts may run other scripts (callbacks, PyPlugs...): only the outer-most one is tracked.
+    // Only the main thread can open knob changes transactions.
+    static int nScriptsRunningOnMainThread = 0;
+    const bool isMainThread = ( qApp && QThread::currentThread() == qApp->thread() );
+    if (isMainThread) {
+        ++nScriptsRunningOnMainThread;
+    }
+
     ///This is faster than PyRun_SimpleString since is doesn't call PyImport_AddModule("__main__")
     PyObject* v = PyRun_String(script.c_str(), Py_file_input, dict, 0);
     if (v) {
         Py_DECREF(v);
     }
 
+    if (isMainThread) {
+        --nScriptsRunningOnMainThread;
+        if (nScriptsRunningOnMainThread == 0) {
+            // End the App.beginChanges() brackets the script did not end, e.g: because it raised an exception
+            const AppInstanceVec& apps = appPTR->getAppInstances();
+            for (AppInstanceVec::const_iterator it = apps.begin(); it != apps.end(); ++it) {
+                (*it)->endAllScriptKnobChangesTransactions();
+            }
+        }
+    }
+
     PyObject *errCatcher = 0;
     PyObject *outCatcher = 0;
 
@@ -182,6 +182,29 @@ public:
 
     CachePtr getCache() const;
 
+    /**
+     * @brief Returns the process-local cache holding the results of the actions and of the knob expressions.
+     **/
+    ActionResultsCache* getActionResultsCache() const;
+
+    /**
+     * @brief Returns the measures of how often the cached outputs of each node are re-read, used to bypass the cache
+     * for the nodes whose outputs are not re-read.
+     **/
+    CacheReuseStats* getCacheReuseStats() const;
+
+    /**
+     * @brief Returns the thread adapting the cache budgets and throttling renders according to the memory limit
+     * of the control group of this process.
+     **/
+    MemoryGovernor* getMemoryGovernor() const;
+
+    /**
+     * @brief If this process is one of the worker processes of a render launched with --workers, returns
+     * in index the index of this worker in [0, nWorkers[. Otherwise index is set to -1.
+     **/
+    void getRenderWorkerIndex(int* index, int* nWorkers) const;
+
     void deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete);
 
 
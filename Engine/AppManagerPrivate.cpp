@@ -86,12 +86,16 @@ AppManagerPrivate::AppManagerPrivate()
     , multiThreadSuite(new MultiThread())
     , _knobFactory( new KnobFactory() )
     , cache()
+    , actionResultsCache( new ActionResultsCache() )
+    , cacheReuseStats( new CacheReuseStats() )
     , _backgroundIPC()
     , _loaded(false)
     , _binaryPath()
     , errorLogMutex()
     , errorLog()
     , idealThreadCount(0)
+    , renderWorkerIndex(-1)
+    , nRenderWorkers(0)
     , commandLineArgsUtf8()
     , nArgs(0)
     , mainModule(0)
@@ -48,9 +48,12 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/OSGLContext_mac.h"
 #endif
 
+#include "Engine/ActionResultsCache.h"
+#include "Engine/CacheReuseStats.h"
 #include "Engine/AppManager.h"
 #include "Engine/Cache.h"
 #include "Engine/StorageDeleterThread.h"
+#include "Engine/MemoryGovernor.h"
 #include "Engine/Image.h"
 #include "Engine/GPUContextPool.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
@@ -113,8 +116,14 @@ public:
 
     CachePtr cache; //< Main application cache
 
+    boost::scoped_ptr<ActionResultsCache> actionResultsCache; //< Process-local cache for the results of the actions
+
+    boost::scoped_ptr<CacheReuseStats> cacheReuseStats; //< How often the cached outputs of each node are re-read
+
     boost::scoped_ptr<StorageDeleterThread> storageDeleteThread; // thread used to kill cache entries without blocking a render thread
 
+    boost::scoped_ptr<MemoryGovernor> memoryGovernor; // thread adapting the cache budgets to the cgroup memory limit
+
     boost::scoped_ptr<ProcessInputChannel> _backgroundIPC; //< object used to communicate with the main app
 
     //if this app is background, see the ProcessInputChannel def
@@ -130,6 +139,10 @@ public:
 
     int idealThreadCount; // return value of QThread::idealThreadCount() cached here
 
+    // If this process is a worker of a render launched with --workers, its index in [0, nRenderWorkers[, otherwise -1
+    int renderWorkerIndex;
+    int nRenderWorkers;
+
     ///Python needs wide strings as from Python 3.x onwards everything is unicode based
 #if PY_MAJOR_VERSION >= 3
     // Python 3
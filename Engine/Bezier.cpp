@@ -133,6 +133,10 @@ struct BezierPrivate
     //alpha value is half the original value when at half distance from the feather distance
     KnobChoiceWPtr fallOffRampType;
 
+    // Deep copy of the points of all views, shared by all the render clones made since the last edit.
+    // The control points it holds are never modified: an edit releases it instead, see getRenderPointsSnapshot()
+    mutable boost::shared_ptr<const PerViewBezierShapeMap> renderPointsSnapshot;
+
 
     BezierPrivate(const std::string& baseName, bool isOpenBezier)
     : itemMutex()
@@ -140,6 +144,7 @@ struct BezierPrivate
     , autoRecomputeOrientation(true)
     , isOpenBezier(isOpenBezier)
     , baseName(baseName)
+    , renderPointsSnapshot()
     {
         viewShapes.insert(std::make_pair(ViewIdx(0), BezierShape()));
     }
@@ -157,21 +162,56 @@ struct BezierPrivate
         featherFallOff = other.featherFallOff;
         fallOffRampType = other.fallOffRampType;
 
+        // Only the first render clone after an edit copies the points, the others share them
+        renderPointsSnapshot = other.getRenderPointsSnapshot();
+
         for (PerViewBezierShapeMap::const_iterator it = other.viewShapes.begin(); it != other.viewShapes.end(); ++it) {
             BezierShape& thisShape = viewShapes[it->first];
             thisShape.isClockwiseOriented = it->second.isClockwiseOriented;
             thisShape.isClockwiseOrientedStatic = it->second.isClockwiseOrientedStatic;
             thisShape.finished = it->second.finished;
+
+            PerViewBezierShapeMap::const_iterator foundPoints = renderPointsSnapshot->find(it->first);
+            assert( foundPoints != renderPointsSnapshot->end() );
+            thisShape.points = foundPoints->second.points;
+            thisShape.featherPoints = foundPoints->second.featherPoints;
+        }
+    }
+
+    /**
+     * @brief Returns a deep copy of the control points and feather points of all views, made the first time it is
+     * requested after an edit.
+     **/
+    boost::shared_ptr<const PerViewBezierShapeMap> getRenderPointsSnapshot() const
+    {
+        assert(!itemMutex.tryLock());
+        if (renderPointsSnapshot) {
+            return renderPointsSnapshot;
+        }
+        boost::shared_ptr<PerViewBezierShapeMap> snapshot(new PerViewBezierShapeMap);
+        for (PerViewBezierShapeMap::const_iterator it = viewShapes.begin(); it != viewShapes.end(); ++it) {
+            BezierShape& snapshotShape = (*snapshot)[it->first];
             for (BezierCPs::const_iterator it2 = it->second.points.begin(); it2 != it->second.points.end(); ++it2) {
                 BezierCPPtr copy(new BezierCP(**it2));
-                thisShape.points.push_back(copy);
+                snapshotShape.points.push_back(copy);
             }
             for (BezierCPs::const_iterator it2 = it->second.featherPoints.begin(); it2 != it->second.featherPoints.end(); ++it2) {
                 BezierCPPtr copy(new BezierCP(**it2));
-                thisShape.featherPoints.push_back(copy);
+                snapshotShape.featherPoints.push_back(copy);
             }
-
         }
+        renderPointsSnapshot = snapshot;
+        return renderPointsSnapshot;
+    }
+
+    /**
+     * @brief Must be called whenever the points are edited so that the next render clone copies them again.
+     * Render clones made before keep the previous snapshot.
+     **/
+    void invalidateRenderPointsSnapshot()
+    {
+        assert(!itemMutex.tryLock());
+        renderPointsSnapshot.reset();
     }
     
     const BezierShape* getViewShape(ViewIdx view) const
@@ -1217,6 +1257,7 @@ Bezier::clearAllPoints()
 {
     removeAnimation(ViewSetSpec::all(), DimSpec::all(), eValueChangedReasonUserEdited);
     QMutexLocker k(&_imp->itemMutex);
+    _imp->invalidateRenderPointsSnapshot();
     for (PerViewBezierShapeMap::iterator it = _imp->viewShapes.begin(); it != _imp->viewShapes.end(); ++it) {
         it->second.points.clear();
         it->second.featherPoints.clear();
@@ -1363,6 +1404,11 @@ Bezier::addControlPoint(double x,
 void
 Bezier::evaluateCurveModified()
 {
+    {
+        QMutexLocker k(&_imp->itemMutex);
+        _imp->invalidateRenderPointsSnapshot();
+    }
+
     // If the curve is not finished, do not evaluate.
     if (!isOpenBezier()) {
         bool hasCurveFinished = false;
@@ -2723,6 +2769,7 @@ Bezier::onKeyFrameSetForView(TimeValue time, ViewIdx view)
         if ( hasMasterKeyframeAtTime(time, view)) {
             return;
         }
+        _imp->invalidateRenderPointsSnapshot();
 
         bool useFeather = useFeatherPoints();
         assert(shape->points.size() == shape->featherPoints.size() || !useFeather);
@@ -2769,6 +2816,7 @@ Bezier::onKeyFrameRemovedForView(TimeValue time, ViewIdx view)
         if ( hasMasterKeyframeAtTime(time, view)) {
             return;
         }
+        _imp->invalidateRenderPointsSnapshot();
         assert( shape->featherPoints.size() == shape->points.size() || !useFeatherPoints() );
 
         bool useFeather = useFeatherPoints();
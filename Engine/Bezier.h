@@ -89,7 +89,8 @@ public:
 private:
 
     // The copy constructor makes a shallow copy and only copy knob pointers
-    // since the knobs are anyway cached during render in RenderValuesCache
+    // since the knobs are anyway cached during render in RenderValuesCache.
+    // The control points are shared with the other render clones made since the last edit.
     Bezier(const Bezier& other);
 
     virtual RotoDrawableItemPtr createRenderCopy() const OVERRIDE FINAL;
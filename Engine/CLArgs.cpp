@@ -74,6 +74,9 @@ public:
     QString breakpadProcessFilePath;
     qint64 breakpadProcessPID;
     QString exportDocsPath;
+    QString renderTraceFilePath;
+    int nRenderWorkers;
+    int renderWorkerIndex;
 
     CLArgsPrivate()
         : args()
@@ -101,6 +104,9 @@ public:
         , breakpadProcessFilePath()
         , breakpadProcessPID(-1)
         , exportDocsPath()
+        , renderTraceFilePath()
+        , nRenderWorkers(0)
+        , renderWorkerIndex(-1)
     {
     }
 
@@ -232,6 +238,9 @@ CLArgs::operator=(const CLArgs& other)
     _imp->isEmpty = other._imp->isEmpty;
     _imp->imageFilename = other._imp->imageFilename;
     _imp->exportDocsPath = other._imp->exportDocsPath;
+    _imp->renderTraceFilePath = other._imp->renderTraceFilePath;
+    _imp->nRenderWorkers = other._imp->nRenderWorkers;
+    _imp->renderWorkerIndex = other._imp->renderWorkerIndex;
 }
 
 bool
@@ -339,6 +348,22 @@ CLArgs::printUsage(const std::string& programName)
         "     This option is useful for debugging purposes or to control that a render\n"
         "     is working correctly.\n"
         "     **Please note** that it does not work when writing video files."
+        "\n  --render-trace <filename>\n"
+        "     Record the time spent in each action, cache operation and image\n"
+        "     conversion by each render thread and write it as a Chrome trace JSON\n"
+        "     file, that can be opened in chrome://tracing or Perfetto.\n"
+        "     If the filename contains '#' characters, a file is written for each\n"
+        "     frame, with the '#' replaced by the frame number (e.g: trace###.json).\n"
+        "     Otherwise a file is written for each render job, the jobs after the\n"
+        "     first one inserting their index before the extension (e.g: trace.1.json).\n"
+        "     With --workers, each worker inserts .worker<index> before the extension.\n"
+        "  --workers <N>\n"
+        "     Render with N worker processes instead of a single process. Each worker\n"
+        "     renders every N-th frame of the range and all workers share the same\n"
+        "     cache, so that images computed by one worker can be used by the others.\n"
+        "     This is useful when the graph contains plug-ins that cannot render\n"
+        "     concurrently in a single process.\n"
+        "     Video files are always rendered by a single worker.\n"
         "Sample uses:\n"
         "  %1 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1 -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp\n"
@@ -552,6 +577,24 @@ CLArgs::getExportDocsPath() const
     return _imp->exportDocsPath;
 }
 
+const QString&
+CLArgs::getRenderTraceFilePath() const
+{
+    return _imp->renderTraceFilePath;
+}
+
+int
+CLArgs::getNumRenderWorkers() const
+{
+    return _imp->nRenderWorkers;
+}
+
+int
+CLArgs::getRenderWorkerIndex() const
+{
+    return _imp->renderWorkerIndex;
+}
+
 QStringList::iterator
 CLArgsPrivate::findFileNameWithExtension(const QString& extension)
 {
@@ -887,6 +930,59 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-trace"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            if ( it != args.end() ) {
+                renderTraceFilePath = *it;
+                args.erase(it);
+            } else {
+                std::cout << tr("--render-trace specified, you must enter a trace filename afterwards.").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("workers"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            bool ok = false;
+            if ( it != args.end() ) {
+                nRenderWorkers = it->toInt(&ok);
+                args.erase(it);
+            }
+            if ( !ok || (nRenderWorkers < 1) ) {
+                std::cout << tr("--workers specified, you must enter a number of worker processes afterwards.").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
+    {
+        // Internal option: passed to the worker processes launched with --workers
+        QStringList::iterator it = hasToken( QString::fromUtf8("worker-index"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            bool ok = false;
+            if ( it != args.end() ) {
+                renderWorkerIndex = it->toInt(&ok);
+                args.erase(it);
+            }
+            if (!ok) {
+                std::cout << tr("You must specify the worker index").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("IPCpipe"), QString() );
         if ( it != args.end() ) {
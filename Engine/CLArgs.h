@@ -146,6 +146,22 @@ public:
     const QString& getBreakpadComPipeFilePath() const;
     const QString& getExportDocsPath() const;
 
+    /*
+     * @brief If not empty, per-thread action timings should be written to this file, @see RenderTrace
+     */
+    const QString& getRenderTraceFilePath() const;
+
+    /*
+     * @brief The number of worker processes requested with --workers, or 0 if not specified.
+     */
+    int getNumRenderWorkers() const;
+
+    /*
+     * @brief If this process is a worker launched by a process started with --workers, this is
+     * the index of the worker in [0, getNumRenderWorkers()[. Otherwise returns -1.
+     */
+    int getRenderWorkerIndex() const;
+
 private:
 
     boost::scoped_ptr<CLArgsPrivate> _imp;
@@ -25,9 +25,14 @@
 #include "Cache.h"
 
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 #include <set>
 #include <list>
+#include <map>
+#include <vector>
+#include <algorithm> // stable_sort
+#include <new> // placement new
 
 #include <QMutex>
 #include <QDir>
@@ -50,6 +55,7 @@ GCC_DIAG_OFF(unused-parameter)
 #include <boost/interprocess/sync/file_lock.hpp> //  file lock
 #include <boost/interprocess/sync/named_semaphore.hpp> //  named semaphore
 #include <boost/date_time/posix_time/posix_time.hpp> // time for timed lock
+#include <boost/crc.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 GCC_DIAG_ON(unused-parameter)
 
@@ -67,6 +73,8 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/Settings.h"
 #include "Engine/StandardPaths.h"
 #include "Engine/RamBuffer.h"
+#include "Engine/RectI.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/ThreadPool.h"
 
 
@@ -84,10 +92,19 @@ GCC_DIAG_ON(unused-parameter)
 #define NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES 524288
 
 // Used to prevent loading older caches when we change the serialization scheme
-#define NATRON_CACHE_SERIALIZATION_VERSION 5
+#define NATRON_CACHE_SERIALIZATION_VERSION 7
 
 // If we change the MemorySegmentEntryHeader struct, we must increment this version so we do not attempt to read an invalid structure.
-#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 1
+#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 3
+
+// The tile size class of images produced by effects that do not read their inputs beyond the pixel they render
+#define NATRON_TILE_SIZE_DEFAULT_CLASS 0
+
+// Images are not split in less tiles than this per channel, unless the image is smaller than a tile of the default class
+#define NATRON_TILE_SIZE_MIN_TILES_PER_IMAGE 128
+
+// The tiles of an image must be at least this many times larger than the kernel footprint of the effect producing it
+#define NATRON_TILE_SIZE_KERNEL_FOOTPRINT_RATIO 4
 
 //#define CACHE_TRACE_ENTRY_ACCESS
 //#define CACHE_TRACE_TIMEOUTS
@@ -183,9 +200,13 @@ struct MemorySegmentEntryHeader
 {
 
     // If this entry has data in the tile aligned memory mapped file, this is the
-    // index of the tile allocated. If not allocated, this is  -1.
+    // index of the first tile allocated. If not allocated, this is  -1.
     int tileCacheIndex;
 
+    // If tileCacheIndex is not -1, the size class of the tile: it spans pow(2, tileSizeClass) tiles
+    // of NATRON_TILE_SIZE_BYTES from tileCacheIndex.
+    int tileSizeClass;
+
     // The size of the memorySegmentPortion, in bytes. This is stored in the main cache memory segment.
     std::size_t size;
 
@@ -225,14 +246,62 @@ struct MemorySegmentEntryHeader
     // to NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION
     unsigned int version;
 
+    // If tileCacheIndex is not -1, the checksum of the tile data computed when the entry was inserted
+    U32 tileChecksum;
+
+    // False if the tile data must be checked against tileChecksum before being read.
+    // This is set to false for all entries when the cache is re-opened from disk, since the tile
+    // file may not have been written entirely when the OS or the last process shutdown.
+    bool tileChecksumVerified;
+
     MemorySegmentEntryHeader(const void_allocator& allocator)
     : tileCacheIndex(-1)
+    , tileSizeClass(0)
     , size(0)
     , lruIterator(0)
     , status(eEntryStatusNull)
     , pluginID(allocator)
     , entryDataPointerList(allocator)
     , version(0)
+    , tileChecksum(0)
+    , tileChecksumVerified(false)
+    {
+
+    }
+};
+
+static std::size_t
+getNTilesForSizeClass(int tileSizeClass)
+{
+    return (std::size_t)1 << tileSizeClass;
+}
+
+static U32
+computeTileChecksum(const char* tileData, int tileSizeClass)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(tileData, Cache::getTileSizeBytes(tileSizeClass));
+    return crc.checksum();
+}
+
+/**
+ * @brief Stored in the ToC memory mapped file of each bucket next to the IPCData.
+ * It is used by the first process opening the cache to know whether the ToC on disk
+ * can be re-used, see CacheBucket::restoreFromDisk().
+ **/
+struct CacheBucketJournal
+{
+    // The NATRON_CACHE_SERIALIZATION_VERSION of the process that created the ToC, or 0 if unknown
+    unsigned int serializationVersion;
+
+    // Incremented before the ToC memory segment is modified and decremented once it is consistent again.
+    // If a process crashes in-between, the count remains non zero in the file and the ToC cannot be trusted anymore.
+    // This is only modified under the tocData.segmentMutex write lock.
+    int nPendingWrites;
+
+    CacheBucketJournal(unsigned int serializationVersion)
+    : serializationVersion(serializationVersion)
+    , nPendingWrites(0)
     {
 
     }
@@ -297,6 +366,9 @@ struct CacheBucket
     // Pointer to the IPC data that live in tocFile memory mapped file
     IPCData *ipc;
 
+    // Pointer to the journal that lives in tocFile memory mapped file
+    CacheBucketJournal* journal;
+
     // Weak pointer to the cache
     CacheWPtr cache;
 
@@ -308,12 +380,31 @@ struct CacheBucket
     , tocFile()
     , tocFileManager()
     , ipc(0)
+    , journal(0)
     , cache()
     , bucketIndex(-1)
     {
 
     }
 
+    /**
+     * @brief Called when opening the cache by the first process using it: no other process may have
+     * a mapping of the bucket files.
+     * Checks that the ToC left on disk by a previous process can be re-used: entries that were not
+     * done computing are removed, the free tiles and the LRU list are rebuilt from the remaining entries
+     * and their tile checksum will be checked the first time they are read.
+     * The tocData.segmentMutex and tileData.segmentMutex are assumed to be taken for write lock and
+     * both mappings to be valid.
+     * @returns False if the ToC cannot be trusted, in which case the caller should call clearFiles().
+     **/
+    bool restoreFromDisk();
+
+    /**
+     * @brief Remove all entries of the bucket by truncating its files.
+     * The tocData.segmentMutex and tileData.segmentMutex are assumed to be taken for write lock.
+     **/
+    void clearFiles(WriteLock& tocWriteLock, WriteLock& tileWriteLock);
+
 
     /**
      * @brief Deallocates the cacheEntry from the ToC memory mapped file.
@@ -395,6 +486,52 @@ struct CacheBucket
      * This function is called internally by ensureTileMappingValid()
      **/
     void growTileFile(WriteLock& lock, std::size_t bytesToAdd);
+
+    /**
+     * @brief Removes nTiles contiguous tiles from the free tiles. The index of the first tile is a multiple of
+     * nTiles so that the tiles of a given size class do not fragment the file for the larger classes.
+     * The tocData.segmentMutex is assumed to be taken for write lock.
+     * @returns The index of the first tile, or -1 if there are not enough contiguous free tiles.
+     **/
+    int allocateTiles(std::size_t nTiles);
+
+    /**
+     * @brief If growing the tile file would exceed the share of the disk cache budget of this bucket,
+     * evicts the entries occupying a single aligned block of nTiles tiles, chosen to have the fewest and least recently
+     * used occupants, and allocates it.
+     * The tocData.segmentMutex is assumed to be taken for write lock, the tileData.segmentMutex must not be taken.
+     * @returns The index of the first tile, or -1 if the file may grow or if there is nothing left to evict.
+     **/
+    int evictEntriesToAllocateTiles(std::size_t nTiles);
+
+    /**
+     * @brief Inserts the nTiles tiles from firstTile back in the free tiles.
+     * The tocData.segmentMutex is assumed to be taken for write lock.
+     **/
+    void releaseTiles(int firstTile, std::size_t nTiles);
+};
+
+/**
+ * @brief Marks the ToC of a bucket as being modified in its journal for the lifetime of this object.
+ * The tocData.segmentMutex is assumed to be taken for write lock.
+ **/
+class ToCJournalWriteScope
+{
+    CacheBucket* _bucket;
+
+public:
+
+    ToCJournalWriteScope(CacheBucket* bucket)
+    : _bucket(bucket)
+    {
+        ++_bucket->journal->nPendingWrites;
+    }
+
+    ~ToCJournalWriteScope()
+    {
+        // The journal pointer may have changed if the ToC file was grown in-between
+        --_bucket->journal->nPendingWrites;
+    }
 };
 
 struct CacheEntryLockerPrivate
@@ -417,8 +554,30 @@ struct CacheEntryLockerPrivate
     // A string version of the hash, uniquely identifying the MemorySegmentEntry in the memory mapped file
     std::string hashStr;
 
+    // The checksum of the tile data of the entry, computed before taking the bucket locks, see computeProcessLocalTileChecksum()
+    U32 tileChecksum;
+
     CacheEntryLockerPrivate(CacheEntryLocker* publicInterface, const CachePtr& cache, const CacheEntryBasePtr& entry);
 
+    /**
+     * @brief Creates the MemorySegmentEntryHeader for this entry in the bucket with a pending status:
+     * this thread is going to compute it.
+     * The tocData.segmentMutex is assumed to be taken for write lock
+     **/
+    void constructPendingEntry();
+
+    /**
+     * @brief If the entry is tiled, computes the checksum of its process local tile data.
+     * This must be called before taking the bucket locks: it reads the whole tile.
+     **/
+    void computeProcessLocalTileChecksum();
+
+    /**
+     * @brief Implementation of insertInCache().
+     * The tocData.segmentMutex is assumed to be taken for write lock
+     **/
+    void insertInCacheUnderWriteLock(WriteLock& writeLock);
+
 };
 
 struct CachePrivate
@@ -600,10 +759,12 @@ struct CachePrivate
     // We apply the following steps:
     // When starting up a new Natron process: globalMemorySegmentFileLock.try_lock()
     //      - If it succeeds, that means no other process is active: We remove the globalMemorySegment shared memory segment
-    //        and create a new one, to ensure no lock was left in a bad state. Then we release the file lock
+    //        and create a new one, to ensure no lock was left in a bad state. We then restore the buckets from their files
+    //        and release the file lock.
     //      - If it fails, another process is still actively using the globalMemorySegment shared memory: it must still be valid
     //
-    // We then take the file lock in read mode, indicating that we use the shared memory:
+    // We then take the file lock in read mode, indicating that we use the shared memory. This waits for the process
+    // restoring the buckets, if any:
     //      globalMemorySegmentFileLock.lock_sharable()
     //
     // Any operation taking the segmentMutex in the shared memory, must do so with a timeout so we can avoid deadlocks:
@@ -831,6 +992,7 @@ CacheEntryLockerPrivate::CacheEntryLockerPrivate(CacheEntryLocker* publicInterfa
 , bucket(0)
 , status(CacheEntryLocker::eCacheEntryStatusMustCompute)
 , hashStr()
+, tileChecksum(0)
 {
 
     U64 hash = entry->getHashKey();
@@ -847,6 +1009,8 @@ CacheEntryLocker::CacheEntryLocker(const CachePtr& cache, const CacheEntryBasePt
 CacheEntryLockerPtr
 CacheEntryLocker::create(const CachePtr& cache, const CacheEntryBasePtr& entry)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryCache, "CacheLookup");
+
     assert(entry);
     if (!entry) {
         throw std::invalid_argument("CacheEntryLocker::create: no entry");
@@ -863,6 +1027,56 @@ CacheEntryLocker::create(const CachePtr& cache, const CacheEntryBasePtr& entry)
     return ret;
 }
 
+static bool
+bucketIndexLess(const std::pair<int, std::size_t>& lhs, const std::pair<int, std::size_t>& rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+void
+CacheEntryLocker::createBatch(const CachePtr& cache, const std::vector<CacheEntryBasePtr>& entries, std::vector<CacheEntryLockerPtr>* lockers)
+{
+    RenderTraceScope traceScope(kRenderTraceCategoryCache, "CacheBatchLookup");
+
+    lockers->resize(entries.size());
+    if (entries.empty()) {
+        return;
+    }
+
+    // For each entry, the index of its bucket and its index in the entries vector
+    std::vector<std::pair<int, std::size_t> > bucketOrder(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        assert(entries[i]);
+        if (!entries[i]) {
+            throw std::invalid_argument("CacheEntryLocker::createBatch: no entry");
+        }
+        CacheEntryLockerPtr locker(new CacheEntryLocker(cache, entries[i]));
+        int bucketIndex = Cache::getBucketCacheBucketIndex(entries[i]->getHashKey());
+        locker->_imp->bucket = &cache->_imp->buckets[bucketIndex];
+        (*lockers)[i] = locker;
+        bucketOrder[i] = std::make_pair(bucketIndex, i);
+    }
+
+    // Sort by bucket so that entries of the same bucket are looked-up under the same lock
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), bucketIndexLess);
+
+    // Lock the SHM for reading to ensure all process shared mutexes and other IPC structures remains valid.
+    boost::scoped_ptr<SharedMemoryReader> shmAccess(new SharedMemoryReader(cache->_imp.get()));
+
+    std::vector<CacheEntryLocker*> bucketLockers;
+    std::size_t i = 0;
+    while (i < bucketOrder.size()) {
+        const int bucketIndex = bucketOrder[i].first;
+        bucketLockers.clear();
+        for (; i < bucketOrder.size() && bucketOrder[i].first == bucketIndex; ++i) {
+            bucketLockers.push_back((*lockers)[bucketOrder[i].second].get());
+        }
+
+        // Never take over an entry upon timeout, same as create()
+        lookupBatchAndSetStatusInBucket(bucketLockers, shmAccess);
+    }
+} // createBatch
+
 bool
 CacheBucket::isToCFileMappingValid() const
 {
@@ -919,6 +1133,10 @@ static void reOpenToCData(CacheBucket* bucket, bool create)
     // The ipc data pointer must be re-fetched
     Size_t_Allocator_ExternalSegment freeTilesAllocator(bucket->tocFileManager->get_segment_manager());
     bucket->ipc = bucket->tocFileManager->find_or_construct<CacheBucket::IPCData>("BucketData")(freeTilesAllocator);
+
+    // A ToC without journal was created by an older version: mark it as unknown so it gets discarded
+    // the next time the cache is opened.
+    bucket->journal = bucket->tocFileManager->find_or_construct<CacheBucketJournal>("Journal")(create ? NATRON_CACHE_SERIALIZATION_VERSION : 0);
 }
 
 void
@@ -1117,6 +1335,149 @@ CacheBucket::growTileFile(WriteLock& lock, std::size_t bytesToAdd)
 
 } // growTileFile
 
+int
+CacheBucket::allocateTiles(std::size_t nTiles)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    assert(nTiles > 0);
+
+    set_size_t_ExternalSegment::iterator it = ipc->freeTiles.begin();
+    while ( it != ipc->freeTiles.end() ) {
+        const std::size_t firstTile = *it;
+        const std::size_t nextAlignedTile = (firstTile / nTiles + 1) * nTiles;
+        if (firstTile % nTiles == 0) {
+            // Check that the following tiles are free too: the set is sorted
+            set_size_t_ExternalSegment::iterator endIt = it;
+            std::size_t nContiguousTiles = 1;
+            for (++endIt; nContiguousTiles < nTiles && endIt != ipc->freeTiles.end() && *endIt == firstTile + nContiguousTiles; ++endIt) {
+                ++nContiguousTiles;
+            }
+            if (nContiguousTiles == nTiles) {
+                ipc->freeTiles.erase(it, endIt);
+#ifdef CACHE_TRACE_TILES_ALLOCATION
+                qDebug() << "Bucket" << bucketIndex << ": removing tiles" << firstTile << "to" << firstTile + nTiles << " Nb free tiles left:" << ipc->freeTiles.size();
+#endif
+                return (int)firstTile;
+            }
+        }
+        it = ipc->freeTiles.lower_bound(nextAlignedTile);
+    }
+    return -1;
+} // allocateTiles
+
+/**
+ * @brief The entries occupying an aligned block of tiles, candidate to be evicted to allocate the block
+ **/
+struct TileBlockOccupants
+{
+    // Hashes of the entries with tiles in the block
+    std::vector<U64> hashes;
+
+    // Position in the LRU list of the most recently used entry in the block (0 = least recently used)
+    std::size_t newestLRUPosition;
+
+    // False if an entry in the block may not be evicted
+    bool evictable;
+
+    TileBlockOccupants()
+    : hashes()
+    , newestLRUPosition(0)
+    , evictable(true)
+    {
+
+    }
+};
+
+int
+CacheBucket::evictEntriesToAllocateTiles(std::size_t nTiles)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    CachePtr c = cache.lock();
+    const std::size_t bucketMaximumSize = c->getMaximumCacheSize(eStorageModeDisk) / NATRON_CACHE_BUCKETS_COUNT;
+
+    // If max size == 0 then there's no limit.
+    if (bucketMaximumSize == 0) {
+        return -1;
+    }
+
+    // The file is only grown under the tocData.segmentMutex write lock: its size cannot change while we evict.
+    const std::size_t growSize = NATRON_CACHE_FILE_GROW_N_TILES * NATRON_TILE_SIZE_BYTES;
+    if (tileAlignedFile->size() + growSize <= bucketMaximumSize) {
+        return -1;
+    }
+    const std::size_t nBlocksInFile = tileAlignedFile->size() / NATRON_TILE_SIZE_BYTES / nTiles;
+
+    // Small tiles are spread across all the aligned blocks: evicting in LRU order until a block happens to be free
+    // could empty the whole bucket. Instead, find the occupants of each aligned block of nTiles tiles and evict
+    // only those of the block with the fewest occupants, the least recently used one if several have as few.
+    std::map<std::size_t, TileBlockOccupants> blocks;
+    {
+        boost::scoped_ptr<bip::scoped_lock<bip::interprocess_mutex> > lruWriteLock;
+        createLockNoTimeout<bip::scoped_lock<bip::interprocess_mutex> >(lruWriteLock, &ipc->lruListMutex);
+
+        std::size_t lruPosition = 0;
+        for (bip::offset_ptr<LRUListNode> node = ipc->lruListFront; node; node = node->next, ++lruPosition) {
+            MemorySegmentEntryHeader* cacheEntry = tryCacheLookupImpl( CacheEntryKeyBase::hashToString(node->hash) );
+            if ( !cacheEntry || (cacheEntry->tileCacheIndex == -1) ) {
+                continue;
+            }
+            const std::size_t entryNTiles = (std::size_t)1 << cacheEntry->tileSizeClass;
+            const std::size_t firstBlock = cacheEntry->tileCacheIndex / nTiles;
+            const std::size_t lastBlock = (cacheEntry->tileCacheIndex + entryNTiles - 1) / nTiles;
+            for (std::size_t b = firstBlock; b <= lastBlock && b < nBlocksInFile; ++b) {
+                TileBlockOccupants& block = blocks[b];
+                block.hashes.push_back(node->hash);
+                block.newestLRUPosition = lruPosition;
+                if (cacheEntry->status != MemorySegmentEntryHeader::eEntryStatusReady) {
+                    block.evictable = false;
+                }
+            }
+        }
+    }
+
+    std::map<std::size_t, TileBlockOccupants>::const_iterator victim = blocks.end();
+    for (std::map<std::size_t, TileBlockOccupants>::const_iterator it = blocks.begin(); it != blocks.end(); ++it) {
+        if (!it->second.evictable) {
+            continue;
+        }
+        if ( (victim == blocks.end()) ||
+             (it->second.hashes.size() < victim->second.hashes.size()) ||
+             ( (it->second.hashes.size() == victim->second.hashes.size()) && (it->second.newestLRUPosition < victim->second.newestLRUPosition) ) ) {
+            victim = it;
+        }
+    }
+    if ( victim == blocks.end() ) {
+        // Nothing left to evict: the file must grow
+        return -1;
+    }
+
+    for (std::vector<U64>::const_iterator it = victim->second.hashes.begin(); it != victim->second.hashes.end(); ++it) {
+        std::string hashStr = CacheEntryKeyBase::hashToString(*it);
+        MemorySegmentEntryHeader* cacheEntry = tryCacheLookupImpl(hashStr);
+        if (cacheEntry) {
+            deallocateCacheEntryImpl(cacheEntry, hashStr);
+        }
+    }
+
+    // Tiles of the block that are neither free nor held by an entry of the LRU list are being inserted by another thread:
+    // the allocation fails and the file grows.
+    return allocateTiles(nTiles);
+} // evictEntriesToAllocateTiles
+
+void
+CacheBucket::releaseTiles(int firstTile, std::size_t nTiles)
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    for (std::size_t i = 0; i < nTiles; ++i) {
+        std::pair<set_size_t_ExternalSegment::iterator, bool>  insertOk = ipc->freeTiles.insert(firstTile + i);
+        assert(insertOk.second);
+        (void)insertOk;
+    }
+#ifdef CACHE_TRACE_TILES_ALLOCATION
+    qDebug() << "Bucket" << bucketIndex << ": tiles freed" << firstTile << "to" << firstTile + nTiles << " Nb free tiles left:" << ipc->freeTiles.size();
+#endif
+} // releaseTiles
+
 MemorySegmentEntryHeader*
 CacheBucket::tryCacheLookupImpl(const std::string& hashStr)
 {
@@ -1186,7 +1547,21 @@ CacheBucket::readFromSharedMemoryEntryImpl(MemorySegmentEntryHeader* cacheEntry,
         }
 
 
+        // The size class is part of the key of the entry, this may only fail on a hash collision
+        if (cacheEntry->tileSizeClass != processLocalEntry->getTileSizeClass()) {
+            return false;
+        }
+
         tileDataPtr = tileAlignedFile->data() + cacheEntry->tileCacheIndex * NATRON_TILE_SIZE_BYTES;
+
+        // The entry was restored from disk: check that the tile data was entirely written.
+        // Several threads may do this concurrently under the read lock, they all write the same value.
+        if (!cacheEntry->tileChecksumVerified) {
+            if (computeTileChecksum(tileDataPtr, cacheEntry->tileSizeClass) != cacheEntry->tileChecksum) {
+                return false;
+            }
+            cacheEntry->tileChecksumVerified = true;
+        }
     }
 
     try {
@@ -1229,6 +1604,8 @@ CacheBucket::deallocateCacheEntryImpl(MemorySegmentEntryHeader* cacheEntry,
 
     // The tocData.segmentMutex must be taken in write mode
 
+    ToCJournalWriteScope journalScope(this);
+
     // Does not throw any exception
     for (ExternalSegmentTypeHandleList::const_iterator it = cacheEntry->entryDataPointerList.begin(); it != cacheEntry->entryDataPointerList.end(); ++it) {
         void* bufPtr = tocFileManager->get_address_from_handle(*it);
@@ -1253,17 +1630,12 @@ CacheBucket::deallocateCacheEntryImpl(MemorySegmentEntryHeader* cacheEntry,
 
             // Invalidate this portion of the memory mapped file
             std::size_t dataOffset = cacheEntry->tileCacheIndex * NATRON_TILE_SIZE_BYTES;
-            tileAlignedFile->flush(MemoryFile::eFlushTypeInvalidate, tileAlignedFile->data() + dataOffset, NATRON_TILE_SIZE_BYTES);
+            tileAlignedFile->flush(MemoryFile::eFlushTypeInvalidate, tileAlignedFile->data() + dataOffset, Cache::getTileSizeBytes(cacheEntry->tileSizeClass));
         }
         
 
-        // Make this tile free again
-#ifdef CACHE_TRACE_TILES_ALLOCATION
-        qDebug() << "Bucket" << bucketIndex << ": tile freed" << cacheEntry->tileCacheIndex << " Nb free tiles left:" << ipc->freeTiles.size();
-#endif
-        std::pair<set_size_t_ExternalSegment::iterator, bool>  insertOk = ipc->freeTiles.insert(cacheEntry->tileCacheIndex);
-        assert(insertOk.second);
-        (void)insertOk;
+        // Make the tiles free again
+        releaseTiles(cacheEntry->tileCacheIndex, getNTilesForSizeClass(cacheEntry->tileSizeClass));
         cacheEntry->tileCacheIndex = -1;
     }
 
@@ -1298,6 +1670,171 @@ CacheBucket::deallocateCacheEntryImpl(MemorySegmentEntryHeader* cacheEntry,
     tocFileManager->destroy<MemorySegmentEntryHeader>(hashStr.c_str());
 } // deallocateCacheEntryImpl
 
+static bool
+isEntryHeaderName(const char* name, std::size_t nameLength)
+{
+    // Entry headers are named after the hash of the entry, written in hexadecimal.
+    // All other named objects (entries data, IPCData, journal) have a suffix or a name that is not hexadecimal.
+    if (nameLength == 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < nameLength; ++i) {
+        char c = name[i];
+        if ( !( (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+CacheBucket::restoreFromDisk()
+{
+    // Private - the tocData.segmentMutex and tileData.segmentMutex are assumed to be taken for write lock
+
+    if (!journal || journal->serializationVersion != NATRON_CACHE_SERIALIZATION_VERSION) {
+        // Created by another version of Natron
+        return false;
+    }
+    if (journal->nPendingWrites != 0) {
+        // A process crashed whilst modifying the ToC
+        return false;
+    }
+
+    // No other process is using the bucket: the LRU list mutex may have been left locked by a process that crashed.
+    new (&ipc->lruListMutex) bip::interprocess_mutex();
+
+    assert(tileAlignedFile->size() % NATRON_TILE_SIZE_BYTES == 0);
+    const std::size_t nTiles = tileAlignedFile->size() / NATRON_TILE_SIZE_BYTES;
+
+    // The named objects index cannot be modified whilst iterating it, first collect the entries.
+    std::vector<std::string> entriesHash;
+    for (ExternalSegmentType::const_named_iterator it = tocFileManager->named_begin(); it != tocFileManager->named_end(); ++it) {
+        if (isEntryHeaderName(it->name(), it->name_length())) {
+            entriesHash.push_back(std::string(it->name(), it->name_length()));
+        }
+    }
+
+    ToCJournalWriteScope journalScope(this);
+
+    std::vector<bool> allocatedTiles(nTiles, false);
+    std::vector<MemorySegmentEntryHeader*> entries;
+    for (std::size_t i = 0; i < entriesHash.size(); ++i) {
+        MemorySegmentEntryHeader* cacheEntry = tryCacheLookupImpl(entriesHash[i]);
+        if (!cacheEntry) {
+            continue;
+        }
+
+        bool keepEntry = cacheEntry->status == MemorySegmentEntryHeader::eEntryStatusReady &&
+                         cacheEntry->version == NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION &&
+                         cacheEntry->lruIterator;
+        std::size_t nEntryTiles = 0;
+        if (keepEntry && cacheEntry->tileCacheIndex != -1) {
+            keepEntry = cacheEntry->tileSizeClass >= 0 && cacheEntry->tileSizeClass < NATRON_TILE_SIZE_CLASSES_COUNT && cacheEntry->tileCacheIndex >= 0;
+            if (keepEntry) {
+                nEntryTiles = getNTilesForSizeClass(cacheEntry->tileSizeClass);
+                keepEntry = (std::size_t)cacheEntry->tileCacheIndex + nEntryTiles <= nTiles;
+            }
+            for (std::size_t t = 0; keepEntry && t < nEntryTiles; ++t) {
+                keepEntry = !allocatedTiles[cacheEntry->tileCacheIndex + t];
+            }
+        }
+
+        if (keepEntry) {
+            for (std::size_t t = 0; t < nEntryTiles; ++t) {
+                allocatedTiles[cacheEntry->tileCacheIndex + t] = true;
+            }
+            cacheEntry->tileChecksumVerified = false;
+            entries.push_back(cacheEntry);
+            continue;
+        }
+
+        // The entry was not done computing or cannot be read by this version: remove it.
+        // Do not use deallocateCacheEntryImpl() since the LRU list and free tiles are rebuilt below.
+        for (ExternalSegmentTypeHandleList::const_iterator it = cacheEntry->entryDataPointerList.begin(); it != cacheEntry->entryDataPointerList.end(); ++it) {
+            void* bufPtr = tocFileManager->get_address_from_handle(*it);
+            if (bufPtr) {
+                tocFileManager->destroy_ptr(bufPtr);
+            }
+        }
+        cacheEntry->entryDataPointerList.clear();
+        if (cacheEntry->lruIterator) {
+            tocFileManager->destroy_ptr(cacheEntry->lruIterator.get());
+            cacheEntry->lruIterator = 0;
+        }
+        tocFileManager->destroy<MemorySegmentEntryHeader>(entriesHash[i].c_str());
+    }
+
+    // Rebuild the free tiles
+    ipc->freeTiles.clear();
+    for (std::size_t i = 0; i < nTiles; ++i) {
+        if (!allocatedTiles[i]) {
+            ipc->freeTiles.insert(i);
+        }
+    }
+
+    // Rebuild the LRU list: keep the order of the previous list for the nodes that are still valid
+    // and append the others. The previous list may be corrupted if a process crashed whilst moving a node.
+    std::set<LRUListNode*> remainingNodes;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        remainingNodes.insert(entries[i]->lruIterator.get());
+    }
+    std::vector<LRUListNode*> orderedNodes;
+    orderedNodes.reserve(entries.size());
+    {
+        LRUListNode* node = ipc->lruListFront.get();
+        while (node && orderedNodes.size() < entries.size()) {
+            std::set<LRUListNode*>::iterator found = remainingNodes.find(node);
+            if (found == remainingNodes.end()) {
+                // Not a node of a valid entry or already visited: the rest of the list cannot be trusted
+                break;
+            }
+            remainingNodes.erase(found);
+            orderedNodes.push_back(node);
+            node = node->next.get();
+        }
+    }
+    orderedNodes.insert(orderedNodes.end(), remainingNodes.begin(), remainingNodes.end());
+
+    ipc->lruListFront = 0;
+    ipc->lruListBack = 0;
+    for (std::size_t i = 0; i < orderedNodes.size(); ++i) {
+        bip::offset_ptr<LRUListNode> node(orderedNodes[i]);
+        node->prev = 0;
+        node->next = 0;
+        if (!ipc->lruListBack) {
+            ipc->lruListFront = node;
+        } else {
+            insertLinkedListNode(node, ipc->lruListBack, bip::offset_ptr<LRUListNode>(0));
+        }
+        ipc->lruListBack = node;
+    }
+
+    return true;
+} // restoreFromDisk
+
+void
+CacheBucket::clearFiles(WriteLock& tocWriteLock, WriteLock& tileWriteLock)
+{
+    // Private - the tocData.segmentMutex and tileData.segmentMutex are assumed to be taken for write lock
+
+    // Close and re-create the memory mapped files
+    {
+        std::string tocFilePath = tocFile->path();
+        tocFile->remove();
+        tocFile->open(tocFilePath, MemoryFile::eFileOpenModeOpenTruncateOrCreate);
+
+        ensureToCFileMappingValid(tocWriteLock, 0);
+    }
+    {
+        std::string tileFilePath = tileAlignedFile->path();
+        tileAlignedFile->remove();
+        tileAlignedFile->open(tileFilePath, MemoryFile::eFileOpenModeOpenTruncateOrCreate);
+
+        ensureTileMappingValid(tileWriteLock, 0);
+    }
+} // clearFiles
+
 /*
  helper function to do thread sleeps, since usleep()/nanosleep()
  aren't reliable enough (in terms of behavior and availability)
@@ -1516,34 +2053,110 @@ CacheEntryLocker::lookupAndSetStatus(boost::scoped_ptr<SharedMemoryReader>& shmA
             }
 
             // Now we are the only thread in this portion.
+            _imp->constructPendingEntry();
+        } // writeLock
+    } // upgradableLock
+    // Concurrency resumes here!
+
+} // lookupAndSetStatus
 
-            // Create the MemorySegmentEntry if it does not exist
-            void_allocator allocator(_imp->bucket->tocFileManager->get_segment_manager());
+void
+CacheEntryLockerPrivate::constructPendingEntry()
+{
+    ToCJournalWriteScope journalScope(bucket);
+
+    // Create the MemorySegmentEntry if it does not exist
+    void_allocator allocator(bucket->tocFileManager->get_segment_manager());
 #ifdef CACHE_TRACE_ENTRY_ACCESS
-            qDebug() << _imp->hashStr.c_str() << ": construct entry";
+    qDebug() << hashStr.c_str() << ": construct entry";
 #endif
-            MemorySegmentEntryHeader* cacheEntry = _imp->bucket->tocFileManager->construct<MemorySegmentEntryHeader>(_imp->hashStr.c_str())(allocator);
-            cacheEntry->pluginID.append(_imp->processLocalEntry->getKey()->getHolderPluginID().c_str());
+    MemorySegmentEntryHeader* cacheEntry = bucket->tocFileManager->construct<MemorySegmentEntryHeader>(hashStr.c_str())(allocator);
+    cacheEntry->pluginID.append(processLocalEntry->getKey()->getHolderPluginID().c_str());
 
-            cacheEntry->version = NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION;
+    cacheEntry->version = NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION;
 
-            // Lock the statusMutex: this will lock-out other threads interested in this entry.
-            // This mutex is unlocked in deallocateCacheEntryImpl() or in insertInCache()
-            // We must get the lock since we are the first thread to create it and we own the write lock on the segmentMutex
+    assert(cacheEntry->status == MemorySegmentEntryHeader::eEntryStatusNull);
 
+    // Set the status of the entry to pending because we (this thread) are going to compute it.
+    // Other fields of the entry will be set once it is done computed in insertInCache()
+    cacheEntry->status = MemorySegmentEntryHeader::eEntryStatusPending;
+} // constructPendingEntry
 
-            assert(cacheEntry->status == MemorySegmentEntryHeader::eEntryStatusNull);
+void
+CacheEntryLocker::lookupBatchAndSetStatusInBucket(const std::vector<CacheEntryLocker*>& lockers, boost::scoped_ptr<SharedMemoryReader>& shmAccess)
+{
+    assert(!lockers.empty());
+    CacheBucket* bucket = lockers[0]->_imp->bucket;
+    CachePrivate* cacheImp = lockers[0]->_imp->cache->_imp.get();
 
-            // Set the status of the entry to pending because we (this thread) are going to compute it.
-            // Other fields of the entry will be set once it is done computed in insertInCache()
-            cacheEntry->status = MemorySegmentEntryHeader::eEntryStatusPending;
+    // The lockers that could not be resolved under the read lock
+    std::vector<CacheEntryLocker*> lockersNeedingWriteRights;
+    {
+        // Take the read lock: many threads/processes can try read at the same time
+        boost::scoped_ptr<ReadLock> readLock;
+        boost::scoped_ptr<WriteLock> writeLock;
+        bool gotLock = createTimedLock<ReadLock>(readLock, &cacheImp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex);
 
-            
-        } // writeLock
-    } // upgradableLock
-    // Concurrency resumes here!
+        // Every time we take the lock, we must ensure the memory mapping is ok
+        if (gotLock && !bucket->isToCFileMappingValid()) {
+            readLock.reset();
+            gotLock = createTimedLock<WriteLock>(writeLock, &cacheImp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex);
+            if (gotLock) {
+                bucket->ensureToCFileMappingValid(*writeLock, 0);
+            }
+        }
 
-} // lookupAndSetStatus
+        if (!gotLock) {
+            // Same as lookupAndSetStatus: the caller will have to call waitForPendingEntry()
+            for (std::size_t i = 0; i < lockers.size(); ++i) {
+                lockers[i]->_imp->status = eCacheEntryStatusComputationPending;
+            }
+            return;
+        }
+
+        for (std::size_t i = 0; i < lockers.size(); ++i) {
+            assert(lockers[i]->_imp->bucket == bucket);
+            if (!lockers[i]->lookupAndSetStatusInternal(false /*hasWriteRights*/, 0, INT_MAX)) {
+                lockersNeedingWriteRights.push_back(lockers[i]);
+            }
+        }
+    } // ReadLock(tocData.segmentMutex)
+
+    if (lockersNeedingWriteRights.empty()) {
+        return;
+    }
+
+    // Concurrency resumes!
+
+    // Repeat the look-up of the remaining entries under the upgradable lock, see lookupAndSetStatus()
+    {
+        boost::scoped_ptr<UpgradableLock> upgradableLock;
+        createLockAndEnsureSHM<UpgradableLock>(cacheImp, shmAccess, upgradableLock, &cacheImp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex);
+
+        boost::scoped_ptr<WriteLock> writeLock;
+
+        // Every time we take the lock, we must ensure the memory mapping is ok
+        if (!bucket->isToCFileMappingValid()) {
+            writeLock.reset(new WriteLock(boost::move(*upgradableLock)));
+            bucket->ensureToCFileMappingValid(*writeLock, 0);
+        }
+
+        for (std::size_t i = 0; i < lockersNeedingWriteRights.size(); ++i) {
+            CacheEntryLocker* locker = lockersNeedingWriteRights[i];
+            if (locker->lookupAndSetStatusInternal(true /*hasWriteRights*/, 0, INT_MAX)) {
+                continue;
+            }
+            assert(locker->_imp->status == eCacheEntryStatusMustCompute);
+
+            // Upgrade the lock to a write lock the first time an entry must be created and keep it
+            // for the remaining entries.
+            if (!writeLock) {
+                writeLock.reset(new WriteLock(boost::move(*upgradableLock)));
+            }
+            locker->_imp->constructPendingEntry();
+        }
+    } // upgradableLock
+} // lookupBatchAndSetStatusInBucket
 
 CacheEntryBasePtr
 CacheEntryLocker::getProcessLocalEntry() const
@@ -1560,10 +2173,15 @@ CacheEntryLocker::getStatus() const
 void
 CacheEntryLocker::insertInCache()
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryCache, "CacheInsert");
+
     // The entry should only be computed and inserted in the cache if the status
     // of the object was eCacheEntryStatusMustCompute
     assert(_imp->status == eCacheEntryStatusMustCompute);
 
+    // Checksum the tile before locking the bucket
+    _imp->computeProcessLocalTileChecksum();
+
     // Public function, the SHM must not be locked.
     boost::scoped_ptr<SharedMemoryReader> shmAccess(new SharedMemoryReader(_imp->cache->_imp.get()));
 
@@ -1572,138 +2190,235 @@ CacheEntryLocker::insertInCache()
         boost::scoped_ptr<WriteLock> writeLock;
         createLockAndEnsureSHM<WriteLock>(_imp->cache->_imp.get(), shmAccess, writeLock, &_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tocData.segmentMutex);
 
-        // Ensure the memory mapping is ok. We grow the file so it contains at least the size needed by the entry
-        // plus some metadatas required management algorithm store its own memory housekeeping data.
-        const std::size_t entrySize = _imp->processLocalEntry->getMetadataSize();
-        if (!_imp->bucket->isToCFileMappingValid()) {
-            _imp->bucket->ensureToCFileMappingValid(*writeLock, entrySize);
+        _imp->insertInCacheUnderWriteLock(*writeLock);
+    } // writeLock
+
+    // Concurrency resumes!
+    
+} // insertInCache
+
+void
+CacheEntryLocker::insertBatchInCache(const std::vector<CacheEntryLockerPtr>& lockers)
+{
+    RenderTraceScope traceScope(kRenderTraceCategoryCache, "CacheBatchInsert");
+
+    // For each locker that must be inserted, the index of its bucket and its index in the lockers vector
+    std::vector<std::pair<int, std::size_t> > bucketOrder;
+    for (std::size_t i = 0; i < lockers.size(); ++i) {
+        if (!lockers[i] || lockers[i]->_imp->status != eCacheEntryStatusMustCompute) {
+            continue;
         }
-        
+        bucketOrder.push_back(std::make_pair(lockers[i]->_imp->bucket->bucketIndex, i));
 
-        // Fetch the entry. It must be here!
-        MemorySegmentEntryHeader* cacheEntry = _imp->bucket->tryCacheLookupImpl(_imp->hashStr);
-        assert(cacheEntry);
-        if (!cacheEntry) {
-            throw std::logic_error("CacheEntryLocker::insertInCache");
+        // Checksum the tile before locking the bucket
+        lockers[i]->_imp->computeProcessLocalTileChecksum();
+    }
+    if (bucketOrder.empty()) {
+        return;
+    }
+
+    // Sort by bucket so that entries of the same bucket are inserted under the same lock
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), bucketIndexLess);
+
+    CachePrivate* cacheImp = lockers[bucketOrder[0].second]->_imp->cache->_imp.get();
+
+    // Public function, the SHM must not be locked.
+    boost::scoped_ptr<SharedMemoryReader> shmAccess(new SharedMemoryReader(cacheImp));
+
+    std::size_t i = 0;
+    while (i < bucketOrder.size()) {
+        const int bucketIndex = bucketOrder[i].first;
+
+        // Take write lock on the bucket
+        boost::scoped_ptr<WriteLock> writeLock;
+        createLockAndEnsureSHM<WriteLock>(cacheImp, shmAccess, writeLock, &cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
+
+        for (; i < bucketOrder.size() && bucketOrder[i].first == bucketIndex; ++i) {
+            const CacheEntryLockerPtr& locker = lockers[bucketOrder[i].second];
+            assert(locker->_imp->cache->_imp.get() == cacheImp);
+            locker->_imp->insertInCacheUnderWriteLock(*writeLock);
         }
+    } // for each bucket
 
-        // The status of the memory segment entry should be pending because we are the thread computing it.
-        // All other threads are waiting.
-        assert(cacheEntry->status == MemorySegmentEntryHeader::eEntryStatusPending);
+    // Concurrency resumes!
 
-        // The cacheEntry fields should be uninitialized
-        // This may throw an exception if out of memory or if the getMetadataSize function does not return
-        // enough memory to encode all the data.
-        try {
+} // insertBatchInCache
 
-            // Allocate memory for the entry metadatas
-            cacheEntry->size = entrySize;
+void
+CacheEntryLockerPrivate::computeProcessLocalTileChecksum()
+{
+    if (!processLocalEntry->isStorageTiled()) {
+        return;
+    }
+    const char* tileData = (const char*)processLocalEntry->getTileData();
+    assert(tileData);
+    if (!tileData) {
+        return;
+    }
+    tileChecksum = computeTileChecksum(tileData, processLocalEntry->getTileSizeClass());
+} // computeProcessLocalTileChecksum
 
+void
+CacheEntryLockerPrivate::insertInCacheUnderWriteLock(WriteLock& writeLock)
+{
+    assert(status == CacheEntryLocker::eCacheEntryStatusMustCompute);
 
-            // Serialize the meta-datas in the memory segment
-            // If the entry also requires tile aligned data storage, allocate a tile now
-            {
-                boost::scoped_ptr<ReadLock> tileReadLock;
-                boost::scoped_ptr<WriteLock> tileWriteLock;
-                char* tileDataPtr = 0;
-                if (_imp->processLocalEntry->isStorageTiled()) {
-                    // First try to check if the tile aligned mapping is valid with a readlock
-                    bool tileMappingValid;
-
-                    {
-                        createLockNoTimeout<ReadLock>(tileReadLock, &_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tileData.segmentMutex);
-
-                        tileMappingValid = _imp->bucket->isTileFileMappingValid();
-                        if (tileMappingValid) {
-                            // Check that there's at least one free tile
-                            tileMappingValid = _imp->bucket->ipc->freeTiles.size() > 0;
-                        }
-                    }
+    // Ensure the memory mapping is ok. We grow the file so it contains at least the size needed by the entry
+    // plus some metadatas required management algorithm store its own memory housekeeping data.
+    const std::size_t entrySize = processLocalEntry->getMetadataSize();
+    if (!bucket->isToCFileMappingValid()) {
+        bucket->ensureToCFileMappingValid(writeLock, entrySize);
+    }
+    
+
+    // Fetch the entry. It must be here!
+    MemorySegmentEntryHeader* cacheEntry = bucket->tryCacheLookupImpl(hashStr);
+    assert(cacheEntry);
+    if (!cacheEntry) {
+        throw std::logic_error("CacheEntryLocker::insertInCache");
+    }
 
-                    // No free tiles or mapping invalid, remap and grow if necessary.
-                    if (!tileMappingValid) {
-                        // If the tile mapping is invalid, take a write lock on the tile mapping and ensure it is valid
-                        tileReadLock.reset();
-                        createLockNoTimeout<WriteLock>(tileWriteLock, &_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tileData.segmentMutex);
+    // The status of the memory segment entry should be pending because we are the thread computing it.
+    // All other threads are waiting.
+    assert(cacheEntry->status == MemorySegmentEntryHeader::eEntryStatusPending);
 
+    ToCJournalWriteScope journalScope(bucket);
 
-                        _imp->bucket->ensureTileMappingValid(*tileWriteLock, NATRON_TILE_SIZE_BYTES);
+    // The cacheEntry fields should be uninitialized
+    // This may throw an exception if out of memory or if the getMetadataSize function does not return
+    // enough memory to encode all the data.
+    try {
+
+        // Allocate memory for the entry metadatas
+        cacheEntry->size = entrySize;
+
+
+        // Serialize the meta-datas in the memory segment
+        // If the entry also requires tile aligned data storage, allocate a tile now
+        {
+            boost::scoped_ptr<ReadLock> tileReadLock;
+            boost::scoped_ptr<WriteLock> tileWriteLock;
+            char* tileDataPtr = 0;
+            if (processLocalEntry->isStorageTiled()) {
+                // First try to check if the tile aligned mapping is valid with a readlock
+                bool tileMappingValid;
+
+                // A tile of size class N spans pow(2, N) contiguous tiles of the file
+                const int tileSizeClass = processLocalEntry->getTileSizeClass();
+                assert(tileSizeClass >= 0 && tileSizeClass < NATRON_TILE_SIZE_CLASSES_COUNT);
+                const std::size_t nTilesToAllocate = getNTilesForSizeClass(tileSizeClass);
+                int freeTileIndex = -1;
+                {
+                    createLockNoTimeout<ReadLock>(tileReadLock, &cache->_imp->ipc->bucketsData[bucket->bucketIndex].tileData.segmentMutex);
+
+                    tileMappingValid = bucket->isTileFileMappingValid();
+                    if (tileMappingValid) {
+                        // The free tiles are protected by the tocData.segmentMutex which is taken for write lock
+                        freeTileIndex = bucket->allocateTiles(nTilesToAllocate);
                     }
-                    assert(_imp->bucket->ipc->freeTiles.size() > 0);
-                    int freeTileIndex;
-                    {
-                        set_size_t_ExternalSegment::iterator freeTileIt = _imp->bucket->ipc->freeTiles.begin();
-                        freeTileIndex = *freeTileIt;
-                        _imp->bucket->ipc->freeTiles.erase(freeTileIt);
-#ifdef CACHE_TRACE_TILES_ALLOCATION
-                        qDebug() << "Bucket" << _imp->bucket->bucketIndex << ": removing tile" << freeTileIndex << " Nb free tiles left:" << _imp->bucket->ipc->freeTiles.size();
-#endif
+                }
+
+                // No contiguous free tiles: if the file is already as big as the cache budget allows, make room
+                // by evicting the least recently used entries of the bucket rather than growing it.
+                // Entries are deallocated under the tile write lock: the read lock must be released first.
+                if (freeTileIndex == -1) {
+                    tileReadLock.reset();
+                    if (tileMappingValid) {
+                        freeTileIndex = bucket->evictEntriesToAllocateTiles(nTilesToAllocate);
+                        if (freeTileIndex != -1) {
+                            // Hold the read lock while writing to the tile. The mapping remains valid: it is only
+                            // grown under the tocData.segmentMutex write lock which we hold.
+                            createLockNoTimeout<ReadLock>(tileReadLock, &cache->_imp->ipc->bucketsData[bucket->bucketIndex].tileData.segmentMutex);
+                        }
                     }
-                    tileDataPtr = _imp->bucket->tileAlignedFile->data() + freeTileIndex * NATRON_TILE_SIZE_BYTES;
+                }
 
-                    // Set the tile index on the entry so we can free it afterwards.
-                    cacheEntry->tileCacheIndex = freeTileIndex;
-                } // tileWriteLock
-                
-                
-                _imp->processLocalEntry->toMemorySegment(_imp->bucket->tocFileManager.get(), _imp->hashStr + "Data", &cacheEntry->entryDataPointerList, tileDataPtr);
+                // No free tiles or mapping invalid, remap and grow if necessary.
+                if (freeTileIndex == -1) {
+                    // If the tile mapping is invalid, take a write lock on the tile mapping and ensure it is valid
+                    createLockNoTimeout<WriteLock>(tileWriteLock, &cache->_imp->ipc->bucketsData[bucket->bucketIndex].tileData.segmentMutex);
+
+                    const std::size_t tileSizeBytes = Cache::getTileSizeBytes(tileSizeClass);
+                    bucket->ensureTileMappingValid(*tileWriteLock, tileSizeBytes);
+                    freeTileIndex = bucket->allocateTiles(nTilesToAllocate);
+                    if (freeTileIndex == -1) {
+                        // There are enough free tiles but they are not contiguous: grow the file. The file grows by a
+                        // multiple of NATRON_CACHE_FILE_GROW_N_TILES tiles, the new tiles are thus aligned for all classes.
+                        bucket->growTileFile(*tileWriteLock, tileSizeBytes);
+                        freeTileIndex = bucket->allocateTiles(nTilesToAllocate);
+                    }
+                }
+                assert(freeTileIndex != -1);
+                if (freeTileIndex == -1) {
+                    throw std::bad_alloc();
+                }
+                tileDataPtr = bucket->tileAlignedFile->data() + freeTileIndex * NATRON_TILE_SIZE_BYTES;
 
+                // Set the tile index on the entry so we can free it afterwards.
+                cacheEntry->tileCacheIndex = freeTileIndex;
+                cacheEntry->tileSizeClass = tileSizeClass;
+            } // tileWriteLock
+            
+            
+            processLocalEntry->toMemorySegment(bucket->tocFileManager.get(), hashStr + "Data", &cacheEntry->entryDataPointerList, tileDataPtr);
+
+            if (tileDataPtr) {
+                // The checksum was computed from the process local data before taking the locks
+                cacheEntry->tileChecksum = tileChecksum;
+                cacheEntry->tileChecksumVerified = true;
             }
+        }
 
 
-            // Insert the hash in the LRU linked list
-            // Lock the LRU list mutex
-            {
-                boost::scoped_ptr<bip::scoped_lock<bip::interprocess_mutex> > lruWriteLock;
-                createLockNoTimeout<bip::scoped_lock<bip::interprocess_mutex> >(lruWriteLock, &_imp->bucket->ipc->lruListMutex);
-
-
-                cacheEntry->lruIterator = _imp->bucket->tocFileManager->construct<LRUListNode>(bip::anonymous_instance)();
-                cacheEntry->lruIterator->prev = 0;
-                cacheEntry->lruIterator->next = 0;
-                cacheEntry->lruIterator->hash = _imp->processLocalEntry->getHashKey();
-
-                if (!_imp->bucket->ipc->lruListBack) {
-                    assert(!_imp->bucket->ipc->lruListFront);
-                    // The list is empty, initialize to this node
-                    _imp->bucket->ipc->lruListFront = cacheEntry->lruIterator;
-                    _imp->bucket->ipc->lruListBack = cacheEntry->lruIterator;
-                    assert(!_imp->bucket->ipc->lruListFront->prev && !_imp->bucket->ipc->lruListFront->next);
-                    assert(!_imp->bucket->ipc->lruListBack->prev && !_imp->bucket->ipc->lruListBack->next);
-                } else {
-                    // Append to the tail of the list
-                    assert(_imp->bucket->ipc->lruListFront && _imp->bucket->ipc->lruListBack);
-
-                    insertLinkedListNode(cacheEntry->lruIterator, _imp->bucket->ipc->lruListBack, bip::offset_ptr<LRUListNode>(0));
-                    // Update back node
-                    _imp->bucket->ipc->lruListBack = cacheEntry->lruIterator;
-                    
-                }
-            } // lruWriteLock
-            cacheEntry->status = MemorySegmentEntryHeader::eEntryStatusReady;
+        // Insert the hash in the LRU linked list
+        // Lock the LRU list mutex
+        {
+            boost::scoped_ptr<bip::scoped_lock<bip::interprocess_mutex> > lruWriteLock;
+            createLockNoTimeout<bip::scoped_lock<bip::interprocess_mutex> >(lruWriteLock, &bucket->ipc->lruListMutex);
 
-            _imp->status = eCacheEntryStatusCached;
 
-#ifdef CACHE_TRACE_ENTRY_ACCESS
-            qDebug() << _imp->hashStr.c_str() << ": entry inserted in cache";
-#endif
+            cacheEntry->lruIterator = bucket->tocFileManager->construct<LRUListNode>(bip::anonymous_instance)();
+            cacheEntry->lruIterator->prev = 0;
+            cacheEntry->lruIterator->next = 0;
+            cacheEntry->lruIterator->hash = processLocalEntry->getHashKey();
 
-        } catch (...) {
+            if (!bucket->ipc->lruListBack) {
+                assert(!bucket->ipc->lruListFront);
+                // The list is empty, initialize to this node
+                bucket->ipc->lruListFront = cacheEntry->lruIterator;
+                bucket->ipc->lruListBack = cacheEntry->lruIterator;
+                assert(!bucket->ipc->lruListFront->prev && !bucket->ipc->lruListFront->next);
+                assert(!bucket->ipc->lruListBack->prev && !bucket->ipc->lruListBack->next);
+            } else {
+                // Append to the tail of the list
+                assert(bucket->ipc->lruListFront && bucket->ipc->lruListBack);
 
-            // Set the status to eCacheEntryStatusMustCompute so that the destructor deallocates the entry.
-            _imp->status = eCacheEntryStatusMustCompute;
-        }
+                insertLinkedListNode(cacheEntry->lruIterator, bucket->ipc->lruListBack, bip::offset_ptr<LRUListNode>(0));
+                // Update back node
+                bucket->ipc->lruListBack = cacheEntry->lruIterator;
+                
+            }
+        } // lruWriteLock
+        cacheEntry->status = MemorySegmentEntryHeader::eEntryStatusReady;
 
+        status = CacheEntryLocker::eCacheEntryStatusCached;
 
-    } // writeLock
+#ifdef CACHE_TRACE_ENTRY_ACCESS
+        qDebug() << hashStr.c_str() << ": entry inserted in cache";
+#endif
 
-    // Concurrency resumes!
-    
-} // insertInCache
+    } catch (...) {
+
+        // Set the status to eCacheEntryStatusMustCompute so that the destructor deallocates the entry.
+        status = CacheEntryLocker::eCacheEntryStatusMustCompute;
+    }
+} // insertInCacheUnderWriteLock
 
 CacheEntryLocker::CacheEntryStatusEnum
 CacheEntryLocker::waitForPendingEntry(std::size_t timeout)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryCache, "WaitForPendingEntry");
+
     // Public function, the SHM must not be locked.
     boost::scoped_ptr<SharedMemoryReader> shmAccess(new SharedMemoryReader(_imp->cache->_imp.get()));
 
@@ -1916,13 +2631,12 @@ Cache::create()
         
     }
 
-    if (gotFileLock) {
-        ret->_imp->globalMemorySegmentFileLock->unlock();
+    if (!gotFileLock) {
+        // Indicate that we use the shared memory by taking the file lock in read mode.
+        // If the process that created the shared memory is still restoring the buckets, this waits until it is done.
+        ret->_imp->globalMemorySegmentFileLock->lock_sharable();
     }
 
-    // Indicate that we use the shared memory by taking the file lock in read mode.
-    ret->_imp->globalMemorySegmentFileLock->try_lock_sharable();
-    
     // Open each bucket individual memory segment.
     // They are not created in shared memory but in a memory mapped file instead
     // to be persistent when the OS shutdown.
@@ -1973,6 +2687,41 @@ Cache::create()
 
     } // for each bucket
 
+    // If we are the first process to use the cache, the bucket files were left by a previous process
+    // that may have crashed: check that they can be re-used, otherwise start from an empty bucket.
+    // This is done while the file lock is still held in write mode, so that no other process may read
+    // the buckets before they are all restored.
+    if (gotFileLock) {
+        for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+            boost::scoped_ptr<WriteLock> tocWriteLock;
+            createLockAndEnsureSHM<WriteLock>(ret->_imp.get(), shmReader, tocWriteLock, &ret->_imp->ipc->bucketsData[i].tocData.segmentMutex);
+            if (!ret->_imp->buckets[i].isToCFileMappingValid()) {
+                ret->_imp->buckets[i].ensureToCFileMappingValid(*tocWriteLock, 0);
+            }
+
+            boost::scoped_ptr<WriteLock> tileWriteLock;
+            createLockAndEnsureSHM<WriteLock>(ret->_imp.get(), shmReader, tileWriteLock, &ret->_imp->ipc->bucketsData[i].tileData.segmentMutex);
+            if (!ret->_imp->buckets[i].isTileFileMappingValid()) {
+                ret->_imp->buckets[i].ensureTileMappingValid(*tileWriteLock, 0);
+            }
+
+            bool restored;
+            try {
+                restored = ret->_imp->buckets[i].restoreFromDisk();
+            } catch (...) {
+                restored = false;
+            }
+            if (!restored) {
+                ret->_imp->buckets[i].clearFiles(*tocWriteLock, *tileWriteLock);
+            }
+        } // for each bucket
+
+        ret->_imp->globalMemorySegmentFileLock->unlock();
+
+        // Indicate that we use the shared memory by taking the file lock in read mode.
+        ret->_imp->globalMemorySegmentFileLock->try_lock_sharable();
+    }
+
 
     return ret;
 } // create
@@ -2114,12 +2863,12 @@ Cache::setMaximumCacheSize(StorageModeEnum storage, std::size_t size)
             case eStorageModeDisk:
                 _imp->maximumDiskSize = size;
                 break;
-            case eStorageModeGLTex:
+            case eStorageModeRAM:
                 _imp->maximumInMemorySize = size;
                 break;
-            case eStorageModeRAM: {
+            case eStorageModeGLTex:
                 _imp->maximumGLTextureSize = size;
-            }   break;
+                break;
             case eStorageModeNone:
                 assert(false);
                 break;
@@ -2141,9 +2890,9 @@ Cache::getMaximumCacheSize(StorageModeEnum storage) const
         switch (storage) {
             case eStorageModeDisk:
                 return _imp->maximumDiskSize;
-            case eStorageModeGLTex:
-                return _imp->maximumInMemorySize;
             case eStorageModeRAM:
+                return _imp->maximumInMemorySize;
+            case eStorageModeGLTex:
                 return _imp->maximumGLTextureSize;
             case eStorageModeNone:
                 return 0;
@@ -2165,10 +2914,10 @@ Cache::getCurrentSize(StorageModeEnum storage) const
         case eStorageModeDisk:
             return _imp->ipc->diskSize;
             break;
-        case eStorageModeGLTex:
+        case eStorageModeRAM:
             return _imp->ipc->memorySize;
             break;
-        case eStorageModeRAM:
+        case eStorageModeGLTex:
             return _imp->ipc->glTextureSize;
             break;
         case eStorageModeNone:
@@ -2294,8 +3043,9 @@ Cache::getCacheDirectoryPath() const
 
 
 void
-Cache::getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty)
+Cache::getTileSizePx(ImageBitDepthEnum bitdepth, int tileSizeClass, int *tx, int *ty)
 {
+    assert(tileSizeClass >= 0 && tileSizeClass < NATRON_TILE_SIZE_CLASSES_COUNT);
     switch (bitdepth) {
         case eImageBitDepthByte:
             *tx = NATRON_TILE_SIZE_X_8_BIT;
@@ -2314,8 +3064,51 @@ Cache::getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty)
             *tx = *ty = 0;
             break;
     }
+    // Double the width on odd classes and the height on even classes
+    *tx <<= (tileSizeClass + 1) / 2;
+    *ty <<= tileSizeClass / 2;
+} // getTileSizePx
+
+std::size_t
+Cache::getTileSizeBytes(int tileSizeClass)
+{
+    assert(tileSizeClass >= 0 && tileSizeClass < NATRON_TILE_SIZE_CLASSES_COUNT);
+    return (std::size_t)NATRON_TILE_SIZE_BYTES << tileSizeClass;
 }
 
+int
+Cache::getTileSizeClassForImage(ImageBitDepthEnum bitdepth, const RectI& bounds, int kernelFootprint)
+{
+    if ( bounds.isNull() || (bitdepth == eImageBitDepthNone) ) {
+        return 0;
+    }
+
+    // The smallest class for which the kernel border is a small fraction of a tile
+    int footprintClass = 0;
+    while (footprintClass < NATRON_TILE_SIZE_CLASSES_COUNT - 1) {
+        int tx, ty;
+        getTileSizePx(bitdepth, footprintClass, &tx, &ty);
+        if ( std::min(tx, ty) >= (double)kernelFootprint * NATRON_TILE_SIZE_KERNEL_FOOTPRINT_RATIO ) {
+            break;
+        }
+        ++footprintClass;
+    }
+
+    // The largest class for which the image still spans enough tiles
+    int maxClass = 0;
+    while (maxClass < NATRON_TILE_SIZE_CLASSES_COUNT - 1) {
+        int tx, ty;
+        getTileSizePx(bitdepth, maxClass + 1, &tx, &ty);
+        double nTiles = std::ceil( (double)bounds.width() / tx ) * std::ceil( (double)bounds.height() / ty );
+        if (nTiles < NATRON_TILE_SIZE_MIN_TILES_PER_IMAGE) {
+            break;
+        }
+        ++maxClass;
+    }
+
+    return std::min(std::max(NATRON_TILE_SIZE_DEFAULT_CLASS, footprintClass), maxClass);
+} // getTileSizeClassForImage
+
 QString
 CachePrivate::getBucketAbsoluteDirPath(int bucketIndex) const
 {
@@ -2336,6 +3129,19 @@ Cache::get(const CacheEntryBasePtr& entry) const
     return CacheEntryLocker::create(thisShared, entry);
 } // get
 
+void
+Cache::getBatch(const std::vector<CacheEntryBasePtr>& entries, std::vector<CacheEntryLockerPtr>* lockers) const
+{
+    CachePtr thisShared = boost::const_pointer_cast<Cache>(shared_from_this());
+    CacheEntryLocker::createBatch(thisShared, entries, lockers);
+} // getBatch
+
+void
+Cache::insertBatch(const std::vector<CacheEntryLockerPtr>& lockers)
+{
+    CacheEntryLocker::insertBatchInCache(lockers);
+} // insertBatch
+
 bool
 Cache::hasCacheEntryForHash(U64 hash) const
 {
@@ -2434,28 +3240,13 @@ Cache::clear()
     for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
         CacheBucket& bucket = _imp->buckets[bucket_i];
 
-        // Close and re-create the memory mapped files
-        {
-            boost::scoped_ptr<WriteLock> writeLock;
-            createLockAndEnsureSHM<WriteLock>(_imp.get(), shmReader, writeLock, &_imp->ipc->bucketsData[bucket_i].tocData.segmentMutex);
+        boost::scoped_ptr<WriteLock> tocWriteLock;
+        createLockAndEnsureSHM<WriteLock>(_imp.get(), shmReader, tocWriteLock, &_imp->ipc->bucketsData[bucket_i].tocData.segmentMutex);
 
-            std::string tocFilePath = bucket.tocFile->path();
-            bucket.tocFile->remove();
-            bucket.tocFile->open(tocFilePath, MemoryFile::eFileOpenModeOpenTruncateOrCreate);
+        boost::scoped_ptr<WriteLock> tileWriteLock;
+        createLockAndEnsureSHM<WriteLock>(_imp.get(), shmReader, tileWriteLock, &_imp->ipc->bucketsData[bucket_i].tileData.segmentMutex);
 
-            bucket.ensureToCFileMappingValid(*writeLock, 0);
-        }
-        {
-            boost::scoped_ptr<WriteLock> writeLock;
-            createLockAndEnsureSHM<WriteLock>(_imp.get(), shmReader, writeLock, &_imp->ipc->bucketsData[bucket_i].tileData.segmentMutex);
-
-            std::string tileFilePath = bucket.tileAlignedFile->path();
-            bucket.tileAlignedFile->remove();
-            bucket.tileAlignedFile->open(tileFilePath, MemoryFile::eFileOpenModeOpenTruncateOrCreate);
-
-
-            bucket.ensureTileMappingValid(*writeLock, 0);
-        }
+        bucket.clearFiles(*tocWriteLock, *tileWriteLock);
 
     } // for each bucket
 
@@ -2524,7 +3315,7 @@ Cache::evictLRUEntries(std::size_t nBytesToFree)
 
                         // Also decrease the size if this entry held a tile
                         if (cacheEntry->tileCacheIndex != -1) {
-                            curSize -= NATRON_TILE_SIZE_BYTES;
+                            curSize -= getTileSizeBytes(cacheEntry->tileSizeClass);
                         }
                         bucket.deallocateCacheEntryImpl(cacheEntry, hashStr);
                     }
@@ -2583,7 +3374,7 @@ Cache::getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const
                     ++entryData.nEntries;
                     entryData.nBytes += cacheEntry->size;
                     if (cacheEntry->tileCacheIndex != -1) {
-                        entryData.nBytes += NATRON_TILE_SIZE_BYTES;
+                        entryData.nBytes += getTileSizeBytes(cacheEntry->tileSizeClass);
                     }
                     
                 }
@@ -2630,7 +3421,7 @@ Cache::flushCacheOnDisk(bool async)
                 writeLockTile.reset(new WriteLock(_imp->ipc->bucketsData[bucket_i].tileData.segmentMutex));
 
                  // This function will flush for us.
-                bucket.ensureTileMappingValid(*writeLock, 0);
+                bucket.ensureTileMappingValid(*writeLockTile, 0);
             } else {
                 flushTileMapping(bucket.tileAlignedFile, bucket.ipc->freeTiles);
             }
@@ -68,6 +68,12 @@
 #define NATRON_TILE_SIZE_X_32_BIT 32
 #define NATRON_TILE_SIZE_Y_32_BIT 32
 
+// The tiles above are of size class 0. A tile of size class N has NATRON_TILE_SIZE_BYTES * pow(2, N) bytes:
+// its width is doubled on odd classes and its height on even classes, e.g: a 32 bit tile of class 1 is 64x32 pixels,
+// of class 2 is 64x64 pixels.
+// The largest tiles (class 6) are 256KB.
+#define NATRON_TILE_SIZE_CLASSES_COUNT 7
+
 // The name of the directory containing all buckets on disk
 #define NATRON_CACHE_DIRECTORY_NAME "Cache"
 
@@ -113,6 +119,10 @@ class CacheEntryLocker
 
     static CacheEntryLockerPtr create(const CachePtr& cache, const CacheEntryBasePtr& entry);
 
+    static void createBatch(const CachePtr& cache, const std::vector<CacheEntryBasePtr>& entries, std::vector<CacheEntryLockerPtr>* lockers);
+
+    static void insertBatchInCache(const std::vector<CacheEntryLockerPtr>& lockers);
+
 
 public:
 
@@ -174,6 +184,12 @@ private:
 
     void lookupAndSetStatus(boost::scoped_ptr<SharedMemoryReader>& shmAccess, std::size_t timeSpentWaitingForPendingEntryMS, std::size_t timeout);
 
+    /**
+     * @brief Same as lookupAndSetStatus for lockers that all belong to the same bucket: the bucket lock
+     * is taken once for all of them.
+     **/
+    static void lookupBatchAndSetStatusInBucket(const std::vector<CacheEntryLocker*>& lockers, boost::scoped_ptr<SharedMemoryReader>& shmAccess);
+
     boost::scoped_ptr<CacheEntryLockerPrivate> _imp;
 };
 
@@ -191,6 +207,7 @@ class Cache
     friend class ImageStorageBase;
 
     friend class CacheEntryLocker;
+    friend struct CacheEntryLockerPrivate;
     friend struct CacheBucket;
     
 private:
@@ -213,9 +230,24 @@ public:
     std::string getCacheDirectoryPath() const;
 
     /**
-     * @brief Returns the tile size (of one dimension) in pixels for the given bitdepth/
+     * @brief Returns the tile size (of one dimension) in pixels for the given bitdepth and tile size class.
+     **/
+    static void getTileSizePx(ImageBitDepthEnum bitdepth, int tileSizeClass, int *tx, int *ty);
+
+    /**
+     * @brief Returns the size in bytes of a tile of the given size class.
      **/
-    static void getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty);
+    static std::size_t getTileSizeBytes(int tileSizeClass);
+
+    /**
+     * @brief Returns the tile size class that should be used to cache an image of the given bounds and bitdepth.
+     * Larger tiles reduce the number of cache entries of an image, but smaller tiles waste less
+     * memory and render time when only a portion of the image is requested.
+     * @param kernelFootprint How far, in pixels, the effect producing the image reads its inputs beyond the
+     * pixel it renders, e.g: the radius of a blur. The tiles are made large enough for this border to only be a
+     * fraction of a tile.
+     **/
+    static int getTileSizeClassForImage(ImageBitDepthEnum bitdepth, const RectI& bounds, int kernelFootprint);
 
     /**
      * @brief Set the maximum cache size available for the given storage.
@@ -250,6 +282,22 @@ public:
      **/
     CacheEntryLockerPtr get(const CacheEntryBasePtr& entry) const;
 
+    /**
+     * @brief Same as get() for several entries at once. The entries are sorted by bucket and
+     * the lock of each bucket is taken once for all the entries it contains, instead of once per entry.
+     * On return, lockers contains for each entry, in the same order, a locker indicating the
+     * status of the entry: cached, must compute or pending.
+     * All entries must have a different hash.
+     **/
+    void getBatch(const std::vector<CacheEntryBasePtr>& entries, std::vector<CacheEntryLockerPtr>* lockers) const;
+
+    /**
+     * @brief Calls CacheEntryLocker::insertInCache() on all lockers that have the status eCacheEntryStatusMustCompute.
+     * The lock of each bucket is taken once for all the entries it contains.
+     * Other lockers are ignored.
+     **/
+    void insertBatch(const std::vector<CacheEntryLockerPtr>& lockers);
+
     /**
      * @brief Returns whether a cache entry exists for the given hash.
      * This is significantly faster than the get() function but does not return the entry.
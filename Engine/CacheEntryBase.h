@@ -121,16 +121,33 @@ public:
     ViewIdx getView() const;
 
     /**
-     * @brief Returns whether the data storage of this entry is exactly the size of NATRON_TILE_SIZE_BYTES or not.
+     * @brief Returns whether the data storage of this entry is exactly the size of Cache::getTileSizeBytes(getTileSizeClass()) or not.
      * In this case, Natron optimizes the storage of the entry in a tile aligned memory mapped file.
      * If true the toMemorySegment and fromMemorySegment function will have their tileDataPtr set to 
-     * a non null value. The implementation should then copy from/to the data exactly NATRON_TILE_SIZE_BYTES bytes.
+     * a non null value. The implementation should then copy from/to the data exactly Cache::getTileSizeBytes(getTileSizeClass()) bytes.
      **/
     virtual bool isStorageTiled() const
     {
         return false;
     }
 
+    /**
+     * @brief If isStorageTiled() returns true, the size class of the tile, between 0 and NATRON_TILE_SIZE_CLASSES_COUNT - 1.
+     **/
+    virtual int getTileSizeClass() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief If isStorageTiled() returns true, the process local data that toMemorySegment copies to the tile.
+     * The cache uses it to compute the checksum of the tile before taking any lock.
+     **/
+    virtual const void* getTileData() const
+    {
+        return 0;
+    }
+
     /**
      * @brief Write this key to the process shared memory segment.
      * Each object written to the memory segment must have its handle appended 
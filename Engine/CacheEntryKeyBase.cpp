@@ -86,6 +86,14 @@ CacheEntryKeyBase::getHash() const
     
 }
 
+void
+CacheEntryKeyBase::setPrecomputedHash(U64 hash)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->hash = hash;
+    _imp->hashComputed = true;
+}
+
 std::string
 CacheEntryKeyBase::hashToString(U64 hash)
 {
@@ -158,6 +166,7 @@ struct ImageTileKeyShmData
     unsigned int mipMapLevel;
     bool draftMode;
     ImageBitDepthEnum bitdepth;
+    int tileSizeClass;
     int tileX;
     int tileY;
 
@@ -169,6 +178,7 @@ struct ImageTileKeyShmData
     , mipMapLevel(0)
     , draftMode(false)
     , bitdepth(eImageBitDepthNone)
+    , tileSizeClass(0)
     , tileX(0)
     , tileY(0)
     {
@@ -199,6 +209,7 @@ ImageTileKey::ImageTileKey(U64 nodeTimeInvariantHash,
                            unsigned int mipMapLevel,
                            bool draftMode,
                            ImageBitDepthEnum bitdepth,
+                           int tileSizeClass,
                            int tileX,
                            int tileY)
 : CacheEntryKeyBase()
@@ -212,6 +223,7 @@ ImageTileKey::ImageTileKey(U64 nodeTimeInvariantHash,
     _imp->data.mipMapLevel = mipMapLevel;
     _imp->data.draftMode = draftMode;
     _imp->data.bitdepth = bitdepth;
+    _imp->data.tileSizeClass = tileSizeClass;
     _imp->data.tileX = tileX;
     _imp->data.tileY = tileY;
 }
@@ -252,22 +264,67 @@ ImageTileKey::getUniqueID() const
     return kCacheKeyUniqueIDImageTile;
 }
 
+static void
+appendTileKeyPrefixToHash(U64 nodeTimeInvariantHash,
+                          TimeValue time,
+                          ViewIdx view,
+                          const std::string& layerChannel,
+                          const RenderScale& proxyScale,
+                          unsigned int mipMapLevel,
+                          bool draftMode,
+                          ImageBitDepthEnum bitdepth,
+                          int tileSizeClass,
+                          Hash64* hash)
+{
+    Hash64::appendQString(QString::fromUtf8(layerChannel.c_str()), hash);
+    hash->append(nodeTimeInvariantHash);
+    hash->append((double)time);
+    hash->append((int)view);
+    hash->append(proxyScale.x);
+    hash->append(proxyScale.y);
+    hash->append(mipMapLevel);
+    hash->append(draftMode);
+    hash->append((int)bitdepth);
+    hash->append(tileSizeClass);
+}
+
 void
 ImageTileKey::appendToHash(Hash64* hash) const
 {
-    Hash64::appendQString(QString::fromUtf8(_imp->layerChannel.c_str()), hash);
-    hash->append(_imp->data.nodeTimeInvariantHash);
-    hash->append((double)_imp->data.time);
-    hash->append((int)_imp->data.view);
-    hash->append(_imp->data.proxyScale.x);
-    hash->append(_imp->data.proxyScale.y);
-    hash->append(_imp->data.mipMapLevel);
-    hash->append(_imp->data.draftMode);
-    hash->append((int)_imp->data.bitdepth);
+    // The tile coordinates must be appended last, see computeTileHash
+    appendTileKeyPrefixToHash(_imp->data.nodeTimeInvariantHash, _imp->data.time, _imp->data.view, _imp->layerChannel, _imp->data.proxyScale, _imp->data.mipMapLevel, _imp->data.draftMode, _imp->data.bitdepth, _imp->data.tileSizeClass, hash);
     hash->append(_imp->data.tileX);
     hash->append(_imp->data.tileY);
 }
 
+U64
+ImageTileKey::computeTilesHashPrefixState(U64 nodeTimeInvariantHash,
+                                          TimeValue time,
+                                          ViewIdx view,
+                                          const std::string& layerChannel,
+                                          const RenderScale& proxyScale,
+                                          unsigned int mipMapLevel,
+                                          bool draftMode,
+                                          ImageBitDepthEnum bitdepth,
+                                          int tileSizeClass)
+{
+    // Same as CacheEntryKeyBase::getHash()
+    Hash64 hash;
+    hash.append(kCacheKeyUniqueIDImageTile);
+    appendTileKeyPrefixToHash(nodeTimeInvariantHash, time, view, layerChannel, proxyScale, mipMapLevel, draftMode, bitdepth, tileSizeClass, &hash);
+    return hash.getPrefixState();
+}
+
+U64
+ImageTileKey::computeTileHash(U64 tilesHashPrefixState, int tileX, int tileY)
+{
+    Hash64 hash;
+    hash.append(tileX);
+    hash.append(tileY);
+    hash.computeHashFromPrefixState(tilesHashPrefixState);
+    return hash.value();
+}
+
 std::string
 ImageTileKey::getLayerChannel() const
 {
@@ -310,6 +367,12 @@ ImageTileKey::getBitDepth() const
     return _imp->data.bitdepth;
 }
 
+int
+ImageTileKey::getTileSizeClass() const
+{
+    return _imp->data.tileSizeClass;
+}
+
 std::size_t
 ImageTileKey::getMetadataSize() const
 {
@@ -327,6 +390,7 @@ ImageTileKey::getMetadataSize() const
     ret += sizeof(_imp->data.mipMapLevel);
     ret += sizeof(_imp->data.draftMode);
     ret += sizeof(_imp->data.bitdepth);
+    ret += sizeof(_imp->data.tileSizeClass);
 
     return ret;
 }
@@ -358,6 +422,7 @@ ImageTileKey::toMemorySegment(ExternalSegmentType* segment, const std::string& o
     data->mipMapLevel = _imp->data.mipMapLevel;
     data->draftMode = _imp->data.draftMode;
     data->bitdepth = _imp->data.bitdepth;
+    data->tileSizeClass = _imp->data.tileSizeClass;
     layerChannel->append(_imp->layerChannel.c_str());
 
     CacheEntryKeyBase::toMemorySegment(segment, objectNamesPrefix, objectPointers);
@@ -385,6 +450,7 @@ ImageTileKey::fromMemorySegment(ExternalSegmentType* segment, const std::string&
     _imp->data.mipMapLevel = data->mipMapLevel;
     _imp->data.draftMode = data->draftMode;
     _imp->data.bitdepth = data->bitdepth;
+    _imp->data.tileSizeClass = data->tileSizeClass;
     _imp->layerChannel.clear();
     _imp->layerChannel.append(layersChannels->c_str());
 
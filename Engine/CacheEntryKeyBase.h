@@ -53,6 +53,7 @@ NATRON_NAMESPACE_ENTER;
 #define kCacheKeyUniqueIDGetComponentsResults 6
 #define kCacheKeyUniqueIDGetFrameRangeResults 7
 #define kCacheKeyUniqueIDExpressionResult 8
+#define kCacheKeyUniqueIDDistortionWarpGrid 9
 
 
 
@@ -104,6 +105,12 @@ public:
      **/
     U64 getHash() const;
 
+    /**
+     * @brief Set the hash of this key when it was computed by other means than getHash(), e.g: with
+     * ImageTileKey::computeTileHash. It must be equal to what getHash() would return.
+     **/
+    void setPrecomputedHash(U64 hash);
+
     static std::string hashToString(U64 hash);
 
     /**
@@ -168,6 +175,7 @@ public:
                  unsigned int mipMapLevel,
                  bool draftMode,
                  ImageBitDepthEnum bitdepth,
+                 int tileSizeClass,
                  int tileX,
                  int tileY);
 
@@ -189,6 +197,32 @@ public:
 
     ImageBitDepthEnum getBitDepth() const;
 
+    /**
+     * @brief The size class of the tile, see Cache::getTileSizePx
+     **/
+    int getTileSizeClass() const;
+
+    /**
+     * @brief Returns the checksum state of the hash of the keys of all tiles of the given image channel:
+     * everything but the tile coordinates. The hash of each tile key can then be obtained
+     * with computeTileHash without hashing again the channel name and the other parameters.
+     **/
+    static U64 computeTilesHashPrefixState(U64 nodeTimeInvariantHash,
+                                           TimeValue time,
+                                           ViewIdx view,
+                                           const std::string& layerChannel,
+                                           const RenderScale& proxyScale,
+                                           unsigned int mipMapLevel,
+                                           bool draftMode,
+                                           ImageBitDepthEnum bitdepth,
+                                           int tileSizeClass);
+
+    /**
+     * @brief Returns the same value as getHash() on a key for the given tile, from the state returned
+     * by computeTilesHashPrefixState.
+     **/
+    static U64 computeTileHash(U64 tilesHashPrefixState, int tileX, int tileY);
+
     virtual TimeValue getTime() const OVERRIDE FINAL;
 
     virtual ViewIdx getView() const OVERRIDE FINAL;
@@ -0,0 +1,377 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "CacheReuseStats.h"
+
+#include <map>
+#include <bitset>
+#include <sstream>
+#include <cassert>
+
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+#include "Global/StrUtils.h"
+
+#include "Engine/AppInstance.h"
+#include "Engine/FStreamsSupport.h"
+#include "Engine/Hash64.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+
+// Name of the file in the cache directory where the measures are saved
+#define NATRON_CACHE_REUSE_STATS_FILE_NAME "CacheReuseStats.txt"
+
+#define NATRON_CACHE_REUSE_STATS_FILE_HEADER "# Natron Cache Reuse Statistics"
+
+// Number of outputs written to the cache before the reuse ratio of a node is trusted
+#define NATRON_CACHE_REUSE_MIN_MEASURED_OUTPUTS 16
+
+// Below this number of reads per write, the outputs of a node are not worth caching
+#define NATRON_CACHE_REUSE_MIN_RATIO 0.1
+
+// Nodes taking longer than this to render a megapixel remain cached whatever their reuse ratio:
+// a single re-read saves more than the cost of caching all the other outputs.
+#define NATRON_CACHE_REUSE_EXPENSIVE_SECONDS_PER_MEGAPIXEL 0.1
+
+// Number of outputs rendered without the cache that are remembered for each node, to count the ones
+// rendered again that would have been read from the cache. Between 1 and 2 times this number of the last outputs
+// are remembered, enough for a looped playback of a long sequence.
+#define NATRON_CACHE_REUSE_RECENT_OUTPUTS 1024
+
+// Size in bits of each of the 2 Bloom filters remembering the outputs: with 4 bits set per output, about 1 output
+// in 200 is wrongly seen as rendered before. Each node uses 4KB whatever the number of outputs it renders.
+#define NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_BITS 16384
+#define NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES 4
+
+// Weight of the measures of the previous sessions when they are loaded
+#define NATRON_CACHE_REUSE_PREVIOUS_SESSIONS_WEIGHT 0.5
+
+// Nodes with less outputs measured than this are not saved
+#define NATRON_CACHE_REUSE_MIN_SAVED_OUTPUTS 1
+
+// The measures are split in this many maps, each with its own lock, so that renders of different nodes do not contend.
+// Must be a power of 2
+#define NATRON_CACHE_REUSE_STATS_SHARDS 16
+
+NATRON_NAMESPACE_ENTER;
+
+struct CacheReuseStatsEntry
+{
+    // Measures loaded from the previous sessions, already weighted
+    CacheReuseNodeStats previousSessions;
+
+    // Measures of this session
+    CacheReuseNodeStats session;
+
+    // Bloom filters of the last outputs rendered without the cache. New outputs go to the current filter,
+    // once it is full the other one is cleared and becomes the current one.
+    std::bitset<NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_BITS> recentUncachedOutputs[2];
+    int currentRecentOutputsFilter;
+    int nOutputsInCurrentFilter;
+
+    CacheReuseStatsEntry()
+    : previousSessions()
+    , session()
+    , currentRecentOutputsFilter(0)
+    , nOutputsInCurrentFilter(0)
+    {
+
+    }
+
+    static void getFilterBits(U64 outputHash, std::size_t bits[NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES])
+    {
+        // Mix the bits of the hash (splitmix64 finalizer), the caller may pass poorly distributed values
+        U64 h = outputHash;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h = h ^ (h >> 31);
+
+        // Derive the positions from 2 independent halves of the hash (Kirsch-Mitzenmacher)
+        const U64 h1 = h & 0xffffffffULL;
+        const U64 h2 = (h >> 32) | 1;
+        for (int i = 0; i < NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES; ++i) {
+            bits[i] = (std::size_t)( (h1 + i * h2) % NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_BITS );
+        }
+    }
+
+    bool filterContains(int filter_i, const std::size_t bits[NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES]) const
+    {
+        for (int i = 0; i < NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES; ++i) {
+            if ( !recentUncachedOutputs[filter_i].test(bits[i]) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Remember an output rendered without the cache. Returns true if it was already rendered recently,
+     * i.e: it would have been read from the cache.
+     **/
+    bool notifyUncachedOutput(U64 outputHash)
+    {
+        std::size_t bits[NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES];
+        getFilterBits(outputHash, bits);
+        if ( filterContains(0, bits) || filterContains(1, bits) ) {
+            return true;
+        }
+        if (nOutputsInCurrentFilter >= NATRON_CACHE_REUSE_RECENT_OUTPUTS) {
+            // Forget the oldest outputs
+            currentRecentOutputsFilter = 1 - currentRecentOutputsFilter;
+            recentUncachedOutputs[currentRecentOutputsFilter].reset();
+            nOutputsInCurrentFilter = 0;
+        }
+        for (int i = 0; i < NATRON_CACHE_REUSE_RECENT_OUTPUTS_FILTER_HASHES; ++i) {
+            recentUncachedOutputs[currentRecentOutputsFilter].set(bits[i]);
+        }
+        ++nOutputsInCurrentFilter;
+        return false;
+    }
+
+    CacheReuseNodeStats getTotal() const
+    {
+        CacheReuseNodeStats ret;
+        ret.nCachedWrites = previousSessions.nCachedWrites + session.nCachedWrites;
+        ret.nCachedReads = previousSessions.nCachedReads + session.nCachedReads;
+        ret.timeSpentRendering = previousSessions.timeSpentRendering + session.timeSpentRendering;
+        ret.nPixelsRendered = previousSessions.nPixelsRendered + session.nPixelsRendered;
+        return ret;
+    }
+};
+
+typedef std::map<U64, CacheReuseStatsEntry> CacheReuseStatsEntryMap;
+
+struct CacheReuseStatsShard
+{
+    mutable QMutex lock;
+
+    CacheReuseStatsEntryMap entries;
+
+    CacheReuseStatsShard()
+    : lock()
+    , entries()
+    {
+
+    }
+};
+
+struct CacheReuseStatsPrivate
+{
+    CacheReuseStatsShard shards[NATRON_CACHE_REUSE_STATS_SHARDS];
+
+    CacheReuseStatsPrivate()
+    {
+
+    }
+
+    // The node keys are hashes: their low bits spread the nodes across the shards
+    CacheReuseStatsShard& getShard(U64 nodeKey)
+    {
+        return shards[nodeKey & (NATRON_CACHE_REUSE_STATS_SHARDS - 1)];
+    }
+
+    const CacheReuseStatsShard& getShard(U64 nodeKey) const
+    {
+        return shards[nodeKey & (NATRON_CACHE_REUSE_STATS_SHARDS - 1)];
+    }
+};
+
+static std::string
+getStatsFilePath(const std::string& directoryPath)
+{
+    QString path = QString::fromUtf8( directoryPath.c_str() );
+    StrUtils::ensureLastPathSeparator(path);
+    path.append( QString::fromUtf8(NATRON_CACHE_REUSE_STATS_FILE_NAME) );
+    return path.toStdString();
+}
+
+CacheReuseStats::CacheReuseStats()
+: _imp( new CacheReuseStatsPrivate() )
+{
+
+}
+
+CacheReuseStats::~CacheReuseStats()
+{
+
+}
+
+U64
+CacheReuseStats::getNodeKey(const NodePtr& node)
+{
+    Hash64 hash;
+    Hash64::appendQString(QString::fromUtf8( node->getPluginID().c_str() ), &hash);
+    hash.append<unsigned short>(0);
+    Hash64::appendQString(QString::fromUtf8( node->getFullyQualifiedName().c_str() ), &hash);
+    hash.append<unsigned short>(0);
+    AppInstancePtr app = node->getApp();
+    if (app) {
+        Hash64::appendQString(app->getProject()->getProjectPath() + app->getProject()->getProjectFilename(), &hash);
+    }
+    hash.computeHash();
+    return hash.value();
+} // getNodeKey
+
+void
+CacheReuseStats::notifyOutputRendered(U64 nodeKey,
+                                      U64 outputHash,
+                                      bool cached,
+                                      double timeSpent,
+                                      double nPixels)
+{
+    CacheReuseStatsShard& shard = _imp->getShard(nodeKey);
+    QMutexLocker k(&shard.lock);
+    CacheReuseStatsEntry& entry = shard.entries[nodeKey];
+    CacheReuseNodeStats& stats = entry.session;
+    if (cached) {
+        stats.nCachedWrites += 1;
+    } else if ( entry.notifyUncachedOutput(outputHash) ) {
+        // Rendered again without the cache: had it been cached, it would have been written once and read since
+        stats.nCachedReads += 1;
+    } else {
+        stats.nCachedWrites += 1;
+    }
+    stats.timeSpentRendering += timeSpent;
+    stats.nPixelsRendered += nPixels;
+}
+
+void
+CacheReuseStats::notifyOutputReadFromCache(U64 nodeKey)
+{
+    CacheReuseStatsShard& shard = _imp->getShard(nodeKey);
+    QMutexLocker k(&shard.lock);
+    shard.entries[nodeKey].session.nCachedReads += 1;
+}
+
+bool
+CacheReuseStats::shouldBypassCache(U64 nodeKey,
+                                   double* reuseRatio)
+{
+    *reuseRatio = -1;
+
+    CacheReuseStatsShard& shard = _imp->getShard(nodeKey);
+    QMutexLocker k(&shard.lock);
+    CacheReuseStatsEntryMap::iterator found = shard.entries.find(nodeKey);
+    if ( found == shard.entries.end() ) {
+        return false;
+    }
+
+    CacheReuseNodeStats total = found->second.getTotal();
+    if (total.nCachedWrites < NATRON_CACHE_REUSE_MIN_MEASURED_OUTPUTS) {
+        return false;
+    }
+    *reuseRatio = total.nCachedReads / total.nCachedWrites;
+    if (*reuseRatio >= NATRON_CACHE_REUSE_MIN_RATIO) {
+        return false;
+    }
+    if (total.nPixelsRendered > 0) {
+        double secondsPerMegaPixel = total.timeSpentRendering * 1e6 / total.nPixelsRendered;
+        if (secondsPerMegaPixel >= NATRON_CACHE_REUSE_EXPENSIVE_SECONDS_PER_MEGAPIXEL) {
+            return false;
+        }
+    }
+    return true;
+} // shouldBypassCache
+
+bool
+CacheReuseStats::getNodeStats(U64 nodeKey,
+                              CacheReuseNodeStats* stats) const
+{
+    const CacheReuseStatsShard& shard = _imp->getShard(nodeKey);
+    QMutexLocker k(&shard.lock);
+    CacheReuseStatsEntryMap::const_iterator found = shard.entries.find(nodeKey);
+    if ( found == shard.entries.end() ) {
+        return false;
+    }
+    *stats = found->second.getTotal();
+    return true;
+}
+
+void
+CacheReuseStats::loadFromDirectory(const std::string& directoryPath)
+{
+    FStreamsSupport::ifstream ifile;
+    FStreamsSupport::open( &ifile, getStatsFilePath(directoryPath) );
+    if (!ifile) {
+        return;
+    }
+
+    std::string line;
+    if ( !std::getline(ifile, line) || (line != NATRON_CACHE_REUSE_STATS_FILE_HEADER) ) {
+        return;
+    }
+
+    while ( std::getline(ifile, line) ) {
+        std::stringstream ss(line);
+        U64 nodeKey;
+        CacheReuseNodeStats stats;
+        if ( !(ss >> nodeKey >> stats.nCachedWrites >> stats.nCachedReads >> stats.timeSpentRendering >> stats.nPixelsRendered) ) {
+            continue;
+        }
+        CacheReuseStatsShard& shard = _imp->getShard(nodeKey);
+        QMutexLocker k(&shard.lock);
+        CacheReuseNodeStats& previous = shard.entries[nodeKey].previousSessions;
+        previous.nCachedWrites = stats.nCachedWrites * NATRON_CACHE_REUSE_PREVIOUS_SESSIONS_WEIGHT;
+        previous.nCachedReads = stats.nCachedReads * NATRON_CACHE_REUSE_PREVIOUS_SESSIONS_WEIGHT;
+        previous.timeSpentRendering = stats.timeSpentRendering * NATRON_CACHE_REUSE_PREVIOUS_SESSIONS_WEIGHT;
+        previous.nPixelsRendered = stats.nPixelsRendered * NATRON_CACHE_REUSE_PREVIOUS_SESSIONS_WEIGHT;
+    }
+} // loadFromDirectory
+
+void
+CacheReuseStats::saveToDirectory(const std::string& directoryPath) const
+{
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open( &ofile, getStatsFilePath(directoryPath) );
+    if (!ofile) {
+        return;
+    }
+
+    ofile << NATRON_CACHE_REUSE_STATS_FILE_HEADER << std::endl;
+
+    for (int i = 0; i < NATRON_CACHE_REUSE_STATS_SHARDS; ++i) {
+        const CacheReuseStatsShard& shard = _imp->shards[i];
+        QMutexLocker k(&shard.lock);
+        for (CacheReuseStatsEntryMap::const_iterator it = shard.entries.begin(); it != shard.entries.end(); ++it) {
+            CacheReuseNodeStats total = it->second.getTotal();
+            if (total.nCachedWrites + total.nCachedReads < NATRON_CACHE_REUSE_MIN_SAVED_OUTPUTS) {
+                // Nodes that were not used for several sessions fade out of the file
+                continue;
+            }
+            ofile << it->first << ' ' << total.nCachedWrites << ' ' << total.nCachedReads << ' ' << total.timeSpentRendering << ' ' << total.nPixelsRendered << std::endl;
+        }
+    }
+} // saveToDirectory
+
+void
+CacheReuseStats::clear()
+{
+    for (int i = 0; i < NATRON_CACHE_REUSE_STATS_SHARDS; ++i) {
+        QMutexLocker k(&_imp->shards[i].lock);
+        _imp->shards[i].entries.clear();
+    }
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,143 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_CacheReuseStats_h
+#define Engine_CacheReuseStats_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief What was measured for the cached outputs of one node
+ **/
+struct CacheReuseNodeStats
+{
+    // Number of outputs rendered and written to the cache, or rendered without the cache for the first time
+    double nCachedWrites;
+
+    // Number of outputs entirely read back from the cache, or rendered again without the cache
+    double nCachedReads;
+
+    // Time spent rendering and number of pixels rendered, cached or not
+    double timeSpentRendering;
+    double nPixelsRendered;
+
+    CacheReuseNodeStats()
+    : nCachedWrites(0)
+    , nCachedReads(0)
+    , timeSpentRendering(0)
+    , nPixelsRendered(0)
+    {
+
+    }
+};
+
+/**
+ * @brief Measures, for each node, how often the outputs it writes to the cache are read back, so that
+ * the outputs that are almost never re-read stop going through the cache: they cost shared memory bandwidth
+ * and lock time and evict tiles that would have been useful.
+ * Nodes are identified by a key computed from their plug-in ID, their fully qualified name and the project
+ * file so that what was measured in a previous session applies to the same node when the project is reopened.
+ * The measures of the previous sessions are loaded from the cache directory and weigh half as much
+ * as the measures of the current session for each session that passed.
+ *
+ * While the cache is bypassed for a node, the outputs it renders again are counted as reads so that
+ * the measures do not depend on whether the node was cached.
+ *
+ * This class only tells whether the measures justify bypassing the cache: nodes that are cached because they
+ * have several consumers, are being edited or are expensive to compute are filtered out by the caller
+ * (see EffectInstance::Implementation::shouldRenderUseCache).
+ **/
+struct CacheReuseStatsPrivate;
+class CacheReuseStats
+{
+public:
+
+    CacheReuseStats();
+
+    ~CacheReuseStats();
+
+    /**
+     * @brief Returns the key identifying the node across sessions.
+     * This hashes the names of the node and of the project: use Node::getCacheReuseKey() which computes it once.
+     **/
+    static U64 getNodeKey(const NodePtr& node);
+
+    /**
+     * @brief Called when an output of the node was rendered. If it was written to the cache, cached is true.
+     * The output hash identifies the image rendered (frame, view, scale, region): if the output was not cached and the same
+     * image was recently rendered, it is counted as read from the cache.
+     **/
+    void notifyOutputRendered(U64 nodeKey, U64 outputHash, bool cached, double timeSpent, double nPixels);
+
+    /**
+     * @brief Called when an output of the node was entirely read from the cache
+     **/
+    void notifyOutputReadFromCache(U64 nodeKey);
+
+    /**
+     * @brief Returns true if the outputs of the node are re-read from the cache so rarely that it should not be
+     * cached. The reuse ratio (reads per write) is set to -1 if not enough outputs were measured to decide.
+     **/
+    bool shouldBypassCache(U64 nodeKey, double* reuseRatio);
+
+    /**
+     * @brief Returns the measures for the node, from this session and the previous ones.
+     **/
+    bool getNodeStats(U64 nodeKey, CacheReuseNodeStats* stats) const;
+
+    /**
+     * @brief Restore the measures saved by a previous session, if any.
+     **/
+    void loadFromDirectory(const std::string& directoryPath);
+
+    /**
+     * @brief Save the measures so that they may be used by the next sessions.
+     **/
+    void saveToDirectory(const std::string& directoryPath) const;
+
+    /**
+     * @brief Forget all measures
+     **/
+    void clear();
+
+private:
+
+    boost::scoped_ptr<CacheReuseStatsPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_CacheReuseStats_h
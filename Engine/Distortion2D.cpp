@@ -26,7 +26,31 @@
 
 
 #include <list>
+#include <cmath>
+#include <algorithm> // min, max
+
+#include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/math/special_functions/fpclassify.hpp>
+#endif
+
+#include "Engine/ActionResultsCache.h"
+#include "Engine/AppManager.h"
+#include "Engine/Hash64.h"
 #include "Engine/Transform.h"
+
+// Size of the cells of the warp grid, in pixels at the render scale
+#define NATRON_WARP_GRID_CELL_SIZE 64.
+
+// Cells are subdivided at most 2^NATRON_WARP_GRID_MAX_LEVEL times in each direction (i.e: down to 2 pixels)
+#define NATRON_WARP_GRID_MAX_LEVEL 5
+
+// Do not build a grid for domains larger than this amount of cells (e.g: infinite region of definition):
+// the stack is evaluated directly instead
+#define NATRON_WARP_GRID_MAX_CELLS (512 * 512)
+
 NATRON_NAMESPACE_ENTER;
 
 DistortionFunction2D::DistortionFunction2D()
@@ -56,6 +80,35 @@ DistortionFunction2D::DistortionFunction2D(const DistortionFunction2D& other)
 struct Distortion2DStackPrivate
 {
     std::list<DistortionFunction2DPtr> stack;
+
+    U64 hash;
+
+    // Parameters of the warp grid, tolerance is 0 if the stack must always be evaluated
+    RectD warpGridDomain;
+    TimeValue warpGridTime;
+    ViewIdx warpGridView;
+    RenderScale warpGridScale;
+    double warpGridTolerance;
+
+    // The warp grid is built by the first thread evaluating the stack. Once warpGridResolved is set
+    // warpGrid is never modified: it can be read without taking the mutex.
+    QMutex warpGridMutex;
+    QAtomicInt warpGridResolved;
+    Distortion2DWarpGridPtr warpGrid;
+
+    Distortion2DStackPrivate()
+    : stack()
+    , hash(0)
+    , warpGridDomain()
+    , warpGridTime(0)
+    , warpGridView(0)
+    , warpGridScale(1.)
+    , warpGridTolerance(0.)
+    , warpGridMutex()
+    , warpGridResolved()
+    , warpGrid()
+    {
+    }
 };
 
 
@@ -71,11 +124,19 @@ Distortion2DStack::~Distortion2DStack()
 }
 
 void
-Distortion2DStack::pushDistortion(const DistortionFunction2DPtr& distortion)
+Distortion2DStack::pushDistortion(const DistortionFunction2DPtr& distortion, U64 distortionHash)
 {
     // The distortion is either a function or a transformation matrix.
     assert((distortion->transformMatrix && !distortion->func) || (!distortion->transformMatrix && distortion->func));
 
+    {
+        Hash64 hash;
+        hash.append(_imp->hash);
+        hash.append(distortionHash);
+        hash.computeHash();
+        _imp->hash = hash.value();
+    }
+
     if (_imp->stack.empty()) {
         _imp->stack.push_back(distortion);
     } else {
@@ -97,9 +158,84 @@ Distortion2DStack::getStack() const
     return _imp->stack;
 }
 
+U64
+Distortion2DStack::getHash() const
+{
+    return _imp->hash;
+}
+
+void
+Distortion2DStack::setWarpGridParameters(const RectD& domain,
+                                         TimeValue time,
+                                         ViewIdx view,
+                                         const RenderScale& scale,
+                                         double tolerance)
+{
+    // The stack must not be evaluated yet
+    assert(!_imp->warpGridResolved.fetchAndAddAcquire(0));
+    _imp->warpGridDomain = domain;
+    _imp->warpGridTime = time;
+    _imp->warpGridView = view;
+    _imp->warpGridScale = scale;
+    _imp->warpGridTolerance = tolerance;
+}
+
+const Distortion2DWarpGrid*
+Distortion2DStack::getWarpGrid() const
+{
+    if ( _imp->warpGridResolved.fetchAndAddAcquire(0) ) {
+        return _imp->warpGrid.get();
+    }
+
+    QMutexLocker k(&_imp->warpGridMutex);
+    if ( _imp->warpGridResolved.fetchAndAddAcquire(0) ) {
+        return _imp->warpGrid.get();
+    }
+
+    // A stack of matrices is evaluated faster than a grid
+    bool hasFunction = false;
+    for (std::list<DistortionFunction2DPtr>::const_iterator it = _imp->stack.begin(); it != _imp->stack.end(); ++it) {
+        if ((*it)->func) {
+            hasFunction = true;
+            break;
+        }
+    }
+
+    if (hasFunction && _imp->warpGridTolerance > 0. && !_imp->warpGridDomain.isNull()) {
+        Distortion2DWarpGridKeyPtr key(new Distortion2DWarpGridKey(_imp->hash, _imp->warpGridTime, _imp->warpGridView, _imp->warpGridScale, _imp->warpGridDomain, _imp->warpGridTolerance));
+        ActionResultsCache* cache = appPTR->getActionResultsCache();
+        _imp->warpGrid = boost::dynamic_pointer_cast<Distortion2DWarpGrid>(cache->get(key->getHash(), kCacheKeyUniqueIDDistortionWarpGrid));
+        if (!_imp->warpGrid) {
+            _imp->warpGrid = Distortion2DWarpGrid::create(key);
+            // The cells span the same amount of pixels whatever the render scale
+            const double cellSize = NATRON_WARP_GRID_CELL_SIZE / std::min(_imp->warpGridScale.x, _imp->warpGridScale.y);
+            _imp->warpGrid->build(*this, _imp->warpGridDomain, cellSize, _imp->warpGridTolerance);
+
+            // Grids of large or strongly distorted domains may be bigger than what a shard of the cache holds.
+            // They are then only used by this render: the cache refuses them rather than evicting all the
+            // action results of the shard.
+            cache->insert(_imp->warpGrid);
+        }
+    }
+    _imp->warpGridResolved.fetchAndStoreRelease(1);
+
+    return _imp->warpGrid.get();
+} // getWarpGrid
 
 void
 Distortion2DStack::applyDistortionStack(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY)
+{
+    if (stack._imp->warpGridTolerance > 0.) {
+        const Distortion2DWarpGrid* grid = stack.getWarpGrid();
+        if ( grid && grid->apply(distortedX, distortedY, undistortedX, undistortedY) ) {
+            return;
+        }
+    }
+    applyDistortionStackExact(distortedX, distortedY, stack, undistortedX, undistortedY);
+}
+
+void
+Distortion2DStack::applyDistortionStackExact(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY)
 {
     Transform::Point3D p(distortedX, distortedY, 1.);
     for (std::list<DistortionFunction2DPtr>::const_iterator it = stack._imp->stack.begin(); it != stack._imp->stack.end(); ++it) {
@@ -116,4 +252,220 @@ Distortion2DStack::applyDistortionStack(double distortedX, double distortedY, co
     *undistortedY = p.y;
 }
 
+Distortion2DWarpGridKey::Distortion2DWarpGridKey(U64 stackHash,
+                                                 TimeValue time,
+                                                 ViewIdx view,
+                                                 const RenderScale& scale,
+                                                 const RectD& domain,
+                                                 double tolerance)
+: CacheEntryKeyBase()
+, _stackHash(stackHash)
+, _time(time)
+, _view(view)
+, _scale(scale)
+, _domain(domain)
+, _tolerance(tolerance)
+{
+
+}
+
+void
+Distortion2DWarpGridKey::appendToHash(Hash64* hash) const
+{
+    hash->append(_stackHash);
+    hash->append((double)_time);
+    hash->append((int)_view);
+    hash->append(_scale.x);
+    hash->append(_scale.y);
+    hash->append(_domain.x1);
+    hash->append(_domain.y1);
+    hash->append(_domain.x2);
+    hash->append(_domain.y2);
+    hash->append(_tolerance);
+}
+
+Distortion2DWarpGrid::Distortion2DWarpGrid()
+: CacheEntryBase(appPTR->getCache())
+, _domain()
+, _cellSize(0)
+, _nCellsX(0)
+, _nCellsY(0)
+, _cells()
+, _samples()
+{
+
+}
+
+Distortion2DWarpGridPtr
+Distortion2DWarpGrid::create(const Distortion2DWarpGridKeyPtr& key)
+{
+    Distortion2DWarpGridPtr ret(new Distortion2DWarpGrid);
+    ret->setKey(key);
+    return ret;
+}
+
+bool
+Distortion2DWarpGrid::sampleCell(const Distortion2DStack& stack,
+                                 double x1,
+                                 double y1,
+                                 double size,
+                                 int level,
+                                 std::vector<double>* samples) const
+{
+    const int n = 1 << level;
+    const double step = size / n;
+    samples->resize( (n + 1) * (n + 1) * 2 );
+    double* s = &(*samples)[0];
+    for (int j = 0; j <= n; ++j) {
+        const double y = y1 + j * step;
+        for (int i = 0; i <= n; ++i, s += 2) {
+            Distortion2DStack::applyDistortionStackExact(x1 + i * step, y, stack, &s[0], &s[1]);
+            if ( !(boost::math::isfinite)(s[0]) || !(boost::math::isfinite)(s[1]) ) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns true if the bilinear interpolation of the samples of a cell subdivided 2^level times
+ * is within the tolerance of the samples of the same cell subdivided 2^(level+1) times.
+ **/
+static bool
+isCellWithinTolerance(const std::vector<double>& coarse,
+                      const std::vector<double>& fine,
+                      int level,
+                      double tolerance)
+{
+    const int n = 1 << level;
+    const int coarseStride = n + 1;
+    const int fineStride = 2 * n + 1;
+    const double tolerance2 = tolerance * tolerance;
+
+    for (int j = 0; j < fineStride; ++j) {
+        const int cj = std::min(j / 2, n - 1);
+        const double b = j * 0.5 - cj;
+        for (int i = 0; i < fineStride; ++i) {
+            if ( !(i & 1) && !(j & 1) ) {
+                // This sample is also a sample of the coarse cell
+                continue;
+            }
+            const int ci = std::min(i / 2, n - 1);
+            const double a = i * 0.5 - ci;
+            const double* p00 = &coarse[(cj * coarseStride + ci) * 2];
+            const double* p10 = p00 + 2;
+            const double* p01 = p00 + coarseStride * 2;
+            const double* p11 = p01 + 2;
+            const double* exact = &fine[(j * fineStride + i) * 2];
+            for (int c = 0; c < 2; ++c) {
+                double interp = (1. - b) * ( (1. - a) * p00[c] + a * p10[c] ) + b * ( (1. - a) * p01[c] + a * p11[c] );
+                double err = interp - exact[c];
+                if (err * err > tolerance2) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+} // isCellWithinTolerance
+
+void
+Distortion2DWarpGrid::build(const Distortion2DStack& stack,
+                            const RectD& domain,
+                            double cellSize,
+                            double tolerance)
+{
+    assert(cellSize > 0.);
+    _domain = domain;
+    _cellSize = cellSize;
+    _cells.clear();
+    _samples.clear();
+
+    double nCellsX = std::ceil(domain.width() / _cellSize);
+    double nCellsY = std::ceil(domain.height() / _cellSize);
+    if ( (nCellsX <= 0) || (nCellsY <= 0) || (nCellsX * nCellsY > NATRON_WARP_GRID_MAX_CELLS) ) {
+        // The stack will be evaluated for each position
+        _nCellsX = _nCellsY = 0;
+
+        return;
+    }
+    _nCellsX = (int)nCellsX;
+    _nCellsY = (int)nCellsY;
+    _cells.resize(_nCellsX * _nCellsY);
+
+    std::vector<double> coarse, fine;
+    for (int cy = 0; cy < _nCellsY; ++cy) {
+        const double y1 = domain.y1 + cy * _cellSize;
+        for (int cx = 0; cx < _nCellsX; ++cx) {
+            const double x1 = domain.x1 + cx * _cellSize;
+            Cell& cell = _cells[cy * _nCellsX + cx];
+            cell.firstSample = _samples.size();
+
+            int level = 0;
+            bool ok = sampleCell(stack, x1, y1, _cellSize, level, &coarse);
+            while (ok && level < NATRON_WARP_GRID_MAX_LEVEL) {
+                ok = sampleCell(stack, x1, y1, _cellSize, level + 1, &fine);
+                if ( !ok || isCellWithinTolerance(coarse, fine, level, tolerance) ) {
+                    break;
+                }
+                coarse.swap(fine);
+                ++level;
+            }
+            if (!ok) {
+                cell.level = -1;
+                continue;
+            }
+            cell.level = level;
+            _samples.insert( _samples.end(), coarse.begin(), coarse.end() );
+        }
+    }
+} // build
+
+bool
+Distortion2DWarpGrid::apply(double distortedX,
+                            double distortedY,
+                            double* undistortedX,
+                            double* undistortedY) const
+{
+    const double fx = (distortedX - _domain.x1) / _cellSize;
+    const double fy = (distortedY - _domain.y1) / _cellSize;
+    if ( !(fx >= 0.) || !(fy >= 0.) || (fx > _nCellsX) || (fy > _nCellsY) ) {
+        return false;
+    }
+    const int cx = std::min( (int)fx, _nCellsX - 1 );
+    const int cy = std::min( (int)fy, _nCellsY - 1 );
+    const Cell& cell = _cells[cy * _nCellsX + cx];
+    if (cell.level < 0) {
+        return false;
+    }
+
+    const int n = 1 << cell.level;
+    const double u = (fx - cx) * n;
+    const double v = (fy - cy) * n;
+    const int i = std::min( (int)u, n - 1 );
+    const int j = std::min( (int)v, n - 1 );
+    const double a = u - i;
+    const double b = v - j;
+    const int stride = n + 1;
+
+    const double* p00 = &_samples[cell.firstSample + (j * stride + i) * 2];
+    const double* p10 = p00 + 2;
+    const double* p01 = p00 + stride * 2;
+    const double* p11 = p01 + 2;
+
+    *undistortedX = (1. - b) * ( (1. - a) * p00[0] + a * p10[0] ) + b * ( (1. - a) * p01[0] + a * p11[0] );
+    *undistortedY = (1. - b) * ( (1. - a) * p00[1] + a * p10[1] ) + b * ( (1. - a) * p01[1] + a * p11[1] );
+
+    return true;
+} // apply
+
+std::size_t
+Distortion2DWarpGrid::getMetadataSize() const
+{
+    return CacheEntryBase::getMetadataSize() + _cells.size() * sizeof(Cell) + _samples.size() * sizeof(double);
+}
+
 NATRON_NAMESPACE_EXIT;
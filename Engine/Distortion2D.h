@@ -27,12 +27,22 @@
 
 #include "Global/Macros.h"
 
+#include <vector>
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
 #endif
 
 #include <ofxNatron.h>
 
+#include "Global/GlobalDefines.h"
+
+#include "Engine/CacheEntryBase.h"
+#include "Engine/CacheEntryKeyBase.h"
+#include "Engine/RectD.h"
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -77,22 +87,151 @@ public:
     ~Distortion2DStack();
 
     /**
-     * @brief Appends a new distortion function to apply.
+     * @brief Appends a new distortion function to apply. The hash is the one of the node that returned
+     * the distortion, at the time and view of the render. It is accumulated to identify the stack.
      **/
-    void pushDistortion(const DistortionFunction2DPtr& distortion);
+    void pushDistortion(const DistortionFunction2DPtr& distortion, U64 distortionHash);
 
     const std::list<DistortionFunction2DPtr>& getStack() const;
 
+    /**
+     * @brief Returns the hash accumulated from the hash of all distortions in the stack.
+     **/
+    U64 getHash() const;
+
+    /**
+     * @brief Evaluate the stack through a warp grid (see Distortion2DWarpGrid) for positions inside the given domain,
+     * instead of calling each distortion function for every position.
+     * This should be called after the last distortion was pushed, the domain being the region of definition of the
+     * last distortion. The domain and the tolerance are in canonical coordinates, like the positions passed to
+     * applyDistortionStack. The grid is built upon the first evaluation and is cached.
+     **/
+    void setWarpGridParameters(const RectD& domain,
+                               TimeValue time,
+                               ViewIdx view,
+                               const RenderScale& scale,
+                               double tolerance);
+
     /**
      * @brief Applies a distortion stack onto a 2D position in canonical coordinates.
      **/
     static void applyDistortionStack(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY);
 
+    /**
+     * @brief Same as applyDistortionStack but always calls the distortion functions, even if a warp grid is enabled.
+     **/
+    static void applyDistortionStackExact(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY);
+
 private:
 
+    const Distortion2DWarpGrid* getWarpGrid() const;
+
     boost::scoped_ptr<Distortion2DStackPrivate> _imp;
 };
 
+class Distortion2DWarpGridKey : public CacheEntryKeyBase
+{
+public:
+
+    Distortion2DWarpGridKey(U64 stackHash,
+                            TimeValue time,
+                            ViewIdx view,
+                            const RenderScale& scale,
+                            const RectD& domain,
+                            double tolerance);
+
+    virtual ~Distortion2DWarpGridKey()
+    {
+
+    }
+
+    virtual TimeValue getTime() const OVERRIDE FINAL
+    {
+        return _time;
+    }
+
+    virtual ViewIdx getView() const OVERRIDE FINAL
+    {
+        return _view;
+    }
+
+    virtual int getUniqueID() const OVERRIDE FINAL
+    {
+        return kCacheKeyUniqueIDDistortionWarpGrid;
+    }
+
+private:
+
+    virtual void appendToHash(Hash64* hash) const OVERRIDE FINAL;
+
+    U64 _stackHash;
+    TimeValue _time;
+    ViewIdx _view;
+    RenderScale _scale;
+    RectD _domain;
+    double _tolerance;
+};
+
+/**
+ * @brief A distortion stack baked on a grid of samples of the undistorted positions (like a STMap), sampled
+ * with a bilinear interpolation.
+ * The domain is split in square cells of a fixed size. Each cell is subdivided independently until the
+ * bilinear interpolation of its samples is within the tolerance (in the coordinates of the undistorted positions)
+ * of the exact stack: a transform or a smooth distortion only needs the 4 corners of each cell while
+ * the areas of strong distortion are refined.
+ * Cells where a distortion function returns a non-finite position fall back to the exact stack.
+ * The grid is immutable once built and is cached in the action results cache, unless it is bigger than a shard of
+ * that cache (see ActionResultsCache::insert), in which case it is only used by the render that built it.
+ **/
+class Distortion2DWarpGrid : public CacheEntryBase
+{
+    Distortion2DWarpGrid();
+
+public:
+
+    static Distortion2DWarpGridPtr create(const Distortion2DWarpGridKeyPtr& key);
+
+    virtual ~Distortion2DWarpGrid()
+    {
+
+    }
+
+    /**
+     * @brief Sample the distortion stack over the domain, with cells of the given size, until the interpolation is
+     * within the tolerance. All arguments are in canonical coordinates.
+     **/
+    void build(const Distortion2DStack& stack, const RectD& domain, double cellSize, double tolerance);
+
+    /**
+     * @brief Interpolates the undistorted position from the grid. Returns false if the position is outside of the domain
+     * or in a cell that could not be baked, in which case the stack must be evaluated.
+     **/
+    bool apply(double distortedX, double distortedY, double* undistortedX, double* undistortedY) const;
+
+    virtual std::size_t getMetadataSize() const OVERRIDE FINAL;
+
+private:
+
+    struct Cell
+    {
+        // The cell is subdivided in 2^level x 2^level sub-cells, -1 if the exact stack must be used
+        int level;
+
+        // Index of the first sample of the cell in _samples
+        std::size_t firstSample;
+    };
+
+    bool sampleCell(const Distortion2DStack& stack, double x1, double y1, double size, int level, std::vector<double>* samples) const;
+
+    RectD _domain;
+    double _cellSize;
+    int _nCellsX, _nCellsY;
+    std::vector<Cell> _cells;
+
+    // (x,y) pairs of undistorted positions, row by row for each cell
+    std::vector<double> _samples;
+};
+
 NATRON_NAMESPACE_EXIT;
 
 
@@ -50,6 +50,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include "Global/QtCompat.h"
 
+#include "Engine/ActionResultsCache.h"
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
 #include "Engine/EffectOpenGLContextData.h"
@@ -241,12 +242,12 @@ EffectInstance::appendToHash(const ComputeHashArgs& args, Hash64* hash)
             cacheKey.reset(new GetFramesNeededKey(hashValue, timeKey, viewKey, getNode()->getPluginID()));
         }
 
-        CacheEntryLockerPtr cacheAccess = appPTR->getCache()->get(framesNeededResults);
-        
-        CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-        if (cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute) {
-            cacheAccess->insertInCache();
-        }
+        // The results were computed without a hash: cache a copy under the key that we now know
+        FramesNeededMap framesNeeded;
+        framesNeededResults->getFramesNeeded(&framesNeeded);
+        GetFramesNeededResultsPtr keyedResults = GetFramesNeededResults::create(cacheKey);
+        keyedResults->setFramesNeeded(framesNeeded);
+        appPTR->getActionResultsCache()->insert(keyedResults);
     }
 
     if (args.render) {
@@ -695,6 +696,9 @@ EffectInstance::getImagePlanes(const GetImageInArgs& inArgs, GetImageOutArgs* ou
         rargs->draftMode = false;
         rargs->playback = false;
         rargs->byPassCache = false;
+        rargs->streaming = false;
+        rargs->priorityPoint = 0;
+        rargs->lowPriority = false;
 
         TreeRenderPtr renderObject = TreeRender::create(rargs);
         ActionRetCodeEnum status = renderObject->launchRender(&outArgs->imagePlanes);
@@ -888,12 +892,27 @@ EffectInstance::getImagePlanes(const GetImageInArgs& inArgs, GetImageOutArgs* ou
             mustConvertImage = true;
         }
 
+        // Images read from the cache are stored as mono-channel tiles: when several consumers want them in the same layout,
+        // convert the cached tiles once for the whole image and share the converted image between them.
+        // Mask conversions depend on the consumer and are never shared.
+        FrameViewRequestPtr inputFrameViewRequest;
+        if ( mustConvertImage && (it->second->getCachePolicy() != eCacheAccessModeNone) && (preferredStorage == eStorageModeRAM) && (channelForMask == -1) ) {
+            inputFrameViewRequest = inputRenderArgs->getFrameViewRequest(inputTime, inArgs.inputView);
+        }
+
         ImagePtr convertedImage = it->second;
+        if (inputFrameViewRequest) {
+            ImagePtr sharedImage = inputFrameViewRequest->getConvertedCachedImage(preferredLayer, thisEffectSupportedImageLayout, thisBitDepth, it->second->getMipMapLevel(), pixelRoI);
+            if (sharedImage) {
+                convertedImage = sharedImage;
+                mustConvertImage = false;
+            }
+        }
         if (mustConvertImage) {
 
             Image::InitStorageArgs initArgs;
             {
-                initArgs.bounds = pixelRoI;
+                initArgs.bounds = inputFrameViewRequest ? it->second->getBounds() : pixelRoI;
                 initArgs.proxyScale = it->second->getProxyScale();
                 initArgs.mipMapLevel = it->second->getMipMapLevel();
                 initArgs.layer = preferredLayer;
@@ -916,6 +935,10 @@ EffectInstance::getImagePlanes(const GetImageInArgs& inArgs, GetImageOutArgs* ou
             }
             convertedImage->copyPixels(*it->second, copyArgs);
 
+            if (inputFrameViewRequest) {
+                inputFrameViewRequest->appendConvertedCachedImage(convertedImage);
+            }
+
         } // mustConvertImage
 
         outArgs->imagePlanes[preferredLayer] = convertedImage;
@@ -1073,6 +1096,19 @@ EffectInstance::NotifyInputNRenderingStarted_RAII::~NotifyInputNRenderingStarted
 }
 
 
+void
+EffectInstance::markDirtyForAutoSave()
+{
+    // Render clones never hold user changes
+    if ( isRenderClone() ) {
+        return;
+    }
+    NodePtr node = getNode();
+    if (node) {
+        node->markDirtyForAutoSave();
+    }
+}
+
 void
 EffectInstance::evaluate(bool isSignificant,
                          bool refreshMetadatas)
@@ -1080,6 +1116,11 @@ EffectInstance::evaluate(bool isSignificant,
 
     NodePtr node = getNode();
 
+    // Within a knob changes transaction, all nodes are evaluated once when it ends
+    if ( getApp()->deferEvaluationToKnobChangesTransaction(node, isSignificant, refreshMetadatas) ) {
+        return;
+    }
+
     if ( refreshMetadatas && node && node->isNodeCreated() ) {
         
         // Force a re-compute of the meta-data if needed
@@ -132,9 +132,20 @@ struct PlaneToRender
     // Points to a temporary image that the plug-in will render
     ImagePtr tmpImage;
 
+    // True if tmpImage will contain all pixels of cacheImage once rendered, i.e: no tile was
+    // found in the cache or is being computed by another thread
+    bool tmpImageCoversCacheImage;
+
+    // When tmpImage covered the cache image, this is the temporary image kept after the render so that
+    // it is returned instead of the cache image: consumers whose preferred layout matches the one of the plug-in
+    // (typically packed RGBA for OpenFX plug-ins) may use it without converting the cache tiles again.
+    ImagePtr renderedImage;
+
     PlaneToRender()
     : cacheImage()
     , tmpImage()
+    , tmpImageCoversCacheImage(false)
+    , renderedImage()
     {
     }
 };
@@ -899,7 +910,8 @@ public:
 
     void onMetadataChanged_recursive_public();
 
-    void onMetadataChanged_nonRecursive_public();
+    // Returns true if the meta-data changed
+    bool onMetadataChanged_nonRecursive_public();
 
 protected:
 
@@ -1235,12 +1247,27 @@ public:
         // For OpenGL this is the effect context dependent data
         EffectOpenGLContextDataPtr glContextData;
 
+        // If priorityPointSet, rectangles are rendered in order of their distance to this point,
+        // in pixel coordinates at the render mapped scale
+        Point priorityPoint;
+        bool priorityPointSet;
+
+        // The size class of the tiles of the cached output images, see Cache::getTileSizeClassForImage
+        int tileSizeClass;
+
+        // The size class of the tiles the outputs are cached with at mipmap level 0
+        int mipMapLevel0TileSizeClass;
+
 
         ImagePlanesToRender()
         : rectsToRender()
         , planes()
         , backendType(eRenderBackendTypeCPU)
         , glContextData()
+        , priorityPoint()
+        , priorityPointSet(false)
+        , tileSizeClass(0)
+        , mipMapLevel0TileSizeClass(0)
         {
         }
     };
@@ -1738,6 +1765,11 @@ public:
      **/
     virtual void evaluate(bool isSignificant, bool refreshMetadatas) OVERRIDE;
 
+    /**
+     * @brief Reimplemented from KnobHolder: marks the node for the next auto-save.
+     **/
+    virtual void markDirtyForAutoSave() OVERRIDE FINAL;
+
 
     bool ifInfiniteclipRectToProjectDefault(RectD* rod) const;
 
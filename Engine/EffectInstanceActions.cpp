@@ -29,6 +29,7 @@
 #include <QtCore/QThread>
 #include <QCoreApplication>
 
+#include "Engine/ActionResultsCache.h"
 #include "Engine/AppInstance.h"
 #include "Engine/Cache.h"
 #include "Engine/EffectInstanceActionResults.h"
@@ -39,6 +40,7 @@
 #include "Engine/Node.h"
 #include "Engine/NodeMetadata.h"
 #include "Engine/Project.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/TreeRenderNodeArgs.h"
 #include "Engine/ThreadPool.h"
 
@@ -430,6 +432,7 @@ ActionRetCodeEnum
 EffectInstance::getLayersProducedAndNeeded_public(TimeValue inArgsTime, ViewIdx view, const TreeRenderNodeArgsPtr& render, GetComponentsResultsPtr* results)
 
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, "GetLayersProducedAndNeeded", this, inArgsTime);
     // Round time for non continuous effects
     TimeValue time = inArgsTime;
     {
@@ -487,20 +490,14 @@ EffectInstance::getLayersProducedAndNeeded_public(TimeValue inArgsTime, ViewIdx
         cacheKey.reset(new GetComponentsKey(hash, timeKey, viewKey, getNode()->getPluginID()));
     }
 
-    *results = GetComponentsResults::create(cacheKey);
-
-    // Ensure the cache fetcher lives as long as we compute the action
-    CacheEntryLockerPtr cacheAccess = appPTR->getCache()->get(*results);
-
-    CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-    while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-        cacheStatus = cacheAccess->waitForPendingEntry();
-    }
-
-    if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
-        return eActionStatusOK;
+    {
+        GetComponentsResultsPtr cachedResults = toGetComponentsResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDGetComponentsResults));
+        if (cachedResults) {
+            *results = cachedResults;
+            return eActionStatusOK;
+        }
     }
-    assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
+    *results = GetComponentsResults::create(cacheKey);
 
 
     // For each input index what layers are required
@@ -539,7 +536,7 @@ EffectInstance::getLayersProducedAndNeeded_public(TimeValue inArgsTime, ViewIdx
     if (fvRequest) {
         fvRequest->setComponentsNeededResults(*results);
     }
-    cacheAccess->insertInCache();
+    appPTR->getActionResultsCache()->insert(*results);
 
     return eActionStatusOK;
     
@@ -721,6 +718,7 @@ EffectInstance::render(const RenderActionArgs & /*args*/)
 ActionRetCodeEnum
 EffectInstance::render_public(const RenderActionArgs & args)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionRender, this, args.time);
 
     REPORT_CURRENT_THREAD_ACTION( kOfxImageEffectActionRender, getNode() );
     return render(args);
@@ -807,6 +805,7 @@ EffectInstance::getDistortion_public(TimeValue inArgsTime,
                                      ViewIdx view,
                                      const TreeRenderNodeArgsPtr& render,
                                      DistortionFunction2DPtr* outDisto) {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, "GetDistortion", this, inArgsTime);
     assert(outDisto);
 
     TimeValue time = inArgsTime;
@@ -934,6 +933,7 @@ EffectInstance::isIdentity_public(bool useIdentityCache, // only set to true whe
                                   const TreeRenderNodeArgsPtr& render,
                                   IsIdentityResultsPtr* results)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionIsIdentity, this, time);
     
 
     {
@@ -1002,25 +1002,14 @@ EffectInstance::isIdentity_public(bool useIdentityCache, // only set to true whe
     }
 
 
-    *results = IsIdentityResults::create(cacheKey);
-
-    CacheEntryLockerPtr cacheAccess;
     if (useIdentityCache) {
-
-        // Ensure the cache fetcher lives as long as we compute the action
-        cacheAccess = appPTR->getCache()->get(*results);
-
-        CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-        while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-            cacheStatus = cacheAccess->waitForPendingEntry();
-        }
-
-        if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
+        IsIdentityResultsPtr cachedResults = toIsIdentityResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDIsIdentityResults));
+        if (cachedResults) {
+            *results = cachedResults;
             return eActionStatusOK;
         }
-
-        assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
     }
+    *results = IsIdentityResults::create(cacheKey);
 
 
     bool caught = false;
@@ -1088,8 +1077,8 @@ EffectInstance::isIdentity_public(bool useIdentityCache, // only set to true whe
     if (fvRequest) {
         fvRequest->setIdentityResults((*results));
     }
-    if (cacheAccess) {
-        cacheAccess->insertInCache();
+    if (useIdentityCache) {
+        appPTR->getActionResultsCache()->insert(*results);
     }
     return eActionStatusOK;
 } // isIdentity_public
@@ -1127,17 +1116,11 @@ EffectInstance::getRegionOfDefinitionFromCache(TimeValue inArgsTime,
         cacheKey.reset(new GetRegionOfDefinitionKey(hash, timeKey, viewKey, scale, getNode()->getPluginID()));
     }
 
-    GetRegionOfDefinitionResultsPtr ret = GetRegionOfDefinitionResults::create(cacheKey);
-
-    CacheEntryLockerPtr cacheAccess = appPTR->getCache()->get(ret);
-
-    CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-    if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
-        *results = ret->getRoD();
-        return eActionStatusOK;
-    } else {
+    GetRegionOfDefinitionResultsPtr cachedResults = toGetRegionOfDefinitionResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDGetRoDResults));
+    if (!cachedResults) {
         return eActionStatusFailed;
     }
+    *results = cachedResults->getRoD();
 
     return eActionStatusOK;
 } // getRegionOfDefinitionFromCache
@@ -1149,6 +1132,7 @@ EffectInstance::getRegionOfDefinition_public(TimeValue inArgsTime,
                                              const TreeRenderNodeArgsPtr& render,
                                              GetRegionOfDefinitionResultsPtr* results)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionGetRegionOfDefinition, this, inArgsTime);
     TimeValue time = inArgsTime;
     {
         int roundedTime = std::floor(time + 0.5);
@@ -1203,24 +1187,14 @@ EffectInstance::getRegionOfDefinition_public(TimeValue inArgsTime,
         cacheKey.reset(new GetRegionOfDefinitionKey(hash, timeKey, viewKey, mappedScale, getNode()->getPluginID()));
     }
 
-    *results = GetRegionOfDefinitionResults::create(cacheKey);
-
-    CacheEntryLockerPtr cacheAccess;
     if (useCache) {
-
-        cacheAccess = appPTR->getCache()->get(*results);
-
-        CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-        while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-            cacheStatus = cacheAccess->waitForPendingEntry();
-        }
-
-        if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
+        GetRegionOfDefinitionResultsPtr cachedResults = toGetRegionOfDefinitionResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDGetRoDResults));
+        if (cachedResults) {
+            *results = cachedResults;
             return eActionStatusOK;
         }
-        assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
-
     }
+    *results = GetRegionOfDefinitionResults::create(cacheKey);
 
 
 
@@ -1303,8 +1277,8 @@ EffectInstance::getRegionOfDefinition_public(TimeValue inArgsTime,
     if (fvRequest) {
         fvRequest->setRegionOfDefinitionResults(*results);
     }
-    if (cacheAccess) {
-        cacheAccess->insertInCache();
+    if (useCache) {
+        appPTR->getActionResultsCache()->insert(*results);
     }
     
     return eActionStatusOK;
@@ -1480,6 +1454,7 @@ EffectInstance::getRegionsOfInterest_public(TimeValue inArgsTime,
                                             const TreeRenderNodeArgsPtr& render,
                                             RoIMap* ret)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionGetRegionsOfInterest, this, inArgsTime);
     TimeValue time = inArgsTime;
     {
         int roundedTime = std::floor(time + 0.5);
@@ -1586,6 +1561,7 @@ EffectInstance::getFramesNeeded_public(TimeValue inArgsTime,
                                        const TreeRenderNodeArgsPtr& render,
                                        GetFramesNeededResultsPtr* results)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionGetFramesNeeded, this, inArgsTime);
 
     // Round time for non continuous effects
     TimeValue time = inArgsTime;
@@ -1625,29 +1601,19 @@ EffectInstance::getFramesNeeded_public(TimeValue inArgsTime,
         getTimeViewParametersDependingOnFrameViewVariance(time, view, render, &timeKey, &viewKey);
         cacheKey.reset(new GetFramesNeededKey(hashValue, timeKey, viewKey, getNode()->getPluginID()));
     }
-    *results = GetFramesNeededResults::create(cacheKey);
-
-    CacheEntryLockerPtr cacheAccess;
 
     // Only use the cache if we got a hash.
     // We cannot compute the hash here because the hash itself requires the result of this function.
     // The results of this function is cached externally instead
     bool isHashCached = hashValue != 0;
     if (isHashCached) {
-
-
-        cacheAccess = appPTR->getCache()->get(*results);
-
-        CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-        while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-            cacheStatus = cacheAccess->waitForPendingEntry();
-        }
-
-        if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
+        GetFramesNeededResultsPtr cachedResults = toGetFramesNeededResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDFramesNeededResults));
+        if (cachedResults) {
+            *results = cachedResults;
             return eActionStatusOK;
         }
-        assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
     }
+    *results = GetFramesNeededResults::create(cacheKey);
 
 
     // Call the action
@@ -1733,8 +1699,8 @@ EffectInstance::getFramesNeeded_public(TimeValue inArgsTime,
         fvRequest->setFramesNeededResults(*results);
     }
 
-    if (cacheAccess) {
-        cacheAccess->insertInCache();
+    if (isHashCached) {
+        appPTR->getActionResultsCache()->insert(*results);
     }
 
     return eActionStatusOK;
@@ -1793,6 +1759,7 @@ EffectInstance::getFrameRange(const TreeRenderNodeArgsPtr& render,
 ActionRetCodeEnum
 EffectInstance::getFrameRange_public(const TreeRenderNodeArgsPtr& render, GetFrameRangeResultsPtr* results)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionGetTimeDomain, this);
 
     // Get a hash to cache the results
     U64 hash = 0;
@@ -1815,19 +1782,14 @@ EffectInstance::getFrameRange_public(const TreeRenderNodeArgsPtr& render, GetFra
     }
 
     GetFrameRangeKeyPtr cacheKey(new GetFrameRangeKey(hash, getNode()->getPluginID()));
-    *results = GetFrameRangeResults::create(cacheKey);
-
-    CacheEntryLockerPtr cacheAccess = appPTR->getCache()->get(*results);
-
-    CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-    while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-        cacheStatus = cacheAccess->waitForPendingEntry();
-    }
-
-    if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
-        return eActionStatusOK;
+    {
+        GetFrameRangeResultsPtr cachedResults = toGetFrameRangeResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDGetFrameRangeResults));
+        if (cachedResults) {
+            *results = cachedResults;
+            return eActionStatusOK;
+        }
     }
-    assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
+    *results = GetFrameRangeResults::create(cacheKey);
 
     // Call the action
     RangeD range;
@@ -1853,7 +1815,7 @@ EffectInstance::getFrameRange_public(const TreeRenderNodeArgsPtr& render, GetFra
     if (render) {
         render->setFrameRangeResults(*results);
     }
-    cacheAccess->insertInCache();
+    appPTR->getActionResultsCache()->insert(*results);
 
     return eActionStatusOK;
     
@@ -2050,10 +2012,10 @@ EffectInstance::onMetadataChanged_recursive_public()
 
 }
 
-void
+bool
 EffectInstance::onMetadataChanged_nonRecursive_public()
 {
-    onMetadataChanged_nonRecursive();
+    return onMetadataChanged_nonRecursive();
 }
 
 void
@@ -2082,6 +2044,7 @@ EffectInstance::onInputChanged_public(int inputNo)
 ActionRetCodeEnum
 EffectInstance::getTimeInvariantMetaDatas_public(const TreeRenderNodeArgsPtr& render, GetTimeInvariantMetaDatasResultsPtr* results)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryAction, kOfxImageEffectActionGetClipPreferences, this);
     // Get a hash to cache the results
     U64 hash = 0;
 
@@ -2103,24 +2066,18 @@ EffectInstance::getTimeInvariantMetaDatas_public(const TreeRenderNodeArgsPtr& re
     }
 
     GetTimeInvariantMetaDatasKeyPtr cacheKey(new GetTimeInvariantMetaDatasKey(hash, getNode()->getPluginID()));
+    {
+        GetTimeInvariantMetaDatasResultsPtr cachedResults = toGetTimeInvariantMetaDatasResults(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDGetTimeInvariantMetaDatasResults));
+        if (cachedResults) {
+            *results = cachedResults;
+            return eActionStatusOK;
+        }
+    }
     *results = GetTimeInvariantMetaDatasResults::create(cacheKey);
     NodeMetadataPtr metadata(new NodeMetadata);
     (*results)->setMetadatasResults(metadata);
 
 
-    CacheEntryLockerPtr cacheAccess = appPTR->getCache()->get(*results);
-
-    CacheEntryLocker::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
-    while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-        cacheStatus = cacheAccess->waitForPendingEntry();
-    }
-
-    if (cacheStatus == CacheEntryLocker::eCacheEntryStatusCached) {
-        return eActionStatusOK;
-    }
-    assert(cacheStatus == CacheEntryLocker::eCacheEntryStatusMustCompute);
-
-
     // If the node is disabled return the meta-datas of the main input.
     // Don't do that for an identity node: a render may be identity but not the metadatas (e.g: NoOp)
     // A disabled generator still has to return some meta-datas, so let it return the default meta-datas.
@@ -2173,7 +2130,7 @@ EffectInstance::getTimeInvariantMetaDatas_public(const TreeRenderNodeArgsPtr& re
         _imp->checkMetadata(*metadata);
     }
 
-    cacheAccess->insertInCache();
+    appPTR->getActionResultsCache()->insert(*results);
 
 
     // For a Reader, try to add the output format to the project formats.
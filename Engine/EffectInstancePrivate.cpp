@@ -27,8 +27,11 @@
 #include <cassert>
 #include <stdexcept>
 #include <bitset>
+#include <cmath>
 
 #include "Engine/AppInstance.h"
+#include "Engine/Cache.h"
+#include "Engine/CacheReuseStats.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/OSGLContext.h"
@@ -149,10 +152,13 @@ EffectInstance::Implementation::resolveRenderBackend(const RenderRoIArgs & args,
 
 CacheAccessModeEnum
 EffectInstance::Implementation::shouldRenderUseCache(const RenderRoIArgs & args,
-                                                     const FrameViewRequestPtr& requestPassData)
+                                                     const FrameViewRequestPtr& requestPassData,
+                                                     U64 cacheReuseKey)
 {
     bool retSet = false;
     CacheAccessModeEnum ret = eCacheAccessModeNone;
+    bool bypassedForReuse = false;
+    double reuseRatio = -1;
 
     // A writer never caches!
     if (!retSet && _publicInterface->isWriter()) {
@@ -170,11 +176,25 @@ EffectInstance::Implementation::shouldRenderUseCache(const RenderRoIArgs & args,
         }
     }
 
+    if (!retSet && args.renderArgs->getParentRender()->isStreamingRender()) {
+        // The tree is rendered in bands: an intermediate image is consumed by the downstream node right away.
+        // Only cache the images that would otherwise be rendered entirely for each band (no tiles support)
+        // or several times per band (referenced by several downstream nodes).
+        const bool renderedSeveralTimes = !args.renderArgs->getCurrentTilesSupport() || requestPassData->getFramesNeededVisitsCount() > 1;
+        ret = renderedSeveralTimes ? eCacheAccessModeReadWrite : eCacheAccessModeNone;
+        retSet = true;
+    }
+
     if (!retSet) {
         const bool isFrameVaryingOrAnimated = _publicInterface->isFrameVarying(args.renderArgs);
         const int requestsCount = requestPassData->getFramesNeededVisitsCount();
 
         bool useCache = _publicInterface->shouldCacheOutput(isFrameVaryingOrAnimated, args.renderArgs, requestsCount);
+        if ( useCache && isFrameVaryingOrAnimated && canBypassCacheForReuse(args, requestsCount) ) {
+            // The output is only consumed once by a cheap node: cache it only if it was measured to be re-read
+            bypassedForReuse = appPTR->getCacheReuseStats()->shouldBypassCache(cacheReuseKey, &reuseRatio);
+            useCache = !bypassedForReuse;
+        }
         if (useCache) {
             ret = eCacheAccessModeReadWrite;
         } else {
@@ -192,9 +212,99 @@ EffectInstance::Implementation::shouldRenderUseCache(const RenderRoIArgs & args,
             ret = eCacheAccessModeWriteOnly;
         }
     }
+
+    RenderStatsPtr stats = args.renderArgs->getParentRender()->getStatsObject();
+    if ( stats && stats->isInDepthProfilingEnabled() ) {
+        stats->setCacheAccessModeForNode(_publicInterface->getNode(), ret, bypassedForReuse, reuseRatio);
+    }
     return ret;
 } // shouldRenderUseCache
 
+bool
+EffectInstance::Implementation::canBypassCacheForReuse(const RenderRoIArgs & args,
+                                                       int requestsCount) const
+{
+    if (requestsCount > 1) {
+        // Several consumers in this render
+        return false;
+    }
+
+    NodePtr node = _publicInterface->getNode();
+    if ( node->isForceCachingEnabled() || appPTR->isAggressiveCachingEnabled() ) {
+        return false;
+    }
+
+    std::list<NodeWPtr> outputs;
+    node->getOutputs_mt_safe(outputs);
+    if (outputs.size() != 1) {
+        return false;
+    }
+    NodePtr output = outputs.front().lock();
+    if ( !output || output->isSettingsPanelVisible() || node->isSettingsPanelVisible() ) {
+        // The user is editing downstream: this node is going to be requested again with the same hash
+        return false;
+    }
+
+    if ( _publicInterface->doesTemporalClipAccess() || !args.renderArgs->getCurrentTilesSupport() ) {
+        return false;
+    }
+
+    // The DiskCache node exists to cache its input
+    if ( node->getPluginID() == PLUGINID_NATRON_DISKCACHE ) {
+        return false;
+    }
+
+    NodeGroupPtr parentIsGroup = toNodeGroup( node->getGroup() );
+    if ( parentIsGroup && parentIsGroup->getNode()->isForceCachingEnabled() && (parentIsGroup->getOutputNodeInput() == node) ) {
+        // Caching was forced on the Group, which caches the input of its output node
+        return false;
+    }
+
+    // Paint strokes are rendered incrementally on top of the previously cached image
+    if ( node->isDuringPaintStrokeCreation() || node->getAttachedRotoItem() ) {
+        return false;
+    }
+    return true;
+} // canBypassCacheForReuse
+
+int
+EffectInstance::Implementation::getTileSizeClassForRender(const RenderRoIArgs & args,
+                                                          const RectD& rod,
+                                                          double par)
+{
+    int forcedTileSizeClass = appPTR->getCurrentSettings()->getTileSizeClass();
+    if (forcedTileSizeClass >= 0) {
+        return forcedTileSizeClass;
+    }
+
+    const RenderScale& mappedCombinedScale = args.proxyScale;
+    RectI pixelRoD;
+    rod.toPixelEnclosing(mappedCombinedScale, par, &pixelRoD);
+
+    ImageBitDepthEnum outputBitDepth = _publicInterface->getBitDepth(args.renderArgs, -1);
+
+    // The kernel footprint is the largest distance, in pixels, by which the effect reads its inputs
+    // outside of the region it renders. If tiles are not supported the image is rendered at once anyway.
+    int kernelFootprint = 0;
+    if (args.renderArgs->getCurrentTilesSupport()) {
+        RoIMap inputsRoI;
+        ActionRetCodeEnum stat = _publicInterface->getRegionsOfInterest_public(args.time, mappedCombinedScale, rod, args.view, args.renderArgs, &inputsRoI);
+        if (!isFailureRetCode(stat)) {
+            for (RoIMap::const_iterator it = inputsRoI.begin(); it != inputsRoI.end(); ++it) {
+                const RectD& roi = it->second;
+                if ( roi.isNull() || roi.isInfinite() ) {
+                    continue;
+                }
+                double footprintX = std::max(rod.x1 - roi.x1, roi.x2 - rod.x2) * mappedCombinedScale.x / par;
+                double footprintY = std::max(rod.y1 - roi.y1, roi.y2 - rod.y2) * mappedCombinedScale.y;
+                kernelFootprint = std::max( kernelFootprint, (int)std::ceil( std::max(footprintX, footprintY) ) );
+            }
+        }
+    }
+
+    return Cache::getTileSizeClassForImage(outputBitDepth, pixelRoD, kernelFootprint);
+} // getTileSizeClassForRender
+
 
 
 
@@ -213,6 +323,13 @@ EffectInstance::Implementation::tiledRenderingFunctor(EffectInstance::Implementa
         appPTR->getAppTLS()->copyTLS(callingThread, curThread);
     }
 
+    // Tiles of a render that only fills the cache ahead of time must not compete with the other renders
+    // sharing the thread pool: lower the priority of this thread while it renders the tile.
+    QThread::Priority threadPriority = curThread->priority();
+    bool lowerPriority = args.args->renderArgs->getParentRender()->isLowPriorityRender() && (threadPriority != QThread::LowestPriority);
+    if (lowerPriority) {
+        curThread->setPriority(QThread::LowestPriority);
+    }
 
     ActionRetCodeEnum ret = tiledRenderingFunctor(specificData,
                                                   args.args,
@@ -222,6 +339,11 @@ EffectInstance::Implementation::tiledRenderingFunctor(EffectInstance::Implementa
                                                   args.planesToRender,
                                                   args.glContext);
 
+    if (lowerPriority) {
+        // Thread-pool threads report InheritPriority, which cannot be set back
+        curThread->setPriority(threadPriority == QThread::InheritPriority ? QThread::NormalPriority : threadPriority);
+    }
+
     //Exit of the host frame threading thread
     if (callingThread != curThread) {
         appPTR->getAppTLS()->cleanupTLSForThread();
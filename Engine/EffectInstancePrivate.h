@@ -138,10 +138,31 @@ public:
 
     /**
      * @brief Helper function in the implementation of renderRoI to determine if a render should use the Cache or not.
+     * Nodes that shouldCacheOutput() would cache are not cached if they could do without the cache and
+     * their cached outputs are measured to be rarely re-read (see CacheReuseStats).
+     * The cacheReuseKey is the key of the node returned by CacheReuseStats::getNodeKey().
      * @returns The cache access type, i.e: none, write only or read/write
      **/
     CacheAccessModeEnum shouldRenderUseCache(const RenderRoIArgs & args,
-                                             const FrameViewRequestPtr& requestPassData);
+                                             const FrameViewRequestPtr& requestPassData,
+                                             U64 cacheReuseKey);
+
+    /**
+     * @brief Returns true if nothing but the measured reuse of the cached outputs justifies caching the output of the render:
+     * the node has a single consumer, reads only the current frame of its inputs, supports tiles and neither it
+     * nor its output is being edited. Nodes whose caching is forced (force caching on the node or its Group,
+     * DiskCache node) or that belong to a paint stroke are never bypassed.
+     **/
+    bool canBypassCacheForReuse(const RenderRoIArgs & args,
+                                int requestsCount) const;
+
+    /**
+     * @brief Helper function in the implementation of renderRoI to determine the size class of the tiles of the cached
+     * output images at mipmap level 0, from the size of the image and the amount of pixels the effect reads around each output pixel.
+     **/
+    int getTileSizeClassForRender(const RenderRoIArgs & args,
+                                  const RectD& rod,
+                                  double par);
 
     bool canSplitRenderWindowWithIdentityRectangles(const RenderRoIArgs& args,
                                                     const RenderScale& renderMappedScale,
@@ -61,6 +61,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/Cache.h"
 #include "Engine/CacheEntryBase.h"
 #include "Engine/CacheEntryKeyBase.h"
+#include "Engine/CacheReuseStats.h"
 #include "Engine/Image.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
@@ -74,6 +75,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/OSGLContext.h"
 #include "Engine/GPUContextPool.h"
+#include "Engine/Hash64.h"
 #include "Engine/PluginMemory.h"
 #include "Engine/Project.h"
 #include "Engine/RenderStats.h"
@@ -91,8 +93,43 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/ViewerInstance.h"
 
 
+// When a render has a priority point (e.g: interactive viewer renders), the render window is split in this many
+// rectangles per thread so that the thread pool picks them in a center-out order
+#define NATRON_PRIORITIZED_RENDER_SPLITS_PER_THREAD 4
+
 NATRON_NAMESPACE_ENTER;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Orders rectangles by the distance of their center to a point.
+ **/
+class RectDistanceToPointLess
+{
+    Point _point;
+
+public:
+
+    RectDistanceToPointLess(const Point& point)
+    : _point(point)
+    {
+    }
+
+    double distanceSquared(const RectI& rect) const
+    {
+        double dx = (rect.x1 + rect.x2) / 2. - _point.x;
+        double dy = (rect.y1 + rect.y2) / 2. - _point.y;
+        return dx * dx + dy * dy;
+    }
+
+    bool operator() (const RectI& lhs, const RectI& rhs) const
+    {
+        return distanceSquared(lhs) < distanceSquared(rhs);
+    }
+};
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 /*
  * @brief Split all rects to render in smaller rects and check if each one of them is identity.
  * For identity rectangles, we just call renderRoI again on the identity input in the tiledRenderingFunctor.
@@ -463,7 +500,31 @@ EffectInstance::Implementation::handleConcatenation(const EffectInstance::Render
     }
 
     // And then push our distortion to the stack...
-    results->distortionStack->pushDistortion(disto);
+    U64 hash;
+    {
+        ComputeHashArgs hashArgs;
+        hashArgs.render = args.renderArgs;
+        hashArgs.time = args.time;
+        hashArgs.view = args.view;
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        hash = _publicInterface->computeHash(hashArgs);
+    }
+    results->distortionStack->pushDistortion(disto, hash);
+
+    // If enabled, bake the stack over our region of definition: the caller evaluates it for each of its pixels.
+    // This is overridden by downstream distortions concatenating with us.
+    double warpGridTolerance = args.renderArgs->getParentRender()->getDistortionWarpGridTolerance();
+    if (warpGridTolerance > 0.) {
+        GetRegionOfDefinitionResultsPtr rodResults;
+        ActionRetCodeEnum stat = _publicInterface->getRegionOfDefinition_public(args.time, renderScale, args.view, args.renderArgs, &rodResults);
+        if (!isFailureRetCode(stat)) {
+            // The stack is applied to canonical positions: the tolerance, in pixels, is converted to canonical units
+            // along the axis where a pixel is the smallest
+            double par = _publicInterface->getAspectRatio(args.renderArgs, -1);
+            double canonicalTolerance = warpGridTolerance * std::min(par / renderScale.x, 1. / renderScale.y);
+            results->distortionStack->setWarpGridParameters(rodResults->getRoD(), args.time, args.view, renderScale, canonicalTolerance);
+        }
+    }
 
     *concatenated = true;
 
@@ -613,11 +674,21 @@ EffectInstance::Implementation::computeRectanglesToRender(const RenderRoIArgs& a
 
             std::vector<RectI> splits;
             if (nThreads > 1) {
-                splits = renderWindow.splitIntoSmallerRects(nThreads);
+                unsigned int nSplits = nThreads;
+                if (planesToRender->priorityPointSet) {
+                    nSplits *= NATRON_PRIORITIZED_RENDER_SPLITS_PER_THREAD;
+                }
+                splits = renderWindow.splitIntoSmallerRects(nSplits);
             } else {
                 splits.push_back(renderWindow);
             }
 
+            // QtConcurrent::mapped hands the rectangles to the threads in the list order: render first the ones closest
+            // to the point the user is looking at.
+            if (planesToRender->priorityPointSet && splits.size() > 1) {
+                std::stable_sort(splits.begin(), splits.end(), RectDistanceToPointLess(planesToRender->priorityPoint));
+            }
+
             for (std::vector<RectI>::iterator it = splits.begin(); it != splits.end(); ++it) {
                 if (!it->isNull()) {
                     RectToRender r;
@@ -651,15 +722,25 @@ EffectInstance::Implementation::checkPlanesToRenderAndComputeRectanglesToRender(
         for (std::map<ImagePlaneDesc, PlaneToRender>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
 
             // If the image is entirely cached, do not even compute it and insert it in the output planes map
-            bool planeHasPendingResults;
+            bool planeHasPendingResults = false;
             std::list<RectI> restToRender = it->second.cacheImage->getRestToRender(&planeHasPendingResults);
 
             if (restToRender.empty() && !planeHasPendingResults) {
-                (*outputPlanes)[it->first] = it->second.cacheImage;
+                (*outputPlanes)[it->first] = it->second.renderedImage ? it->second.renderedImage : it->second.cacheImage;
                 continue;
             }
 
-            planesToRender->planes.insert(*it);
+            PlaneToRender& plane = planesToRender->planes[it->first];
+            plane = it->second;
+
+            // Check if all the tiles of the cache image are left to render by this thread
+            {
+                U64 restToRenderArea = 0;
+                for (std::list<RectI>::const_iterator it2 = restToRender.begin(); it2 != restToRender.end(); ++it2) {
+                    restToRenderArea += (U64)it2->area();
+                }
+                plane.tmpImageCoversCacheImage = !planeHasPendingResults && restToRenderArea == (U64)it->second.cacheImage->getBounds().area();
+            }
 
             // if there's nothing left to render but only pending results, do not mark it has a portion to render.
             if (restToRender.empty()) {
@@ -723,13 +804,18 @@ EffectInstance::Implementation::checkPlanesToRenderAndComputeRectanglesToRender(
     }
 
 
-    if (cacheAccess != eCacheAccessModeNone && (cacheBufferLayout != pluginBufferLayout) && !renderWindow.isNull()) {
+    if (cacheAccess != eCacheAccessModeNone && !renderWindow.isNull()) {
 
         // The bitdepth of the image
         ImageBitDepthEnum outputBitDepth = _publicInterface->getBitDepth(args.renderArgs, -1);
 
         for (std::map<ImagePlaneDesc, PlaneToRender>::iterator it = planesToRender->planes.begin(); it != planesToRender->planes.end(); ++it) {
 
+            // The cache image may be stored with a lower bitdepth than what the plug-in renders, see fetchOrCreateOutputPlanes
+            if ( (cacheBufferLayout == pluginBufferLayout) && (it->second.cacheImage->getBitDepth() == outputBitDepth) ) {
+                continue;
+            }
+
             // The image planes left are not entirely cached (or not at all): create a temporary image
             // with the memory layout supported by the plug-in that we will write to.
             // When the temporary image will be destroyed, it will automatically copy pixels
@@ -738,6 +824,9 @@ EffectInstance::Implementation::checkPlanesToRenderAndComputeRectanglesToRender(
             {
                 tmpImgInitArgs.bounds = renderWindow;
                 tmpImgInitArgs.renderArgs = args.renderArgs;
+                // The temporary image may be returned instead of the cache image: it must be at the same scale
+                tmpImgInitArgs.proxyScale = it->second.cacheImage->getProxyScale();
+                tmpImgInitArgs.mipMapLevel = it->second.cacheImage->getMipMapLevel();
                 tmpImgInitArgs.cachePolicy = eCacheAccessModeNone;
                 tmpImgInitArgs.bufferFormat = pluginBufferLayout;
                 tmpImgInitArgs.glContext = glContextLocker ? glContextLocker->getContext() : OSGLContextPtr();
@@ -865,6 +954,20 @@ EffectInstance::Implementation::fetchOrCreateOutputPlanes(const RenderRoIArgs &
         }
     } // isDrawing
 
+    // Intermediate float images may be stored in the cache as half to fit twice as many images. The plug-in still renders
+    // to a float temporary image which is converted when its pixels are copied to the cache image.
+    // The root of the tree is excluded since its output is handed as is to the viewer or the caller of the render,
+    // and accumulation buffers are excluded since each stroke step would lose precision.
+    ImageBitDepthEnum cacheBitDepth = outputBitDepth;
+    if (cacheAccess != eCacheAccessModeNone &&
+        outputBitDepth == eImageBitDepthFloat &&
+        args.renderArgs->getParentRender()->getTreeRoot()->getEffectInstance().get() != _publicInterface &&
+        planesToRender->backendType != eRenderBackendTypeOpenGL &&
+        (!attachedStroke || !attachedStroke->isCurrentlyDrawing()) &&
+        appPTR->getCurrentSettings()->isCacheFloatImagesAsHalfEnabled()) {
+        cacheBitDepth = eImageBitDepthHalf;
+    }
+
     // For each requested components, create the corresponding image plane.
     // If this plug-in does not use the cache, we directly allocate an image using the plug-in preferred buffer format.
     // If using the cache, the image has to be in a mono-channel tiled format, hence we later create a temporary copy
@@ -885,7 +988,9 @@ EffectInstance::Implementation::fetchOrCreateOutputPlanes(const RenderRoIArgs &
             initArgs.view = args.view;
             initArgs.storage = cacheStorage;
             initArgs.bufferFormat = cacheBufferLayout;
-            initArgs.bitdepth = outputBitDepth;
+            initArgs.tileSizeClass = planesToRender->tileSizeClass;
+            initArgs.mipMapLevel0TileSizeClass = planesToRender->mipMapLevel0TileSizeClass;
+            initArgs.bitdepth = cacheBitDepth;
             initArgs.layer = *it;
 
             // Do not allocate the image buffers yet since we initialize the image BEFORE recursing on input nodes.
@@ -945,8 +1050,12 @@ EffectInstance::Implementation::launchRenderAndWaitForPendingTiles(const RenderR
         for (std::map<ImagePlaneDesc, PlaneToRender>::iterator it = planesToRender->planes.begin(); it != planesToRender->planes.end(); ++it) {
             if (it->second.cacheImage->getCachePolicy() != eCacheAccessModeNone) {
 
-                // Destroy the temporary image if there was any.
-                // The cached image has been copied from the temporary image in tiledRenderingFunctor
+                // The cached image has been copied from the temporary image in tiledRenderingFunctor.
+                // If the temporary image holds the whole plane in the plug-in preferred layout, keep it
+                // to return it instead of the cache image, otherwise destroy it.
+                if (it->second.tmpImage != it->second.cacheImage && it->second.tmpImageCoversCacheImage && it->second.tmpImage->getStorageMode() == eStorageModeRAM) {
+                    it->second.renderedImage = it->second.tmpImage;
+                }
                 it->second.tmpImage.reset();
 
                 // Push to the cache the tiles that we rendered
@@ -1241,7 +1350,8 @@ EffectInstance::renderRoI(const RenderRoIArgs & args, RenderRoIResults* results)
     ////////////////////////////// Compute RoI depending on render scale ///////////////////////////////////////////////////
 
     // Should the output of this render be cached ?
-    CacheAccessModeEnum cacheAccess = _imp->shouldRenderUseCache(args, requestPassData);
+    const U64 cacheReuseKey = getNode()->getCacheReuseKey();
+    CacheAccessModeEnum cacheAccess = _imp->shouldRenderUseCache(args, requestPassData, cacheReuseKey);
 
     // The RoD in pixel coordinates at the scale of renderMappedScale
     RectI pixelRoDRenderMapped;
@@ -1252,6 +1362,19 @@ EffectInstance::renderRoI(const RenderRoIArgs & args, RenderRoIResults* results)
 
     rod.toPixelEnclosing(mappedCombinedScale, par, &pixelRoDRenderMapped);
 
+    // Larger tiles for effects with a large kernel so that each tile does not read much more than itself from the inputs.
+    // The class is computed once per frame/view at level 0. Each mipmap level halves both dimensions of the tiles (2 classes)
+    // so that a tile of level 0 is downscaled to exactly one tile of this level.
+    if (cacheAccess != eCacheAccessModeNone) {
+        int level0TileSizeClass;
+        if ( !requestPassData->getTileSizeClass(&level0TileSizeClass) ) {
+            level0TileSizeClass = _imp->getTileSizeClassForRender(args, rod, par);
+            requestPassData->setTileSizeClass(level0TileSizeClass);
+        }
+        planesToRender->mipMapLevel0TileSizeClass = level0TileSizeClass;
+        planesToRender->tileSizeClass = std::max(0, level0TileSizeClass - 2 * (int)mappedMipMapLevel);
+    }
+
     if (!args.renderArgs->getCurrentTilesSupport()) {
         // If tiles are not supported the RoI is the full image bounds
         renderMappedRoI = pixelRoDRenderMapped;
@@ -1261,7 +1384,7 @@ EffectInstance::renderRoI(const RenderRoIArgs & args, RenderRoIResults* results)
         if (cacheAccess != eCacheAccessModeNone) {
             ImageBitDepthEnum outputBitDepth = getBitDepth(args.renderArgs, -1);
             int tileWidth, tileHeight;
-            Cache::getTileSizePx(outputBitDepth, &tileWidth, &tileHeight);
+            Cache::getTileSizePx(outputBitDepth, planesToRender->tileSizeClass, &tileWidth, &tileHeight);
 
             RectI tiledRoundedRoI = renderMappedRoI;
 
@@ -1295,10 +1418,25 @@ EffectInstance::renderRoI(const RenderRoIArgs & args, RenderRoIResults* results)
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////// Allocate images and look-up cache ///////////////////////////////////////////////////////
 
+    // Map the priority point of the render to the pixel coordinates of the render window
+    {
+        Point canonicalPriorityPoint;
+        if ( renderObj->getPriorityPoint(&canonicalPriorityPoint) ) {
+            planesToRender->priorityPoint.x = canonicalPriorityPoint.x * mappedCombinedScale.x / par;
+            planesToRender->priorityPoint.y = canonicalPriorityPoint.y * mappedCombinedScale.y;
+            planesToRender->priorityPointSet = true;
+        }
+    }
+
     _imp->fetchOrCreateOutputPlanes(args, requestPassData, cacheAccess, planesToRender, requestedPlanes, renderMappedRoI, mappedCombinedScale, args.proxyScale, mappedMipMapLevel, glContextLocker, &results->outputPlanes);
 
     bool hasSomethingToRender = !planesToRender->rectsToRender.empty();
 
+    // Measure how often cached outputs are re-read, to decide whether this node should keep being cached
+    if ( (cacheAccess == eCacheAccessModeReadWrite) && !hasSomethingToRender ) {
+        appPTR->getCacheReuseStats()->notifyOutputReadFromCache(cacheReuseKey);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////// Pre-render input images ////////////////////////////////////////////////////////////////
     if (hasSomethingToRender) {
@@ -1322,7 +1460,28 @@ EffectInstance::renderRoI(const RenderRoIArgs & args, RenderRoIResults* results)
 
     ActionRetCodeEnum renderRetCode = eActionStatusOK;
     if (hasSomethingToRender) {
+        double nPixelsToRender = 0;
+        for (std::list<RectToRender>::const_iterator it = planesToRender->rectsToRender.begin(); it != planesToRender->rectsToRender.end(); ++it) {
+            nPixelsToRender += (double)it->rect.area();
+        }
+        TimeLapse renderTimer;
         renderRetCode = _imp->launchRenderAndWaitForPendingTiles(args, planesToRender, glContextLocker, cacheAccess, renderMappedRoI, mappedCombinedScale, processChannels, inputLayersNeeded, &results->outputPlanes);
+        // The bands of a streaming render are consumed right away and never go through the statistics (see shouldRenderUseCache)
+        if ( (renderRetCode == eActionStatusOK) && !renderObj->isStreamingRender() ) {
+            // Identify the image rendered so that images rendered again without the cache are counted as re-read.
+            // Different portions of the same frame are different outputs.
+            Hash64 outputHash;
+            U64 frameViewHash = 0;
+            requestPassData->getHash(&frameViewHash);
+            outputHash.append(frameViewHash);
+            outputHash.append(mappedMipMapLevel);
+            outputHash.append(renderMappedRoI.x1);
+            outputHash.append(renderMappedRoI.y1);
+            outputHash.append(renderMappedRoI.x2);
+            outputHash.append(renderMappedRoI.y2);
+            outputHash.computeHash();
+            appPTR->getCacheReuseStats()->notifyOutputRendered(cacheReuseKey, outputHash.value(), cacheAccess != eCacheAccessModeNone, renderTimer.getTimeSinceCreation(), nPixelsToRender);
+        }
     }
 
     // Now that this effect has rendered, clear pre-rendered inputs
@@ -74,6 +74,7 @@ DEPENDPATH += $$PWD/NatronEngine
 DEPENDPATH += $$PWD/../Global
 
 SOURCES += \
+    ActionResultsCache.cpp \
     AnimatingObjectI.cpp \
     AppInstance.cpp \
     AppManager.cpp \
@@ -84,6 +85,7 @@ SOURCES += \
     Cache.cpp \
     CacheEntryBase.cpp \
     CacheEntryKeyBase.cpp \
+    CacheReuseStats.cpp \
     CLArgs.cpp \
     CoonsRegularization.cpp \
     ColorParser.cpp \
@@ -111,6 +113,7 @@ SOURCES += \
     GroupInput.cpp \
     GroupOutput.cpp \
     HashableObject.cpp \
+    Half.cpp \
     Hash64.cpp \
     HistogramCPU.cpp \
     HostOverlaySupport.cpp \
@@ -139,6 +142,7 @@ SOURCES += \
     Markdown.cpp \
     MemoryFile.cpp \
     MultiThread.cpp \
+    MemoryGovernor.cpp \
     MemoryInfo.cpp \
     Node.cpp \
     NodeChannelSelectors.cpp \
@@ -192,7 +196,10 @@ SOURCES += \
     RenderValuesCache.cpp \
     RectD.cpp \
     RectI.cpp \
+    RenderBatch.cpp \
     RenderStats.cpp \
+    RenderTrace.cpp \
+    RenderWorkers.cpp \
     RenderQueue.cpp \
     RotoBezierTriangulation.cpp \
     RotoDrawableItem.cpp \
@@ -302,6 +309,7 @@ SOURCES += \
 
 
 HEADERS += \
+    ActionResultsCache.h \
     AfterQuitProcessingI.h \
     AnimatingObjectI.h \
     AppInstance.h \
@@ -316,6 +324,7 @@ HEADERS += \
     Cache.h \
     CacheEntryBase.h \
     CacheEntryKeyBase.h \
+    CacheReuseStats.h \
     CoonsRegularization.h \
     ChoiceOption.h \
     Color.h \
@@ -349,6 +358,7 @@ HEADERS += \
     GroupInput.h \
     GroupOutput.h \
     HashableObject.h \
+    Half.h \
     Hash64.h \
     HistogramCPU.h \
     HostOverlaySupport.h \
@@ -378,6 +388,7 @@ HEADERS += \
     Lut.h \
     Markdown.h \
     MemoryFile.h \
+    MemoryGovernor.h \
     MemoryInfo.h \
     MergingEnum.h \
     MultiThread.h \
@@ -432,7 +443,10 @@ HEADERS += \
     ReadNode.h \
     RectD.h \
     RectI.h \
+    RenderBatch.h \
     RenderStats.h \
+    RenderTrace.h \
+    RenderWorkers.h \
     RenderValuesCache.h \
     RenderQueue.h \
     RotoBezierTriangulation.h \
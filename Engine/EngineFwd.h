@@ -123,6 +123,7 @@ typedef boost::shared_ptr<SequenceFromFiles> SequenceFromFilesPtr;
 
 NATRON_NAMESPACE_ENTER;
 class AbortableRenderInfo;
+class ActionResultsCache;
 class AbortableThread;
 class AbstractOfxEffectInstance;
 class AfterQuitProcessingI;
@@ -142,6 +143,7 @@ class CacheSignalEmitter;
 class CacheEntryKeyBase;
 class CacheEntryBase;
 class CacheEntryLocker;
+class CacheReuseStats;
 class CompNodeItem;
 class CreateNodeArgs;
 class Curve;
@@ -149,6 +151,8 @@ class DimIdx;
 class DiskCacheNode;
 struct DistortionFunction2D;
 class Distortion2DStack;
+class Distortion2DWarpGrid;
+class Distortion2DWarpGridKey;
 class DockablePanelI;
 class Dot;
 class EffectInstance;
@@ -225,6 +229,7 @@ class LayeredCompNode;
 class LibraryBinary;
 class LogEntry;
 class MemoryFile;
+class MemoryGovernor;
 class ImageStorageBase;
 class CacheImageTileStorage;
 class MultiThread;
@@ -266,6 +271,7 @@ class RAMImageStorage;
 class ReadNode;
 class RectD;
 class RectI;
+class RenderBatch;
 class RenderEngine;
 class RenderStats;
 class RenderValuesCache;
@@ -341,6 +347,8 @@ typedef boost::shared_ptr<CreateNodeArgs> CreateNodeArgsPtr;
 typedef boost::shared_ptr<DiskCacheNode> DiskCacheNodePtr;
 typedef boost::shared_ptr<DistortionFunction2D> DistortionFunction2DPtr;
 typedef boost::shared_ptr<Distortion2DStack> Distortion2DStackPtr;
+typedef boost::shared_ptr<Distortion2DWarpGrid> Distortion2DWarpGridPtr;
+typedef boost::shared_ptr<Distortion2DWarpGridKey> Distortion2DWarpGridKeyPtr;
 typedef boost::shared_ptr<Dot> DotPtr;
 typedef boost::shared_ptr<EffectInstance> EffectInstancePtr;
 typedef boost::shared_ptr<EffectInstance const> EffectInstanceConstPtr;
@@ -429,6 +437,7 @@ typedef boost::shared_ptr<PluginGroupNode> PluginGroupNodePtr;
 typedef boost::shared_ptr<PluginMemory> PluginMemoryPtr;
 typedef boost::shared_ptr<RAMImageStorage> RAMImageStoragePtr;
 typedef boost::shared_ptr<ReadNode> ReadNodePtr;
+typedef boost::shared_ptr<RenderBatch> RenderBatchPtr;
 typedef boost::shared_ptr<RenderEngine> RenderEnginePtr;
 typedef boost::shared_ptr<RenderValuesCache> RenderValuesCachePtr;
 typedef boost::shared_ptr<RenderStats> RenderStatsPtr;
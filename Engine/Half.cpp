@@ -0,0 +1,159 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Half.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/static_assert.hpp>
+#endif
+
+// The F16C code is compiled with a target attribute and selected at runtime, so that it does not require
+// building with -mf16c
+#if ( defined(__x86_64__) || defined(__i386__) ) && \
+    ( defined(__clang__) || ( defined(__GNUC__) && ( __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) ) ) )
+#define NATRON_HALF_F16C_DISPATCH
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+NATRON_NAMESPACE_ENTER;
+
+// Images of half are accessed as arrays of 16-bit values
+BOOST_STATIC_ASSERT(sizeof(Half) == 2);
+
+#ifdef NATRON_HALF_F16C_DISPATCH
+
+// The 256-bit conversions need F16C and AVX, and the OS must save the AVX registers
+static bool
+cpuHasF16C()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if ( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ) {
+        return false;
+    }
+    const unsigned int osxsaveBit = 1u << 27;
+    const unsigned int avxBit = 1u << 28;
+    const unsigned int f16cBit = 1u << 29;
+    if ( (ecx & (osxsaveBit | avxBit | f16cBit)) != (osxsaveBit | avxBit | f16cBit) ) {
+        return false;
+    }
+    // xgetbv with ecx = 0: the XMM and YMM states must be enabled
+    unsigned int xcr0Low, xcr0High;
+    __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+
+    return (xcr0Low & 0x6) == 0x6;
+}
+
+__attribute__((target("avx,f16c")))
+static std::size_t
+toFloatF16C(const Half* src,
+            float* dst,
+            std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128( reinterpret_cast<const __m128i*>(src + i) );
+        _mm256_storeu_ps( dst + i, _mm256_cvtph_ps(h) );
+    }
+
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static std::size_t
+fromFloatF16C(const float* src,
+              Half* dst,
+              std::size_t count)
+{
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 f = _mm256_loadu_ps(src + i);
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT) );
+    }
+
+    return i;
+}
+
+static const bool gCpuHasF16C = cpuHasF16C();
+
+#else // !NATRON_HALF_F16C_DISPATCH
+
+static const bool gCpuHasF16C = false;
+
+#endif // NATRON_HALF_F16C_DISPATCH
+
+static bool gUseF16C = gCpuHasF16C;
+
+bool
+Half::isHardwareConversionEnabled()
+{
+    return gUseF16C;
+}
+
+bool
+Half::setHardwareConversionEnabled(bool enabled)
+{
+    gUseF16C = enabled && gCpuHasF16C;
+
+    return gUseF16C;
+}
+
+void
+Half::toFloat(const Half* src,
+              float* dst,
+              std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef NATRON_HALF_F16C_DISPATCH
+    if (gUseF16C) {
+        i = toFloatF16C(src, dst, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = bitsToFloat(src[i]._bits);
+    }
+}
+
+void
+Half::fromFloat(const float* src,
+                Half* dst,
+                std::size_t count)
+{
+    std::size_t i = 0;
+
+#ifdef NATRON_HALF_F16C_DISPATCH
+    if (gUseF16C) {
+        i = fromFloatF16C(src, dst, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i]._bits = floatToBits(src[i]);
+    }
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,191 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_HALF_H
+#define NATRON_ENGINE_HALF_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "Global/GlobalDefines.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A 16-bit IEEE 754 floating point value (1 sign bit, 5 exponent bits, 10 mantissa bits), the storage
+ * type of eImageBitDepthHalf images. It has the same layout as the OpenEXR and OpenFX half types.
+ * It converts implicitly from and to float so that the pixel processing templates written for float
+ * work unmodified: all arithmetic is done in float.
+ * Single values are converted in software with round to nearest even. The buffer conversions use the
+ * F16C instructions when the CPU supports them, which give the same results.
+ **/
+class Half
+{
+public:
+
+    // Uninitialized, like the built-in types
+    Half()
+    {
+    }
+
+    Half(float f)
+        : _bits( floatToBits(f) )
+    {
+    }
+
+    operator float() const
+    {
+        return bitsToFloat(_bits);
+    }
+
+    Half& operator+=(float f)
+    {
+        *this = Half(bitsToFloat(_bits) + f);
+
+        return *this;
+    }
+
+    Half& operator-=(float f)
+    {
+        *this = Half(bitsToFloat(_bits) - f);
+
+        return *this;
+    }
+
+    Half& operator*=(float f)
+    {
+        *this = Half(bitsToFloat(_bits) * f);
+
+        return *this;
+    }
+
+    Half& operator/=(float f)
+    {
+        *this = Half(bitsToFloat(_bits) / f);
+
+        return *this;
+    }
+
+    U16 bits() const
+    {
+        return _bits;
+    }
+
+    static Half fromBits(U16 bits)
+    {
+        Half ret;
+
+        ret._bits = bits;
+
+        return ret;
+    }
+
+    static U16 floatToBits(float f)
+    {
+        // From "half <-> float conversion" by F. Giesen, rounding to nearest even
+        U32 u;
+        std::memcpy( &u, &f, sizeof(U32) );
+        const U32 sign = u & 0x80000000u;
+        u ^= sign;
+
+        U32 ret;
+        if (u >= 0x47800000u) {
+            // Overflow, infinity or NaN: NaN maps to a quiet NaN, everything else to infinity
+            ret = (u > 0x7f800000u) ? 0x7e00u : 0x7c00u;
+        } else if (u < 0x38800000u) {
+            // The result is a denormal or zero: let the FPU do the rounding by adding 0.5
+            const U32 denormMagicBits = 126u << 23;
+            float denormMagic;
+            std::memcpy( &denormMagic, &denormMagicBits, sizeof(float) );
+            float tmp;
+            std::memcpy( &tmp, &u, sizeof(float) );
+            tmp += denormMagic;
+            std::memcpy( &u, &tmp, sizeof(U32) );
+            ret = u - denormMagicBits;
+        } else {
+            const U32 mantissaOdd = (u >> 13) & 1;
+            // Rebias the exponent and round
+            u += (U32)(15 - 127) << 23;
+            u += 0xfff + mantissaOdd;
+            ret = u >> 13;
+        }
+
+        return (U16)( ret | (sign >> 16) );
+    }
+
+    static float bitsToFloat(U16 h)
+    {
+        const U32 shiftedExponent = 0x7c00u << 13;
+        U32 u = (U32)(h & 0x7fff) << 13;
+        const U32 exponent = shiftedExponent & u;
+        u += (U32)(127 - 15) << 23;
+        if (exponent == shiftedExponent) {
+            // Infinity or NaN
+            u += (U32)(128 - 16) << 23;
+        } else if (exponent == 0) {
+            // Zero or denormal: renormalize
+            u += 1u << 23;
+            const U32 magicBits = 113u << 23;
+            float magic, tmp;
+            std::memcpy( &magic, &magicBits, sizeof(float) );
+            std::memcpy( &tmp, &u, sizeof(float) );
+            tmp -= magic;
+            std::memcpy( &u, &tmp, sizeof(U32) );
+        }
+        u |= (U32)(h & 0x8000) << 16;
+        float ret;
+        std::memcpy( &ret, &u, sizeof(float) );
+
+        return ret;
+    }
+
+    /**
+     * @brief Convert count contiguous values. These use the 8-wide F16C instructions when the CPU supports
+     * them and are the preferred way to convert scan-lines.
+     **/
+    static void toFloat(const Half* src, float* dst, std::size_t count);
+    static void fromFloat(const float* src, Half* dst, std::size_t count);
+
+    /**
+     * @brief Returns true if toFloat() and fromFloat() use the F16C instructions.
+     **/
+    static bool isHardwareConversionEnabled();
+
+    /**
+     * @brief Use the F16C instructions in toFloat() and fromFloat() if enabled is true and the CPU supports them,
+     * otherwise convert in software. This is detected at startup and only meant to be changed by tests.
+     * Returns whether the F16C instructions are used.
+     **/
+    static bool setHardwareConversionEnabled(bool enabled);
+
+private:
+
+    U16 _bits;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_HALF_H
@@ -55,6 +55,34 @@ Hash64::computeHash()
     hashValid = true;
 }
 
+U64
+Hash64::getPrefixState() const
+{
+    boost::crc_optimal<64, 0x42F0E1EBA9EA3693ULL, 0, 0, false, false> crc_64;
+    if ( !node_values.empty() ) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>( &node_values.front() );
+        crc_64 = std::for_each( data, data + node_values.size() * sizeof(node_values[0]), crc_64 );
+    }
+    return crc_64.get_interim_remainder();
+}
+
+void
+Hash64::computeHashFromPrefixState(U64 prefixState)
+{
+    if (hashValid) {
+        return;
+    }
+
+    // The checksum has no reflection nor final xor: the interim remainder can be used as an initial remainder
+    boost::crc_optimal<64, 0x42F0E1EBA9EA3693ULL, 0, 0, false, false> crc_64(prefixState);
+    if ( !node_values.empty() ) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>( &node_values.front() );
+        crc_64 = std::for_each( data, data + node_values.size() * sizeof(node_values[0]), crc_64 );
+    }
+    hash = crc_64();
+    hashValid = true;
+}
+
 void
 Hash64::reset()
 {
@@ -70,6 +70,19 @@ public:
 
     void computeHash();
 
+    /**
+     * @brief Returns the state of the checksum after all the values appended so far.
+     * Several hashes starting with the same values may then be computed with computeHashFromPrefixState
+     * without processing these values again.
+     **/
+    U64 getPrefixState() const;
+
+    /**
+     * @brief Same as computeHash(), except that the values appended to this object are hashed
+     * as if they followed the values from which prefixState was obtained.
+     **/
+    void computeHashFromPrefixState(U64 prefixState);
+
     void reset();
 
     bool valid() const
@@ -492,6 +492,9 @@ HistogramCPU::run()
             args->draftMode = false;
             args->playback = false;
             args->byPassCache = false;
+            args->streaming = false;
+            args->priorityPoint = 0;
+            args->lowPriority = false;
             
             TreeRenderPtr render = TreeRender::create(args);
             std::map<ImagePlaneDesc, ImagePtr> planes;
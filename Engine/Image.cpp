@@ -32,6 +32,7 @@
 #include <QtCore/QDebug>
 
 #include "Engine/ImagePrivate.h"
+#include "Engine/RenderTrace.h"
 
 
 #ifndef M_LN2
@@ -128,6 +129,8 @@ Image::InitStorageArgs::InitStorageArgs()
 , components()
 , cachePolicy(eCacheAccessModeNone)
 , bufferFormat(eImageBufferLayoutRGBAPackedFullRect)
+, tileSizeClass(0)
+, mipMapLevel0TileSizeClass(-1)
 , proxyScale(1.)
 , mipMapLevel(0)
 , isDraft(false)
@@ -152,6 +155,7 @@ class TileFetcherProcessor : public MultiThreadProcessorBase
     int _tileSizeX, _tileSizeY;
     ImagePrivate* _imp;
     const Image::InitStorageArgs* _args;
+    const ImageTilesInitData* _initData;
 
 public:
 
@@ -166,7 +170,7 @@ public:
 
     }
 
-    void setData(ImagePrivate* imp, const Image::InitStorageArgs* args, int nTilesWidth, int nTilesHeight, int tileSizeX, int tileSizeY)
+    void setData(ImagePrivate* imp, const Image::InitStorageArgs* args, const ImageTilesInitData* initData, int nTilesWidth, int nTilesHeight, int tileSizeX, int tileSizeY)
     {
         // Initialize each tile
         int tx = 0, ty = 0;
@@ -193,6 +197,7 @@ public:
         _tileSizeY = tileSizeY;
         _imp = imp;
         _args = args;
+        _initData = initData;
     }
 
     virtual ActionRetCodeEnum launchThreads(unsigned int nCPUs = 0) OVERRIDE FINAL WARN_UNUSED_RETURN
@@ -215,8 +220,11 @@ public:
         for (int i = fromIndex; i < toIndex; ++i) {
             int tx = _tileIndices[i].first;
             int ty = _tileIndices[i].second;
-            _imp->initTileAndFetchFromCache(*_args, tx, ty, _nTilesWidth, _tileSizeX, _tileSizeY);
+            _imp->initTile(*_args, *_initData, tx, ty, _nTilesWidth, _tileSizeX, _tileSizeY);
         }
+
+        // Tiles are ordered by index, look-up the cache for the whole range at once
+        _imp->fetchTilesFromCache(*_args, *_initData, fromIndex, toIndex, _nTilesWidth);
         return eActionStatusOK;
     }
 };
@@ -280,8 +288,8 @@ Image::init(const Image::InitStorageArgs& args)
     int tileSizeX = 0, tileSizeY = 0;
     switch (args.bufferFormat) {
         case eImageBufferLayoutMonoChannelTiled: {
-            // The size of a tile depends on the bitdepth
-            Cache::getTileSizePx(args.bitdepth, &tileSizeX, &tileSizeY);
+            // The size of a tile depends on the bitdepth and the size class
+            Cache::getTileSizePx(args.bitdepth, args.tileSizeClass, &tileSizeX, &tileSizeY);
             nTilesHeight = std::ceil((double)_imp->bounds.height() / tileSizeY);
             nTilesWidth = std::ceil((double)_imp->bounds.width() / tileSizeX);
         }   break;
@@ -300,8 +308,12 @@ Image::init(const Image::InitStorageArgs& args)
     if (args.externalBuffer) {
         _imp->initFromExternalBuffer(args);
     } else {
+        // Compute once what is common to all tiles
+        ImageTilesInitData initData;
+        _imp->initTilesInitData(args, &initData);
+
         TileFetcherProcessor processor(args.renderArgs);
-        processor.setData(_imp.get(), &args, nTilesWidth, nTilesHeight, tileSizeX, tileSizeY);
+        processor.setData(_imp.get(), &args, &initData, nTilesWidth, nTilesHeight, tileSizeX, tileSizeY);
         ActionRetCodeEnum stat = processor.launchThreads();
         (void)stat;
     }
@@ -326,6 +338,8 @@ Image::CopyPixelsArgs::CopyPixelsArgs()
 void
 Image::copyPixels(const Image& other, const CopyPixelsArgs& args)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryImage, "CopyPixels");
+
     if (_imp->tiles.empty() || other._imp->tiles.empty()) {
         // Nothing to copy
         return;
@@ -397,8 +411,14 @@ Image::copyPixels(const Image& other, const CopyPixelsArgs& args)
     argsCpy.roi = roi;
 
     if (_imp->bufferFormat == eImageBufferLayoutMonoChannelTiled) {
-        // UNTILED ---> TILED
-        _imp->copyUntiledImageToTiledImage(*fromImage, argsCpy);
+
+        if (fromImage->_imp->bufferFormat == eImageBufferLayoutMonoChannelTiled) {
+            // TILED ---> TILED
+            _imp->copyTiledImageToTiledImage(*fromImage, argsCpy);
+        } else {
+            // UNTILED ---> TILED
+            _imp->copyUntiledImageToTiledImage(*fromImage, argsCpy);
+        }
 
     } else {
 
@@ -553,7 +573,13 @@ Image::getCPUTileData(const Tile& tile, ImageBufferLayoutEnum layout, CPUTileDat
                 }
             } else {
                 data->ptrs[0] = fromIsMMAPBuffer->getData();
-                data->tileBounds = fromIsMMAPBuffer->getBounds();
+                // The buffer always has the size of a full tile, even on the edges of the image, but it
+                // is located at the position of the tile in the image.
+                RectI bufferBounds = fromIsMMAPBuffer->getBounds();
+                data->tileBounds.x1 = tile.tileBounds.x1;
+                data->tileBounds.y1 = tile.tileBounds.y1;
+                data->tileBounds.x2 = tile.tileBounds.x1 + bufferBounds.width();
+                data->tileBounds.y2 = tile.tileBounds.y1 + bufferBounds.height();
                 data->bitDepth = fromIsMMAPBuffer->getBitDepth();
                 data->nComps = tile.perChannelTile.size();
             }
@@ -807,6 +833,9 @@ Image::getChannelPointers(const void* ptrs[4],
         case eImageBitDepthShort:
             getChannelPointers<unsigned short>((const unsigned short**)ptrs, x, y, bounds, nComps, (unsigned short**)outPtrs, pixelStride);
             break;
+        case eImageBitDepthHalf:
+            getChannelPointers<Half>((const Half**)ptrs, x, y, bounds, nComps, (Half**)outPtrs, pixelStride);
+            break;
         case eImageBitDepthFloat:
             getChannelPointers<float>((const float**)ptrs, x, y, bounds, nComps, (float**)outPtrs, pixelStride);
             break;
@@ -992,7 +1021,7 @@ Image::downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const
 bool
 Image::checkForNaNs(const RectI& roi)
 {
-    if (getBitDepth() != eImageBitDepthFloat) {
+    if (getBitDepth() != eImageBitDepthFloat && getBitDepth() != eImageBitDepthHalf) {
         return false;
     }
     if (getStorageMode() == eStorageModeGLTex) {
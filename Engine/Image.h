@@ -39,6 +39,7 @@
 
 #include "Global/GLIncludes.h"
 #include "Engine/Cache.h" // CacheEntryLockerPtr - put it in EngineFwd.h?
+#include "Engine/Half.h"
 #include "Engine/ImagePlaneDesc.h"
 #include "Engine/RectI.h"
 #include "Engine/TimeValue.h"
@@ -163,6 +164,18 @@ public:
         //
         // Default - eImageBufferLayoutRGBAPackedFullRect
         ImageBufferLayoutEnum bufferFormat;
+
+        // The size class of the tiles, only relevant for the eImageBufferLayoutMonoChannelTiled layout.
+        // See Cache::getTileSizePx and Cache::getTileSizeClassForImage
+        //
+        // Default - 0
+        int tileSizeClass;
+
+        // The size class of the tiles the node caches at mipmap level 0, used to look-up tiles at level 0 to build
+        // the tiles of this mipmap level. -1 if it is the same as tileSizeClass.
+        //
+        // Default - -1
+        int mipMapLevel0TileSizeClass;
         
         // The scale of the image: This is the scale of the render: for a proxy render, this should be (1,1)
         // and for a proxy render, the scale to convert from the full format to proxy format
@@ -768,6 +781,10 @@ template<>
 inline float
 Image::clampIfInt(float v) { return v; }
 
+template<>
+inline Half
+Image::clampIfInt(float v) { return Half(v); }
+
 NATRON_NAMESPACE_EXIT;
 
 #endif // NATRON_ENGINE_IMAGE_H
@@ -108,6 +108,55 @@ Image::convertPixelDepth(float pix)
     return pix;
 }
 
+template <>
+Half
+Image::convertPixelDepth(unsigned char pix)
+{
+    return Half( Color::intToFloat<256>(pix) );
+}
+
+template <>
+Half
+Image::convertPixelDepth(unsigned short pix)
+{
+    return Half( Color::intToFloat<65536>(pix) );
+}
+
+template <>
+Half
+Image::convertPixelDepth(float pix)
+{
+    return Half(pix);
+}
+
+template <>
+Half
+Image::convertPixelDepth(Half pix)
+{
+    return pix;
+}
+
+template <>
+unsigned char
+Image::convertPixelDepth(Half pix)
+{
+    return (unsigned char)Color::floatToInt<256>(pix);
+}
+
+template <>
+unsigned short
+Image::convertPixelDepth(Half pix)
+{
+    return (unsigned short)Color::floatToInt<65536>(pix);
+}
+
+template <>
+float
+Image::convertPixelDepth(Half pix)
+{
+    return pix;
+}
+
 static const Color::Lut*
 lutFromColorspace(ViewerColorSpaceEnum cs)
 {
@@ -132,6 +181,56 @@ lutFromColorspace(ViewerColorSpaceEnum cs)
     return lut;
 }
 
+/**
+ * @brief Convert count contiguous values between two depths of the same range (float and half).
+ * A plain memcpy is used when the depths are the same.
+ **/
+template <typename SRCPIX, typename DSTPIX>
+static void
+convertContiguousPixels(const SRCPIX* src,
+                        DSTPIX* dst,
+                        std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = Image::convertPixelDepth<SRCPIX, DSTPIX>(src[i]);
+    }
+}
+
+template <>
+void
+convertContiguousPixels(const Half* src,
+                        float* dst,
+                        std::size_t count)
+{
+    Half::toFloat(src, dst, count);
+}
+
+template <>
+void
+convertContiguousPixels(const float* src,
+                        Half* dst,
+                        std::size_t count)
+{
+    Half::fromFloat(src, dst, count);
+}
+
+#define CONVERT_CONTIGUOUS_PIXELS_MEMCPY(PIX) \
+    template <> \
+    void \
+    convertContiguousPixels(const PIX* src, \
+                            PIX* dst, \
+                            std::size_t count) \
+    { \
+        memcpy( dst, src, count * sizeof(PIX) ); \
+    }
+
+CONVERT_CONTIGUOUS_PIXELS_MEMCPY(unsigned char)
+CONVERT_CONTIGUOUS_PIXELS_MEMCPY(unsigned short)
+CONVERT_CONTIGUOUS_PIXELS_MEMCPY(Half)
+CONVERT_CONTIGUOUS_PIXELS_MEMCPY(float)
+
+#undef CONVERT_CONTIGUOUS_PIXELS_MEMCPY
+
 ///Fast version when components are the same
 template <typename SRCPIX, int srcMaxValue, typename DSTPIX, int dstMaxValue>
 static void
@@ -154,9 +253,6 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
     const Color::Lut* const srcLut = (srcLut_ == dstLut_) ? 0 : srcLut_;
     const Color::Lut* const dstLut = (srcLut_ == dstLut_) ? 0 : dstLut_;
 
-    int srcDataSizeOf = sizeof(SRCPIX);
-
-
     for (int y = renderWindow.y1; y < renderWindow.y2; ++y) {
 
         if (renderArgs && renderArgs->isRenderAborted()) {
@@ -164,7 +260,7 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
         }
 
         if (srcMaxValue == dstMaxValue && !srcLut && !dstLut) {
-            // Use memcpy when possible
+            // Use memcpy when possible, or a vectorized conversion between float and half
 
             const SRCPIX* srcPixelPtrs[4];
             int srcPixelStride;
@@ -178,18 +274,18 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
             // If the pixel stride is the same, use memcpy
             if (srcPixelStride == dstPixelStride) {
                 if (srcPixelStride == 1) {
-                    std::size_t nBytesToCopy = renderWindow.width() * srcDataSizeOf;
+                    std::size_t nElementsToCopy = renderWindow.width();
                     // Ok we are in coplanar mode, copy each channel individually
                     for (int c = 0; c < 4; ++c) {
                         if (srcPixelPtrs[c] && dstPixelPtrs[c]) {
-                            memcpy(dstPixelPtrs[c], srcPixelPtrs[c], nBytesToCopy);
+                            convertContiguousPixels<SRCPIX, DSTPIX>(srcPixelPtrs[c], dstPixelPtrs[c], nElementsToCopy);
                         }
                     }
                 } else {
-                    std::size_t nBytesToCopy = renderWindow.width() * nComp * srcDataSizeOf;
+                    std::size_t nElementsToCopy = renderWindow.width() * nComp;
 
                     // In packed RGBA mode or single channel coplanar a single call to memcpy is needed per scan-line
-                    memcpy(dstPixelPtrs[0], srcPixelPtrs[0], nBytesToCopy);
+                    convertContiguousPixels<SRCPIX, DSTPIX>(srcPixelPtrs[0], dstPixelPtrs[0], nElementsToCopy);
                 }
             } else {
                 // Different strides, copy manually
@@ -198,7 +294,7 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
                         const SRCPIX* src_pix = srcPixelPtrs[c];
                         DSTPIX* dst_pix = dstPixelPtrs[c];
                         for (int x = renderWindow.x1; x < renderWindow.x2; ++x) {
-                            // They are of the same bitdepth since srcMaxValue == dstMaxValue was checked above
+                            // They are of the same range since srcMaxValue == dstMaxValue was checked above
                             *dst_pix = (DSTPIX)*src_pix;
                             src_pix += srcPixelStride;
                             dst_pix += dstPixelStride;
@@ -260,7 +356,7 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
                                 } else if (srcMaxValue == 65535) {
                                     pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(sourcePixel);
                                 } else {
-                                    pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(sourcePixel);
+                                    pixFloat = srcLut->fromColorSpaceFloatToLinearFloatFast(sourcePixel);
                                 }
                             } else {
                                 pixFloat = Image::convertPixelDepth<SRCPIX, float>(sourcePixel);
@@ -272,11 +368,11 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
                                                                 Color::floatToInt<0xff01>(pixFloat) );
                                 pix = error[k] >> 8;
                             } else if (dstMaxValue == 65535) {
-                                pix = dstLut ? dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
+                                pix = dstLut ? (DSTPIX)dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
                                 Image::convertPixelDepth<float, DSTPIX>(pixFloat);
                             } else {
                                 if (dstLut) {
-                                    pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
+                                    pixFloat = dstLut->toColorSpaceFloatFromLinearFloatFast(pixFloat);
                                 }
                                 pix = Image::convertPixelDepth<float, DSTPIX>(pixFloat);
                             }
@@ -429,7 +525,7 @@ static convertToFormatInternalForColorSpace(const RectI & renderWindow,
                             pixFloat = Image::convertPixelDepth<SRCPIX, float>(sourcePixel);
                             pixFloat = alphaForUnPremult == 0.f ? 0. : pixFloat / alphaForUnPremult;
                             if (srcLut) {
-                                pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(pixFloat);
+                                pixFloat = srcLut->fromColorSpaceFloatToLinearFloatFast(pixFloat);
                             }
                         } else if (srcLut) {
                             if (srcMaxValue == 255) {
@@ -437,7 +533,7 @@ static convertToFormatInternalForColorSpace(const RectI & renderWindow,
                             } else if (srcMaxValue == 65535) {
                                 pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(sourcePixel);
                             } else {
-                                pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(sourcePixel);
+                                pixFloat = srcLut->fromColorSpaceFloatToLinearFloatFast(sourcePixel);
                             }
                         } else {
                             pixFloat = Image::convertPixelDepth<SRCPIX, float>(sourcePixel);
@@ -450,11 +546,11 @@ static convertToFormatInternalForColorSpace(const RectI & renderWindow,
                                                             Color::floatToInt<0xff01>(pixFloat) );
                             pix = error[k] >> 8;
                         } else if (dstMaxValue == 65535) {
-                            pix = dstLut ? dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
+                            pix = dstLut ? (DSTPIX)dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
                             Image::convertPixelDepth<float, DSTPIX>(pixFloat);
                         } else {
                             if (dstLut) {
-                                pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
+                                pixFloat = dstLut->toColorSpaceFloatFromLinearFloatFast(pixFloat);
                             }
                             pix = Image::convertPixelDepth<float, DSTPIX>(pixFloat);
                         }
@@ -852,6 +948,7 @@ convertToFormatInternalForSrcDepth(const RectI & renderWindow,
             convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, unsigned short, 65535>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderArgs);
             break;
         case eImageBitDepthHalf:
+            convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, Half, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderArgs);
             break;
         case eImageBitDepthFloat:
             convertToFormatInternalForDstDepth<SRCPIX, srcMaxValue, float, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBounds, renderArgs);
@@ -891,6 +988,7 @@ ImagePrivate::convertCPUImage(const RectI & renderWindow,
             convertToFormatInternalForSrcDepth<unsigned short, 65535>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderArgs);
             break;
         case eImageBitDepthHalf:
+            convertToFormatInternalForSrcDepth<Half, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderArgs);
             break;
         case eImageBitDepthFloat:
             convertToFormatInternalForSrcDepth<float, 1>(renderWindow, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcBufPtrs, srcNComps, srcBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderArgs);
@@ -163,8 +163,9 @@ fillForDepthForComponents(void* ptrs[4],
                           const RectI& roi,
                           const TreeRenderNodeArgsPtr& renderArgs)
 {
-    const float fillValue[4] = {
-        nComps == 1 ? a * maxValue : r * maxValue, g * maxValue, b * maxValue, a * maxValue
+    // Convert once to the pixel depth rather than for each pixel
+    const PIX fillValue[4] = {
+        PIX(nComps == 1 ? a * maxValue : r * maxValue), PIX(g * maxValue), PIX(b * maxValue), PIX(a * maxValue)
     };
 
     int nCompsPerBuffer = nComps;
@@ -262,6 +263,9 @@ ImagePrivate::fillCPU(void* ptrs[4],
             fillForDepth<unsigned short, 65535>(ptrs, r, g, b, a, nComps, bounds, roi, renderArgs);
             break;
         case eImageBitDepthHalf:
+            fillForDepth<Half, 1>(ptrs, r, g, b, a, nComps, bounds, roi, renderArgs);
+            break;
+        case eImageBitDepthNone:
         default:
             break;
     }
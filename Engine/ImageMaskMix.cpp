@@ -171,6 +171,9 @@ applyMaskMixForDstComponents(const void* originalImgPtrs[4],
         case eImageBitDepthFloat:
             applyMaskMixForDepth<srcNComps, dstNComps, float, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderArgs);
             break;
+        case eImageBitDepthHalf:
+            applyMaskMixForDepth<srcNComps, dstNComps, Half, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderArgs);
+            break;
         default:
             assert(false);
             break;
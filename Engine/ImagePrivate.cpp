@@ -25,36 +25,93 @@
 
 #include "ImagePrivate.h"
 
+#include <algorithm> // min
+
 NATRON_NAMESPACE_ENTER;
 
 void
-ImagePrivate::initTileAndFetchFromCache(const Image::InitStorageArgs& args, int tx, int ty, int nTilesWidth, int tileSizeX, int tileSizeY)
+ImagePrivate::initTilesInitData(const Image::InitStorageArgs& args, ImageTilesInitData* data) const
 {
-    CachePtr cache = appPTR->getCache();
-
-    int tile_i = nTilesWidth * ty + tx;
-    Image::Tile& tile = tiles[tile_i];
-
     const std::string& planeID = args.layer.getPlaneID();
 
     // How many buffer should we make for a tile
     // A mono channel image should have one per channel
-    std::vector<int> channelIndices;
     switch (args.bufferFormat) {
         case eImageBufferLayoutMonoChannelTiled: {
-
+            const std::vector<std::string>& compNames = args.layer.getChannels();
             for (int nc = 0; nc < args.layer.getNumComponents(); ++nc) {
                 if (args.components[nc]) {
-                    channelIndices.push_back(nc);
+                    data->channelIndices.push_back(nc);
+                    assert(nc < (int)compNames.size());
+                    data->channelNames.push_back(planeID + "." + compNames[nc]);
                 }
             }
         }   break;
         case eImageBufferLayoutRGBACoplanarFullRect:
         case eImageBufferLayoutRGBAPackedFullRect:
-            channelIndices.push_back(-1);
+            data->channelIndices.push_back(-1);
+            data->channelNames.push_back(planeID);
             break;
     }
 
+    if (args.storage == eStorageModeDisk) {
+        boost::shared_ptr<AllocateMemoryArgs> a(new AllocateMemoryArgs());
+        a->bitDepth = args.bitdepth;
+        data->cacheTileAllocArgs = a;
+    }
+
+    if (cachePolicy == eCacheAccessModeNone) {
+        return;
+    }
+
+    // First look for a tile at the proxy + mipmap scale, if not found look for a tile at proxy scale and downscale it.
+    // This is the default cache lookup scale: for OpenGL textures, always assume them at full proxy scale
+    // since downscaling is handled by OpenGL itself
+    if (args.storage != eStorageModeRAM && args.storage != eStorageModeDisk) {
+        data->nMipMapLookups = 1;
+        data->firstLookupLevel = 0;
+    } else {
+        data->nMipMapLookups = (args.mipMapLevel != 0) ? 2 : 1;
+        data->firstLookupLevel = args.mipMapLevel;
+    }
+
+    // Tiles at level 0 are looked-up with the size class the node caches them with at level 0.
+    // A tile of level 0 can only be downscaled to the tile with the same coordinates at this level if it is
+    // 2^mipMapLevel times larger in each direction, otherwise do not look it up.
+    data->level0TileSizeClass = (args.mipMapLevel0TileSizeClass >= 0) ? args.mipMapLevel0TileSizeClass : args.tileSizeClass;
+    if (data->nMipMapLookups == 2) {
+        int tileSizeX, tileSizeY, level0TileSizeX, level0TileSizeY;
+        Cache::getTileSizePx(args.bitdepth, args.tileSizeClass, &tileSizeX, &tileSizeY);
+        Cache::getTileSizePx(args.bitdepth, data->level0TileSizeClass, &level0TileSizeX, &level0TileSizeY);
+        if ( (level0TileSizeX != (tileSizeX << args.mipMapLevel)) || (level0TileSizeY != (tileSizeY << args.mipMapLevel)) ) {
+            data->nMipMapLookups = 1;
+        }
+    }
+
+    // Hash once the part of the keys that does not depend on the tile coordinates
+    data->requestedScaleHashPrefix.resize(data->channelNames.size());
+    data->lookupHashPrefix.resize(data->channelNames.size() * 4);
+    for (std::size_t c = 0; c < data->channelNames.size(); ++c) {
+        data->requestedScaleHashPrefix[c] = ImageTileKey::computeTilesHashPrefixState(args.nodeTimeInvariantHash, args.time, args.view, data->channelNames[c], args.proxyScale, args.mipMapLevel, args.isDraft, args.bitdepth, args.tileSizeClass);
+        for (int mipmap_i = 0; mipmap_i < data->nMipMapLookups; ++mipmap_i) {
+            const unsigned int lookupLevel = mipmap_i == 0 ? data->firstLookupLevel : 0;
+            const int lookupTileSizeClass = mipmap_i == 0 ? args.tileSizeClass : data->level0TileSizeClass;
+            for (int draft_i = 0; draft_i < 2; ++draft_i) {
+                data->lookupHashPrefix[(c * 2 + mipmap_i) * 2 + draft_i] = ImageTileKey::computeTilesHashPrefixState(args.nodeTimeInvariantHash, args.time, args.view, data->channelNames[c], args.proxyScale, lookupLevel, (bool)draft_i, args.bitdepth, lookupTileSizeClass);
+            }
+        }
+    }
+} // initTilesInitData
+
+void
+ImagePrivate::initTile(const Image::InitStorageArgs& args, const ImageTilesInitData& initData, int tx, int ty, int nTilesWidth, int tileSizeX, int tileSizeY)
+{
+    CachePtr cache = appPTR->getCache();
+
+    int tile_i = nTilesWidth * ty + tx;
+    Image::Tile& tile = tiles[tile_i];
+
+    const std::vector<int>& channelIndices = initData.channelIndices;
 
     switch (args.bufferFormat) {
         case eImageBufferLayoutMonoChannelTiled:
@@ -80,22 +137,7 @@ ImagePrivate::initTileAndFetchFromCache(const Image::InitStorageArgs& args, int
         Image::MonoChannelTile& thisChannelTile = tile.perChannelTile[c];
         thisChannelTile.channelIndex = channelIndices[c];
 
-        std::string channelName;
-        switch (args.bufferFormat) {
-            case eImageBufferLayoutMonoChannelTiled: {
-                const std::vector<std::string>& compNames = args.layer.getChannels();
-                assert(thisChannelTile.channelIndex >= 0 && thisChannelTile.channelIndex < (int)compNames.size());
-                channelName = planeID + "." + compNames[thisChannelTile.channelIndex];
-            }   break;
-            case eImageBufferLayoutRGBACoplanarFullRect:
-            case eImageBufferLayoutRGBAPackedFullRect:
-                channelName = planeID;
-                break;
-        }
-
-
-
-
+        const std::string& channelName = initData.channelNames[c];
 
         boost::shared_ptr<AllocateMemoryArgs> allocArgs;
 
@@ -104,11 +146,9 @@ ImagePrivate::initTileAndFetchFromCache(const Image::InitStorageArgs& args, int
             // Allocate a new entry
             switch (args.storage) {
                 case eStorageModeDisk: {
-                    cachedBuffer.reset(new CacheImageTileStorage(cache));
+                    cachedBuffer.reset(new CacheImageTileStorage(cache, args.tileSizeClass));
                     thisChannelTile.buffer = cachedBuffer;
-                    boost::shared_ptr<AllocateMemoryArgs> a(new AllocateMemoryArgs());
-                    a->bitDepth = args.bitdepth;
-                    allocArgs = a;
+                    allocArgs = initData.cacheTileAllocArgs;
                 }   break;
                 case eStorageModeGLTex: {
                     GLImageStoragePtr buffer(new GLImageStorage());
@@ -162,131 +202,253 @@ ImagePrivate::initTileAndFetchFromCache(const Image::InitStorageArgs& args, int
                                                      args.mipMapLevel,
                                                      args.isDraft,
                                                      args.bitdepth,
+                                                     args.tileSizeClass,
                                                      tx,
                                                      ty));
+            requestedScaleKey->setPrecomputedHash( ImageTileKey::computeTileHash(initData.requestedScaleHashPrefix[c], tx, ty) );
             cachedBuffer->setKey(requestedScaleKey);
         }
 
-        // If the entry wants to be cached but we don't want to read from the cache
-        // we must remove from the cache any entry that already exists at the given hash.
-        if (cachePolicy == eCacheAccessModeWriteOnly) {
-            CacheEntryLockerPtr locker = cache->get(cachedBuffer);
-            if (locker->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
-                cache->removeEntry(cachedBuffer);
-            }
+    } // for each channel
+
+} // initTile
+
+/**
+ * @brief A buffer of a tile looked-up in the cache by fetchTilesFromCache
+ **/
+struct TileBufferCacheLookup
+{
+    int tile_i;
+    std::size_t channel_i;
+
+    // The buffer of the tile, its key is changed for each look-up
+    CacheImageTileStoragePtr cachedBuffer;
+
+    // The buffer used to look-up the tile at mipmap level 0 if its size class is not the one of cachedBuffer
+    CacheImageTileStoragePtr level0Buffer;
+
+    // The key of the tile at the requested draft/mipmap level
+    CacheEntryKeyBasePtr requestedScaleKey;
+
+    // The locker of the key at the requested draft/mipmap level
+    CacheEntryLockerPtr requestedScaleLocker;
+
+    // The mipmap level at which the tile was found in the cache, or -1 if not cached
+    int cachedLevel;
+
+    TileBufferCacheLookup()
+    : tile_i(0)
+    , channel_i(0)
+    , cachedBuffer()
+    , level0Buffer()
+    , requestedScaleKey()
+    , requestedScaleLocker()
+    , cachedLevel(-1)
+    {
+
+    }
+};
+
+void
+ImagePrivate::fetchTilesFromCache(const Image::InitStorageArgs& args, const ImageTilesInitData& initData, int fromTileIndex, int toTileIndex, int nTilesWidth)
+{
+    if (cachePolicy != eCacheAccessModeReadWrite && cachePolicy != eCacheAccessModeWriteOnly) {
+        return;
+    }
+
+    CachePtr cache = appPTR->getCache();
+
+    const std::vector<int>& channelIndices = initData.channelIndices;
+
+    std::vector<TileBufferCacheLookup> lookups;
+    lookups.reserve((toTileIndex - fromTileIndex) * channelIndices.size());
+    for (int tile_i = fromTileIndex; tile_i < toTileIndex; ++tile_i) {
+        Image::Tile& tile = tiles[tile_i];
+        for (std::size_t c = 0; c < tile.perChannelTile.size(); ++c) {
+            TileBufferCacheLookup lookup;
+            lookup.tile_i = tile_i;
+            lookup.channel_i = c;
+            lookup.cachedBuffer = toCacheImageTileStorage(tile.perChannelTile[c].buffer);
+            assert(lookup.cachedBuffer);
+            lookup.requestedScaleKey = lookup.cachedBuffer->getKey();
+            lookups.push_back(lookup);
         }
+    }
 
-        // Look in the cache
-        if (cachePolicy == eCacheAccessModeReadWrite || cachePolicy == eCacheAccessModeWriteOnly) {
+    if (lookups.empty()) {
+        return;
+    }
 
-            // First look for a tile at the proxy + mipmap scale, if not found look for a tile at proxy scale and downscale it.
-            // This is the default cache lookup scale: for OpenGL textures, always assume them at full proxy scale
-            // since downscaling is handled by OpenGL itself
-            int nMipMapLookups;
-            unsigned firstLookupLevel;
-            if (args.storage != eStorageModeRAM && args.storage != eStorageModeDisk) {
-                nMipMapLookups = 1;
-                firstLookupLevel = 0;
-            } else {
-                nMipMapLookups = (args.mipMapLevel != 0) ? 2 : 1;
-                firstLookupLevel = args.mipMapLevel;
+    // The entries of a look-up pass and their lockers. All the buffers of the range of tiles are looked-up
+    // at once so that the lock of each cache bucket is taken once per pass instead of once per buffer.
+    std::vector<CacheEntryBasePtr> entries;
+    std::vector<CacheEntryLockerPtr> lockers;
+
+    // If the entry wants to be cached but we don't want to read from the cache
+    // we must remove from the cache any entry that already exists at the given hash.
+    if (cachePolicy == eCacheAccessModeWriteOnly) {
+        entries.resize(lookups.size());
+        for (std::size_t i = 0; i < lookups.size(); ++i) {
+            entries[i] = lookups[i].cachedBuffer;
+        }
+        cache->getBatch(entries, &lockers);
+        for (std::size_t i = 0; i < lookups.size(); ++i) {
+            if (lockers[i]->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
+                cache->removeEntry(lookups[i].cachedBuffer);
             }
+        }
+        // Release the entries before looking them up again
+        lockers.clear();
+    }
 
-            // Retain the pointer give by the Cache::get function for the key we are interested in.
-            CacheEntryLockerPtr requestedScaleLocker;
+    // First look for tiles at the proxy + mipmap scale, if not found look for tiles at proxy scale and downscale them.
+    const int nMipMapLookups = initData.nMipMapLookups;
+    const unsigned int firstLookupLevel = initData.firstLookupLevel;
 
-            bool isCached = false;
-            for (int mipmap_i = 0; mipmap_i < nMipMapLookups; ++mipmap_i) {
+    // Only look for a draft tile in the cache if the image allows draft
+    const int nDraftLookups = args.isDraft ? 2 : 1;
 
-                const unsigned int lookupLevel = mipmap_i == 0 ? firstLookupLevel : 0;
+    // Indices in lookups of the buffers that were not found in the cache yet
+    std::vector<std::size_t> remainingLookups(lookups.size());
+    for (std::size_t i = 0; i < lookups.size(); ++i) {
+        remainingLookups[i] = i;
+    }
 
-                // Only look for a draft tile in the cache if the image allows draft
-                const int nDraftLookups = args.isDraft ? 2 : 1;
+    for (int mipmap_i = 0; mipmap_i < nMipMapLookups; ++mipmap_i) {
 
-                for (int draft_i = 0; draft_i < nDraftLookups; ++draft_i) {
+        const unsigned int lookupLevel = mipmap_i == 0 ? firstLookupLevel : 0;
 
-                    const bool useDraft = (const bool)draft_i;
+        for (int draft_i = 0; draft_i < nDraftLookups; ++draft_i) {
 
-                    ImageTileKeyPtr keyToReadCache(new ImageTileKey(args.nodeTimeInvariantHash,
-                                                                    args.time,
-                                                                    args.view,
-                                                                    channelName,
-                                                                    args.proxyScale,
-                                                                    lookupLevel,
-                                                                    useDraft,
-                                                                    args.bitdepth,
-                                                                    tx,
-                                                                    ty));
+            if (remainingLookups.empty()) {
+                break;
+            }
 
-                    assert(cachedBuffer);
-                    cachedBuffer->setKey(keyToReadCache);
+            const bool useDraft = (const bool)draft_i;
+            const bool isRequestedScale = useDraft == args.isDraft && lookupLevel == args.mipMapLevel;
 
-                    // Store the entry locker pointer
-                    thisChannelTile.entryLocker = cache->get(cachedBuffer);
+            // Tiles at level 0 have their own size class, see initTilesInitData
+            const int lookupTileSizeClass = mipmap_i == 0 ? args.tileSizeClass : initData.level0TileSizeClass;
 
-                    if (useDraft == args.isDraft && lookupLevel == args.mipMapLevel) {
-                        assert(requestedScaleKey->getHash() == keyToReadCache->getHash());
-                        requestedScaleLocker = thisChannelTile.entryLocker;
-                    }
+            entries.resize(remainingLookups.size());
+            for (std::size_t i = 0; i < remainingLookups.size(); ++i) {
+                TileBufferCacheLookup& lookup = lookups[remainingLookups[i]];
+                const int tx = lookup.tile_i % nTilesWidth;
+                const int ty = lookup.tile_i / nTilesWidth;
 
-                    if (thisChannelTile.entryLocker->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
-                        isCached = true;
-                        // We found a cache entry, don't continue to look for a tile computed in draft mode.
-                        break;
-                    }
-                } // for each draft mode to check
-                if (isCached) {
-
-                    if (args.storage == eStorageModeRAM || args.storage == eStorageModeDisk) {
-                        // If the image fetched is at a upper scale, we must downscale
-                        if (lookupLevel != firstLookupLevel) {
-                            assert(firstLookupLevel > lookupLevel);
-
-                            const unsigned int downscaleLevels = firstLookupLevel - lookupLevel;
-
-                            // Make a new view of this tile with a format that downscaleMipMap understands
-                            // The copy will not actually copy the pixels, just the buffer memory pointer
-                            ImagePtr fullScaleImage;
-                            {
-                                Image::InitStorageArgs tmpArgs;
-                                tmpArgs.bounds = tile.tileBounds;
-                                tmpArgs.renderArgs = renderArgs;
-                                tmpArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
-                                tmpArgs.layer = channelIndices.size() > 1 ? ImagePlaneDesc::getAlphaComponents() : layer;
-                                tmpArgs.bitdepth = args.bitdepth;
-                                tmpArgs.proxyScale = args.proxyScale;
-                                tmpArgs.mipMapLevel = args.mipMapLevel;
-                                tmpArgs.externalBuffer = thisChannelTile.buffer;
-                                tmpArgs.nodeTimeInvariantHash = args.nodeTimeInvariantHash;
-                                tmpArgs.time = args.time;
-                                tmpArgs.view = args.view;
-                                fullScaleImage = Image::create(tmpArgs);
-                            }
-
-                            ImagePtr downscaledImage = fullScaleImage->downscaleMipMap(tile.tileBounds, downscaleLevels);
-
-                            assert(downscaledImage->_imp->tiles.size() == 1);
-                            assert(downscaledImage->_imp->tiles[0].perChannelTile.size() == 1);
-
-                            // Since we downscaled a single tile of the same size and same number of components and same bitdepth
-                            // as this tile, we can just copy the pointer
-                            thisChannelTile.buffer = downscaledImage->_imp->tiles[0].perChannelTile[0].buffer;
-
-                        } // must downscale
+                CacheImageTileStoragePtr lookupBuffer = lookup.cachedBuffer;
+                if (lookupTileSizeClass != args.tileSizeClass) {
+                    if (!lookup.level0Buffer) {
+                        // Allocated by the cache only if the tile is found
+                        lookup.level0Buffer.reset( new CacheImageTileStorage(cache, lookupTileSizeClass) );
+                        lookup.level0Buffer->setAllocateMemoryArgs(initData.cacheTileAllocArgs);
                     }
-                    break;
-                } // isCached
-            } // for each mip map lvel to check
-            if (!isCached) {
-                assert(requestedScaleLocker);
-                cachedBuffer->setKey(requestedScaleKey);
-                thisChannelTile.entryLocker = requestedScaleLocker;
+                    lookupBuffer = lookup.level0Buffer;
+                }
+
+                ImageTileKeyPtr keyToReadCache(new ImageTileKey(args.nodeTimeInvariantHash,
+                                                                args.time,
+                                                                args.view,
+                                                                initData.channelNames[lookup.channel_i],
+                                                                args.proxyScale,
+                                                                lookupLevel,
+                                                                useDraft,
+                                                                args.bitdepth,
+                                                                lookupTileSizeClass,
+                                                                tx,
+                                                                ty));
+                keyToReadCache->setPrecomputedHash( ImageTileKey::computeTileHash(initData.lookupHashPrefix[(lookup.channel_i * 2 + mipmap_i) * 2 + draft_i], tx, ty) );
+                lookupBuffer->setKey(keyToReadCache);
+                entries[i] = lookupBuffer;
             }
-        } // useCache
 
-    } // for each channel
+            cache->getBatch(entries, &lockers);
+
+            std::vector<std::size_t> notCachedLookups;
+            for (std::size_t i = 0; i < remainingLookups.size(); ++i) {
+                TileBufferCacheLookup& lookup = lookups[remainingLookups[i]];
+
+                // Store the entry locker pointer
+                tiles[lookup.tile_i].perChannelTile[lookup.channel_i].entryLocker = lockers[i];
 
-} // initTileAndFetchFromCache
+                if (isRequestedScale) {
+                    assert(lookup.requestedScaleKey->getHash() == lookup.cachedBuffer->getKey()->getHash());
+                    lookup.requestedScaleLocker = lockers[i];
+                }
+
+                if (lockers[i]->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
+                    // We found a cache entry, don't continue to look for a tile computed in draft mode.
+                    lookup.cachedLevel = (int)lookupLevel;
+                } else {
+                    notCachedLookups.push_back(remainingLookups[i]);
+                }
+            }
+            lockers.clear();
+            remainingLookups.swap(notCachedLookups);
+        } // for each draft mode to check
+    } // for each mip map level to check
+
+    for (std::size_t i = 0; i < lookups.size(); ++i) {
+        TileBufferCacheLookup& lookup = lookups[i];
+        Image::Tile& tile = tiles[lookup.tile_i];
+        Image::MonoChannelTile& thisChannelTile = tile.perChannelTile[lookup.channel_i];
+
+        if (lookup.cachedLevel == -1) {
+            assert(lookup.requestedScaleLocker);
+            lookup.cachedBuffer->setKey(lookup.requestedScaleKey);
+            thisChannelTile.entryLocker = lookup.requestedScaleLocker;
+            continue;
+        }
+
+        const unsigned int lookupLevel = (unsigned int)lookup.cachedLevel;
+        if (args.storage == eStorageModeRAM || args.storage == eStorageModeDisk) {
+            // If the image fetched is at a upper scale, we must downscale
+            if (lookupLevel != firstLookupLevel) {
+                assert(firstLookupLevel > lookupLevel);
+
+                const unsigned int downscaleLevels = firstLookupLevel - lookupLevel;
+
+                // The tile at level 0 is 2^downscaleLevels times larger than this tile, unless it has the same size class
+                ImageStorageBasePtr fullScaleBuffer = thisChannelTile.buffer;
+                RectI fullScaleBounds = tile.tileBounds;
+                if (lookup.level0Buffer) {
+                    fullScaleBuffer = lookup.level0Buffer;
+                    fullScaleBounds = lookup.level0Buffer->getBounds();
+                }
+
+                // Make a new view of this tile with a format that downscaleMipMap understands
+                // The copy will not actually copy the pixels, just the buffer memory pointer
+                ImagePtr fullScaleImage;
+                {
+                    Image::InitStorageArgs tmpArgs;
+                    tmpArgs.bounds = fullScaleBounds;
+                    tmpArgs.renderArgs = renderArgs;
+                    tmpArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+                    tmpArgs.layer = channelIndices.size() > 1 ? ImagePlaneDesc::getAlphaComponents() : layer;
+                    tmpArgs.bitdepth = args.bitdepth;
+                    tmpArgs.proxyScale = args.proxyScale;
+                    tmpArgs.mipMapLevel = args.mipMapLevel;
+                    tmpArgs.externalBuffer = fullScaleBuffer;
+                    tmpArgs.nodeTimeInvariantHash = args.nodeTimeInvariantHash;
+                    tmpArgs.time = args.time;
+                    tmpArgs.view = args.view;
+                    fullScaleImage = Image::create(tmpArgs);
+                }
+
+                ImagePtr downscaledImage = fullScaleImage->downscaleMipMap(fullScaleBounds, downscaleLevels);
+
+                assert(downscaledImage->_imp->tiles.size() == 1);
+                assert(downscaledImage->_imp->tiles[0].perChannelTile.size() == 1);
+
+                // Since we downscaled a single tile of the same size and same number of components and same bitdepth
+                // as this tile, we can just copy the pointer
+                thisChannelTile.buffer = downscaledImage->_imp->tiles[0].perChannelTile[0].buffer;
+
+            } // must downscale
+        }
+    } // for each buffer looked-up
+
+} // fetchTilesFromCache
 
 
 void
@@ -371,25 +533,24 @@ ImagePrivate::insertTilesInCache()
 
     bool renderAborted = renderArgs->isRenderAborted();
 
+    // Insert all tiles at once so that each cache bucket is locked once.
+    // Tiles that are already cached have their status set to eCacheEntryStatusCached and are ignored by insertBatch.
+    std::vector<CacheEntryLockerPtr> lockersToInsert;
     for (std::size_t tile_i = 0; tile_i < tiles.size(); ++tile_i) {
         Image::Tile& tile = tiles[tile_i];
-
         for (std::size_t c = 0; c < tile.perChannelTile.size(); ++c) {
-
             Image::MonoChannelTile& thisChannelTile = tile.perChannelTile[c];
-
-            // If the tile is already cached, don't push it to the cache
             if (!thisChannelTile.entryLocker) {
                 continue;
             }
-            CacheEntryLocker::CacheEntryStatusEnum status = thisChannelTile.entryLocker->getStatus();
-            if (status == CacheEntryLocker::eCacheEntryStatusMustCompute && !renderAborted) {
-                thisChannelTile.entryLocker->insertInCache();
+            if (!renderAborted) {
+                lockersToInsert.push_back(thisChannelTile.entryLocker);
             }
             thisChannelTile.entryLocker.reset();
         }
-        
     } // for each tile
+
+    cache->insertBatch(lockersToInsert);
 } // insertTilesInCache
 
 const Image::Tile*
@@ -459,21 +620,7 @@ ImagePrivate::getTilesCoordinates(const RectI& pixelCoordinates) const
 ImagePtr
 ImagePrivate::checkIfCopyToTempImageIsNeeded(const Image& fromImage, const Image& toImage, const RectI& roi)
 {
-    // Copying from a tiled buffer is not trivial unless we are not tiled.
-    // If both are tiled, convert the original image to a packed format first
-    if (fromImage._imp->bufferFormat == eImageBufferLayoutMonoChannelTiled && toImage._imp->bufferFormat == eImageBufferLayoutMonoChannelTiled) {
-        ImagePtr tmpImage;
-        Image::InitStorageArgs args;
-        args.renderArgs = fromImage._imp->renderArgs;
-        args.bounds = roi;
-        args.layer = fromImage._imp->layer;
-        tmpImage = Image::create(args);
-
-        Image::CopyPixelsArgs copyArgs;
-        copyArgs.roi = roi;
-        tmpImage->copyPixels(fromImage, copyArgs);
-        return tmpImage;
-    }
+    // Note that tiled images are only stored on the CPU, and are copied to one another with copyTiledImageToTiledImage
 
     // OpenGL textures may only be read from a RGBA packed buffer
     if (fromImage.getStorageMode() == eStorageModeGLTex) {
@@ -796,6 +943,153 @@ ImagePrivate::copyUntiledImageToUntiledImage(const Image& fromImage, const Image
 
 } // copyUntiledImageToUntiledImage
 
+void
+ImagePrivate::copyTiledImageToTile(const ImagePrivate& fromImage, const Image::Tile& toTile, const Image::CopyPixelsArgs& args) const
+{
+    RectI toTileRoI;
+    if ( !toTile.tileBounds.intersect(args.roi, &toTileRoI) ) {
+        return;
+    }
+
+    if (args.skipDestinationTilesMarkedCached) {
+        // Don't write over a tile if all its channels are cached
+        bool allChannelsCached = !toTile.perChannelTile.empty();
+        for (std::size_t c = 0; c < toTile.perChannelTile.size(); ++c) {
+            if (!toTile.perChannelTile[c].entryLocker || toTile.perChannelTile[c].entryLocker->getStatus() != CacheEntryLocker::eCacheEntryStatusCached) {
+                allChannelsCached = false;
+                break;
+            }
+        }
+        if (allChannelsCached) {
+            return;
+        }
+    }
+
+    Image::CPUTileData dstTileData;
+    Image::getCPUTileData(toTile, eImageBufferLayoutMonoChannelTiled, &dstTileData);
+
+    // The tiles of the source image may have a different size (e.g: different bitdepth) and may not be aligned
+    // with the tiles of this image: find the range of source tiles overlapping the destination tile.
+    const int srcTileSizeX = fromImage.tiles[0].tileBounds.width();
+    const int srcTileSizeY = fromImage.tiles[0].tileBounds.height();
+    const int nSrcTilesPerLine = (fromImage.bounds.width() + srcTileSizeX - 1) / srcTileSizeX;
+    const int nSrcTilesPerColumn = (int)fromImage.tiles.size() / nSrcTilesPerLine;
+
+    const int srcTx1 = (toTileRoI.x1 - fromImage.bounds.x1) / srcTileSizeX;
+    const int srcTy1 = (toTileRoI.y1 - fromImage.bounds.y1) / srcTileSizeY;
+    const int srcTx2 = std::min(nSrcTilesPerLine, (toTileRoI.x2 - 1 - fromImage.bounds.x1) / srcTileSizeX + 1);
+    const int srcTy2 = std::min(nSrcTilesPerColumn, (toTileRoI.y2 - 1 - fromImage.bounds.y1) / srcTileSizeY + 1);
+
+    for (int ty = srcTy1; ty < srcTy2; ++ty) {
+        for (int tx = srcTx1; tx < srcTx2; ++tx) {
+            const Image::Tile& fromTile = fromImage.tiles[ty * nSrcTilesPerLine + tx];
+
+            RectI rectToCopy;
+            if ( !fromTile.tileBounds.intersect(toTileRoI, &rectToCopy) ) {
+                continue;
+            }
+
+            Image::CPUTileData srcTileData;
+            Image::getCPUTileData(fromTile, eImageBufferLayoutMonoChannelTiled, &srcTileData);
+
+            // Convert directly from the source tile to the destination tile: this handles bitdepth and components conversion in a single pass
+            ImagePrivate::convertCPUImage(rectToCopy,
+                                          args.srcColorspace,
+                                          args.dstColorspace,
+                                          args.unPremultIfNeeded,
+                                          args.conversionChannel,
+                                          args.alphaHandling,
+                                          args.monoConversion,
+                                          (const void**)srcTileData.ptrs,
+                                          srcTileData.nComps,
+                                          srcTileData.bitDepth,
+                                          srcTileData.tileBounds,
+                                          (void**)dstTileData.ptrs,
+                                          dstTileData.nComps,
+                                          dstTileData.bitDepth,
+                                          dstTileData.tileBounds,
+                                          renderArgs);
+        }
+    }
+} // copyTiledImageToTile
+
+class CopyTiledToTiledProcessor : public MultiThreadProcessorBase
+{
+
+    std::vector<int> _tileIndices;
+    const ImagePrivate* _imp;
+    const ImagePrivate* _fromImage;
+    const Image::CopyPixelsArgs* _originalArgs;
+
+public:
+
+    CopyTiledToTiledProcessor(const TreeRenderNodeArgsPtr& renderArgs)
+    : MultiThreadProcessorBase(renderArgs)
+    {
+
+    }
+
+    virtual ~CopyTiledToTiledProcessor()
+    {
+
+    }
+
+    void setData(const Image::CopyPixelsArgs* args, const ImagePrivate* imp, const ImagePrivate* fromImage, const std::vector<int>& tileIndices)
+    {
+        _tileIndices = tileIndices;
+        _imp = imp;
+        _fromImage = fromImage;
+        _originalArgs = args;
+    }
+
+    virtual ActionRetCodeEnum launchThreads(unsigned int nCPUs = 0) OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        return MultiThreadProcessorBase::launchThreads(nCPUs);
+    }
+
+    virtual ActionRetCodeEnum multiThreadFunction(unsigned int threadID,
+                                                  unsigned int nThreads,
+                                                  const TreeRenderNodeArgsPtr& /*renderArgs*/) OVERRIDE FINAL WARN_UNUSED_RETURN
+    {
+        // Each thread gets a range of destination tiles: a destination tile is never written by 2 threads
+        int fromIndex, toIndex;
+        ImageMultiThreadProcessorBase::getThreadRange(threadID, nThreads, 0, _tileIndices.size(), &fromIndex, &toIndex);
+
+        for (int i = fromIndex; i < toIndex; ++i) {
+            _imp->copyTiledImageToTile(*_fromImage, _imp->tiles[_tileIndices[i]], *_originalArgs);
+        }
+        return eActionStatusOK;
+    }
+};
+
+void
+ImagePrivate::copyTiledImageToTiledImage(const Image& fromImage, const Image::CopyPixelsArgs& args)
+{
+    assert(bufferFormat == eImageBufferLayoutMonoChannelTiled && fromImage._imp->bufferFormat == eImageBufferLayoutMonoChannelTiled);
+    assert(bounds.contains(args.roi) && fromImage._imp->bounds.contains(args.roi));
+
+    // Mono channel tiles are always stored on the CPU
+    assert(fromImage.getStorageMode() != eStorageModeGLTex && tiles[0].perChannelTile[0].buffer->getStorageMode() != eStorageModeGLTex);
+
+    const int nTilesPerLine = getNTilesPerLine();
+    const RectI tilesRect = getTilesCoordinates(args.roi);
+
+    std::vector<int> tileIndices;
+    for (int ty = tilesRect.y1; ty < tilesRect.y2; ++ty) {
+        for (int tx = tilesRect.x1; tx < tilesRect.x2; ++tx) {
+            int tile_i = tx + ty * nTilesPerLine;
+            assert(tile_i >= 0 && tile_i < (int)tiles.size());
+            tileIndices.push_back(tile_i);
+        } // for all tiles horizontally
+    } // for all tiles vertically
+
+    CopyTiledToTiledProcessor processor(renderArgs);
+    processor.setData(&args, this, fromImage._imp.get(), tileIndices);
+    ActionRetCodeEnum stat = processor.launchThreads();
+    (void)stat;
+
+} // copyTiledImageToTiledImage
+
 template <typename PIX, int maxValue, int nComps>
 static void
 halveImageForInternal(const void* srcPtrs[4],
@@ -849,10 +1143,10 @@ halveImageForInternal(const void* srcPtrs[4],
                 // a b
                 // c d
 
-                const PIX a = (pickThisCol && pickThisRow) ? *(srcPixelPtrs[k]) : 0;
-                const PIX b = (pickNextCol && pickThisRow) ? *(srcPixelPtrs[k] + srcPixelStride) : 0;
-                const PIX c = (pickThisCol && pickNextRow) ? *(srcPixelPtrs[k] + srcRowElementsCount) : 0;
-                const PIX d = (pickNextCol && pickNextRow) ? *(srcPixelPtrs[k] + srcRowElementsCount + srcPixelStride)  : 0;
+                const PIX a = (pickThisCol && pickThisRow) ? *(srcPixelPtrs[k]) : PIX(0);
+                const PIX b = (pickNextCol && pickThisRow) ? *(srcPixelPtrs[k] + srcPixelStride) : PIX(0);
+                const PIX c = (pickThisCol && pickNextRow) ? *(srcPixelPtrs[k] + srcRowElementsCount) : PIX(0);
+                const PIX d = (pickNextCol && pickNextRow) ? *(srcPixelPtrs[k] + srcRowElementsCount + srcPixelStride)  : PIX(0);
 
                 assert( sumW == 2 || ( sumW == 1 && ( (a == 0 && c == 0) || (b == 0 && d == 0) ) ) );
                 assert( sumH == 2 || ( sumH == 1 && ( (a == 0 && b == 0) || (c == 0 && d == 0) ) ) );
@@ -917,7 +1211,7 @@ ImagePrivate::halveImage(const void* srcPtrs[4],
             halveImageForDepth<unsigned short, 65535>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            halveImageForDepth<Half, 1>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds);
             break;
         case eImageBitDepthFloat:
             halveImageForDepth<float, 1>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds);
@@ -1004,7 +1298,7 @@ ImagePrivate::checkForNaNs(void* ptrs[4],
             return checkForNaNsForDepth<unsigned short, 65535>(ptrs, nComps, bounds, roi);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            return checkForNaNsForDepth<Half, 1>(ptrs, nComps, bounds, roi);
             break;
         case eImageBitDepthFloat:
             return checkForNaNsForDepth<float, 1>(ptrs, nComps, bounds, roi);
@@ -46,6 +46,50 @@
 
 NATRON_NAMESPACE_ENTER;
 
+/**
+ * @brief Data that are the same for all tiles of an image. They are computed once in Image::init
+ * and then used by initTile and fetchTilesFromCache for each tile.
+ **/
+struct ImageTilesInitData
+{
+    // For each buffer of a tile, the index of the channel in the layer or -1 if the buffer holds all channels
+    std::vector<int> channelIndices;
+
+    // For each buffer of a tile, the name of the channel in the keys
+    std::vector<std::string> channelNames;
+
+    // For each buffer of a tile, the hash prefix state (see ImageTileKey::computeTilesHashPrefixState)
+    // of the key at the requested scale and draft mode
+    std::vector<U64> requestedScaleHashPrefix;
+
+    // For each buffer of a tile, the hash prefix states of the keys to look-up in the cache.
+    // Indexed by (buffer_i * 2 + mipmap_i) * 2 + draft_i
+    std::vector<U64> lookupHashPrefix;
+
+    // The number of mipmap levels to look-up in the cache and the first one
+    int nMipMapLookups;
+    unsigned int firstLookupLevel;
+
+    // The size class of the tiles looked-up at mipmap level 0
+    int level0TileSizeClass;
+
+    // For tiles stored in the cache, the allocation arguments are the same for all tiles
+    boost::shared_ptr<AllocateMemoryArgs> cacheTileAllocArgs;
+
+    ImageTilesInitData()
+    : channelIndices()
+    , channelNames()
+    , requestedScaleHashPrefix()
+    , lookupHashPrefix()
+    , nMipMapLookups(0)
+    , firstLookupLevel(0)
+    , level0TileSizeClass(0)
+    , cacheTileAllocArgs()
+    {
+
+    }
+};
+
 struct ImagePrivate
 {
     // The rectangle where data are defined
@@ -90,7 +134,23 @@ struct ImagePrivate
 
     void initFromExternalBuffer(const Image::InitStorageArgs& args);
 
-    void initTileAndFetchFromCache(const Image::InitStorageArgs& args, int tx, int ty, int nTilesWidth, int tileSizeX, int tileSizeY);
+    /**
+     * @brief Computes the data shared by all tiles, to be passed to initTile and fetchTilesFromCache.
+     **/
+    void initTilesInitData(const Image::InitStorageArgs& args, ImageTilesInitData* data) const;
+
+    /**
+     * @brief Initializes the bounds and buffers of the tile at tx,ty. If the image is cached, the buffers key
+     * are set to the requested scale, but the cache is not looked-up: see fetchTilesFromCache.
+     **/
+    void initTile(const Image::InitStorageArgs& args, const ImageTilesInitData& initData, int tx, int ty, int nTilesWidth, int tileSizeX, int tileSizeY);
+
+    /**
+     * @brief Look-up the cache for the tiles in the range [fromTileIndex, toTileIndex[ that were
+     * initialized with initTile. All the buffers of the range are looked-up with Cache::getBatch
+     * so that each cache bucket is locked once per look-up pass.
+     **/
+    void fetchTilesFromCache(const Image::InitStorageArgs& args, const ImageTilesInitData& initData, int fromTileIndex, int toTileIndex, int nTilesWidth);
 
     /**
      * @brief Called in the destructor to insert tiles that were processed in the cache.
@@ -127,6 +187,18 @@ struct ImagePrivate
      **/
     void copyUntiledImageToUntiledImage(const Image& fromImage, const Image::CopyPixelsArgs& args);
 
+    /**
+     * @brief Helper to copy from a tiled image to another tiled image. The tiles of both images
+     * do not need to be aligned nor to have the same size: each destination tile is written
+     * directly from the source tiles it overlaps.
+     **/
+    void copyTiledImageToTiledImage(const Image& fromImage, const Image::CopyPixelsArgs& args);
+
+    /**
+     * @brief Copy the pixels of the source tiled image that overlap the given tile of this image.
+     **/
+    void copyTiledImageToTile(const ImagePrivate& fromImage, const Image::Tile& toTile, const Image::CopyPixelsArgs& args) const;
+
     /**
      * @brief The main entry point to copy image portions.
      * The storage may vary as well as the number of components and the bitdepth.
@@ -461,18 +461,22 @@ struct CacheImageTileStoragePrivate
     boost::scoped_ptr<RamBuffer<char> > localBuffer;
     ImageBitDepthEnum bitdepth;
 
-    CacheImageTileStoragePrivate()
+    // The size class of the tile, see Cache::getTileSizePx
+    int tileSizeClass;
+
+    CacheImageTileStoragePrivate(int tileSizeClass)
     : localBuffer()
     , bitdepth(eImageBitDepthNone)
+    , tileSizeClass(tileSizeClass)
     {
 
     }
 };
 
-CacheImageTileStorage::CacheImageTileStorage(const CachePtr& cache)
+CacheImageTileStorage::CacheImageTileStorage(const CachePtr& cache, int tileSizeClass)
 : ImageStorageBase()
 , CacheEntryBase(cache)
-, _imp(new CacheImageTileStoragePrivate())
+, _imp(new CacheImageTileStoragePrivate(tileSizeClass))
 {
 
 }
@@ -486,7 +490,7 @@ void
 CacheImageTileStorage::toMemorySegment(ExternalSegmentType* segment, const std::string& objectNamesPrefix, ExternalSegmentTypeHandleList* objectPointers, void* tileDataPtr) const
 {
     assert(tileDataPtr && _imp->localBuffer);
-    memcpy(tileDataPtr, _imp->localBuffer->getData(), NATRON_TILE_SIZE_BYTES);
+    memcpy(tileDataPtr, _imp->localBuffer->getData(), getBufferSize());
     CacheEntryBase::toMemorySegment(segment, objectNamesPrefix, objectPointers, tileDataPtr);
 }
 
@@ -504,7 +508,7 @@ CacheImageTileStorage::fromMemorySegment(ExternalSegmentType* segment, const std
         allocateMemoryFromSetArgs();
     }
     assert(tileDataPtr && _imp->localBuffer);
-    memcpy(_imp->localBuffer->getData(), tileDataPtr, NATRON_TILE_SIZE_BYTES);
+    memcpy(_imp->localBuffer->getData(), tileDataPtr, getBufferSize());
 }
 
 StorageModeEnum
@@ -516,7 +520,7 @@ CacheImageTileStorage::getStorageMode() const
 std::size_t
 CacheImageTileStorage::getBufferSize() const
 {
-    return NATRON_TILE_SIZE_BYTES;
+    return Cache::getTileSizeBytes(_imp->tileSizeClass);
 }
 
 std::size_t
@@ -531,7 +535,7 @@ CacheImageTileStorage::getBounds() const
     RectI ret;
 
     int tileSizeX, tileSizeY;
-    Cache::getTileSizePx(getBitDepth(), &tileSizeX, &tileSizeY);
+    Cache::getTileSizePx(getBitDepth(), _imp->tileSizeClass, &tileSizeX, &tileSizeY);
     // Recover the bottom left corner from the tile coords
     {
         CacheEntryKeyBasePtr key = getKey();
@@ -552,7 +556,7 @@ CacheImageTileStorage::getRowSize() const
 
     ImageBitDepthEnum bitDepth = getBitDepth();
     int tileSizeX, tileSizeY;
-    Cache::getTileSizePx(bitDepth,&tileSizeX, &tileSizeY);
+    Cache::getTileSizePx(bitDepth, _imp->tileSizeClass, &tileSizeX, &tileSizeY);
 
     return tileSizeX * getSizeOfForBitDepth(bitDepth);
 
@@ -564,6 +568,18 @@ CacheImageTileStorage::isStorageTiled() const
     return true;
 }
 
+int
+CacheImageTileStorage::getTileSizeClass() const
+{
+    return _imp->tileSizeClass;
+}
+
+const void*
+CacheImageTileStorage::getTileData() const
+{
+    return getData();
+}
+
 const char*
 CacheImageTileStorage::getData() const
 {
@@ -589,7 +605,7 @@ CacheImageTileStorage::allocateMemoryImpl(const AllocateMemoryArgs& args)
 {
     assert(!_imp->localBuffer);
     _imp->localBuffer.reset(new RamBuffer<char>);
-    _imp->localBuffer->resize(NATRON_TILE_SIZE_BYTES);
+    _imp->localBuffer->resize( getBufferSize() );
     _imp->bitdepth = args.bitDepth;
 }
 
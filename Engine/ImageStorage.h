@@ -300,7 +300,7 @@ toGLImageStorage(const ImageStorageBasePtr& entry)
 /**
  * @brief Image storage based on the cache shared memory.
  * Unlike other storage modes, the size of such an image storage is 
- * exactly the size of a tile in the cache: NATRON_TILE_SIZE_BYTES
+ * exactly the size of a tile in the cache: Cache::getTileSizeBytes(tileSizeClass)
  * The allocate() args must be of CacheAllocateMemoryArgs type.
  **/
 struct CacheImageTileStoragePrivate;
@@ -309,7 +309,7 @@ class CacheImageTileStorage
 , public CacheEntryBase
 {
 public:
-    CacheImageTileStorage(const CachePtr& cache);
+    CacheImageTileStorage(const CachePtr& cache, int tileSizeClass);
 
     virtual ~CacheImageTileStorage();
 
@@ -329,6 +329,10 @@ public:
 
     virtual bool isStorageTiled() const OVERRIDE FINAL;
 
+    virtual int getTileSizeClass() const OVERRIDE FINAL;
+
+    virtual const void* getTileData() const OVERRIDE FINAL;
+
     virtual void toMemorySegment(ExternalSegmentType* segment, const std::string& objectNamesPrefix, ExternalSegmentTypeHandleList* objectPointers, void* tileDataPtr) const OVERRIDE FINAL;
 
     virtual void fromMemorySegment(ExternalSegmentType* segment, const std::string& objectNamesPrefix, const void* tileDataPtr) OVERRIDE FINAL;
@@ -39,6 +39,12 @@
 #include <QtCore/QThread>
 #include <QtCore/QDebug>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <boost/unordered_map.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
+
 #include "Global/GlobalDefines.h"
 
 #include "Engine/AppInstance.h"
@@ -1337,6 +1343,7 @@ void
 KnobHelper::setName(const std::string & name,
                     bool throwExceptions)
 {
+    std::string oldName = _imp->name;
     _imp->originalName = name;
     _imp->name = NATRON_PYTHON_NAMESPACE::makeNameScriptFriendly(name);
     KnobHolderPtr holder = getHolder();
@@ -1378,6 +1385,7 @@ KnobHelper::setName(const std::string & name,
             Q_UNUSED(obj);
             if (isAttrDefined) {
                 QString message = tr("A Python attribute with the name %1 already exists.").arg(QString::fromUtf8(newPotentialQualifiedName.c_str()));
+                holder->onKnobNameChanged(shared_from_this(), oldName);
                 if (throwExceptions) {
                     throw std::runtime_error( message.toStdString() );
                 } else {
@@ -1390,6 +1398,7 @@ KnobHelper::setName(const std::string & name,
         }
     }
     _imp->name = finalName;
+    holder->onKnobNameChanged(shared_from_this(), oldName);
 } // KnobHelper::setName
 
 const std::string &
@@ -4144,6 +4153,11 @@ struct KnobHolder::KnobHolderPrivate
     bool isShallowRenderCopy;
 
     std::vector< KnobIPtr > knobs;
+
+    // The knobs indexed by script-name, kept in sync with knobs and KnobHelper::setName.
+    // Knobs are named after their label until they get their script-name, so several knobs may share a name.
+    typedef boost::unordered_multimap<std::string, KnobIPtr> KnobsNameIndex;
+    KnobsNameIndex knobsByName;
     bool knobsInitialized;
     bool isInitializingKnobs;
     std::vector<KnobIWPtr> knobsWithViewerUI;
@@ -4200,6 +4214,7 @@ struct KnobHolder::KnobHolderPrivate
         , knobsMutex()
         , isShallowRenderCopy(false)
         , knobs()
+        , knobsByName()
         , knobsInitialized(false)
         , isInitializingKnobs(false)
         , evaluationBlockedMutex(QMutex::Recursive)
@@ -4225,6 +4240,7 @@ struct KnobHolder::KnobHolderPrivate
     , knobsMutex()
     , isShallowRenderCopy(true)
     , knobs(other.knobs)
+    , knobsByName(other.knobsByName)
     , knobsInitialized(other.knobsInitialized)
     , isInitializingKnobs(other.isInitializingKnobs)
     , evaluationBlockedMutex(QMutex::Recursive)
@@ -4240,6 +4256,50 @@ struct KnobHolder::KnobHolderPrivate
     {
 
     }
+
+    // The following must be called with knobsMutex locked
+
+    void indexKnob(const KnobIPtr& knob)
+    {
+        knobsByName.insert( std::make_pair(knob->getName(), knob) );
+    }
+
+    void unindexKnob(const KnobIConstPtr& knob,
+                     const std::string& name)
+    {
+        std::pair<KnobsNameIndex::iterator, KnobsNameIndex::iterator> range = knobsByName.equal_range(name);
+        for (KnobsNameIndex::iterator it = range.first; it != range.second; ++it) {
+            if (it->second == knob) {
+                knobsByName.erase(it);
+
+                return;
+            }
+        }
+    }
+
+    KnobIPtr findKnobByName(const std::string& name,
+                            const KnobIConstPtr& caller) const
+    {
+        std::pair<KnobsNameIndex::const_iterator, KnobsNameIndex::const_iterator> range = knobsByName.equal_range(name);
+        KnobIPtr found;
+        for (KnobsNameIndex::const_iterator it = range.first; it != range.second; ++it) {
+            if (it->second == caller) {
+                continue;
+            }
+            if (found) {
+                // Several knobs have this name: return the first one in the knobs order
+                for (U32 i = 0; i < knobs.size(); ++i) {
+                    if ( (knobs[i] != caller) && (knobs[i]->getName() == name) ) {
+                        return knobs[i];
+                    }
+                }
+                break;
+            }
+            found = it->second;
+        }
+
+        return found;
+    }
 };
 
 KnobHolder::KnobHolder(const AppInstancePtr& appInstance)
@@ -4400,6 +4460,7 @@ KnobHolder::addKnob(const KnobIPtr& k)
         }
     }
     _imp->knobs.push_back(k);
+    _imp->indexKnob(k);
 }
 
 void
@@ -4422,6 +4483,7 @@ KnobHolder::insertKnob(int index,
         std::advance(it, index);
         _imp->knobs.insert(it, k);
     }
+    _imp->indexKnob(k);
 }
 
 void
@@ -4432,6 +4494,25 @@ KnobHolder::removeKnobFromList(const KnobIConstPtr& knob)
     for (KnobsVec::iterator it = _imp->knobs.begin(); it != _imp->knobs.end(); ++it) {
         if (*it == knob) {
             _imp->knobs.erase(it);
+            _imp->unindexKnob( knob, knob->getName() );
+
+            return;
+        }
+    }
+}
+
+void
+KnobHolder::onKnobNameChanged(const KnobIPtr& knob,
+                              const std::string& oldName)
+{
+    QMutexLocker kk(&_imp->knobsMutex);
+
+    // Only knobs in the list are indexed
+    std::pair<KnobHolderPrivate::KnobsNameIndex::iterator, KnobHolderPrivate::KnobsNameIndex::iterator> range = _imp->knobsByName.equal_range(oldName);
+    for (KnobHolderPrivate::KnobsNameIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == knob) {
+            _imp->knobsByName.erase(it);
+            _imp->indexKnob(knob);
 
             return;
         }
@@ -4503,6 +4584,7 @@ KnobHolder::deleteKnob(const KnobIPtr& knob,
         for (KnobsVec::iterator it2 = _imp->knobs.begin(); it2 != _imp->knobs.end(); ++it2) {
             if (*it2 == knob) {
                 _imp->knobs.erase(it2);
+                _imp->unindexKnob( knob, knob->getName() );
                 break;
             }
         }
@@ -4511,6 +4593,9 @@ KnobHolder::deleteKnob(const KnobIPtr& knob,
     if (sharedKnob && alsoDeleteGui && _imp->settingsPanel) {
         _imp->settingsPanel->deleteKnobGui(sharedKnob);
     }
+    if ( sharedKnob && sharedKnob->isUserKnob() ) {
+        markDirtyForAutoSave();
+    }
 }
 
 void
@@ -4770,6 +4855,9 @@ KnobHolder::onUserKnobCreated(const KnobIPtr& knob, bool isUserKnob)
             isEffect->getNode()->declarePythonKnobs();
         }
     }
+    if (isUserKnob) {
+        markDirtyForAutoSave();
+    }
 
 }
 
@@ -5075,6 +5163,9 @@ KnobHolder::onKnobValueChangedInternal(const KnobIPtr& knob,
         return false;
     }
 
+    // Values set from other threads (e.g: tracking) must be auto-saved too
+    markDirtyForAutoSave();
+
     // Don't run anything when setValue was called on a thread different than the main thread
     if (QThread::currentThread() != qApp->thread()) {
         return true;
@@ -5279,13 +5370,7 @@ KnobHolder::getKnobByName(const std::string & name) const
 {
     QMutexLocker k(&_imp->knobsMutex);
 
-    for (U32 i = 0; i < _imp->knobs.size(); ++i) {
-        if (_imp->knobs[i]->getName() == name) {
-            return _imp->knobs[i];
-        }
-    }
-
-    return KnobIPtr();
+    return _imp->findKnobByName( name, KnobIConstPtr() );
 }
 
 // Same as getKnobByName expect that if we find the caller, we skip it
@@ -5295,16 +5380,7 @@ KnobHolder::getOtherKnobByName(const std::string & name,
 {
     QMutexLocker k(&_imp->knobsMutex);
 
-    for (U32 i = 0; i < _imp->knobs.size(); ++i) {
-        if (_imp->knobs[i] == caller) {
-            continue;
-        }
-        if (_imp->knobs[i]->getName() == name) {
-            return _imp->knobs[i];
-        }
-    }
-
-    return KnobIPtr();
+    return _imp->findKnobByName(name, caller);
 }
 
 const KnobsVec &
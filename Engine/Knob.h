@@ -2311,7 +2311,11 @@ private:
      */
     bool evaluateExpression_pod(TimeValue time, ViewIdx view, DimIdx dimension, double* value, std::string* error);
 
-    CacheEntryLockerPtr getKnobExpresionResults(TimeValue time, ViewIdx view, DimIdx dimension);
+    /**
+     * @brief Returns the cached result of the expression if isCached is set to true, otherwise
+     * a new result to fill and insert in the action results cache.
+     **/
+    KnobExpressionResultPtr getKnobExpresionResults(TimeValue time, ViewIdx view, DimIdx dimension, bool* isCached);
 
     bool getValueFromExpression(TimeValue time, ViewIdx view, DimIdx dimension, bool clamp, T* ret);
 
@@ -2589,19 +2593,7 @@ public:
     template <typename TYPE>
     boost::shared_ptr<TYPE> getKnobByNameAndType(const std::string & name) const
     {
-        const KnobsVec& knobs = getKnobs();
-
-        for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
-            if ( (*it)->getName() == name ) {
-                boost::shared_ptr<TYPE> isType = boost::dynamic_pointer_cast<TYPE>(*it);
-                if (isType) {
-                    return isType;
-                }
-                break;
-            }
-        }
-
-        return boost::shared_ptr<TYPE>();
+        return boost::dynamic_pointer_cast<TYPE>( getKnobByName(name) );
     }
 
     const std::vector< KnobIPtr > & getKnobs() const WARN_UNUSED_RETURN;
@@ -2834,6 +2826,12 @@ protected:
     virtual void evaluate(bool /*isSignificant*/,
                           bool /*refreshMetadatas*/) {}
 
+    /**
+     * @brief Called whenever a knob of this holder changed or a user knob was created or removed, so that
+     * the next auto-save knows what it has to write. This may be called from any thread.
+     **/
+    virtual void markDirtyForAutoSave() {}
+
     /**
      * @brief The virtual portion of notifyProjectBeginValuesChanged(). This is called by the project
      * You should NEVER CALL THIS YOURSELF as it would break the bracketing system.
@@ -2870,6 +2868,10 @@ protected:
 
 private:
 
+    /**
+     * @brief Called by KnobHelper::setName to keep the index of knobs by name up to date.
+     **/
+    void onKnobNameChanged(const KnobIPtr& knob, const std::string& oldName);
 
     /**
      * @brief Must be implemented to initialize any knob using the
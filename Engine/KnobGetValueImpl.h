@@ -29,6 +29,7 @@
 
 #include "KnobPrivate.h"
 
+#include "Engine/ActionResultsCache.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/KnobItemsTable.h"
 #include "Engine/RenderValuesCache.h"
@@ -71,8 +72,8 @@ setValueFromCachedExpressionResult(const KnobExpressionResultPtr& cachedValue, c
 }
 
 template <typename T>
-CacheEntryLockerPtr
-Knob<T>::getKnobExpresionResults(TimeValue time, ViewIdx view, DimIdx dimension)
+KnobExpressionResultPtr
+Knob<T>::getKnobExpresionResults(TimeValue time, ViewIdx view, DimIdx dimension, bool* isCached)
 {
     KnobHolderPtr holder = getHolder();
     EffectInstancePtr effect = toEffectInstance(holder);
@@ -99,16 +100,14 @@ Knob<T>::getKnobExpresionResults(TimeValue time, ViewIdx view, DimIdx dimension)
 
 
     KnobExpressionKeyPtr cacheKey(new KnobExpressionKey(effectHash, dimension, time, view, getName()));
-    KnobExpressionResultPtr cachedResult = KnobExpressionResult::create(cacheKey);
 
-    CacheEntryLockerPtr locker = appPTR->getCache()->get(cachedResult);
-
-    CacheEntryLocker::CacheEntryStatusEnum cacheStatus = locker->getStatus();
-    while (cacheStatus == CacheEntryLocker::eCacheEntryStatusComputationPending) {
-        cacheStatus = locker->waitForPendingEntry();
+    KnobExpressionResultPtr cachedResult = boost::dynamic_pointer_cast<KnobExpressionResult>(appPTR->getActionResultsCache()->get(cacheKey->getHash(), kCacheKeyUniqueIDExpressionResult));
+    *isCached = (bool)cachedResult;
+    if (!cachedResult) {
+        cachedResult = KnobExpressionResult::create(cacheKey);
     }
 
-    return locker;
+    return cachedResult;
 
 } // getKnobExpresionResults
 
@@ -132,11 +131,10 @@ Knob<T>::getValueFromExpression(TimeValue time,
     ViewIdx view_i = getViewIdxFromGetSpec(view);
 
     // Check for a cached expression result
-    CacheEntryLockerPtr cacheAccess = getKnobExpresionResults(time, view, dimension);
-
-    KnobExpressionResultPtr cachedResult = boost::dynamic_pointer_cast<KnobExpressionResult>(cacheAccess->getProcessLocalEntry());
+    bool isCached;
+    KnobExpressionResultPtr cachedResult = getKnobExpresionResults(time, view, dimension, &isCached);
 
-    if (cacheAccess->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
+    if (isCached) {
         getValueFromCachedExpressionResult(cachedResult, ret);
         return true;
 
@@ -164,7 +162,7 @@ Knob<T>::getValueFromExpression(TimeValue time,
     }
 
     setValueFromCachedExpressionResult(cachedResult, *ret);
-    cacheAccess->insertInCache();
+    appPTR->getActionResultsCache()->insert(cachedResult);
 
     return true;
 } // getValueFromExpression
@@ -231,11 +229,10 @@ Knob<T>::getValueFromExpression_pod(TimeValue time,
     ViewIdx view_i = getViewIdxFromGetSpec(view);
     
     // Check for a cached expression result
-    CacheEntryLockerPtr cacheAccess = getKnobExpresionResults(time, view, dimension);
-
-    KnobExpressionResultPtr cachedResult = boost::dynamic_pointer_cast<KnobExpressionResult>(cacheAccess->getProcessLocalEntry());
+    bool isCached;
+    KnobExpressionResultPtr cachedResult = getKnobExpresionResults(time, view, dimension, &isCached);
 
-    if (cacheAccess->getStatus() == CacheEntryLocker::eCacheEntryStatusCached) {
+    if (isCached) {
         getValueFromCachedExpressionResult<double>(cachedResult, ret);
         return true;
     }
@@ -263,7 +260,7 @@ Knob<T>::getValueFromExpression_pod(TimeValue time,
     
 
     setValueFromCachedExpressionResult(cachedResult, *ret);
-    cacheAccess->insertInCache();
+    appPTR->getActionResultsCache()->insert(cachedResult);
 
     
     return true;
@@ -457,7 +457,11 @@ KnobItemsTable::insertItem(int index, const KnobTableItemPtr& item, const KnobTa
     item->onItemInsertedInModel_recursive();
 
     Q_EMIT itemInserted(index, item, reason);
-    
+
+    NodePtr node = getNode();
+    if (node) {
+        node->markDirtyForAutoSave();
+    }
 }
 
 
@@ -488,6 +492,11 @@ KnobItemsTable::removeItem(const KnobTableItemPtr& item, TableChangeReasonEnum r
             removeItemAsPythonField(item);
         }
         item->onItemRemovedFromModel_recursive();
+
+        NodePtr node = getNode();
+        if (node) {
+            node->markDirtyForAutoSave();
+        }
     }
 }
 
@@ -684,6 +693,22 @@ KnobTableItem::evaluate(bool isSignificant, bool refreshMetadatas)
     node->getEffectInstance()->evaluate(isSignificant, refreshMetadatas);
 }
 
+void
+KnobTableItem::markDirtyForAutoSave()
+{
+    if ( isRenderClone() ) {
+        return;
+    }
+    KnobItemsTablePtr model = getModel();
+    if (!model) {
+        return;
+    }
+    NodePtr node = model->getNode();
+    if (node) {
+        node->markDirtyForAutoSave();
+    }
+}
+
 void
 KnobTableItem::setLabel(const std::string& label, TableChangeReasonEnum reason)
 {
@@ -697,6 +722,7 @@ KnobTableItem::setLabel(const std::string& label, TableChangeReasonEnum reason)
     }
     if (changed) {
         Q_EMIT labelChanged(QString::fromUtf8(label.c_str()), reason);
+        markDirtyForAutoSave();
         evaluate(false, false);
     }
 }
@@ -440,6 +440,12 @@ protected:
      **/
     virtual void evaluate(bool isSignificant, bool refreshMetadatas) OVERRIDE;
 
+    /**
+     * @brief Reimplemented from KnobHolder.
+     * Items are saved with the node holding the model, mark it for the next auto-save.
+     **/
+    virtual void markDirtyForAutoSave() OVERRIDE FINAL;
+
     /**
      * @brief Refresh all animated knobs and recurses on children items
      **/
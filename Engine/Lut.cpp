@@ -27,6 +27,7 @@
 #include <cstring> // for std::memcpy
 #include <algorithm> // min, max
 #include <cassert>
+#include <limits>
 #include <stdexcept>
 
 #include "Engine/RectI.h"
@@ -228,28 +229,15 @@ getOffsetsForPacking(PixelPackingEnum format,
 float
 Lut::fromColorSpaceUint8ToLinearFloatFast(unsigned char v) const
 {
-    assert(init_);
+    assert( isValid() );
 
     return fromFunc_uint8_to_float[v];
 }
 
-#ifdef DEAD_CODE
-// It is not recommended to use this function, because the output is quantized
-// If one really needs float, one has to use the full function (or OpenColorIO)
-float
-Lut::toColorSpaceFloatFromLinearFloatFast(float v) const
-{
-    assert(init_);
-
-    return Color::intToFloat<0xff01>(toFunc_hipart_to_uint8xx[hipart(v)]);
-}
-
-#endif // DEAD_CODE
-
 unsigned char
 Lut::toColorSpaceUint8FromLinearFloatFast(float v) const
 {
-    assert(init_);
+    assert( isValid() );
 
     return Color::uint8xxToChar(toFunc_hipart_to_uint8xx[hipart(v)]);
 }
@@ -257,7 +245,7 @@ Lut::toColorSpaceUint8FromLinearFloatFast(float v) const
 unsigned short
 Lut::toColorSpaceUint8xxFromLinearFloatFast(float v) const
 {
-    assert(init_);
+    assert( isValid() );
 
     return toFunc_hipart_to_uint8xx[hipart(v)];
 }
@@ -266,7 +254,7 @@ Lut::toColorSpaceUint8xxFromLinearFloatFast(float v) const
 unsigned short
 Lut::toColorSpaceUint16FromLinearFloatFast(float v) const
 {
-    assert(init_);
+    assert( isValid() );
     // algorithm:
     // - convert to 8 bits -> val8u
     // - convert val8u-1, val8u and val8u+1 to float
@@ -307,7 +295,7 @@ Lut::toColorSpaceUint16FromLinearFloatFast(float v) const
 float
 Lut::fromColorSpaceUint16ToLinearFloatFast(unsigned short v) const
 {
-    assert(init_);
+    assert( isValid() );
     // the following is from ImageMagick's quantum.h
     unsigned char v8u_prev = ( v - (v >> 8) ) >> 8;
     unsigned char v8u_next = v8u_prev + 1;
@@ -320,12 +308,40 @@ Lut::fromColorSpaceUint16ToLinearFloatFast(unsigned short v) const
     return v32f_prev + (v - v16u_prev) * (v32f_next - v32f_prev) / (v16u_next - v16u_prev);
 }
 
+/// Clamps infinite values of a transfer function to the largest float, so that interpolating between
+/// 2 entries of a table never computes inf - inf
+static float
+clampToFiniteFloat(float f)
+{
+    if ( f > std::numeric_limits<float>::max() ) {
+        return std::numeric_limits<float>::max();
+    } else if ( f < -std::numeric_limits<float>::max() ) {
+        return -std::numeric_limits<float>::max();
+    }
+
+    return f;
+}
+
 void
 Lut::fillTables() const
 {
-    if (init_) {
-        return;
+    // fill the float tables
+    for (int i = 0; i < 0x10002; ++i) {
+        float inp = NATRON_LUT_FROM_FLOAT_MIN + i * ( (NATRON_LUT_FROM_FLOAT_MAX - NATRON_LUT_FROM_FLOAT_MIN) / 0x10000 );
+        fromFunc_float_to_float[i] = clampToFiniteFloat( _fromFunc(inp) );
+    }
+    for (unsigned int i = 0; i < 0x10000; ++i) {
+        unsigned int bits = i << 16;
+        float inp;
+        if ( (bits & 0x7f800000) == 0x7f800000 ) {
+            // Infinity and NaN are never looked up, but infinity is the upper bound of the interval of the largest floats
+            inp = (bits & 0x80000000) ? -std::numeric_limits<float>::max() : std::numeric_limits<float>::max();
+        } else {
+            std::memcpy( &inp, &bits, sizeof(inp) );
+        }
+        toFunc_hipart_to_float[i] = clampToFiniteFloat( _toFunc(inp) );
     }
+
     // fill all
     for (int i = 0; i < 0x10000; ++i) {
         float inp = index_to_float( (unsigned short)i );
@@ -423,12 +439,12 @@ Lut::to_float_planar(float* to,
 {
     validate();
     if (!alpha) {
-        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = toColorSpaceFloatFromLinearFloat(from[f]);
+        for (int x = 0, f = 0, t = 0; x < W; ++x, f += inDelta, t += outDelta) {
+            to[t] = toColorSpaceFloatFromLinearFloatFast(from[f]);
         }
     } else {
-        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = toColorSpaceFloatFromLinearFloat(from[f] * alpha[f]);
+        for (int x = 0, f = 0, t = 0; x < W; ++x, f += inDelta, t += outDelta) {
+            to[t] = toColorSpaceFloatFromLinearFloatFast(from[f] * alpha[f]);
         }
     }
 }
@@ -579,9 +595,9 @@ Lut::to_float_packed(float* to,
             int inCol = x * inPackingSize;
             int outCol = x * outPackingSize;
             float a = (inputHasAlpha && premult) ? src_pixels[inCol + inAOffset] : 1.f;;
-            dst_pixels[outCol + outROffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inROffset] * a);
-            dst_pixels[outCol + outGOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inGOffset] * a);
-            dst_pixels[outCol + outBOffset] = toColorSpaceFloatFromLinearFloat(src_pixels[inCol + inBOffset] * a);
+            dst_pixels[outCol + outROffset] = toColorSpaceFloatFromLinearFloatFast(src_pixels[inCol + inROffset] * a);
+            dst_pixels[outCol + outGOffset] = toColorSpaceFloatFromLinearFloatFast(src_pixels[inCol + inGOffset] * a);
+            dst_pixels[outCol + outBOffset] = toColorSpaceFloatFromLinearFloatFast(src_pixels[inCol + inBOffset] * a);
             if (outputHasAlpha) {
                 // alpha is linear and should not be dithered
                 dst_pixels[outCol + outAOffset] = a;
@@ -631,13 +647,13 @@ Lut::from_float_planar(float* to,
 {
     validate();
     if (!alpha) {
-        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
-            to[t] = fromColorSpaceFloatToLinearFloat(from[f]);
+        for (int x = 0, f = 0, t = 0; x < W; ++x, f += inDelta, t += outDelta) {
+            to[t] = fromColorSpaceFloatToLinearFloatFast(from[f]);
         }
     } else {
-        for (int f = 0, t = 0; f < W; f += inDelta, t += outDelta) {
+        for (int x = 0, f = 0, t = 0; x < W; ++x, f += inDelta, t += outDelta) {
             float a = alpha[f];
-            to[t] = a <= 0. ? 0. : fromColorSpaceFloatToLinearFloat(from[f] / a) * a;
+            to[t] = a <= 0. ? 0. : fromColorSpaceFloatToLinearFloatFast(from[f] / a) * a;
         }
     }
 }
@@ -788,9 +804,9 @@ Lut::from_float_packed(float* to,
                 gf = src_pixels[inCol + inGOffset] / a;
                 bf = src_pixels[inCol + inBOffset] / a;
             }
-            dst_pixels[outCol + outROffset] = fromColorSpaceFloatToLinearFloat(rf) * a;
-            dst_pixels[outCol + outGOffset] = fromColorSpaceFloatToLinearFloat(gf) * a;
-            dst_pixels[outCol + outBOffset] = fromColorSpaceFloatToLinearFloat(bf) * a;
+            dst_pixels[outCol + outROffset] = fromColorSpaceFloatToLinearFloatFast(rf) * a;
+            dst_pixels[outCol + outGOffset] = fromColorSpaceFloatToLinearFloatFast(gf) * a;
+            dst_pixels[outCol + outBOffset] = fromColorSpaceFloatToLinearFloatFast(bf) * a;
             if (outputHasAlpha) {
                 // alpha is linear
                 dst_pixels[outCol + outAOffset] = a;
@@ -31,12 +31,15 @@
 ///// This namespace is kept is synch with what can be found in openfx-io repository. It is used here in Natron for the viewer essentially.
 ///
 
+#include <cassert>
 #include <cmath>
+#include <cstring>
 #include <map>
 #include <string>
 
 CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
 CLANG_DIAG_ON(deprecated)
 
 #include "Engine/EngineFwd.h"
@@ -46,6 +49,11 @@ NATRON_NAMESPACE_ENTER;
 #define NATRON_COLOR_HUE_CIRCLE 1. // if hue should be between 0 and 1
 //#define NATRON_COLOR_HUE_CIRCLE 360. // if hue should be in degrees
 
+// Range of the color-space values covered by the float to float table of the fromFunc.
+// Values outside of this range use the transfer function directly.
+#define NATRON_LUT_FROM_FLOAT_MIN -0.5f
+#define NATRON_LUT_FROM_FLOAT_MAX 1.5f
+
 
 namespace Color {
 /// @enum An enum describing supported pixels packing formats
@@ -139,8 +147,15 @@ class Lut
     /// and never change afterwards
     mutable unsigned short toFunc_hipart_to_uint8xx[0x10000];         /// contains  2^16 = 65536 values between 0-255
     mutable float fromFunc_uint8_to_float[256];         /// values between 0-1.f
-    mutable bool init_;         ///< false if the tables are not yet initialized
-    mutable QMutex _lock;         ///< protects init_
+
+    /// fromFunc sampled at 2^16 regular intervals over [NATRON_LUT_FROM_FLOAT_MIN, NATRON_LUT_FROM_FLOAT_MAX].
+    /// There is one extra sample for the upper bound of the last interval and one for rounding errors.
+    mutable float fromFunc_float_to_float[0x10002];
+    /// toFunc sampled at each float whose 16 low bits are 0, i.e. at the hipart of the float.
+    /// Interpolating linearly between 2 consecutive values keeps a relative step of 2^-7 whatever the exponent.
+    mutable float toFunc_hipart_to_float[0x10000];
+    mutable QAtomicInt _initialized;         ///< 0 if the tables are not yet initialized, 1 otherwise
+    mutable QMutex _lock;         ///< protects the tables initialization
 
     friend class LutManager;
     ///private constructor, used by LutManager
@@ -150,7 +165,7 @@ class Lut
         : _name(name)
         , _fromFunc(fromFunc)
         , _toFunc(toFunc)
-        , init_(false)
+        , _initialized()
         , _lock()
     {
     }
@@ -180,16 +195,65 @@ public:
         return _toFunc(v);
     }
 
-    //Called by all public members
+    /* @brief Same as fromColorSpaceFloatToLinearFloat(float) but interpolates linearly in the look-up tables.
+     * The relative error is in the order of 1e-6 in [NATRON_LUT_FROM_FLOAT_MIN, NATRON_LUT_FROM_FLOAT_MAX], values
+     * outside of this range are converted with the transfer function.
+     * validate() must have been called before.
+     */
+    float fromColorSpaceFloatToLinearFloatFast(float v) const
+    {
+        assert( isValid() );
+        // This also catches NaNs
+        if ( !(v >= NATRON_LUT_FROM_FLOAT_MIN && v < NATRON_LUT_FROM_FLOAT_MAX) ) {
+            return _fromFunc(v);
+        }
+        const float x = (v - NATRON_LUT_FROM_FLOAT_MIN) * ( 0x10000 / (NATRON_LUT_FROM_FLOAT_MAX - NATRON_LUT_FROM_FLOAT_MIN) );
+        const int i = (int)x;
+        const float lo = fromFunc_float_to_float[i];
+
+        return lo + (fromFunc_float_to_float[i + 1] - lo) * (x - i);
+    }
+
+    /* @brief Same as toColorSpaceFloatFromLinearFloat(float) but interpolates linearly in the look-up tables.
+     * The relative error is in the order of 1e-6 for all finite values.
+     * validate() must have been called before.
+     */
+    float toColorSpaceFloatFromLinearFloatFast(float v) const
+    {
+        assert( isValid() );
+        unsigned int bits;
+        std::memcpy( &bits, &v, sizeof(bits) );
+        // Infinity and NaN
+        if ( (bits & 0x7f800000) == 0x7f800000 ) {
+            return _toFunc(v);
+        }
+        // The next hipart is at most the one of infinity, which is in the table
+        const unsigned int i = bits >> 16;
+        const float lo = toFunc_hipart_to_float[i];
+
+        return lo + (toFunc_hipart_to_float[i + 1] - lo) * ( (bits & 0xffff) * (1.f / 0x10000) );
+    }
+
+    /* @brief Initializes the look-up tables if needed. This must be called before using any of the Fast functions,
+     * the planar and packed functions call it.
+     * The tables are only built once: afterwards this does not lock.
+     */
     void validate() const
     {
+        if ( _initialized.fetchAndAddAcquire(0) ) {
+            return;
+        }
         QMutexLocker g(&_lock);
-
-        if (init_) {
+        if ( _initialized.fetchAndAddAcquire(0) ) {
             return;
         }
         fillTables();
-        init_ = true;
+        _initialized.fetchAndStoreRelease(1);
+    }
+
+    bool isValid() const
+    {
+        return _initialized.fetchAndAddAcquire(0) != 0;
     }
 
     const std::string & getName() const
@@ -197,13 +261,6 @@ public:
         return _name;
     }
 
-    /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
-     * @return A float in [0 - 1.f] in the destination color-space.
-     */
-    // It is not recommended to use this function, because the output is quantized
-    // If one really needs float, one has to use the full function (or OpenColorIO)
-    //float toColorSpaceFloatFromLinearFloatFast(float v) const;
-
     /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
      * @return A byte in [0 - 255] in the destination color-space.
      */
@@ -0,0 +1,222 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "MemoryGovernor.h"
+
+#include <algorithm> // min, max
+
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDebug>
+
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
+#include "Engine/MemoryInfo.h"
+#include "Engine/Settings.h"
+
+// Interval between 2 polls of the cgroup files
+#define NATRON_MEMORY_GOVERNOR_POLL_INTERVAL_MS 500
+
+// The cache budgets are computed so that the working set stays below this fraction of the limit
+#define NATRON_MEMORY_GOVERNOR_CACHE_TARGET_RATIO 0.80
+
+// New renders are throttled above this fraction of the limit...
+#define NATRON_MEMORY_GOVERNOR_THROTTLE_RATIO 0.90
+
+// ...and admitted again once the working set is below this fraction of the limit
+#define NATRON_MEMORY_GOVERNOR_RESUME_RATIO 0.85
+
+// New renders are also throttled when tasks were stalled waiting for memory more than this percentage of the last 10 seconds
+#define NATRON_MEMORY_GOVERNOR_PRESSURE_THRESHOLD 20.
+
+// Never shrink the cache below this size, otherwise a single frame could not be rendered without thrashing
+#define NATRON_MEMORY_GOVERNOR_MIN_CACHE_BYTES ((std::size_t)256 * 1024 * 1024)
+
+NATRON_NAMESPACE_ENTER;
+
+struct MemoryGovernorPrivate
+{
+    QMutex mustQuitMutex;
+    QWaitCondition mustQuitCond;
+    bool mustQuit;
+
+    // 1 if new renders should wait
+    QAtomicInt throttled;
+
+    MemoryGovernorPrivate()
+    : mustQuitMutex()
+    , mustQuitCond()
+    , mustQuit(false)
+    , throttled()
+    {
+    }
+
+    void poll();
+};
+
+MemoryGovernor::MemoryGovernor()
+: QThread()
+, _imp(new MemoryGovernorPrivate())
+{
+    setObjectName( QString::fromUtf8("MemoryGovernor") );
+}
+
+MemoryGovernor::~MemoryGovernor()
+{
+
+}
+
+void
+MemoryGovernor::startIfMemoryLimited()
+{
+    U64 limit, workingSet;
+    if ( !getCGroupMemoryInfo(&limit, &workingSet) ) {
+        return;
+    }
+    qDebug() << "Memory limited to" << printAsRAM(limit) << "by the control group, cache budgets will follow the memory usage";
+    if ( !isRunning() ) {
+        start();
+    }
+}
+
+void
+MemoryGovernor::quitThread()
+{
+    if ( !isRunning() ) {
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->mustQuitMutex);
+        _imp->mustQuit = true;
+        _imp->mustQuitCond.wakeOne();
+    }
+    wait();
+
+    // Do not block renders anymore
+    _imp->throttled.fetchAndStoreRelease(0);
+}
+
+bool
+MemoryGovernor::canAdmitRender() const
+{
+    return _imp->throttled.fetchAndAddAcquire(0) == 0;
+}
+
+void
+MemoryGovernorPrivate::poll()
+{
+    U64 limit, workingSet;
+    if ( !getCGroupMemoryInfo(&limit, &workingSet) ) {
+        throttled.fetchAndStoreRelease(0);
+
+        return;
+    }
+
+    CachePtr cache = appPTR->getCache();
+    SettingsPtr settings = appPTR->getCurrentSettings();
+    if (!cache || !settings) {
+        return;
+    }
+
+    // The disk cache is backed by memory mapped files and the RAM cache by process memory: the pages they touched are
+    // accounted in the working set. Compute how much the rest of the process uses, the caches may take what remains below the target.
+    std::size_t cacheSize = cache->getCurrentSize(eStorageModeDisk) + cache->getCurrentSize(eStorageModeRAM);
+    U64 nonCacheUsage = workingSet - std::min( (U64)cacheSize, workingSet );
+    U64 target = (U64)(limit * NATRON_MEMORY_GOVERNOR_CACHE_TARGET_RATIO);
+    U64 available = target > nonCacheUsage ? target - nonCacheUsage : 0;
+
+    std::size_t budget = (std::size_t)std::max( available, (U64)NATRON_MEMORY_GOVERNOR_MIN_CACHE_BYTES );
+
+    // Both caches share the budget. It is split in proportion to their sizes in the Settings, or evenly
+    // if one of them is unlimited (a size of 0 in the settings means unlimited).
+    // What the RAM cache may not use because of its Settings size is left to the disk cache.
+    std::size_t settingsDiskSize = settings->getMaximumDiskCacheSize();
+    std::size_t settingsRAMSize = settings->getMaximumRAMCacheSize();
+    double ramShare = 0.5;
+    if ( (settingsDiskSize != 0) && (settingsRAMSize != 0) ) {
+        ramShare = (double)settingsRAMSize / ( (double)settingsRAMSize + settingsDiskSize );
+    }
+    std::size_t ramBudget = (std::size_t)(budget * ramShare);
+    if (settingsRAMSize != 0) {
+        ramBudget = std::min(ramBudget, settingsRAMSize);
+    }
+    std::size_t diskBudget = budget - ramBudget;
+    if (settingsDiskSize != 0) {
+        diskBudget = std::min(diskBudget, settingsDiskSize);
+    }
+
+    if ( diskBudget != cache->getMaximumCacheSize(eStorageModeDisk) ) {
+        // This evicts the least recently used entries if the budget shrinks
+        cache->setMaximumCacheSize(eStorageModeDisk, diskBudget);
+    }
+    if ( ramBudget != cache->getMaximumCacheSize(eStorageModeRAM) ) {
+        cache->setMaximumCacheSize(eStorageModeRAM, ramBudget);
+    }
+
+    // Re-read the usage now that entries may have been evicted
+    if ( !getCGroupMemoryInfo(&limit, &workingSet) ) {
+        throttled.fetchAndStoreRelease(0);
+
+        return;
+    }
+    double usageRatio = (double)workingSet / limit;
+    double pressure = 0.;
+    bool highPressure = getMemoryPressure(&pressure) && pressure > NATRON_MEMORY_GOVERNOR_PRESSURE_THRESHOLD;
+
+    bool wasThrottled = throttled.fetchAndAddAcquire(0) != 0;
+    bool mustThrottle;
+    if (wasThrottled) {
+        mustThrottle = highPressure || usageRatio > NATRON_MEMORY_GOVERNOR_RESUME_RATIO;
+    } else {
+        mustThrottle = highPressure || usageRatio > NATRON_MEMORY_GOVERNOR_THROTTLE_RATIO;
+    }
+    if (mustThrottle != wasThrottled) {
+        qDebug() << (mustThrottle ? "Throttling" : "Resuming") << "renders, memory usage:" << printAsRAM(workingSet) << "/" << printAsRAM(limit) << "pressure:" << pressure;
+        throttled.fetchAndStoreRelease(mustThrottle ? 1 : 0);
+    }
+} // poll
+
+void
+MemoryGovernor::run()
+{
+    for (;;) {
+        _imp->poll();
+
+        QMutexLocker k(&_imp->mustQuitMutex);
+        if (_imp->mustQuit) {
+            _imp->mustQuit = false;
+
+            return;
+        }
+        _imp->mustQuitCond.wait(&_imp->mustQuitMutex, NATRON_MEMORY_GOVERNOR_POLL_INTERVAL_MS);
+        if (_imp->mustQuit) {
+            _imp->mustQuit = false;
+
+            return;
+        }
+    }
+} // run
+
+NATRON_NAMESPACE_EXIT;
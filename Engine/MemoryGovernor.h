@@ -0,0 +1,84 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_MemoryGovernor_h
+#define Engine_MemoryGovernor_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <QtCore/QThread>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief When the process runs in a memory limited control group (e.g: a container on a render farm), the
+ * cache budgets from the Settings and the system RAM are meaningless: the kernel kills the process as soon as
+ * the working set reaches the cgroup limit.
+ * This thread periodically polls the cgroup limit, usage and the memory pressure stall information and:
+ * - Shrinks the cache budgets so that the working set stays below a fraction of the limit, which evicts the
+ * least recently used entries. The disk and RAM caches share what is available, in proportion to their sizes in
+ * the Settings, and their budgets never exceed the ones from the Settings.
+ * - Throttles the launch of new render tasks (see canAdmitRender()) when the working set approaches the limit.
+ * The thread is not started if the process is not memory limited.
+ **/
+struct MemoryGovernorPrivate;
+class MemoryGovernor
+: public QThread
+{
+
+public:
+
+    MemoryGovernor();
+
+    virtual ~MemoryGovernor();
+
+    /**
+     * @brief Start polling if the process is in a memory limited cgroup, otherwise does nothing.
+     **/
+    void startIfMemoryLimited();
+
+    void quitThread();
+
+    /**
+     * @brief Returns false if the working set is too close to the memory limit (or the memory pressure
+     * is too high) to start a new render task. Always returns true if the process is not memory limited.
+     **/
+    bool canAdmitRender() const;
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    boost::scoped_ptr<MemoryGovernorPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_MemoryGovernor_h
@@ -36,6 +36,9 @@
 #include <algorithm> // min, max
 #include <stdexcept>
 #include <sstream> // stringstream
+#include <fstream>
+#include <list>
+#include <string>
 
 #if defined(_WIN32)
 #  include <windows.h>
@@ -420,4 +423,207 @@ getAmountFreePhysicalRAM()
 #endif
 }
 
+#if defined(__NATRON_LINUX__)
+// Returns the path of the cgroup of this process relative to the cgroup mount point, for the v2 unified hierarchy
+// if isV2 is true, otherwise for the v1 memory controller.
+static bool
+getCGroupPath(bool isV2,
+              std::string* path)
+{
+    std::ifstream ifile("/proc/self/cgroup");
+    if (!ifile) {
+        return false;
+    }
+    std::string line;
+    while ( std::getline(ifile, line) ) {
+        // Format is hierarchy-ID:controller-list:cgroup-path
+        std::size_t firstColon = line.find(':');
+        if (firstColon == std::string::npos) {
+            continue;
+        }
+        std::size_t secondColon = line.find(':', firstColon + 1);
+        if (secondColon == std::string::npos) {
+            continue;
+        }
+        std::string hierarchy = line.substr(0, firstColon);
+        std::string controllers = line.substr(firstColon + 1, secondColon - firstColon - 1);
+        bool found;
+        if (isV2) {
+            found = hierarchy == "0" && controllers.empty();
+        } else {
+            found = false;
+            std::stringstream ss(controllers);
+            std::string controller;
+            while ( std::getline(ss, controller, ',') ) {
+                if (controller == "memory") {
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (found) {
+            *path = line.substr(secondColon + 1);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Reads the first token of a cgroup file. Returns false if the file does not exist or the value is "max" (unlimited).
+static bool
+readCGroupValue(const std::string& filePath,
+                U64* value)
+{
+    std::ifstream ifile( filePath.c_str() );
+    if (!ifile) {
+        return false;
+    }
+    std::string token;
+    ifile >> token;
+    if ( token.empty() || (token == "max") ) {
+        return false;
+    }
+    std::stringstream ss(token);
+    ss >> *value;
+
+    return !ss.fail();
+}
+
+// Reads a "key value" entry of a memory.stat file
+static bool
+readCGroupStat(const std::string& filePath,
+               const std::string& key,
+               U64* value)
+{
+    std::ifstream ifile( filePath.c_str() );
+    if (!ifile) {
+        return false;
+    }
+    std::string name;
+    U64 v;
+    while (ifile >> name >> v) {
+        if (name == key) {
+            *value = v;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Returns the directory of the cgroup files: the cgroup path of the process may not be visible
+// from within a container, in which case the files are at the root of the mount point.
+static std::string
+getCGroupDirectory(const std::string& mountPoint,
+                   const std::string& cgroupPath,
+                   const std::string& probeFile)
+{
+    std::string dir = mountPoint + cgroupPath;
+    if ( !dir.empty() && (dir[dir.size() - 1] != '/') ) {
+        dir.push_back('/');
+    }
+    std::ifstream probe( (dir + probeFile).c_str() );
+    if (probe) {
+        return dir;
+    }
+
+    return mountPoint + "/";
+}
+#endif // __NATRON_LINUX__
+
+bool
+getCGroupMemoryInfo(U64* limitBytes,
+                    U64* workingSetBytes)
+{
+#if defined(__NATRON_LINUX__)
+    std::string cgroupPath;
+
+    // cgroup v2
+    if ( getCGroupPath(true, &cgroupPath) ) {
+        std::string dir = getCGroupDirectory("/sys/fs/cgroup", cgroupPath, "memory.max");
+        U64 limit = 0, usage = 0;
+        if ( readCGroupValue(dir + "memory.max", &limit) && readCGroupValue(dir + "memory.current", &usage) ) {
+            // Inactive file pages are reclaimed by the kernel before it invokes the OOM killer
+            U64 inactiveFile = 0;
+            if ( readCGroupStat(dir + "memory.stat", "inactive_file", &inactiveFile) && (inactiveFile < usage) ) {
+                usage -= inactiveFile;
+            }
+            *limitBytes = limit;
+            *workingSetBytes = usage;
+
+            return true;
+        }
+    }
+
+    // cgroup v1 memory controller
+    if ( getCGroupPath(false, &cgroupPath) ) {
+        std::string dir = getCGroupDirectory("/sys/fs/cgroup/memory", cgroupPath, "memory.limit_in_bytes");
+        U64 limit = 0, usage = 0;
+        if ( readCGroupValue(dir + "memory.limit_in_bytes", &limit) && readCGroupValue(dir + "memory.usage_in_bytes", &usage) ) {
+            // An unlimited v1 cgroup reports a huge page-aligned value
+            if ( limit >= getSystemTotalRAM() ) {
+                return false;
+            }
+            U64 inactiveFile = 0;
+            if ( readCGroupStat(dir + "memory.stat", "total_inactive_file", &inactiveFile) && (inactiveFile < usage) ) {
+                usage -= inactiveFile;
+            }
+            *limitBytes = limit;
+            *workingSetBytes = usage;
+
+            return true;
+        }
+    }
+#else
+    Q_UNUSED(limitBytes);
+    Q_UNUSED(workingSetBytes);
+#endif
+
+    return false;
+} // getCGroupMemoryInfo
+
+bool
+getMemoryPressure(double* someAvg10)
+{
+#if defined(__NATRON_LINUX__)
+    // Prefer the pressure of our own cgroup (v2 only), then the system wide one
+    std::list<std::string> files;
+    std::string cgroupPath;
+    if ( getCGroupPath(true, &cgroupPath) ) {
+        files.push_back( getCGroupDirectory("/sys/fs/cgroup", cgroupPath, "memory.pressure") + "memory.pressure" );
+    }
+    files.push_back("/proc/pressure/memory");
+
+    for (std::list<std::string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+        std::ifstream ifile( it->c_str() );
+        if (!ifile) {
+            continue;
+        }
+        // Format is: some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+        std::string line;
+        while ( std::getline(ifile, line) ) {
+            if (line.compare(0, 5, "some ") != 0) {
+                continue;
+            }
+            std::size_t pos = line.find("avg10=");
+            if (pos == std::string::npos) {
+                break;
+            }
+            std::stringstream ss( line.substr(pos + 6) );
+            ss >> *someAvg10;
+            if ( !ss.fail() ) {
+                return true;
+            }
+        }
+    }
+#else
+    Q_UNUSED(someAvg10);
+#endif
+
+    return false;
+} // getMemoryPressure
+
 NATRON_NAMESPACE_EXIT;
@@ -68,6 +68,20 @@ std::size_t getCurrentRSS( );
 
 std::size_t getAmountFreePhysicalRAM();
 
+/**
+ * @brief Reads the memory limit of the control group (cgroup v2, or v1 memory controller) of this process
+ * and its current working set, i.e: the memory usage that the kernel cannot reclaim without swapping or killing.
+ * Returns false if the process is not in a memory limited control group or if it cannot be determined on this OS.
+ **/
+bool getCGroupMemoryInfo(U64* limitBytes, U64* workingSetBytes);
+
+/**
+ * @brief Returns in someAvg10 the share of time (in percent) over the last 10 seconds during which at least
+ * one task of the control group (or of the system) was stalled waiting for memory, as reported by the
+ * Linux pressure stall information. Returns false if not available.
+ **/
+bool getMemoryPressure(double* someAvg10);
+
 NATRON_NAMESPACE_EXIT;
 
 #endif // ifndef Engine_MemoryInfo_h
@@ -133,6 +133,29 @@ static PyObject* Sbk_AppFunc_addProjectLayer(PyObject* self, PyObject* pyArg)
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_beginChanges(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // beginChanges()
+            cppSelf->beginChanges();
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject* Sbk_AppFunc_closeProject(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -486,6 +509,29 @@ static PyObject* Sbk_AppFunc_createWriter(PyObject* self, PyObject* args, PyObje
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_endChanges(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // endChanges()
+            cppSelf->endChanges();
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject* Sbk_AppFunc_getAppID(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -1037,6 +1083,95 @@ static PyObject* Sbk_AppFunc_render(PyObject* self, PyObject* args, PyObject* kw
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_renderBatch(PyObject* self, PyObject* pyArg)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp;
+    SBK_UNUSED(pythonToCpp)
+
+    // Overloaded function decisor
+    // 0: renderBatch(std::list<Effect*>,std::list<int>,std::list<int>,std::list<int>)
+    if (PyList_Check(pyArg)) {
+        overloadId = 0; // renderBatch(std::list<Effect*>,std::list<int>,std::list<int>,std::list<int>)
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_AppFunc_renderBatch_TypeError;
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // renderBatch(std::list<Effect*>,std::list<int>,std::list<int>,std::list<int>)
+                // Begin code injection
+
+                if (!PyList_Check(pyArg)) {
+                    PyErr_SetString(PyExc_TypeError, "tasks must be a list of tuple objects.");
+                    return 0;
+                }
+                std::list<Effect*> effects;
+
+                std::list<int> firstFrames;
+
+                std::list<int> lastFrames;
+
+                std::list<int> frameSteps;
+
+                int size = (int)PyList_GET_SIZE(pyArg);
+                for (int i = 0; i < size; ++i) {
+                    PyObject* tuple = PyList_GET_ITEM(pyArg,i);
+                    if (!tuple) {
+                        PyErr_SetString(PyExc_TypeError, "tasks must be a list of tuple objects.");
+                        return 0;
+                    }
+
+                    int tupleSize = PyTuple_GET_SIZE(tuple);
+                    if (tupleSize != 4 && tupleSize != 3) {
+                        PyErr_SetString(PyExc_TypeError, "the tuple must have 3 or 4 items.");
+                        return 0;
+                    }
+                    ::Effect* writeNode = ((::Effect*)0);
+                    Shiboken::Conversions::pythonToCppPointer((SbkObjectType*)SbkNatronEngineTypes[SBK_EFFECT_IDX], PyTuple_GET_ITEM(tuple, 0), &(writeNode));
+                    int firstFrame;
+                    Shiboken::Conversions::pythonToCppCopy(Shiboken::Conversions::PrimitiveTypeConverter<int>(), PyTuple_GET_ITEM(tuple, 1), &(firstFrame));
+                    int lastFrame;
+                    Shiboken::Conversions::pythonToCppCopy(Shiboken::Conversions::PrimitiveTypeConverter<int>(), PyTuple_GET_ITEM(tuple, 2), &(lastFrame));
+                    int frameStep;
+                    if (tupleSize == 4) {
+                        Shiboken::Conversions::pythonToCppCopy(Shiboken::Conversions::PrimitiveTypeConverter<int>(), PyTuple_GET_ITEM(tuple, 3), &(frameStep));
+                    } else {
+                        frameStep = INT_MIN;
+                    }
+                    effects.push_back(writeNode);
+                    firstFrames.push_back(firstFrame);
+                    lastFrames.push_back(lastFrame);
+                    frameSteps.push_back(frameStep);
+                }
+
+                cppSelf->renderBatch(effects,firstFrames,lastFrames, frameSteps);
+
+                // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_AppFunc_renderBatch_TypeError:
+        const char* overloads[] = {"list", 0};
+        Shiboken::setErrorAboutWrongArguments(pyArg, "NatronEngine.App.renderBatch", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_AppFunc_resetProject(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -1363,10 +1498,12 @@ static PyObject* Sbk_AppFunc_writeToScriptEditor(PyObject* self, PyObject* pyArg
 static PyMethodDef Sbk_App_methods[] = {
     {"addFormat", (PyCFunction)Sbk_AppFunc_addFormat, METH_O},
     {"addProjectLayer", (PyCFunction)Sbk_AppFunc_addProjectLayer, METH_O},
+    {"beginChanges", (PyCFunction)Sbk_AppFunc_beginChanges, METH_NOARGS},
     {"closeProject", (PyCFunction)Sbk_AppFunc_closeProject, METH_NOARGS},
     {"createNode", (PyCFunction)Sbk_AppFunc_createNode, METH_VARARGS|METH_KEYWORDS},
     {"createReader", (PyCFunction)Sbk_AppFunc_createReader, METH_VARARGS|METH_KEYWORDS},
     {"createWriter", (PyCFunction)Sbk_AppFunc_createWriter, METH_VARARGS|METH_KEYWORDS},
+    {"endChanges", (PyCFunction)Sbk_AppFunc_endChanges, METH_NOARGS},
     {"getAppID", (PyCFunction)Sbk_AppFunc_getAppID, METH_NOARGS},
     {"getProjectParam", (PyCFunction)Sbk_AppFunc_getProjectParam, METH_O},
     {"getViewIndex", (PyCFunction)Sbk_AppFunc_getViewIndex, METH_O},
@@ -1377,6 +1514,7 @@ static PyMethodDef Sbk_App_methods[] = {
     {"redrawViewer", (PyCFunction)Sbk_AppFunc_redrawViewer, METH_O},
     {"refreshViewer", (PyCFunction)Sbk_AppFunc_refreshViewer, METH_VARARGS|METH_KEYWORDS},
     {"render", (PyCFunction)Sbk_AppFunc_render, METH_VARARGS|METH_KEYWORDS},
+    {"renderBatch", (PyCFunction)Sbk_AppFunc_renderBatch, METH_O},
     {"resetProject", (PyCFunction)Sbk_AppFunc_resetProject, METH_NOARGS},
     {"saveProject", (PyCFunction)Sbk_AppFunc_saveProject, METH_O},
     {"saveProjectAs", (PyCFunction)Sbk_AppFunc_saveProjectAs, METH_O},
@@ -2060,18 +2060,37 @@ Node::getPosition(double *x,
 void
 Node::onNodeUIPositionChanged(double x, double y)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodePositionCoords[0] = x;
-    _imp->nodePositionCoords[1] = y;
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodePositionCoords[0] = x;
+        _imp->nodePositionCoords[1] = y;
+    }
+    markDirtyForAutoSave();
 }
 
 void
 Node::onNodeUISizeChanged(double w,
               double h)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodeSize[0] = w;
-    _imp->nodeSize[1] = h;
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodeSize[0] = w;
+        _imp->nodeSize[1] = h;
+    }
+    markDirtyForAutoSave();
+}
+
+void
+Node::markDirtyForAutoSave()
+{
+    AppInstancePtr app = getApp();
+    if (!app) {
+        return;
+    }
+    ProjectPtr project = app->getProject();
+    if (project) {
+        project->setNodeDirtyForAutoSave( shared_from_this() );
+    }
 }
 
 
@@ -2174,11 +2193,13 @@ Node::onNodeUIColorChanged(double r,
                            double g,
                            double b)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodeColor[0] = r;
-    _imp->nodeColor[1] = g;
-    _imp->nodeColor[2] = b;
-
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodeColor[0] = r;
+        _imp->nodeColor[1] = g;
+        _imp->nodeColor[2] = b;
+    }
+    markDirtyForAutoSave();
 }
 
 
@@ -750,6 +750,11 @@ public:
     void onNodeUISelectionChanged(bool isSelected);
     bool getNodeIsSelected() const;
 
+    /**
+     * @brief Marks this node as changed since the last auto-save, see Project::setNodeDirtyForAutoSave()
+     **/
+    void markDirtyForAutoSave();
+
 
     std::string getKnobChangedCallback() const;
     std::string getInputChangedCallback() const;
@@ -909,9 +914,17 @@ public:
      *
      * The width and height might be modified by the function, so their value can
      * be queried at the end of the function
+     *
+     * The preview is rendered at the mipmap level returned by getPreviewMipMapLevel().
      **/
     bool makePreviewImage(TimeValue time, int *width, int *height, unsigned int* buf);
 
+    /**
+     * @brief Returns the mipmap level at which the preview of this node should be rendered so that
+     * its region of definition fits in width x height, or -1 if the preview cannot be computed.
+     **/
+    int getPreviewMipMapLevel(TimeValue time, int width, int height);
+
     /**
      * @brief Returns true if the node is currently rendering a preview image.
      **/
@@ -1180,6 +1193,18 @@ public:
 
     std::string getContainerGroupFullyQualifiedName() const;
 
+    /**
+     * @brief Returns the key identifying this node in the cache reuse statistics (@see CacheReuseStats::getNodeKey).
+     * It is computed once and computed again only after the node, a group containing it or the project was renamed.
+     **/
+    U64 getCacheReuseKey();
+
+    /**
+     * @brief Called when the fully qualified name of the node or the project file changed, so that
+     * getCacheReuseKey() computes the key again. If this node is a group, the nodes it contains are invalidated as well.
+     **/
+    void invalidateCacheReuseKey();
+
     void setLabel(const std::string& label);
 
     const std::string& getLabel() const;
@@ -29,12 +29,20 @@
 #include <cfloat>
 #include <algorithm> // min, max
 #include <cassert>
+#include <cctype>
+#include <cstdlib>
 #include <stdexcept>
 #include <sstream> // stringstream
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QTextStream>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <boost/unordered_map.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
+
 #include "Engine/AppInstance.h"
 #include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
@@ -69,6 +77,15 @@ struct NodeCollectionPrivate
     mutable QMutex nodesMutex;
     NodesList nodes;
 
+    // The nodes indexed by script-name, kept in sync with nodes and Node::setNameInternal
+    typedef boost::unordered_multimap<std::string, NodePtr> NodesNameIndex;
+    NodesNameIndex nodesByName;
+
+    // For each base name, the first digit checkNodeName tries: all the names from base1 to base(n-1) are taken.
+    // This avoids probing all the existing names each time a node is created.
+    typedef boost::unordered_map<std::string, int> NameSuffixMap;
+    NameSuffixMap nextNameSuffix;
+
     mutable QMutex graphEditedMutex;
 
     // If false the user cannot ever edit this graph from the UI, except if from Python the setSubGraphEditable function is called
@@ -83,6 +100,8 @@ struct NodeCollectionPrivate
         , graph(0)
         , nodesMutex()
         , nodes()
+        , nodesByName()
+        , nextNameSuffix()
         , graphEditedMutex()
         , isEditable(true)
         , wasGroupEditedByUser(false)
@@ -90,8 +109,106 @@ struct NodeCollectionPrivate
     }
 
     NodePtr findNodeInternal(const std::string& name, const std::string& recurseName) const;
+
+    // The following must be called with nodesMutex locked
+
+    NodePtr findNodeByName(const std::string& name, const NodeConstPtr& caller) const;
+
+    void indexNode(const NodePtr& node, const std::string& name);
+
+    void unindexNode(const Node* node, const std::string& name);
+
+    void onNameFreed(const std::string& name);
 };
 
+NodePtr
+NodeCollectionPrivate::findNodeByName(const std::string& name,
+                                      const NodeConstPtr& caller) const
+{
+    std::pair<NodesNameIndex::const_iterator, NodesNameIndex::const_iterator> range = nodesByName.equal_range(name);
+    NodePtr found;
+
+    for (NodesNameIndex::const_iterator it = range.first; it != range.second; ++it) {
+        if (it->second == caller) {
+            continue;
+        }
+        if (found) {
+            // Several nodes have this name: return the first one in the nodes order
+            for (NodesList::const_iterator it2 = nodes.begin(); it2 != nodes.end(); ++it2) {
+                if ( (*it2 != caller) && ( (*it2)->getScriptName_mt_safe() == name ) ) {
+                    return *it2;
+                }
+            }
+            break;
+        }
+        found = it->second;
+    }
+
+    return found;
+}
+
+void
+NodeCollectionPrivate::indexNode(const NodePtr& node,
+                                 const std::string& name)
+{
+    nodesByName.insert( std::make_pair(name, node) );
+}
+
+void
+NodeCollectionPrivate::unindexNode(const Node* node,
+                                   const std::string& name)
+{
+    std::pair<NodesNameIndex::iterator, NodesNameIndex::iterator> range = nodesByName.equal_range(name);
+
+    for (NodesNameIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second.get() == node) {
+            nodesByName.erase(it);
+            onNameFreed(name);
+
+            return;
+        }
+    }
+
+    // The name of the node changed but the collection was not notified yet
+    for (NodesNameIndex::iterator it = nodesByName.begin(); it != nodesByName.end(); ++it) {
+        if (it->second.get() == node) {
+            std::string indexedName = it->first;
+            nodesByName.erase(it);
+            onNameFreed(indexedName);
+
+            return;
+        }
+    }
+}
+
+void
+NodeCollectionPrivate::onNameFreed(const std::string& name)
+{
+    if ( nextNameSuffix.empty() ) {
+        return;
+    }
+    // The name may be a base name followed by a suffix given by checkNodeName: the suffix is free again.
+    // Try all the possible splits, e.g: Blur12 may be Blur + 12 or Blur1 + 2
+    std::size_t nDigits = 0;
+    while ( nDigits < name.size() && nDigits < 9 && std::isdigit( (unsigned char)name[name.size() - 1 - nDigits] ) ) {
+        ++nDigits;
+    }
+    for (std::size_t i = 1; i <= nDigits; ++i) {
+        std::size_t suffixStart = name.size() - i;
+        if ( (suffixStart == 0) || (name[suffixStart] == '0') ) {
+            continue;
+        }
+        NameSuffixMap::iterator found = nextNameSuffix.find( name.substr(0, suffixStart) );
+        if ( found == nextNameSuffix.end() ) {
+            continue;
+        }
+        int suffix = std::atoi( name.c_str() + suffixStart );
+        if (suffix < found->second) {
+            found->second = suffix;
+        }
+    }
+}
+
 NodeCollection::NodeCollection(const AppInstancePtr& app)
     : _imp( new NodeCollectionPrivate(app) )
 {
@@ -158,13 +275,28 @@ NodeCollection::getNodes_recursive(NodesList& nodes,
     }
 }
 
+void
+NodeCollection::markGraphStructureDirtyForAutoSave()
+{
+    AppInstancePtr app = getApplication();
+    if (!app) {
+        return;
+    }
+    ProjectPtr project = app->getProject();
+    if (project) {
+        project->setGraphStructureDirtyForAutoSave();
+    }
+}
+
 void
 NodeCollection::addNode(const NodePtr& node)
 {
     {
         QMutexLocker k(&_imp->nodesMutex);
         _imp->nodes.push_back(node);
+        _imp->indexNode( node, node->getScriptName_mt_safe() );
     }
+    markGraphStructureDirtyForAutoSave();
 }
 
 
@@ -179,9 +311,12 @@ NodeCollection::removeNode(const Node* node)
     for (NodesList::iterator it =_imp->nodes.begin(); it != _imp->nodes.end();++it) {
         if ( it->get() == node ) {
             _imp->nodes.erase(it);
+            _imp->unindexNode( node, node->getScriptName_mt_safe() );
             break;
         }
     }
+    k.unlock();
+    markGraphStructureDirtyForAutoSave();
     onNodeRemoved(node);
 }
 
@@ -454,6 +589,8 @@ NodeCollection::clearNodesInternal(bool blocking)
     {
         QMutexLocker l(&_imp->nodesMutex);
         _imp->nodes.clear();
+        _imp->nodesByName.clear();
+        _imp->nextNameSuffix.clear();
     }
 
     nodesToDelete.clear();
@@ -496,17 +633,24 @@ NodeCollection::checkNodeName(const NodeConstPtr& node,
     ///the python attribute will be overwritten. Try to prevent this situation.
     NodeGroup* isGroup = dynamic_cast<NodeGroup*>(this);
     if (isGroup) {
-        const KnobsVec&  knobs = isGroup->getKnobs();
-        for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
-            if ( (*it)->getName() == cpy ) {
-                throw std::runtime_error( tr("A node within a group cannot have the same script-name (%1) as a parameter on the group for scripting purposes.").arg( QString::fromUtf8( cpy.c_str() ) ).toStdString() );
+        if ( isGroup->getKnobByName(cpy) ) {
+            throw std::runtime_error( tr("A node within a group cannot have the same script-name (%1) as a parameter on the group for scripting purposes.").arg( QString::fromUtf8( cpy.c_str() ) ).toStdString() );
 
-                return;
-            }
+            return;
         }
     }
-    bool foundNodeWithName = false;
+
+    QMutexLocker l(&_imp->nodesMutex);
+
+    // When naming a new node, start at the first digit that may be free instead of probing all the existing names
+    const bool useNameSuffix = appendDigit && !errorIfExists && !node;
     int no = 1;
+    if (useNameSuffix) {
+        NodeCollectionPrivate::NameSuffixMap::const_iterator foundSuffix = _imp->nextNameSuffix.find(cpy);
+        if ( foundSuffix != _imp->nextNameSuffix.end() ) {
+            no = foundSuffix->second;
+        }
+    }
 
     {
         std::stringstream ss;
@@ -516,29 +660,24 @@ NodeCollection::checkNodeName(const NodeConstPtr& node,
         }
         *nodeName = ss.str();
     }
-    do {
-        foundNodeWithName = false;
-        QMutexLocker l(&_imp->nodesMutex);
-        for (NodesList::iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
-            if ( (*it != node) && ( (*it)->getScriptName_mt_safe() == *nodeName ) ) {
-                foundNodeWithName = true;
-                break;
-            }
-        }
-        if (foundNodeWithName) {
-            if (errorIfExists || !appendDigit) {
-                throw std::runtime_error( tr("A node with the script-name %1 already exists.").arg( QString::fromUtf8( nodeName->c_str() ) ).toStdString() );
+    while ( _imp->findNodeByName(*nodeName, node) ) {
+        if (errorIfExists || !appendDigit) {
+            throw std::runtime_error( tr("A node with the script-name %1 already exists.").arg( QString::fromUtf8( nodeName->c_str() ) ).toStdString() );
 
-                return;
-            }
-            ++no;
-            {
-                std::stringstream ss;
-                ss << cpy << no;
-                *nodeName = ss.str();
-            }
+            return;
         }
-    } while (foundNodeWithName);
+        ++no;
+        {
+            std::stringstream ss;
+            ss << cpy << no;
+            *nodeName = ss.str();
+        }
+    }
+
+    if (useNameSuffix) {
+        // All the names before this one are taken. This one is not taken yet: the node may not use it.
+        _imp->nextNameSuffix[cpy] = no;
+    }
 } // NodeCollection::checkNodeName
 
 void
@@ -767,19 +906,18 @@ NodePtr
 NodeCollectionPrivate::findNodeInternal(const std::string& name,
                                         const std::string& recurseName) const
 {
-    QMutexLocker k(&nodesMutex);
+    NodePtr found;
+    {
+        QMutexLocker k(&nodesMutex);
+        found = findNodeByName( name, NodeConstPtr() );
+    }
 
-    for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
-        if ( (*it)->getScriptName_mt_safe() == name ) {
-            if ( !recurseName.empty() ) {
-                NodeGroupPtr isGrp = (*it)->isEffectNodeGroup();
-                if (isGrp) {
-                    return isGrp->getNodeByFullySpecifiedName(recurseName);
-                }
-            } else {
-                return *it;
-            }
-        }
+    if ( !found || recurseName.empty() ) {
+        return found;
+    }
+    NodeGroupPtr isGrp = found->isEffectNodeGroup();
+    if (isGrp) {
+        return isGrp->getNodeByFullySpecifiedName(recurseName);
     }
 
     return NodePtr();
@@ -941,13 +1079,34 @@ NodeCollection::checkIfNodeNameExists(const std::string & n,
 {
     QMutexLocker k(&_imp->nodesMutex);
 
-    for (NodesList::const_iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
-        if ( (*it != caller) && ( (*it)->getScriptName_mt_safe() == n ) ) {
-            return true;
-        }
+    return _imp->findNodeByName(n, caller).get() != 0;
+}
+
+void
+NodeCollection::onNodeScriptNameChanged(const Node* node,
+                                        const std::string& oldName,
+                                        const std::string& newName)
+{
+    if (oldName == newName) {
+        return;
     }
 
-    return false;
+    // The auto-save journal identifies nodes by their script-name
+    markGraphStructureDirtyForAutoSave();
+
+    QMutexLocker k(&_imp->nodesMutex);
+    std::pair<NodeCollectionPrivate::NodesNameIndex::iterator, NodeCollectionPrivate::NodesNameIndex::iterator> range = _imp->nodesByName.equal_range(oldName);
+
+    for (NodeCollectionPrivate::NodesNameIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second.get() == node) {
+            NodePtr sharedNode = it->second;
+            _imp->nodesByName.erase(it);
+            _imp->onNameFreed(oldName);
+            _imp->indexNode(sharedNode, newName);
+
+            return;
+        }
+    }
 }
 
 void
@@ -165,6 +165,11 @@ public:
      **/
     bool checkIfNodeNameExists(const std::string & n, const NodeConstPtr& caller) const;
 
+    /**
+     * @brief Called by the node after its script-name changed to keep the index of nodes by name up to date. MT-safe.
+     **/
+    void onNodeScriptNameChanged(const Node* node, const std::string& oldName, const std::string& newName);
+
     /**
      * @brief Returns true if a node has the give label n in the group. This is not called recursively on subgroups.
      **/
@@ -296,6 +301,8 @@ protected:
 private:
     void quitAnyProcessingInternal(bool blocking);
 
+    void markGraphStructureDirtyForAutoSave();
+
     void recomputeFrameRangeForAllReadersInternal(int* firstFrame,
                                                   int* lastFrame,
                                                   bool setFrameRange);
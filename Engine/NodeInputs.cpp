@@ -774,6 +774,8 @@ Node::replaceInputInternal(const NodePtr& input, int inputNumber, bool failIfExi
         return true;
     }
 
+    getApp()->getProject()->setGraphStructureDirtyForAutoSave();
+
     // Make the application recheck expressions, they may now be valid again.
     getApp()->recheckInvalidExpressions();
 
@@ -1280,18 +1282,22 @@ Node::endInputEdition(bool triggerRender)
         bool hasChanged = !_imp->inputsModified.empty();
         _imp->inputsModified.clear();
 
+        triggerRender = triggerRender && hasChanged;
+
+        // Within a knob changes transaction, the meta-datas are refreshed and the viewers rendered when it ends
+        bool deferred = hasChanged && getApp()->deferEvaluationToKnobChangesTransaction(shared_from_this(), triggerRender, true);
+
         if (hasChanged) {
 
             // Force a refresh of the meta-datas
-
-            _imp->effect->onMetadataChanged_recursive_public();
+            if (!deferred) {
+                _imp->effect->onMetadataChanged_recursive_public();
+            }
 
             refreshDynamicProperties();
         }
 
-        triggerRender = triggerRender && hasChanged;
-
-        if (triggerRender) {
+        if (triggerRender && !deferred) {
             getApp()->renderAllViewers();
         }
     }
@@ -1516,6 +1516,9 @@ Node::deactivate(const std::list< NodePtr > & outputsToDisconnect,
     //first tell the gui to clear any persistent message linked to this node
     clearPersistentMessage(false);
 
+    // Deactivated nodes are not saved
+    getApp()->getProject()->setGraphStructureDirtyForAutoSave();
+
 
 
     bool beingDestroyed;
@@ -1730,6 +1733,7 @@ Node::activate(const std::list< NodePtr > & outputsToRestore,
         return;
     }
 
+    getApp()->getProject()->setGraphStructureDirtyForAutoSave();
 
     ///No need to lock, inputs is only written to by the main-thread
     NodePtr thisShared = shared_from_this();
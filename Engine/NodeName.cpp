@@ -24,6 +24,8 @@
 
 #include "NodePrivate.h"
 
+#include "Engine/CacheReuseStats.h"
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -181,6 +183,7 @@ Node::setLabel(const std::string& label)
     if (collection) {
         collection->notifyNodeLabelChanged( shared_from_this() );
     }
+    markDirtyForAutoSave();
     Q_EMIT labelChanged(curLabel, newLabel );
 }
 
@@ -317,6 +320,10 @@ Node::setNameInternal(const std::string& name,
             labelSet = true;
         }
     }
+    if (collection) {
+        collection->onNodeScriptNameChanged(this, oldName, newName);
+    }
+    invalidateCacheReuseKey();
     std::string fullySpecifiedName = getFullyQualifiedName();
 
     if (collection) {
@@ -354,6 +361,50 @@ Node::setNameInternal(const std::string& name,
     }
 } // Node::setNameInternal
 
+U64
+Node::getCacheReuseKey()
+{
+    int age;
+    {
+        QMutexLocker l(&_imp->nameMutex);
+        if (_imp->cacheReuseKeyValid) {
+            return _imp->cacheReuseKey;
+        }
+        age = _imp->cacheReuseKeyAge;
+    }
+
+    // Computed outside of the lock since it takes the name mutex of this node and of the containing groups
+    U64 key = CacheReuseStats::getNodeKey( shared_from_this() );
+    {
+        QMutexLocker l(&_imp->nameMutex);
+        if (age == _imp->cacheReuseKeyAge) {
+            _imp->cacheReuseKey = key;
+            _imp->cacheReuseKeyValid = true;
+        }
+    }
+
+    return key;
+} // getCacheReuseKey
+
+void
+Node::invalidateCacheReuseKey()
+{
+    {
+        QMutexLocker l(&_imp->nameMutex);
+        _imp->cacheReuseKeyValid = false;
+        ++_imp->cacheReuseKeyAge;
+    }
+
+    // The fully qualified name of the nodes in a group contains the name of the group
+    NodeGroupPtr isGroup = isEffectNodeGroup();
+    if (isGroup) {
+        NodesList nodes = isGroup->getNodes();
+        for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+            (*it)->invalidateCacheReuseKey();
+        }
+    }
+} // invalidateCacheReuseKey
+
 
 void
 Node::setScriptName(const std::string& name)
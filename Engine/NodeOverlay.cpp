@@ -493,11 +493,13 @@ Node::onNodeUIOverlayColorChanged(double r,
                                   double g,
                                   double b)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->overlayColor[0] = r;
-    _imp->overlayColor[1] = g;
-    _imp->overlayColor[2] = b;
-
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->overlayColor[0] = r;
+        _imp->overlayColor[1] = g;
+        _imp->overlayColor[2] = b;
+    }
+    markDirtyForAutoSave();
 }
 
 void
@@ -61,6 +61,9 @@ NodePrivate::NodePrivate(Node* publicInterface,
 , nameMutex()
 , scriptName()
 , label()
+, cacheReuseKey(0)
+, cacheReuseKeyValid(false)
+, cacheReuseKeyAge(0)
 , inputsLabelsMutex()
 , inputLabels()
 , deactivatedState()
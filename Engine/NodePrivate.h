@@ -229,6 +229,12 @@ public:
     // Node label as visible in the GUI. Can be set to any-thing.
     std::string label;
 
+    // The key of the node in the cache reuse statistics, also protected by nameMutex.
+    // cacheReuseKeyAge is incremented on each invalidation so that a key computed meanwhile is not stored.
+    U64 cacheReuseKey;
+    bool cacheReuseKeyValid;
+    int cacheReuseKeyAge;
+
     // Protects inputLabels, inputHints
     mutable QMutex inputsLabelsMutex;
 
@@ -28,6 +28,9 @@
 #include "Engine/Lut.h"
 #include "Engine/TreeRender.h"
 
+// Previews are tiny, never render them at a scale finer than 1/32 of the node's RoD
+#define NATRON_PREVIEW_MAX_MIPMAP_LEVEL 5
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -194,8 +197,10 @@ static void renderPreviewInternal(const void* srcPtrs[4],
             renderPreviewForDepth<unsigned short, 65535>(srcPtrs, srcBounds, srcNComps, width, height, convertToSrgb, buf);
             break;
         }
-        case eImageBitDepthHalf:
+        case eImageBitDepthHalf: {
+            renderPreviewForDepth<Half, 1>(srcPtrs, srcBounds, srcNComps, width, height, convertToSrgb, buf);
             break;
+        }
         case eImageBitDepthFloat: {
             renderPreviewForDepth<float, 1>(srcPtrs, srcBounds, srcNComps , width, height, convertToSrgb, buf);
             break;
@@ -211,6 +216,53 @@ NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 
 
+int
+Node::getPreviewMipMapLevel(TimeValue time,
+                            int width,
+                            int height)
+{
+    EffectInstancePtr effect;
+    NodeGroupPtr isGroup = isEffectNodeGroup();
+    if (isGroup) {
+        NodePtr outputNode = isGroup->getOutputNodeInput();
+        if (outputNode) {
+            return outputNode->getPreviewMipMapLevel(time, width, height);
+        }
+        return -1;
+    } else {
+        effect = _imp->effect;
+    }
+
+    if (!effect) {
+        return -1;
+    }
+
+    RectD rod;
+
+    {
+        RenderScale scale(1.);
+
+        GetRegionOfDefinitionResultsPtr actionResults;
+        ActionRetCodeEnum stat = effect->getRegionOfDefinition_public(time, scale, ViewIdx(0), TreeRenderNodeArgsPtr(), &actionResults);
+        if (isFailureRetCode(stat)) {
+            return -1;
+        }
+        rod = actionResults->getRoD();
+    }
+    if (rod.isNull()) {
+        return -1;
+    }
+
+    // Compute the mipmap level to pass to render
+    double yZoomFactor = (double)height / (double)rod.height();
+    double xZoomFactor = (double)width / (double)rod.width();
+    double closestPowerOf2X = xZoomFactor >= 1 ? 1 : std::pow( 2, -std::ceil( std::log(xZoomFactor) / std::log(2.) ) );
+    double closestPowerOf2Y = yZoomFactor >= 1 ? 1 : std::pow( 2, -std::ceil( std::log(yZoomFactor) / std::log(2.) ) );
+    int closestPowerOf2 = std::max(closestPowerOf2X, closestPowerOf2Y);
+
+    return (int)std::min(std::log( (double)closestPowerOf2 ) / std::log(2.), (double)NATRON_PREVIEW_MAX_MIPMAP_LEVEL);
+} // getPreviewMipMapLevel
+
 bool
 Node::makePreviewImage(TimeValue time,
                        int *width,
@@ -237,7 +289,6 @@ Node::makePreviewImage(TimeValue time,
     /// prevent 2 previews to occur at the same time since there's only 1 preview instance
     ComputingPreviewSetter_RAII computingPreviewRAII( _imp.get() );
 
-    EffectInstancePtr effect;
     NodeGroupPtr isGroup = isEffectNodeGroup();
     if (isGroup) {
         NodePtr outputNode = isGroup->getOutputNodeInput();
@@ -245,40 +296,19 @@ Node::makePreviewImage(TimeValue time,
             return outputNode->makePreviewImage(time, width, height, buf);
         }
         return false;
-    } else {
-        effect = _imp->effect;
     }
 
-    if (!effect) {
+    if (!_imp->effect) {
         return false;
     }
 
-
-    RectD rod;
-
-    {
-        RenderScale scale(1.);
-
-        GetRegionOfDefinitionResultsPtr actionResults;
-        ActionRetCodeEnum stat = effect->getRegionOfDefinition_public(time, scale, ViewIdx(0), TreeRenderNodeArgsPtr(), &actionResults);
-        if (isFailureRetCode(stat)) {
-            return false;
-        }
-        rod = actionResults->getRoD();
-    }
-    if (rod.isNull()) {
+    // Each node computes its own level from its region of definition: upstream nodes of a branch whose
+    // region of definition is the same as the root's get the same level and find their images in the cache.
+    int mipMapLevel = getPreviewMipMapLevel(time, *width, *height);
+    if (mipMapLevel < 0) {
         return false;
     }
 
-    // Compute the mipmap level to pass to render
-    double yZoomFactor = (double)*height / (double)rod.height();
-    double xZoomFactor = (double)*width / (double)rod.width();
-    double closestPowerOf2X = xZoomFactor >= 1 ? 1 : std::pow( 2, -std::ceil( std::log(xZoomFactor) / std::log(2.) ) );
-    double closestPowerOf2Y = yZoomFactor >= 1 ? 1 : std::pow( 2, -std::ceil( std::log(yZoomFactor) / std::log(2.) ) );
-    int closestPowerOf2 = std::max(closestPowerOf2X, closestPowerOf2Y);
-
-    unsigned int mipMapLevel = std::min(std::log( (double)closestPowerOf2 ) / std::log(2.), 5.);
-
     TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
     {
         args->treeRoot = shared_from_this();
@@ -287,7 +317,7 @@ Node::makePreviewImage(TimeValue time,
 
         // Render all layers produced
         args->layers = 0;
-        args->mipMapLevel = mipMapLevel;
+        args->mipMapLevel = (unsigned int)mipMapLevel;
 
         args->proxyScale = RenderScale(1.);
 
@@ -296,6 +326,9 @@ Node::makePreviewImage(TimeValue time,
         args->draftMode = false;
         args->playback = false;
         args->byPassCache = false;
+        args->streaming = false;
+        args->priorityPoint = 0;
+        args->lowPriority = false;
     }
 
     std::map<ImagePlaneDesc, ImagePtr> planes;
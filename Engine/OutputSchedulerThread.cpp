@@ -59,16 +59,20 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/Cache.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
 #include "Engine/KnobFile.h"
 #include "Engine/Node.h"
 #include "Engine/KnobItemsTable.h"
+#include "Engine/MemoryGovernor.h"
 #include "Engine/OpenGLViewerI.h"
 #include "Engine/FStreamsSupport.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
 #include "Engine/Project.h"
+#include "Engine/RenderBatch.h"
 #include "Engine/RenderStats.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
 #include "Engine/TimeLine.h"
@@ -360,6 +364,40 @@ struct OutputSchedulerThreadPrivate
         QMutexLocker l(&renderThreadsMutex);
         waitForRenderThreadsToQuitInternal();
     }
+
+    /**
+     * @brief Blocks the scheduler while the memory governor refuses new renders, until a render thread finishes.
+     * If no render thread is running, nothing would free memory so the render is admitted anyway.
+     **/
+    void waitForMemoryToAdmitRender()
+    {
+        MemoryGovernor* governor = appPTR->getMemoryGovernor();
+        if (!governor) {
+            return;
+        }
+        QMutexLocker l(&renderThreadsMutex);
+        while ( !governor->canAdmitRender() && !renderThreads.empty() && !_publicInterface->isBeingAborted() && !_publicInterface->mustQuitThread() ) {
+            allRenderThreadsInactiveCond.wait(&renderThreadsMutex, 200);
+        }
+    }
+
+    /**
+     * @brief If the engine renders as part of a batch, blocks until the other renders of the batch
+     * caught up with the given frame, then notifies them that we started it.
+     **/
+    void waitForRenderBatch(TimeValue frame)
+    {
+        RenderBatchPtr batch = engine->getRenderBatch();
+        if (!batch) {
+            return;
+        }
+        while ( !batch->waitForFrameCanStart(engine, frame, 200) ) {
+            if ( _publicInterface->isBeingAborted() || _publicInterface->mustQuitThread() ) {
+                return;
+            }
+        }
+        batch->notifyFrameStarted(engine, frame);
+    }
 };
 
 OutputSchedulerThread::OutputSchedulerThread(RenderEngine* engine,
@@ -526,7 +564,6 @@ OutputSchedulerThread::startTasksFromLastStartedFrame()
     }
 
     if (canContinue) {
-        QMutexLocker l(&_imp->renderThreadsMutex);
         startTasks(frame);
     }
 } // startTasksFromLastStartedFrame
@@ -541,6 +578,7 @@ OutputSchedulerThread::startTasks(TimeValue startingFrame)
 
     PlaybackModeEnum pMode = _imp->engine->getPlaybackMode();
     if (args->firstFrame == args->lastFrame) {
+        _imp->waitForMemoryToAdmitRender();
         RenderThreadTask* task = createRunnable(startingFrame, args->enableRenderStats, args->viewsToRender);
         {
             QMutexLocker k(&_imp->renderThreadsMutex);
@@ -558,6 +596,12 @@ OutputSchedulerThread::startTasks(TimeValue startingFrame)
 
         for (int i = 0; i < nConcurrentFrames; ++i) {
 
+            // Do not grow the working set when close to the memory limit
+            _imp->waitForMemoryToAdmitRender();
+
+            // Do not get ahead of the other outputs rendered with the same batch
+            _imp->waitForRenderBatch(frame);
+
             RenderThreadTask* task = createRunnable(frame, args->enableRenderStats, args->viewsToRender);
             {
                 QMutexLocker k(&_imp->renderThreadsMutex);
@@ -716,6 +760,9 @@ OutputSchedulerThread::stopRender()
     bool wasAborted = isBeingAborted();
 
 
+    // Write the trace of the whole job, if enabled
+    RenderTrace::onRenderJobFinished();
+
     ///Notify everyone that the render is finished
     _imp->engine->s_renderFinished(wasAborted ? 1 : 0);
 
@@ -1744,6 +1791,11 @@ protected:
         args->draftMode = false;
         args->playback = true;
         args->byPassCache = false;
+        args->priorityPoint = 0;
+        args->lowPriority = false;
+
+        // A sequence render is feed-forward: render the image in input of the writer in bands without caching intermediate images
+        args->streaming = appPTR->getCurrentSettings()->isStreamingRenderOnDiskEnabled();
 
         ActionRetCodeEnum retCode = eActionStatusFailed;
         TreeRenderPtr render = TreeRender::create(args);
@@ -1802,6 +1854,8 @@ private:
         
         _imp->scheduler->notifyFrameRendered(frameContainer, eSchedulingPolicyFFA);
 
+        RenderTrace::onFrameRendered(time);
+
 
         // If policy is FFA run the callback on this thread, otherwise wait that it gets processed on the scheduler thread.
         if (getScheduler()->getSchedulingPolicy() == eSchedulingPolicyFFA) {
@@ -2122,6 +2176,13 @@ struct RenderViewerProcessFunctorArgs
     bool isDraftModeEnabled;
     bool isPlayback;
     bool byPassCache;
+
+    // If hasPriorityPoint, tiles closest to this point (in canonical coordinates) are rendered first
+    Point priorityPoint;
+    bool hasPriorityPoint;
+
+    // True for the frames rendered ahead when the viewer is idle, see TreeRender::CtorArgs::lowPriority
+    bool lowPriority;
 };
 
 typedef boost::shared_ptr<RenderViewerProcessFunctorArgs> RenderViewerProcessFunctorArgsPtr;
@@ -2175,6 +2236,9 @@ public:
         args->draftMode = inArgs->isDraftModeEnabled;
         args->playback = inArgs->isPlayback;
         args->byPassCache = inArgs->byPassCache;
+        args->streaming = false;
+        args->priorityPoint = inArgs->hasPriorityPoint ? &inArgs->priorityPoint : 0;
+        args->lowPriority = inArgs->lowPriority;
 
         inArgs->retCode = eActionStatusFailed;
         inArgs->renderObject = TreeRender::create(args);
@@ -2280,6 +2344,7 @@ public:
                                                      TimeValue time,
                                                      ViewIdx view,
                                                      bool isPlayback,
+                                                     bool isPreview,
                                                      const RenderStatsPtr& stats,
                                                      const RectD* roiParam,
                                                      ViewerRenderBufferedFrame* bufferedFrame,
@@ -2289,7 +2354,14 @@ public:
         bool fullFrameProcessing = viewer->isFullFrameProcessingEnabled();
         bool draftModeEnabled = viewer->getApp()->isDraftRenderEnabled();
         unsigned int mipMapLevel = getViewerMipMapLevel(viewer, draftModeEnabled, fullFrameProcessing);
-        bool byPassCache = viewer->isRenderWithoutCacheEnabledAndTurnOff();
+
+        // A preview is rendered at a lower resolution, using the auto-proxy level of the preferences
+        if (isPreview) {
+            mipMapLevel += appPTR->getCurrentSettings()->getAutoProxyMipMapLevel();
+        }
+
+        // Leave the cache by-pass request to the full resolution render, since querying it turns it off
+        bool byPassCache = isPreview ? false : viewer->isRenderWithoutCacheEnabledAndTurnOff();
 
         RectD roi;
         if (roiParam) {
@@ -2307,6 +2379,15 @@ public:
         (outArgs)->time = time;
         (outArgs)->view = view;
         (outArgs)->viewerProcessNode = viewer->getViewerProcessNode(viewerProcess_i)->getNode();
+
+        // When the user is waiting for the frame, render first the tiles around the point the viewer is
+        // going to be centered on, or otherwise the center of the viewport.
+        (outArgs)->hasPriorityPoint = !isPlayback && !roi.isNull();
+        if ( (outArgs)->hasPriorityPoint && !viewer->getViewerCenterPoint(&(outArgs)->priorityPoint) ) {
+            (outArgs)->priorityPoint.x = (roi.x1 + roi.x2) / 2.;
+            (outArgs)->priorityPoint.y = (roi.y1 + roi.y2) / 2.;
+        }
+        (outArgs)->lowPriority = false;
         createRenderViewerObject(outArgs);
         bufferedFrame->canonicalRoi[viewerProcess_i] = roi;
 
@@ -2317,7 +2398,7 @@ private:
     void createAndLaunchRenderInThread(const RenderViewerProcessFunctorArgsPtr& processArgs, int viewerProcess_i, TimeValue time, const RenderStatsPtr& stats, ViewerRenderBufferedFrame* bufferedFrame)
     {
 
-        createRenderViewerProcessArgs(_viewer, viewerProcess_i, time, bufferedFrame->view, true /*isPlayback*/, stats, 0 /*roiParam*/,  bufferedFrame, processArgs.get());
+        createRenderViewerProcessArgs(_viewer, viewerProcess_i, time, bufferedFrame->view, true /*isPlayback*/, false /*isPreview*/, stats, 0 /*roiParam*/,  bufferedFrame, processArgs.get());
 
         // Register the render so that it can be aborted in abortRenders()
         {
@@ -2506,6 +2587,10 @@ struct RenderEnginePrivate
     PlaybackModeEnum pbMode;
     ViewerCurrentFrameRequestScheduler* currentFrameScheduler;
 
+    // The batch of renders this engine belongs to, if any
+    mutable QMutex renderBatchMutex;
+    RenderBatchPtr renderBatch;
+
     // Only used on the main-thread
     boost::scoped_ptr<RenderEngineWatcher> engineWatcher;
     struct RefreshRequest
@@ -2530,6 +2615,8 @@ struct RenderEnginePrivate
         , pbModeMutex()
         , pbMode(ePlaybackModeLoop)
         , currentFrameScheduler(0)
+        , renderBatchMutex()
+        , renderBatch()
         , refreshQueue()
     {
     }
@@ -2909,6 +2996,22 @@ RenderEngine::getPlaybackMode() const
     return _imp->pbMode;
 }
 
+void
+RenderEngine::setRenderBatch(const RenderBatchPtr& batch)
+{
+    QMutexLocker l(&_imp->renderBatchMutex);
+
+    _imp->renderBatch = batch;
+}
+
+RenderBatchPtr
+RenderEngine::getRenderBatch() const
+{
+    QMutexLocker l(&_imp->renderBatchMutex);
+
+    return _imp->renderBatch;
+}
+
 void
 RenderEngine::setDesiredFPS(double d)
 {
@@ -2977,6 +3080,9 @@ RenderEngine::reportStats(TimeValue time,
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = statsMap.begin(); it != statsMap.end(); ++it) {
         ofile << "------------------------------- " << it->first->getScriptName_mt_safe() << "------------------------------- " << std::endl;
         ofile << "Time spent rendering: " << Timer::printAsTime(it->second.getTotalTimeSpentRendering(), false).toStdString() << std::endl;
+        if ( it->second.hasCacheAccessMode() ) {
+            ofile << "Cache: " << it->second.getCacheAccessModeDescription() << std::endl;
+        }
     }
 } // reportStats
 
@@ -2999,6 +3105,30 @@ ViewerRenderEngine::reportStats(TimeValue time,
 
 
 ////////////////////////ViewerCurrentFrameRequestScheduler////////////////////////
+class ViewerSpeculativeFrameRendererStartArgs
+    : public GenericThreadStartArgs
+{
+public:
+
+    NodePtr viewer;
+
+    // The frame displayed by the viewer, around which frames are rendered
+    TimeValue time;
+    ViewIdx view;
+
+    ViewerSpeculativeFrameRendererStartArgs()
+        : GenericThreadStartArgs()
+        , viewer()
+        , time(0)
+        , view(0)
+    {
+    }
+
+    virtual ~ViewerSpeculativeFrameRendererStartArgs()
+    {
+    }
+};
+
 class CurrentFrameFunctorArgs
     : public GenericThreadStartArgs
 {
@@ -3072,6 +3202,10 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     QThreadPool* threadPool;
     QMutex producedFramesMutex;
     ProducedFrameSet producedFrames;
+
+    // Low resolution previews of the renders in flight, displayed while waiting for the full resolution frame.
+    // Protected by producedFramesMutex
+    ProducedFrameSet producedPreviewFrames;
     QWaitCondition producedFramesNotEmpty;
 
 
@@ -3080,6 +3214,11 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
      * activity to keep the renders responsive even if the thread pool is choking.
      **/
     ViewerCurrentFrameRequestRendererBackup backupThread;
+
+    /**
+     * Renders the frames around the displayed frame in the cache when the viewer is idle
+     **/
+    ViewerSpeculativeFrameRenderer speculativeRenderer;
     mutable QMutex currentFrameRenderTasksMutex;
     QWaitCondition currentFrameRenderTasksCond;
     std::list<RenderCurrentFrameFunctorRunnable*> currentFrameRenderTasks;
@@ -3100,8 +3239,10 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
         , threadPool( QThreadPool::globalInstance() )
         , producedFramesMutex()
         , producedFrames()
+        , producedPreviewFrames()
         , producedFramesNotEmpty()
         , backupThread()
+        , speculativeRenderer()
         , currentFrameRenderTasksCond()
         , currentFrameRenderTasks()
         , renderAge(1)
@@ -3155,6 +3296,18 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
         producedFramesNotEmpty.wakeOne();
     }
 
+    void notifyPreviewFrameProduced(const BufferedFrameContainerPtr& frames,
+                                    U64 age)
+    {
+        QMutexLocker k(&producedFramesMutex);
+        ProducedFrame p;
+
+        p.frames = frames;
+        p.age = age;
+        producedPreviewFrames.insert(p);
+        producedFramesNotEmpty.wakeOne();
+    }
+
     void processProducedFrame(const BufferedFrameContainerPtr& frames);
 };
 
@@ -3174,10 +3327,10 @@ public:
     {
     }
 
-    void createAndLaunchRenderInThread(const ViewerNodePtr &viewer, const RenderViewerProcessFunctorArgsPtr& processArgs, int viewerProcess_i, TimeValue time, const RenderStatsPtr& stats, const RectD* roiParam, ViewerRenderBufferedFrame* bufferedFrame)
+    void createAndLaunchRenderInThread(const ViewerNodePtr &viewer, const RenderViewerProcessFunctorArgsPtr& processArgs, int viewerProcess_i, TimeValue time, bool isPreview, const RenderStatsPtr& stats, const RectD* roiParam, ViewerRenderBufferedFrame* bufferedFrame)
     {
 
-        ViewerRenderFrameRunnable::createRenderViewerProcessArgs(viewer, viewerProcess_i, time, bufferedFrame->view, false /*isPlayback*/, stats, roiParam,  bufferedFrame, processArgs.get());
+        ViewerRenderFrameRunnable::createRenderViewerProcessArgs(viewer, viewerProcess_i, time, bufferedFrame->view, false /*isPlayback*/, isPreview, stats, roiParam,  bufferedFrame, processArgs.get());
 
         // Register the current renders and their age on the scheduler so that they can be aborted
         {
@@ -3208,7 +3361,7 @@ public:
     }
 
 
-    void computeViewsForRoI(const ViewerNodePtr &viewer, const RectD* roiParam, const ViewerRenderBufferedFrameContainerPtr& framesContainer)
+    void computeViewsForRoI(const ViewerNodePtr &viewer, const RectD* roiParam, bool isPreview, const ViewerRenderBufferedFrameContainerPtr& framesContainer)
     {
 
         for (std::size_t i = 0; i < _args->viewsToRender.size(); ++i) {
@@ -3217,7 +3370,7 @@ public:
 
             // Create stats object if we want statistics
             RenderStatsPtr stats;
-            if (_args->useStats) {
+            if (_args->useStats && !isPreview) {
                 stats.reset( new RenderStats(true) );
             }
 
@@ -3244,13 +3397,14 @@ public:
                                                                processArgs[1],
                                                                1,
                                                                _args->time,
+                                                               isPreview,
                                                                stats,
                                                                roiParam,
                                                                bufferObject.get()));
             }
 
             // Launch the 1st viewer process in this thread
-            createAndLaunchRenderInThread(viewer, processArgs[0], 0, _args->time, stats, roiParam, bufferObject.get());
+            createAndLaunchRenderInThread(viewer, processArgs[0], 0, _args->time, isPreview, stats, roiParam, bufferObject.get());
 
             // Wait for the 2nd viewer process
             if (!viewerBEqualsViewerA) {
@@ -3280,10 +3434,14 @@ public:
         if (viewer->isDoingPartialUpdates()) {
             std::list<RectD> partialUpdates = viewer->getPartialUpdateRects();
             for (std::list<RectD>::const_iterator it = partialUpdates.begin(); it != partialUpdates.end(); ++it) {
-                computeViewsForRoI(viewer, &(*it), framesContainer);
+                computeViewsForRoI(viewer, &(*it), false /*isPreview*/, framesContainer);
             }
         } else {
-            computeViewsForRoI(viewer, 0, framesContainer);
+            // While painting, strokes must be rendered in order with a single render
+            if ( !_args->strokeItem && appPTR->getCurrentSettings()->isProgressiveViewerPreviewEnabled() ) {
+                renderPreview(viewer, framesContainer->recenterViewer, framesContainer->viewerCenter);
+            }
+            computeViewsForRoI(viewer, 0, false /*isPreview*/, framesContainer);
         }
 
       
@@ -3293,6 +3451,38 @@ public:
 
         _args->scheduler->removeRunnableTask(this);
     } // run
+
+private:
+
+    /**
+     * @brief Render the frame at a lower resolution and hand it to the scheduler so that it is displayed while
+     * the full resolution frame is rendering.
+     **/
+    void renderPreview(const ViewerNodePtr &viewer, bool recenterViewer, const Point& viewerCenter)
+    {
+        ViewerRenderBufferedFrameContainerPtr previewContainer(new ViewerRenderBufferedFrameContainer);
+        previewContainer->time = _args->time;
+        previewContainer->recenterViewer = recenterViewer;
+        previewContainer->viewerCenter = viewerCenter;
+
+        computeViewsForRoI(viewer, 0, true /*isPreview*/, previewContainer);
+
+        for (std::list<BufferedFramePtr>::const_iterator it = previewContainer->frames.begin(); it != previewContainer->frames.end(); ++it) {
+            ViewerRenderBufferedFrame* viewerObject = dynamic_cast<ViewerRenderBufferedFrame*>(it->get());
+            assert(viewerObject);
+
+            // Do not display a preview that failed or was aborted
+            if (!viewerObject->viewerProcessImages[0]) {
+                return;
+            }
+
+            // The timeline cache line must only reflect full resolution frames
+            for (int i = 0; i < 2; ++i) {
+                viewerObject->viewerProcessImageKey[i].reset();
+            }
+        }
+        _args->scheduler->notifyPreviewFrameProduced(previewContainer, _args->age);
+    } // renderPreview
 };
 
 
@@ -3304,10 +3494,14 @@ public:
     BufferedFrameContainerPtr frames;
     U64 age;
 
+    // True if frames is a low resolution preview of the render
+    bool isPreview;
+
     ViewerCurrentFrameRequestSchedulerExecOnMT()
     : GenericThreadExecOnMainThreadArgs()
     , frames()
     , age(0)
+    , isPreview(false)
     {
     }
 
@@ -3329,6 +3523,9 @@ ViewerCurrentFrameRequestScheduler::~ViewerCurrentFrameRequestScheduler()
     if (_imp->backupThread.quitThread(false)) {
         _imp->backupThread.waitForAbortToComplete_enforce_blocking();
     }
+    if (_imp->speculativeRenderer.quitThread(false)) {
+        _imp->speculativeRenderer.waitForAbortToComplete_enforce_blocking();
+    }
 }
 
 GenericSchedulerThread::TaskQueueBehaviorEnum
@@ -3387,10 +3584,33 @@ ViewerCurrentFrameRequestScheduler::threadLoopOnce(const GenericThreadStartArgsP
             if ( (state == eThreadStateStopped) || (state == eThreadStateAborted) ) {
                 break;
             }
-            // Wait at most 100ms and re-check, so that we can resolveState() again:
-            // Imagine we launched 1 render (very long) that is not being aborted (the viewer always keeps 1 thread running)
-            // then this thread would be stuck here and would never launch a new render.
-            _imp->producedFramesNotEmpty.wait(&_imp->producedFramesMutex, 100);
+
+            // Display the low resolution preview of this render, if any, while the full resolution frame is rendering
+            ProducedFrameSet::iterator foundPreview = _imp->producedPreviewFrames.end();
+            for (ProducedFrameSet::iterator it = _imp->producedPreviewFrames.begin(); it != _imp->producedPreviewFrames.end(); ++it) {
+                if (it->age == args->functorArgs->age) {
+                    foundPreview = it;
+                    break;
+                }
+            }
+            if ( (foundPreview != _imp->producedPreviewFrames.end()) && (state == eThreadStateActive) ) {
+                boost::shared_ptr<ViewerCurrentFrameRequestSchedulerExecOnMT> previewArgs(new ViewerCurrentFrameRequestSchedulerExecOnMT);
+                previewArgs->age = args->functorArgs->age;
+                previewArgs->frames = foundPreview->frames;
+                previewArgs->isPreview = true;
+                ++foundPreview;
+                _imp->producedPreviewFrames.erase(_imp->producedPreviewFrames.begin(), foundPreview);
+
+                // Do not block render threads while the main thread uploads the preview
+                k.unlock();
+                requestExecutionOnMainThread(previewArgs);
+                k.relock();
+            } else {
+                // Wait at most 100ms and re-check, so that we can resolveState() again:
+                // Imagine we launched 1 render (very long) that is not being aborted (the viewer always keeps 1 thread running)
+                // then this thread would be stuck here and would never launch a new render.
+                _imp->producedFramesNotEmpty.wait(&_imp->producedFramesMutex, 100);
+            }
             for (ProducedFrameSet::iterator it = _imp->producedFrames.begin(); it != _imp->producedFrames.end(); ++it) {
                 if (it->age == args->functorArgs->age) {
                     found = it;
@@ -3409,6 +3629,11 @@ ViewerCurrentFrameRequestScheduler::threadLoopOnce(const GenericThreadStartArgsP
             // since they are no longer going to be used.
             ++found;
             _imp->producedFrames.erase(_imp->producedFrames.begin(), found);
+
+            // Same for the previews: this render is complete
+            while ( !_imp->producedPreviewFrames.empty() && (_imp->producedPreviewFrames.begin()->age <= args->functorArgs->age) ) {
+                _imp->producedPreviewFrames.erase( _imp->producedPreviewFrames.begin() );
+            }
         } else {
 #ifdef TRACE_CURRENT_FRAME_SCHEDULER
             qDebug() << getThreadName().c_str() << "Got aborted, skip waiting for" << args->age;
@@ -3444,6 +3669,18 @@ ViewerCurrentFrameRequestScheduler::threadLoopOnce(const GenericThreadStartArgsP
 
     if (mtArgs->frames) {
         requestExecutionOnMainThread(mtArgs);
+
+        // The viewer is now idle on this frame: render its neighbours in the cache until the user requests something else.
+        // Do not do so while tracking, painting or scrubbing.
+        ViewerNodePtr viewerNode = _imp->viewer->isEffectViewerNode();
+        if ( !args->useSingleThread && !viewerNode->getApp()->isDraftRenderEnabled() &&
+             appPTR->getCurrentSettings()->getSpeculativeRenderFramesCount() > 0 ) {
+            boost::shared_ptr<ViewerSpeculativeFrameRendererStartArgs> speculativeArgs(new ViewerSpeculativeFrameRendererStartArgs);
+            speculativeArgs->viewer = _imp->viewer;
+            speculativeArgs->time = args->functorArgs->time;
+            speculativeArgs->view = args->functorArgs->viewsToRender.front();
+            _imp->speculativeRenderer.startTask(speculativeArgs);
+        }
     }
 
 #ifdef TRACE_CURRENT_FRAME_SCHEDULER
@@ -3469,8 +3706,11 @@ ViewerCurrentFrameRequestScheduler::executeOnMainThread(const ExecOnMTArgsPtr& i
         if (args->age <= _imp->displayAge) {
             return;
         }
-        // Update the display age
-        _imp->displayAge = args->age;
+        // Update the display age. A preview does not, so that the full resolution frame of the same render
+        // is still displayed afterwards.
+        if (!args->isPreview) {
+            _imp->displayAge = args->age;
+        }
     }
     
     _imp->processProducedFrame(args->frames);
@@ -3530,6 +3770,9 @@ ViewerCurrentFrameRequestScheduler::onAbortRequested(bool keepOldestRender)
 #endif
     _imp->backupThread.abortThreadedTask();
 
+    // Any render request must stop the speculative renders right away
+    _imp->speculativeRenderer.abortThreadedTask();
+
     ViewerNodePtr viewerNode = _imp->viewer->isEffectViewerNode();
 
     // Do not abort the oldest render while scrubbing timeline or sliders so that the user gets some feedback
@@ -3564,6 +3807,7 @@ void
 ViewerCurrentFrameRequestScheduler::onQuitRequested(bool allowRestarts)
 {
     _imp->backupThread.quitThread(allowRestarts);
+    _imp->speculativeRenderer.quitThread(allowRestarts);
 }
 
 void
@@ -3571,6 +3815,7 @@ ViewerCurrentFrameRequestScheduler::onWaitForThreadToQuit()
 {
     _imp->waitForRunnableTasks();
     _imp->backupThread.waitForThreadToQuit_enforce_blocking();
+    _imp->speculativeRenderer.waitForThreadToQuit_enforce_blocking();
 }
 
 void
@@ -3578,6 +3823,7 @@ ViewerCurrentFrameRequestScheduler::onWaitForAbortCompleted()
 {
     _imp->waitForRunnableTasks();
     _imp->backupThread.waitForAbortToComplete_enforce_blocking();
+    _imp->speculativeRenderer.waitForAbortToComplete_enforce_blocking();
 }
 
 void
@@ -3676,6 +3922,137 @@ ViewerCurrentFrameRequestRendererBackup::threadLoopOnce(const GenericThreadStart
     return eThreadStateActive;
 }
 
+ViewerSpeculativeFrameRenderer::ViewerSpeculativeFrameRenderer()
+: GenericSchedulerThread()
+{
+    setThreadName("ViewerSpeculativeFrameRenderer");
+}
+
+ViewerSpeculativeFrameRenderer::~ViewerSpeculativeFrameRenderer()
+{
+}
+
+GenericSchedulerThread::TaskQueueBehaviorEnum
+ViewerSpeculativeFrameRenderer::tasksQueueBehaviour() const
+{
+    return eTaskQueueBehaviorSkipToMostRecent;
+}
+
+void
+ViewerSpeculativeFrameRenderer::onAbortRequested(bool /*keepOldestRender*/)
+{
+    // The render launched from this thread registered itself on the thread: abort it without waiting
+    // for the next frame
+    TreeRenderPtr render = getCurrentRender();
+    if (render) {
+        render->setRenderAborted();
+    }
+}
+
+/**
+ * @brief Returns true if the budgets of the preferences allow to render a frame ahead now
+ **/
+static bool
+canRenderSpeculativeFrame(const ViewerNodePtr& viewer)
+{
+    // Never compete with a playback or a render on disk
+    if ( viewer->getNode()->isDoingSequentialRender() ) {
+        return false;
+    }
+
+    SettingsPtr settings = appPTR->getCurrentSettings();
+
+    QThreadPool* threadPool = QThreadPool::globalInstance();
+    if ( threadPool->activeThreadCount() > settings->getSpeculativeRenderCPUBudget() * threadPool->maxThreadCount() ) {
+        return false;
+    }
+
+    MemoryGovernor* governor = appPTR->getMemoryGovernor();
+    if ( governor && !governor->canAdmitRender() ) {
+        return false;
+    }
+
+    CachePtr cache = appPTR->getCache();
+    if (cache) {
+        const double cacheBudget = settings->getSpeculativeRenderCacheBudget();
+        const StorageModeEnum storages[2] = {eStorageModeRAM, eStorageModeDisk};
+        for (int i = 0; i < 2; ++i) {
+            if ( cache->getCurrentSize(storages[i]) > cacheBudget * cache->getMaximumCacheSize(storages[i]) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+} // canRenderSpeculativeFrame
+
+GenericSchedulerThread::ThreadStateEnum
+ViewerSpeculativeFrameRenderer::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
+{
+    boost::shared_ptr<ViewerSpeculativeFrameRendererStartArgs> args = boost::dynamic_pointer_cast<ViewerSpeculativeFrameRendererStartArgs>(inArgs);
+    assert(args);
+
+    ViewerNodePtr viewer = args->viewer->isEffectViewerNode();
+    if (!viewer) {
+        return eThreadStateActive;
+    }
+
+    // Do not compete with the interface for the CPU
+    setPriority(QThread::LowestPriority);
+
+    TimeValue firstFrame, lastFrame;
+    viewer->getApp()->getProject()->getFrameRange(&firstFrame, &lastFrame);
+
+    const int nFrames = appPTR->getCurrentSettings()->getSpeculativeRenderFramesCount();
+
+    // Render alternatively the frames after and before the displayed frame, closest first
+    for (int i = 1; i <= nFrames; ++i) {
+        for (int side = 0; side < 2; ++side) {
+            ThreadStateEnum state = resolveState();
+            if ( (state == eThreadStateAborted) || (state == eThreadStateStopped) ) {
+                return state;
+            }
+            if ( !canRenderSpeculativeFrame(viewer) ) {
+                return eThreadStateActive;
+            }
+
+            TimeValue time(side == 0 ? args->time + i : args->time - i);
+            if ( (time < firstFrame) || (time > lastFrame) ) {
+                continue;
+            }
+
+            // Render the viewer process nodes the same way the current frame is rendered, so that scrubbing to
+            // this frame finds all tiles in the cache. Only the cache matters, the images are dropped.
+            int nViewerProcesses = viewer->getCurrentAInput() == viewer->getCurrentBInput() ? 1 : 2;
+            for (int viewerProcess_i = 0; viewerProcess_i < nViewerProcesses; ++viewerProcess_i) {
+                bool fullFrameProcessing = viewer->isFullFrameProcessingEnabled();
+
+                RenderViewerProcessFunctorArgs processArgs;
+                processArgs.viewerProcessNode = viewer->getViewerProcessNode(viewerProcess_i)->getNode();
+                processArgs.time = time;
+                processArgs.view = args->view;
+                processArgs.isPlayback = false;
+                processArgs.isDraftModeEnabled = false;
+                processArgs.byPassCache = false;
+                processArgs.hasPriorityPoint = false;
+                processArgs.lowPriority = true;
+                processArgs.viewerMipMapLevel = ViewerRenderFrameRunnable::getViewerMipMapLevel(viewer, false /*draftModeEnabled*/, fullFrameProcessing);
+                if (!fullFrameProcessing) {
+                    processArgs.roi = viewer->getUiContext()->getImageRectangleDisplayed();
+                }
+                ViewerRenderFrameRunnable::createRenderViewerObject(&processArgs);
+
+                std::map<ImagePlaneDesc, ImagePtr> planes;
+                processArgs.retCode = processArgs.renderObject->launchRender(&planes);
+                if ( isFailureRetCode(processArgs.retCode) ) {
+                    break;
+                }
+            }
+        }
+    }
+
+    return eThreadStateActive;
+} // threadLoopOnce
+
 NATRON_NAMESPACE_EXIT;
 
 NATRON_NAMESPACE_USING;
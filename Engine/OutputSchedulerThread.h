@@ -523,6 +523,35 @@ private:
     virtual ThreadStateEnum threadLoopOnce(const GenericThreadStartArgsPtr& inArgs) OVERRIDE FINAL WARN_UNUSED_RETURN;
 };
 
+/**
+ * @brief Single low priority thread used by the ViewerCurrentFrameRequestScheduler when it is idle to render the frames
+ * around the current frame in the cache, so that scrubbing to a neighbouring frame does not pay a full render.
+ * It is aborted as soon as the user requests a new render.
+ **/
+class ViewerSpeculativeFrameRenderer
+    : public GenericSchedulerThread
+{
+public:
+
+    ViewerSpeculativeFrameRenderer();
+
+    virtual ~ViewerSpeculativeFrameRenderer();
+
+private:
+
+    virtual void onAbortRequested(bool keepOldestRender) OVERRIDE FINAL;
+
+    /**
+     * @brief How to pick the task to process from the consumer thread
+     **/
+    virtual TaskQueueBehaviorEnum tasksQueueBehaviour() const OVERRIDE FINAL;
+
+    /**
+     * @brief Must be implemented to execute the work of the thread for 1 loop. This function will be called in a infinite loop by the thread
+     **/
+    virtual ThreadStateEnum threadLoopOnce(const GenericThreadStartArgsPtr& inArgs) OVERRIDE FINAL WARN_UNUSED_RETURN;
+};
+
 
 /**
  * @brief This class manages multiple OutputThreadScheduler so that each render request gets processed as soon as possible.
@@ -605,6 +634,14 @@ public:
      **/
     PlaybackModeEnum getPlaybackMode() const;
 
+    /**
+     * @brief Set the batch this engine renders with, @see RenderBatch. Must be set before
+     * calling renderFrameRange() and reset once the render is finished.
+     **/
+    void setRenderBatch(const RenderBatchPtr& batch);
+
+    RenderBatchPtr getRenderBatch() const;
+
     /**
      * @brief Returns the desired user FPS that the internal scheduler should stick to
      **/
@@ -30,6 +30,7 @@
 #include <cstdlib> // strtoul
 #include <cerrno> // errno
 #include <cassert>
+#include <sstream> // stringstream
 #include <stdexcept>
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
@@ -215,6 +216,7 @@ Project::loadProject(const QString & path,
                 }
                 if ( (ret == eStandardButtonNo) || (ret == eStandardButtonEscape) ) {
                     QFile::remove(realPath + autosaveFileName);
+                    QFile::remove( ProjectPrivate::getAutoSaveJournalFilePath(realPath + autosaveFileName) );
                 } else {
                     realName = autosaveFileName;
                     isAutoSave = true;
@@ -312,6 +314,14 @@ Project::loadProjectInternal(const QString & pathIn,
         _imp->lastProjectLoaded.reset(new SERIALIZATION_NAMESPACE::ProjectSerialization);
         appPTR->loadProjectFromFileFunction(ifile, filePathOut.toStdString(), getApp(), _imp->lastProjectLoaded.get());
 
+        if (isAutoSave) {
+            // Apply the changes journaled after the full auto-save
+            int nEntries = ProjectPrivate::replayAutoSaveJournal( ProjectPrivate::getAutoSaveJournalFilePath(filePathIn), _imp->lastProjectLoaded.get() );
+            if (nEntries > 0) {
+                appPTR->writeToErrorLog_mt_safe(tr("Project"), QDateTime::currentDateTime(), tr("Replayed %1 auto-save journal entries").arg(nEntries));
+            }
+        }
+
         {
             FlagSetter __raii_loadingProjectInternal__(true, &_imp->isLoadingProjectInternal, &_imp->isLoadingProjectMutex);
             ret = load(*_imp->lastProjectLoaded, nameIn, pathIn);
@@ -370,6 +380,10 @@ Project::loadProjectInternal(const QString & pathIn,
         }
     }
 
+    // When an auto-save was loaded, further changes can be appended to its journal. A converted auto-save
+    // is not the file the journal belongs to.
+    _imp->resetAutoSaveJournalState(!isAutoSave || hasConverted);
+
     _imp->runOnProjectLoadCallback();
 
     ///Process all events before flagging that we're no longer loading the project
@@ -424,6 +438,9 @@ Project::saveProject_imp(const QString & path,
             removeLastAutosave();
 
             //}
+        } else if ( updateProjectProperties && appendToAutoSaveJournal() ) {
+            ///Only the changes since the last auto-save were written
+            ret = getLastAutoSaveFilePath();
         } else {
             if (updateProjectProperties) {
                 ///Replace the last auto-save with a more recent one
@@ -539,6 +556,11 @@ Project::saveProjectInternal(const QString & path,
             _imp->natronVersion->setValue( generateUserFriendlyNatronVersionName());
         }
 
+        if (updateProjectProperties) {
+            // Changes made from now on go to the journal of this save
+            _imp->resetAutoSaveJournalState(false);
+        }
+
         try {
             SERIALIZATION_NAMESPACE::ProjectSerialization projectSerializationObj;
             toSerialization(&projectSerializationObj);
@@ -549,6 +571,9 @@ Project::saveProjectInternal(const QString & path,
                 ///Reset the old project path in case of failure.
                 _imp->autoSetProjectDirectory(oldProjectPath);
             }
+            if (updateProjectProperties) {
+                setGraphStructureDirtyForAutoSave();
+            }
             throw;
         }
     } // ofile
@@ -563,6 +588,9 @@ Project::saveProjectInternal(const QString & path,
     }
 
     if (nAttemps >= 10) {
+        if (updateProjectProperties) {
+            setGraphStructureDirtyForAutoSave();
+        }
         throw std::runtime_error( "Failed to save to " + filePath.toStdString() );
     }
 
@@ -612,6 +640,151 @@ Project::autoSave()
     saveProject_imp(path, name, true, true, 0);
 }
 
+void
+Project::setNodeDirtyForAutoSave(const NodePtr& node)
+{
+    if ( !node || isLoadingProject() ) {
+        return;
+    }
+    QMutexLocker k(&_imp->autoSaveJournalMutex);
+    _imp->autoSaveDirtyNodes.insert(node);
+}
+
+void
+Project::setGraphStructureDirtyForAutoSave()
+{
+    if ( isLoadingProject() ) {
+        return;
+    }
+    QMutexLocker k(&_imp->autoSaveJournalMutex);
+    _imp->autoSaveRequiresFullSave = true;
+}
+
+void
+Project::markDirtyForAutoSave()
+{
+    if ( isLoadingProject() ) {
+        return;
+    }
+    QMutexLocker k(&_imp->autoSaveJournalMutex);
+    _imp->autoSaveProjectSettingsDirty = true;
+}
+
+/**
+ * @brief Returns true if the node is written in the project file: nodes in a sub-graph are only written if the
+ * sub-graph was edited by the user.
+ **/
+static bool
+isNodeInProjectFile(const NodePtr& node)
+{
+    if ( !node->isPersistent() || !node->isActivated() ) {
+        return false;
+    }
+    if ( toStubNode( node->getEffectInstance() ) ) {
+        return false;
+    }
+    NodeGroupPtr isGroup = toNodeGroup( node->getGroup() );
+    while (isGroup) {
+        NodePtr groupNode = isGroup->getNode();
+        if ( !groupNode || !groupNode->isSubGraphEditedByUser() ) {
+            return false;
+        }
+        isGroup = toNodeGroup( groupNode->getGroup() );
+    }
+
+    return true;
+}
+
+bool
+Project::appendToAutoSaveJournal()
+{
+    QString autoSaveFilePath = getLastAutoSaveFilePath();
+    if ( autoSaveFilePath.isEmpty() ) {
+        return false;
+    }
+    QFileInfo autoSaveInfo(autoSaveFilePath);
+    if ( !autoSaveInfo.exists() ) {
+        return false;
+    }
+
+    // Compact the journal into a full auto-save when it gets bigger than the auto-save itself
+    QString journalFilePath = ProjectPrivate::getAutoSaveJournalFilePath(autoSaveFilePath);
+    QFileInfo journalInfo(journalFilePath);
+    if ( journalInfo.exists() && (journalInfo.size() >= autoSaveInfo.size()) ) {
+        return false;
+    }
+
+    NodesList dirtyNodes;
+    {
+        QMutexLocker k(&_imp->autoSaveJournalMutex);
+        if (_imp->autoSaveRequiresFullSave) {
+            return false;
+        }
+        // Something that is not tracked changed (e.g: the workspace), write everything
+        if ( _imp->autoSaveDirtyNodes.empty() && !_imp->autoSaveProjectSettingsDirty ) {
+            return false;
+        }
+        for (std::set<NodeWPtr>::const_iterator it = _imp->autoSaveDirtyNodes.begin(); it != _imp->autoSaveDirtyNodes.end(); ++it) {
+            NodePtr node = it->lock();
+            if (node) {
+                dirtyNodes.push_back(node);
+            }
+        }
+        _imp->autoSaveDirtyNodes.clear();
+        _imp->autoSaveProjectSettingsDirty = false;
+    }
+
+    // All the code below is MT-safe and run in the serialization thread
+    SERIALIZATION_NAMESPACE::ProjectSerialization entry;
+    for (NodesList::const_iterator it = dirtyNodes.begin(); it != dirtyNodes.end(); ++it) {
+        if ( !isNodeInProjectFile(*it) ) {
+            // Deactivated nodes are handled by the graph structure flag, the others are not in the auto-save
+            if ( (*it)->isActivated() && (*it)->isPersistent() ) {
+                return false;
+            }
+            continue;
+        }
+        SERIALIZATION_NAMESPACE::NodeSerializationPtr state( new SERIALIZATION_NAMESPACE::NodeSerialization );
+        (*it)->toSerialization( state.get() );
+
+        // Sub-graphs are restored from the full auto-save. Nodes are identified by their fully qualified
+        // script-name since the group they belong to is not encoded.
+        state->_children.clear();
+        state->_nodeScriptName = (*it)->getFullyQualifiedName();
+        entry._nodes.push_back(state);
+    }
+
+    toSerializationProjectSettings(&entry);
+    entry._timelineCurrent = currentFrame();
+
+    std::stringstream ss;
+    SERIALIZATION_NAMESPACE::write( ss, entry, std::string() );
+    std::string data = ss.str();
+
+    {
+        FStreamsSupport::ofstream ofile;
+        FStreamsSupport::open( &ofile, journalFilePath.toStdString(), std::ios_base::out | std::ios_base::app | std::ios_base::binary );
+        if (ofile) {
+            // The size lets the replay detect an entry that was not completely written
+            ofile << NATRON_PROJECT_AUTOSAVE_JOURNAL_ENTRY_HEADER << ' ' << data.size() << '\n';
+            ofile.write( data.c_str(), data.size() );
+            ofile.flush();
+        }
+        if (!ofile) {
+            qDebug() << "Failed to append to the auto-save journal" << journalFilePath;
+
+            return false;
+        }
+    }
+
+    _imp->lastAutoSave = QDateTime::currentDateTime();
+    QString projectPath = QString::fromUtf8( _imp->getProjectPath().c_str() );
+    QString projectFilename = QString::fromUtf8( _imp->getProjectFilename().c_str() );
+    Q_EMIT projectNameChanged(projectPath + projectFilename, true);
+
+    return true;
+} // Project::appendToAutoSaveJournal
+
 void
 Project::triggerAutoSave()
 {
@@ -692,7 +865,7 @@ Project::findAutoSaveForProject(const QString& projectPath,
         QString autosaveSuffix( QString::fromUtf8(".autosave") );
         searchStr.append(autosaveSuffix);
         int suffixPos = entry.indexOf(searchStr);
-        if (suffixPos == -1) {
+        if ( (suffixPos == -1) || entry.endsWith( QLatin1Char('.') + QString::fromUtf8(NATRON_PROJECT_AUTOSAVE_JOURNAL_EXT) ) ) {
             continue;
         }
         QString filename = projectPath + entry.left( suffixPos + ntpExt.size() );
@@ -1810,6 +1983,7 @@ Project::removeLastAutosave()
 
     if ( !filepath.isEmpty() ) {
         QFile::remove(filepath);
+        QFile::remove( ProjectPrivate::getAutoSaveJournalFilePath(filepath) );
     }
 
     /*
@@ -1823,6 +1997,10 @@ Project::removeLastAutosave()
     if ( QFile::exists(autoSaveFilePath) ) {
         QFile::remove(autoSaveFilePath);
     }
+    QString journalFilePath = ProjectPrivate::getAutoSaveJournalFilePath(autoSaveFilePath);
+    if ( QFile::exists(journalFilePath) ) {
+        QFile::remove(journalFilePath);
+    }
 }
 
 void
@@ -1983,6 +2161,9 @@ Project::doResetEnd(bool aboutToQuit)
         onOCIOConfigPathChanged(appPTR->getOCIOConfigPath(), true);
 
         endChanges(true);
+
+        // The last auto-save belongs to the previous project
+        _imp->resetAutoSaveJournalState(true);
     }
 
     {
@@ -2824,6 +3005,39 @@ Project::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* seria
         }
     }
 
+    toSerializationProjectSettings(serialization);
+
+
+    // Timeline's current frame
+    serialization->_timelineCurrent = currentFrame();
+
+    if (getApp()->isBackground()) {
+        // Use the last project loaded serialization for the gui layout
+        if (_imp->lastProjectLoaded) {
+            serialization->_projectWorkspace = _imp->lastProjectLoaded->_projectWorkspace;
+            serialization->_openedPanelsOrdered = _imp->lastProjectLoaded->_openedPanelsOrdered;
+            serialization->_viewportsData = _imp->lastProjectLoaded->_viewportsData;
+        }
+    } else {
+        // Serialize workspace
+        serialization->_projectWorkspace.reset(new SERIALIZATION_NAMESPACE::WorkspaceSerialization);
+        getApp()->saveApplicationWorkspace(serialization->_projectWorkspace.get());
+
+        // Save opened panels
+        std::list<DockablePanelI*> openedPanels = getApp()->getOpenedSettingsPanels();
+        for (std::list<DockablePanelI*>::iterator it = openedPanels.begin(); it!=openedPanels.end(); ++it) {
+            serialization->_openedPanelsOrdered.push_back((*it)->getHolderFullyQualifiedScriptName());
+        }
+
+        // Save viewports
+        getApp()->getViewportsProjection(&serialization->_viewportsData);
+    }
+    
+} // Project::toSerialization
+
+void
+Project::toSerializationProjectSettings(SERIALIZATION_NAMESPACE::ProjectSerialization* serialization)
+{
     // Get user additional formats
     std::list<Format> formats;
     getAdditionalFormats(&formats);
@@ -2903,34 +3117,7 @@ Project::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* seria
     serialization->_projectLoadedInfo.vMajor = NATRON_VERSION_MAJOR;
     serialization->_projectLoadedInfo.vMinor = NATRON_VERSION_MINOR;
     serialization->_projectLoadedInfo.vRev = NATRON_VERSION_REVISION;
-
-
-    // Timeline's current frame
-    serialization->_timelineCurrent = currentFrame();
-
-    if (getApp()->isBackground()) {
-        // Use the last project loaded serialization for the gui layout
-        if (_imp->lastProjectLoaded) {
-            serialization->_projectWorkspace = _imp->lastProjectLoaded->_projectWorkspace;
-            serialization->_openedPanelsOrdered = _imp->lastProjectLoaded->_openedPanelsOrdered;
-            serialization->_viewportsData = _imp->lastProjectLoaded->_viewportsData;
-        }
-    } else {
-        // Serialize workspace
-        serialization->_projectWorkspace.reset(new SERIALIZATION_NAMESPACE::WorkspaceSerialization);
-        getApp()->saveApplicationWorkspace(serialization->_projectWorkspace.get());
-
-        // Save opened panels
-        std::list<DockablePanelI*> openedPanels = getApp()->getOpenedSettingsPanels();
-        for (std::list<DockablePanelI*>::iterator it = openedPanels.begin(); it!=openedPanels.end(); ++it) {
-            serialization->_openedPanelsOrdered.push_back((*it)->getHolderFullyQualifiedScriptName());
-        }
-
-        // Save viewports
-        getApp()->getViewportsProjection(&serialization->_viewportsData);
-    }
-    
-} // Project::toSerialization
+} // Project::toSerializationProjectSettings
 
 
 
@@ -124,6 +124,19 @@ public:
      **/
     void triggerAutoSave();
 
+    /**
+     * @brief Marks the given node as changed since the last auto-save. As long as only nodes and project settings
+     * are changed, auto-saves append the changed objects to a journal next to the last full auto-save instead of
+     * writing the whole project. MT-safe.
+     **/
+    void setNodeDirtyForAutoSave(const NodePtr& node);
+
+    /**
+     * @brief Marks the graph as changed in a way the auto-save journal cannot express (nodes created, removed,
+     * renamed or connected): the next auto-save writes the whole project. MT-safe.
+     **/
+    void setGraphStructureDirtyForAutoSave();
+
     /**
      * @brief Returns the path to where the auto save files are stored on disk.
      **/
@@ -427,6 +440,22 @@ private:
 
     QString saveProjectInternal(const QString & path, const QString & name, bool autosave, bool updateProjectProperties);
 
+    /**
+     * @brief Appends the nodes and settings changed since the last auto-save to the journal of the last full auto-save.
+     * @returns False if the changes cannot be journaled, in which case a full auto-save must be done.
+     **/
+    bool appendToAutoSaveJournal();
+
+    /**
+     * @brief Serializes the project settings, formats and version info, i.e: everything but the nodes and the GUI.
+     **/
+    void toSerializationProjectSettings(SERIALIZATION_NAMESPACE::ProjectSerialization* serialization);
+
+    /**
+     * @brief Reimplemented from KnobHolder: marks the project settings for the next auto-save.
+     **/
+    virtual void markDirtyForAutoSave() OVERRIDE FINAL;
+
 
 
     void doResetEnd(bool aboutToQuit);
@@ -26,6 +26,7 @@
 
 #include <list>
 #include <cassert>
+#include <cstdlib> // strtoul
 #include <stdexcept>
 #include <sstream> // stringstream
 
@@ -42,6 +43,7 @@
 #include "Engine/AppManager.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/FStreamsSupport.h"
 #include "Engine/Node.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/Project.h"
@@ -53,6 +55,7 @@
 
 #include "Serialization/NodeSerialization.h"
 #include "Serialization/ProjectSerialization.h"
+#include "Serialization/SerializationIO.h"
 
 
 NATRON_NAMESPACE_ENTER;
@@ -95,7 +98,10 @@ ProjectPrivate::ProjectPrivate(Project* project)
     , autoSaveTimer( new QTimer() )
     , projectClosing(false)
     , tlsData( new TLSHolder<Project::ProjectTLSData>() )
-
+    , autoSaveJournalMutex()
+    , autoSaveDirtyNodes()
+    , autoSaveProjectSettingsDirty(false)
+    , autoSaveRequiresFullSave(true)
 {
     autoSaveTimer->setSingleShot(true);
 }
@@ -242,6 +248,9 @@ Project::restoreGroupFromSerialization(const SERIALIZATION_NAMESPACE::NodeSerial
 {
     bool mustShowErrorsLog = false;
 
+    // Refresh the meta-datas of the created nodes and render once they are all created and connected
+    KnobChangesTransaction_RAII transaction( group->getApplication() );
+
     NodeGroupPtr isGrp = toNodeGroup(group);
 
     QString groupName;
@@ -618,6 +627,7 @@ void
 ProjectPrivate::setProjectFilename(const std::string& filename)
 {
     projectName->setValue(filename);
+    invalidateNodesCacheReuseKey();
 }
 
 std::string
@@ -630,6 +640,17 @@ void
 ProjectPrivate::setProjectPath(const std::string& path)
 {
     projectPath->setValue(path);
+    invalidateNodesCacheReuseKey();
+}
+
+void
+ProjectPrivate::invalidateNodesCacheReuseKey()
+{
+    // The key of the nodes in the cache reuse statistics depends on the project file
+    NodesList nodes = _publicInterface->getNodes();
+    for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        (*it)->invalidateCacheReuseKey();
+    }
 }
 
 std::string
@@ -638,4 +659,110 @@ ProjectPrivate::getProjectPath() const
     return projectPath->getValue();
 }
 
+void
+ProjectPrivate::resetAutoSaveJournalState(bool requiresFullSave)
+{
+    QMutexLocker k(&autoSaveJournalMutex);
+
+    autoSaveDirtyNodes.clear();
+    autoSaveProjectSettingsDirty = false;
+    autoSaveRequiresFullSave = requiresFullSave;
+}
+
+QString
+ProjectPrivate::getAutoSaveJournalFilePath(const QString& autoSaveFilePath)
+{
+    return autoSaveFilePath + QLatin1Char('.') + QString::fromUtf8(NATRON_PROJECT_AUTOSAVE_JOURNAL_EXT);
+}
+
+/**
+ * @brief Returns the serialization of the node with the given fully qualified script-name, e.g: Group1.Blur1,
+ * or NULL if it is not in the given list or in the children of the serialized groups.
+ **/
+static SERIALIZATION_NAMESPACE::NodeSerializationPtr*
+findNodeSerialization(SERIALIZATION_NAMESPACE::NodeSerializationList* nodes,
+                      const std::string& fullyQualifiedName)
+{
+    std::size_t foundDot = fullyQualifiedName.find('.');
+    std::string scriptName = fullyQualifiedName.substr(0, foundDot);
+
+    for (SERIALIZATION_NAMESPACE::NodeSerializationList::iterator it = nodes->begin(); it != nodes->end(); ++it) {
+        if ( (*it)->_nodeScriptName != scriptName ) {
+            continue;
+        }
+        if (foundDot == std::string::npos) {
+            return &(*it);
+        }
+
+        return findNodeSerialization( &(*it)->_children, fullyQualifiedName.substr(foundDot + 1) );
+    }
+
+    return 0;
+}
+
+int
+ProjectPrivate::replayAutoSaveJournal(const QString& journalFilePath,
+                                      SERIALIZATION_NAMESPACE::ProjectSerialization* serialization)
+{
+    if ( !QFile::exists(journalFilePath) ) {
+        return 0;
+    }
+
+    FStreamsSupport::ifstream ifile;
+    FStreamsSupport::open( &ifile, journalFilePath.toStdString(), std::ios_base::in | std::ios_base::binary );
+    if (!ifile) {
+        return 0;
+    }
+
+    const std::string entryHeader(NATRON_PROJECT_AUTOSAVE_JOURNAL_ENTRY_HEADER);
+    int nEntries = 0;
+    std::string line;
+    while ( std::getline(ifile, line) ) {
+        // Each entry starts with the header followed by the size in bytes of its YAML encoding
+        if ( (line.size() <= entryHeader.size() + 1) || (line.compare(0, entryHeader.size(), entryHeader) != 0) ) {
+            break;
+        }
+        std::size_t entrySize = std::strtoul(line.c_str() + entryHeader.size() + 1, 0, 10);
+        if (entrySize == 0) {
+            break;
+        }
+        std::string data(entrySize, '\0');
+        ifile.read(&data[0], entrySize);
+        if ( (std::size_t)ifile.gcount() != entrySize ) {
+            // The entry was not completely written
+            break;
+        }
+
+        SERIALIZATION_NAMESPACE::ProjectSerialization entry;
+        try {
+            std::istringstream ss(data);
+            SERIALIZATION_NAMESPACE::read(std::string(), ss, &entry);
+        } catch (...) {
+            qDebug() << "Ignoring a damaged entry of the auto-save journal" << journalFilePath;
+            break;
+        }
+
+        // In the journal nodes are identified by their fully qualified script-name, see Project::appendToAutoSaveJournal
+        for (SERIALIZATION_NAMESPACE::NodeSerializationList::iterator it = entry._nodes.begin(); it != entry._nodes.end(); ++it) {
+            SERIALIZATION_NAMESPACE::NodeSerializationPtr* found = findNodeSerialization(&serialization->_nodes, (*it)->_nodeScriptName);
+            if (!found) {
+                qDebug() << "Auto-save journal: could not find" << QString::fromUtf8( (*it)->_nodeScriptName.c_str() ) << "in the auto-save";
+                continue;
+            }
+            (*it)->_nodeScriptName = (*found)->_nodeScriptName;
+            // Sub-graphs are not journaled, keep the one of the full auto-save
+            (*it)->_children = (*found)->_children;
+            *found = *it;
+        }
+
+        // The project settings are written in each entry
+        serialization->_projectKnobs = entry._projectKnobs;
+        serialization->_additionalFormats = entry._additionalFormats;
+        serialization->_timelineCurrent = entry._timelineCurrent;
+        ++nEntries;
+    }
+
+    return nEntries;
+} // ProjectPrivate::replayAutoSaveJournal
+
 NATRON_NAMESPACE_EXIT;
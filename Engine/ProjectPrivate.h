@@ -29,6 +29,7 @@
 
 #include <map>
 #include <list>
+#include <set>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
@@ -109,6 +110,12 @@ public:
     bool projectClosing;
     boost::shared_ptr<TLSHolder<Project::ProjectTLSData> > tlsData;
 
+    // What changed since the last auto-save, see Project::setNodeDirtyForAutoSave
+    mutable QMutex autoSaveJournalMutex;
+    std::set<NodeWPtr> autoSaveDirtyNodes; //< nodes changed since the last auto-save
+    bool autoSaveProjectSettingsDirty; //< project settings changed since the last auto-save
+    bool autoSaveRequiresFullSave; //< something changed that the auto-save journal cannot express
+
 
     // only used on the main-thread
     struct RenderWatcher
@@ -140,6 +147,27 @@ public:
 
     void setProjectPath(const std::string& path);
     std::string getProjectPath() const;
+
+    void invalidateNodesCacheReuseKey();
+
+    /**
+     * @brief Forgets what changed since the last auto-save. If requiresFullSave is true the next
+     * auto-save writes the whole project instead of appending to the journal.
+     **/
+    void resetAutoSaveJournalState(bool requiresFullSave);
+
+    /**
+     * @brief Returns the file path of the journal of changes appended after the given full auto-save.
+     **/
+    static QString getAutoSaveJournalFilePath(const QString& autoSaveFilePath);
+
+    /**
+     * @brief Applies the entries of the given journal, in the order they were written, on the serialization of
+     * the full auto-save it belongs to. An entry that was not completely written (e.g: crash while appending it)
+     * ends the replay.
+     * @returns The number of entries replayed
+     **/
+    static int replayAutoSaveJournal(const QString& journalFilePath, SERIALIZATION_NAMESPACE::ProjectSerialization* serialization);
     static QString generateStringFromFormat(const Format & f)
     {
         QString formatStr;
@@ -29,6 +29,8 @@
 #include <sstream> // stringstream
 
 #include <QtCore/QDebug>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
 
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 CLANG_DIAG_OFF(mismatched-tags)
@@ -397,6 +399,15 @@ App::render(const std::list<Effect*>& effects,
     renderInternal(false, effects, firstFrames, lastFrames, frameSteps);
 }
 
+void
+App::renderBatch(const std::list<Effect*>& effects,
+                 const std::list<int>& firstFrames,
+                 const std::list<int>& lastFrames,
+                 const std::list<int>& frameSteps)
+{
+    renderInternal(false, true /*batch*/, effects, firstFrames, lastFrames, frameSteps);
+}
+
 void
 App::renderInternal(bool forceBlocking,
                     Effect* writeNode,
@@ -439,6 +450,17 @@ App::renderInternal(bool forceBlocking,
                     const std::list<int>& firstFrames,
                     const std::list<int>& lastFrames,
                     const std::list<int>& frameSteps)
+{
+    renderInternal(forceBlocking, false /*batch*/, effects, firstFrames, lastFrames, frameSteps);
+}
+
+void
+App::renderInternal(bool forceBlocking,
+                    bool batch,
+                    const std::list<Effect*>& effects,
+                    const std::list<int>& firstFrames,
+                    const std::list<int>& lastFrames,
+                    const std::list<int>& frameSteps)
 {
     std::list<RenderQueue::RenderWork> l;
 
@@ -474,7 +496,10 @@ App::renderInternal(bool forceBlocking,
 
         l.push_back(w);
     }
-    if (forceBlocking) {
+    if (batch) {
+        // Blocking in background mode only, like renderNonBlocking()
+        getInternalApp()->getRenderQueue()->renderBatch(l);
+    } else if (forceBlocking) {
         getInternalApp()->getRenderQueue()->renderBlocking(l);
     } else {
         getInternalApp()->getRenderQueue()->renderNonBlocking(l);
@@ -639,5 +664,26 @@ App::addProjectLayer(const ImageLayer& layer)
     getInternalApp()->getProject()->addProjectDefaultLayer( layer.getInternalComps() );
 }
 
+void
+App::beginChanges()
+{
+    // Nodes are only evaluated on the main thread
+    if ( QThread::currentThread() != qApp->thread() ) {
+        return;
+    }
+    getInternalApp()->beginScriptKnobChangesTransaction();
+}
+
+void
+App::endChanges()
+{
+    if ( QThread::currentThread() != qApp->thread() ) {
+        return;
+    }
+    if ( !getInternalApp()->endScriptKnobChangesTransaction() ) {
+        PyErr_SetString( PyExc_RuntimeError, tr("endChanges() called without a matching call to beginChanges()").toStdString().c_str() );
+    }
+}
+
 NATRON_PYTHON_NAMESPACE_EXIT;
 NATRON_NAMESPACE_EXIT;
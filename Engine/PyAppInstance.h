@@ -311,6 +311,8 @@ public:
 
     void render(const std::list<Effect*>& effects, const std::list<int>& firstFrames, const std::list<int>& lastFrames, const std::list<int>& frameSteps);
 
+    void renderBatch(const std::list<Effect*>& effects, const std::list<int>& firstFrames, const std::list<int>& lastFrames, const std::list<int>& frameSteps);
+
     void redrawViewer(Effect* viewerNode);
 
     void refreshViewer(Effect* viewerNode,bool useCache = true);
@@ -340,6 +342,14 @@ public:
 
     void addProjectLayer(const ImageLayer& layer);
 
+    /**
+     * @brief Same as Effect::beginChanges() but for all the nodes of the project: the meta-datas of the nodes
+     * changed between the two calls are refreshed, and the viewers rendered, only once when endChanges() is called.
+     **/
+    void beginChanges();
+
+    void endChanges();
+
     static Effect* createEffectFromNodeWrapper(const NodePtr& node);
 
     static App* createAppFromAppInstance(const AppInstancePtr& app);
@@ -349,6 +359,8 @@ protected:
     void renderInternal(bool forceBlocking, Effect* writeNode, int firstFrame, int lastFrame, int frameStep);
     void renderInternal(bool forceBlocking, const std::list<Effect*>& effects, const std::list<int>& firstFrames, const std::list<int>& lastFrames,
                         const std::list<int>& frameSteps);
+    void renderInternal(bool forceBlocking, bool batch, const std::list<Effect*>& effects, const std::list<int>& firstFrames, const std::list<int>& lastFrames,
+                        const std::list<int>& frameSteps);
 
     NodeCollectionPtr getCollectionFromGroup(Group* group) const;
 };
@@ -0,0 +1,199 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderBatch.h"
+
+#include <map>
+#include <cmath>
+#include <algorithm> // max
+#include <cassert>
+
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
+// How many frames a render of the batch may be ahead of a slower one it overlaps, counted in frame steps of the slower render
+#define NATRON_RENDER_BATCH_MAX_FRAMES_AHEAD 1
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderBatchRender
+{
+    TimeValue firstFrame;
+    TimeValue lastFrame;
+    TimeValue frameStep;
+
+    // The last frame started by this render. Before the first frame is started, this is the first frame
+    // so that all renders may start their first frame together.
+    TimeValue lastStartedFrame;
+
+    RenderBatchRender()
+        : firstFrame(0)
+        , lastFrame(0)
+        , frameStep(1)
+        , lastStartedFrame(0)
+    {
+    }
+
+    // 1 if the render goes forward, -1 if it goes backward
+    double getDirection() const
+    {
+        return frameStep > 0 ? 1. : -1.;
+    }
+
+    bool containsFrame(TimeValue frame) const
+    {
+        return (frame - firstFrame) * getDirection() >= 0 && (lastFrame - frame) * getDirection() >= 0;
+    }
+
+    bool overlaps(const RenderBatchRender& other) const
+    {
+        if ( getDirection() != other.getDirection() ) {
+            return false;
+        }
+        return containsFrame(other.firstFrame) || containsFrame(other.lastFrame) || other.containsFrame(firstFrame);
+    }
+
+    bool hasStartedAllFrames() const
+    {
+        return (lastFrame - lastStartedFrame) * getDirection() < std::abs( (double)frameStep );
+    }
+};
+
+typedef std::map<const RenderEngine*, RenderBatchRender> RenderBatchRenderMap;
+
+struct RenderBatchPrivate
+{
+    mutable QMutex rendersMutex;
+    mutable QWaitCondition progressCond;
+    RenderBatchRenderMap renders;
+
+    RenderBatchPrivate()
+        : rendersMutex()
+        , progressCond()
+        , renders()
+    {
+    }
+
+    bool canStartFrame(const RenderEngine* engine, TimeValue frame) const;
+};
+
+RenderBatch::RenderBatch()
+    : _imp( new RenderBatchPrivate() )
+{
+}
+
+RenderBatch::~RenderBatch()
+{
+}
+
+void
+RenderBatch::addRender(const RenderEngine* engine,
+                       TimeValue firstFrame,
+                       TimeValue lastFrame,
+                       TimeValue frameStep)
+{
+    assert(frameStep != 0);
+    RenderBatchRender r;
+    r.firstFrame = firstFrame;
+    r.frameStep = frameStep;
+    // The last frame is before the first one in the direction of the render if the range is empty
+    r.lastFrame = (lastFrame - firstFrame) * r.getDirection() >= 0 ? lastFrame : firstFrame;
+    r.lastStartedFrame = firstFrame;
+
+    QMutexLocker k(&_imp->rendersMutex);
+    _imp->renders[engine] = r;
+}
+
+void
+RenderBatch::removeRender(const RenderEngine* engine)
+{
+    QMutexLocker k(&_imp->rendersMutex);
+    _imp->renders.erase(engine);
+    _imp->progressCond.wakeAll();
+}
+
+bool
+RenderBatchPrivate::canStartFrame(const RenderEngine* engine,
+                                  TimeValue frame) const
+{
+    // Private shouldn't lock
+    assert( !rendersMutex.tryLock() );
+    RenderBatchRenderMap::const_iterator found = renders.find(engine);
+    if ( found == renders.end() ) {
+        return true;
+    }
+    const RenderBatchRender& thisRender = found->second;
+    for (RenderBatchRenderMap::const_iterator it = renders.begin(); it != renders.end(); ++it) {
+        if (it->first == engine) {
+            continue;
+        }
+        const RenderBatchRender& other = it->second;
+
+        // Only renders that will also render this frame share its images
+        if ( !thisRender.overlaps(other) || !other.containsFrame(frame) ) {
+            continue;
+        }
+        // A render that has started all its frames will not make any more progress
+        if ( other.hasStartedAllFrames() ) {
+            continue;
+        }
+        if ( (frame - other.lastStartedFrame) * other.getDirection() > NATRON_RENDER_BATCH_MAX_FRAMES_AHEAD * std::abs( (double)other.frameStep ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+RenderBatch::waitForFrameCanStart(const RenderEngine* engine,
+                                  TimeValue frame,
+                                  unsigned long timeoutMS) const
+{
+    QMutexLocker k(&_imp->rendersMutex);
+    if ( _imp->canStartFrame(engine, frame) ) {
+        return true;
+    }
+    _imp->progressCond.wait(&_imp->rendersMutex, timeoutMS);
+
+    return _imp->canStartFrame(engine, frame);
+}
+
+void
+RenderBatch::notifyFrameStarted(const RenderEngine* engine,
+                                TimeValue frame)
+{
+    QMutexLocker k(&_imp->rendersMutex);
+    RenderBatchRenderMap::iterator found = _imp->renders.find(engine);
+    if ( found == _imp->renders.end() ) {
+        return;
+    }
+    RenderBatchRender& r = found->second;
+    if ( (frame - r.lastStartedFrame) * r.getDirection() > 0 ) {
+        r.lastStartedFrame = frame;
+    }
+    _imp->progressCond.wakeAll();
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,89 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_RenderBatch_h
+#define Engine_RenderBatch_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/TimeValue.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A set of renders (one per output node) started together with App.renderBatch().
+ * All renders of the batch run concurrently. Renders going in the same direction over overlapping frame ranges are
+ * kept in lock-step on the frame time: a render does not start a frame within the range of another render of the
+ * batch while that render is more than one of its own frame steps behind it.
+ * Renders that do not overlap, or that go in opposite directions, share no frame and do not hold each other back.
+ * Since the overlapping outputs then pull the same frames from the shared upstream graph at the same time, the images
+ * of the shared nodes are computed once: the other renders wait for the pending cache entry
+ * (@see CacheEntryLocker) or find it in the cache, instead of computing it again once it was evicted.
+ * Each render keeps writing its frames in order.
+ **/
+struct RenderBatchPrivate;
+class RenderBatch
+{
+public:
+
+    RenderBatch();
+
+    ~RenderBatch();
+
+    /**
+     * @brief Add a render to the batch. Must be called before the render starts.
+     * The frame step is negative if the render goes from the first frame backward to the last frame.
+     **/
+    void addRender(const RenderEngine* engine, TimeValue firstFrame, TimeValue lastFrame, TimeValue frameStep);
+
+    /**
+     * @brief Remove a render from the batch, once it is finished or aborted, so that it no longer holds back the others.
+     **/
+    void removeRender(const RenderEngine* engine);
+
+    /**
+     * @brief Blocks until the given render may start the given frame, or until the timeout elapsed.
+     * @returns True if the frame may be started. The caller should check for abortion when returning false.
+     **/
+    bool waitForFrameCanStart(const RenderEngine* engine, TimeValue frame, unsigned long timeoutMS) const;
+
+    /**
+     * @brief Notify the other renders of the batch that the given render started the given frame.
+     **/
+    void notifyFrameStarted(const RenderEngine* engine, TimeValue frame);
+
+private:
+
+    boost::scoped_ptr<RenderBatchPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_RenderBatch_h
@@ -40,6 +40,7 @@
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/ProcessHandler.h"
 #include "Engine/Project.h"
+#include "Engine/RenderBatch.h"
 #include "Engine/Settings.h"
 
 
@@ -197,6 +198,25 @@ RenderQueuePrivate::validateRenderOptions(RenderQueue::RenderWork& w)
             return false;
         }
     }
+
+    // When rendering with several worker processes, each worker renders every N-th frame of the range
+    int workerIndex, nWorkers;
+    appPTR->getRenderWorkerIndex(&workerIndex, &nWorkers);
+    if ( (workerIndex >= 0) && (nWorkers > 1) ) {
+        if ( w.treeRoot->getEffectInstance()->isVideoWriter() ) {
+            // A video file cannot be written by several processes: the first worker renders all frames
+            return workerIndex == 0;
+        }
+        w.firstFrame = TimeValue(w.firstFrame + workerIndex * w.frameStep);
+        w.frameStep = TimeValue(w.frameStep * nWorkers);
+        if ( (w.frameStep > 0 && w.firstFrame > w.lastFrame) || (w.frameStep < 0 && w.firstFrame < w.lastFrame) ) {
+            // More workers than frames to render
+            return false;
+        }
+        // Make sure the last frame is one of the frames of this worker
+        w.lastFrame = TimeValue(w.firstFrame + std::floor( (w.lastFrame - w.firstFrame) / w.frameStep ) * w.frameStep);
+    }
+
     return true;
 } // validateRenderOptions
 
@@ -210,11 +230,14 @@ RenderQueuePrivate::dispatchQueue(bool doBlockingRender, const std::list<RenderQ
 
     AppInstancePtr app = getApp();
 
+    // A batch must be rendered concurrently in this process so that the writers can share the images of the upstream nodes
+    const bool isBatch = (bool)writers.front().batch;
+
     // If queueing is enabled and we have to render multiple writers, render them in order
-    const bool isQueuingEnabled = appPTR->getCurrentSettings()->isRenderQueuingEnabled();
+    const bool isQueuingEnabled = !isBatch && appPTR->getCurrentSettings()->isRenderQueuingEnabled();
 
     // If enabled, we launch the render in a separate process launching NatronRenderer
-    const bool renderInSeparateProcess = appPTR->getCurrentSettings()->isRenderInSeparatedProcessEnabled();
+    const bool renderInSeparateProcess = !isBatch && appPTR->getCurrentSettings()->isRenderInSeparatedProcessEnabled();
 
     // When launching in a separate process, make a temporary save file that we pass to NatronRenderer
     QString savePath;
@@ -258,6 +281,15 @@ RenderQueuePrivate::dispatchQueue(bool doBlockingRender, const std::list<RenderQ
         return;
     }
 
+    // Register all renders of the batch before starting any of them, otherwise the first one would not wait for the others
+    for (std::list<RenderQueueItem>::const_iterator it = itemsToQueue.begin(); it != itemsToQueue.end(); ++it) {
+        if (it->work.batch) {
+            RenderEnginePtr engine = it->work.treeRoot->getRenderEngine();
+            engine->setRenderBatch(it->work.batch);
+            it->work.batch->addRender(engine.get(), it->work.firstFrame, it->work.lastFrame, it->work.frameStep);
+        }
+    }
+
     if (!isQueuingEnabled) {
         // Just launch everything
         for (std::list<RenderQueueItem>::const_iterator it = itemsToQueue.begin(); it != itemsToQueue.end(); ++it) {
@@ -453,6 +485,21 @@ RenderQueue::renderNonBlocking(const std::list<RenderWork>& writers)
     _imp->dispatchQueue(blocking, writers);
 }
 
+void
+RenderQueue::renderBatch(const std::list<RenderWork>& writers)
+{
+    RenderBatchPtr batch(new RenderBatch);
+    std::list<RenderWork> works = writers;
+    for (std::list<RenderWork>::iterator it = works.begin(); it != works.end(); ++it) {
+        it->batch = batch;
+    }
+
+    // Can only render non blocking if the application is not background
+    bool blocking = appPTR->isBackground();
+
+    _imp->dispatchQueue(blocking, works);
+}
+
 void
 RenderQueuePrivate::renderInternal(const RenderQueueItem& w)
 {
@@ -479,6 +526,13 @@ RenderQueue::onQueuedRenderFinished(int /*retCode*/)
     if (!engine) {
         return;
     }
+    // Do not hold back the other renders of the batch anymore
+    RenderBatchPtr batch = engine->getRenderBatch();
+    if (batch) {
+        batch->removeRender(engine);
+        engine->setRenderBatch( RenderBatchPtr() );
+    }
+
     NodePtr effect = engine->getOutput();
     if (!effect) {
         return;
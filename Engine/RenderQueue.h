@@ -79,6 +79,9 @@ public:
         // True if this request is a restart of a previous request
         bool isRestart;
 
+        // If set, all requests with the same batch are rendered concurrently in lock-step, @see RenderBatch
+        RenderBatchPtr batch;
+
         RenderWork()
         : treeRoot()
         , renderLabel()
@@ -87,6 +90,7 @@ public:
         , frameStep(INT_MIN)
         , useRenderStats(false)
         , isRestart(false)
+        , batch()
         {
         }
 
@@ -103,6 +107,7 @@ public:
         , frameStep(frameStep)
         , useRenderStats(useRenderStats)
         , isRestart(false)
+        , batch()
         {
         }
     };
@@ -142,6 +147,14 @@ public:
      **/
     void renderNonBlocking(const std::list<RenderWork>& writers);
 
+    /**
+     * @brief Renders the given write nodes concurrently, keeping them in lock-step so that the nodes they
+     * have in common are rendered once per frame, @see RenderBatch.
+     * This ignores the render queuing and separate process settings.
+     * This function blocks until all renders are finished in background mode.
+     **/
+    void renderBatch(const std::list<RenderWork>& writers);
+
     /**
      * @brief Remove from the render queue a render that was not yet started. This is useful for the GUI
      * if the user wants to cancel a render request.
@@ -26,6 +26,7 @@
 
 #include <bitset>
 #include <cassert>
+#include <sstream>
 #include <stdexcept>
 
 #include <QtCore/QMutex>
@@ -42,9 +43,18 @@ struct NodeRenderStatsPrivate
     //The accumulated time spent in the EffectInstance::renderHandler function
     double totalTimeSpentRendering;
 
+    // How the cache was accessed, see NodeRenderStats::setCacheAccessMode
+    bool cacheAccessModeSet;
+    CacheAccessModeEnum cacheAccessMode;
+    bool cacheBypassedForReuse;
+    double cacheReuseRatio;
 
     NodeRenderStatsPrivate()
     : totalTimeSpentRendering(0)
+    , cacheAccessModeSet(false)
+    , cacheAccessMode(eCacheAccessModeNone)
+    , cacheBypassedForReuse(false)
+    , cacheReuseRatio(-1)
     {
 
     }
@@ -69,6 +79,10 @@ void
 NodeRenderStats::operator=(const NodeRenderStats& other)
 {
     _imp->totalTimeSpentRendering = other._imp->totalTimeSpentRendering;
+    _imp->cacheAccessModeSet = other._imp->cacheAccessModeSet;
+    _imp->cacheAccessMode = other._imp->cacheAccessMode;
+    _imp->cacheBypassedForReuse = other._imp->cacheBypassedForReuse;
+    _imp->cacheReuseRatio = other._imp->cacheReuseRatio;
 }
 
 void
@@ -83,6 +97,65 @@ NodeRenderStats::getTotalTimeSpentRendering() const
     return _imp->totalTimeSpentRendering;
 }
 
+void
+NodeRenderStats::setCacheAccessMode(CacheAccessModeEnum mode,
+                                    bool bypassedForReuse,
+                                    double reuseRatio)
+{
+    _imp->cacheAccessModeSet = true;
+    _imp->cacheAccessMode = mode;
+    _imp->cacheBypassedForReuse = bypassedForReuse;
+    _imp->cacheReuseRatio = reuseRatio;
+}
+
+bool
+NodeRenderStats::hasCacheAccessMode() const
+{
+    return _imp->cacheAccessModeSet;
+}
+
+CacheAccessModeEnum
+NodeRenderStats::getCacheAccessMode() const
+{
+    return _imp->cacheAccessMode;
+}
+
+bool
+NodeRenderStats::isCacheBypassedForReuse() const
+{
+    return _imp->cacheBypassedForReuse;
+}
+
+double
+NodeRenderStats::getCacheReuseRatio() const
+{
+    return _imp->cacheReuseRatio;
+}
+
+std::string
+NodeRenderStats::getCacheAccessModeDescription() const
+{
+    if (!_imp->cacheAccessModeSet) {
+        return std::string();
+    }
+    std::stringstream ss;
+    switch (_imp->cacheAccessMode) {
+        case eCacheAccessModeNone:
+            ss << (_imp->cacheBypassedForReuse ? "Bypassed (rarely re-read)" : "Not cached");
+            break;
+        case eCacheAccessModeReadWrite:
+            ss << "Cached";
+            break;
+        case eCacheAccessModeWriteOnly:
+            ss << "Cached (write only)";
+            break;
+    }
+    if (_imp->cacheReuseRatio >= 0) {
+        ss << ", " << _imp->cacheReuseRatio << " reads per write";
+    }
+    return ss.str();
+} // getCacheAccessModeDescription
+
 
 struct RenderStatsPrivate
 {
@@ -163,6 +236,20 @@ RenderStats::addRenderInfosForNode(const NodePtr& node, double timeSpent)
     stats.addTimeSpentRendering(timeSpent);
 }
 
+void
+RenderStats::setCacheAccessModeForNode(const NodePtr& node,
+                                       CacheAccessModeEnum mode,
+                                       bool bypassedForReuse,
+                                       double reuseRatio)
+{
+    QMutexLocker k(&_imp->lock);
+
+    assert(_imp->doNodesProfiling);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.setCacheAccessMode(mode, bypassedForReuse, reuseRatio);
+}
+
 std::map<NodePtr, NodeRenderStats >
 RenderStats::getStats(double *totalTimeSpent) const
 {
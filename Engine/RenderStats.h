@@ -68,6 +68,22 @@ public:
     void addTimeSpentRendering(double time);
     double getTotalTimeSpentRendering() const;
 
+    /**
+     * @brief Set how the last render of the node accessed the cache. If bypassedForReuse is true, the node would
+     * have been cached but its cached outputs were measured to be rarely re-read (see CacheReuseStats).
+     * The reuse ratio is the number of reads per write measured for the node, or -1 if not measured yet.
+     **/
+    void setCacheAccessMode(CacheAccessModeEnum mode, bool bypassedForReuse, double reuseRatio);
+    bool hasCacheAccessMode() const;
+    CacheAccessModeEnum getCacheAccessMode() const;
+    bool isCacheBypassedForReuse() const;
+    double getCacheReuseRatio() const;
+
+    /**
+     * @brief Returns a human readable description of the cache access mode
+     **/
+    std::string getCacheAccessModeDescription() const;
+
 
 private:
 
@@ -94,6 +110,8 @@ public:
 
     void addRenderInfosForNode(const NodePtr& node, double timeSpent);
 
+    void setCacheAccessModeForNode(const NodePtr& node, CacheAccessModeEnum mode, bool bypassedForReuse, double reuseRatio);
+
     std::map<NodePtr, NodeRenderStats > getStats(double *totalTimeSpent) const;
 
 private:
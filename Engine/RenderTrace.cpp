@@ -0,0 +1,366 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderTrace.h"
+
+#include <list>
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QCoreApplication>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#endif
+
+#include "Engine/FStreamsSupport.h"
+#include "Engine/Knob.h"
+#include "Engine/ThreadStorage.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderTraceEvent
+{
+    const char* category;
+    const char* name;
+    std::string nodeName;
+    double frame;
+    qint64 beginUS, durationUS;
+};
+
+/**
+ * @brief The events recorded by a thread. Each thread only appends to its own buffer, the mutex
+ * is only contended when the buffers are written to disk.
+ **/
+struct RenderTraceThreadBuffer
+{
+    int threadIndex;
+    std::string threadName;
+    QMutex eventsMutex;
+    std::vector<RenderTraceEvent> events;
+
+    RenderTraceThreadBuffer()
+        : threadIndex(0)
+        , threadName()
+        , eventsMutex()
+        , events()
+    {
+    }
+};
+
+typedef boost::shared_ptr<RenderTraceThreadBuffer> RenderTraceThreadBufferPtr;
+
+struct RenderTracePrivate
+{
+    std::string filePattern;
+    bool perFrame;
+    QElapsedTimer clock;
+
+    // Buffers of all threads that recorded something, they outlive their thread
+    QMutex buffersMutex;
+    std::list<RenderTraceThreadBufferPtr> buffers;
+    ThreadStorage<RenderTraceThreadBufferPtr> threadBuffer;
+
+    // Number of render jobs whose trace was written, in per-job mode
+    QMutex jobsMutex;
+    int nJobsFinished;
+
+    RenderTracePrivate()
+        : filePattern()
+        , perFrame(false)
+        , clock()
+        , buffersMutex()
+        , buffers()
+        , threadBuffer()
+        , jobsMutex()
+        , nJobsFinished(0)
+    {
+    }
+
+    RenderTraceThreadBufferPtr getThreadBuffer();
+
+    void writeEvents(const std::string& filename, bool clearEvents);
+};
+
+// Allocated once in enable() and never freed: render threads may still record events while the process exits
+static RenderTracePrivate* gTrace = 0;
+
+bool RenderTrace::_enabled = false;
+
+void
+RenderTrace::enable(const std::string& filePattern)
+{
+    if (gTrace) {
+        return;
+    }
+    gTrace = new RenderTracePrivate;
+    gTrace->filePattern = filePattern;
+    gTrace->perFrame = filePattern.find('#') != std::string::npos;
+    gTrace->clock.start();
+    _enabled = true;
+}
+
+qint64
+RenderTrace::getTimestampUS()
+{
+    assert(gTrace);
+
+    return gTrace->clock.nsecsElapsed() / 1000;
+}
+
+RenderTraceThreadBufferPtr
+RenderTracePrivate::getThreadBuffer()
+{
+    if ( threadBuffer.hasLocalData() ) {
+        const RenderTraceThreadBufferPtr& ret = threadBuffer.localData();
+        if (ret) {
+            return ret;
+        }
+    }
+
+    RenderTraceThreadBufferPtr ret(new RenderTraceThreadBuffer);
+    QThread* thread = QThread::currentThread();
+    if (thread) {
+        ret->threadName = thread->objectName().toStdString();
+    }
+    {
+        QMutexLocker k(&buffersMutex);
+        ret->threadIndex = (int)buffers.size();
+        buffers.push_back(ret);
+    }
+    if ( ret->threadName.empty() ) {
+        std::stringstream ss;
+        ss << "Thread " << ret->threadIndex;
+        ret->threadName = ss.str();
+    }
+    threadBuffer.setLocalData(ret);
+
+    return ret;
+}
+
+void
+RenderTrace::addEvent(const char* category,
+                      const char* name,
+                      const std::string& nodeName,
+                      double frame,
+                      qint64 beginUS,
+                      qint64 endUS)
+{
+    if (!_enabled) {
+        return;
+    }
+    RenderTraceThreadBufferPtr buffer = gTrace->getThreadBuffer();
+
+    RenderTraceEvent e;
+    e.category = category;
+    e.name = name;
+    e.nodeName = nodeName;
+    e.frame = frame;
+    e.beginUS = beginUS;
+    e.durationUS = endUS - beginUS;
+
+    QMutexLocker k(&buffer->eventsMutex);
+    buffer->events.push_back(e);
+}
+
+static void
+writeJSONString(std::ostream& os,
+                const std::string& str)
+{
+    os << '"';
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        char c = str[i];
+        switch (c) {
+        case '"':
+            os << "\\\"";
+            break;
+        case '\\':
+            os << "\\\\";
+            break;
+        case '\n':
+            os << "\\n";
+            break;
+        default:
+            if ( (unsigned char)c >= 0x20 ) {
+                os << c;
+            }
+            break;
+        }
+    }
+    os << '"';
+}
+
+void
+RenderTracePrivate::writeEvents(const std::string& filename,
+                                bool clearEvents)
+{
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open(&ofile, filename);
+    if (!ofile) {
+        std::cerr << QCoreApplication::translate("RenderTrace", "Failure to write render trace file %1.").arg( QString::fromUtf8( filename.c_str() ) ).toStdString() << std::endl;
+
+        return;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    ofile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    std::list<RenderTraceThreadBufferPtr> buffersCopy;
+    {
+        QMutexLocker k(&buffersMutex);
+        buffersCopy = buffers;
+    }
+    for (std::list<RenderTraceThreadBufferPtr>::const_iterator it = buffersCopy.begin(); it != buffersCopy.end(); ++it) {
+        std::vector<RenderTraceEvent> events;
+        {
+            QMutexLocker k(&(*it)->eventsMutex);
+            if (clearEvents) {
+                events.swap( (*it)->events );
+            } else {
+                events = (*it)->events;
+            }
+        }
+
+        // Thread name metadata event
+        if (!first) {
+            ofile << ',';
+        }
+        first = false;
+        ofile << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << (*it)->threadIndex << ",\"args\":{\"name\":";
+        writeJSONString(ofile, (*it)->threadName);
+        ofile << "}}";
+
+        for (std::vector<RenderTraceEvent>::const_iterator it2 = events.begin(); it2 != events.end(); ++it2) {
+            ofile << ",\n{\"ph\":\"X\",\"cat\":\"" << it2->category << "\",\"name\":";
+            writeJSONString(ofile, it2->name);
+            ofile << ",\"pid\":" << pid << ",\"tid\":" << (*it)->threadIndex << ",\"ts\":" << it2->beginUS << ",\"dur\":" << it2->durationUS;
+            ofile << ",\"args\":{";
+            bool hasArg = false;
+            if ( !it2->nodeName.empty() ) {
+                ofile << "\"node\":";
+                writeJSONString(ofile, it2->nodeName);
+                hasArg = true;
+            }
+            if ( !boost::math::isnan(it2->frame) ) {
+                if (hasArg) {
+                    ofile << ',';
+                }
+                ofile << "\"frame\":" << it2->frame;
+            }
+            ofile << "}}";
+        }
+    }
+    ofile << "\n]}" << std::endl;
+} // writeEvents
+
+static std::string
+makeFrameFileName(const std::string& pattern,
+                  TimeValue time)
+{
+    // Replace the first sequence of '#' by the frame number, padded to the number of '#'
+    std::size_t firstHash = pattern.find('#');
+    if (firstHash == std::string::npos) {
+        return pattern;
+    }
+    std::size_t lastHash = pattern.find_first_not_of('#', firstHash);
+    if (lastHash == std::string::npos) {
+        lastHash = pattern.size();
+    }
+    std::stringstream ss;
+    ss.fill('0');
+    ss.width(lastHash - firstHash);
+    ss << (int)std::floor(time + 0.5);
+
+    std::string ret = pattern;
+    ret.replace( firstHash, lastHash - firstHash, ss.str() );
+
+    return ret;
+}
+
+static std::string
+makeJobFileName(const std::string& filename,
+                int jobIndex)
+{
+    // The first job writes to the file name as is, the next ones insert their index before the extension
+    if (jobIndex == 0) {
+        return filename;
+    }
+    std::stringstream ss;
+    ss << '.' << jobIndex;
+
+    std::string ret = filename;
+    std::size_t lastDot = ret.find_last_of('.');
+    std::size_t lastSeparator = ret.find_last_of("/\\");
+    if ( (lastDot == std::string::npos) || ( (lastSeparator != std::string::npos) && (lastDot < lastSeparator) ) ) {
+        ret.append( ss.str() );
+    } else {
+        ret.insert( lastDot, ss.str() );
+    }
+
+    return ret;
+}
+
+void
+RenderTrace::onFrameRendered(TimeValue time)
+{
+    if (!_enabled || !gTrace->perFrame) {
+        return;
+    }
+    gTrace->writeEvents(makeFrameFileName(gTrace->filePattern, time), true);
+}
+
+void
+RenderTrace::onRenderJobFinished()
+{
+    if (!_enabled || gTrace->perFrame) {
+        return;
+    }
+
+    // Each job writes its own file and clears the events it wrote, so that they do not pile up
+    // for the lifetime of the process.
+    QMutexLocker k(&gTrace->jobsMutex);
+    gTrace->writeEvents(makeJobFileName(gTrace->filePattern, gTrace->nJobsFinished), true);
+    ++gTrace->nJobsFinished;
+}
+
+void
+RenderTraceScope::finish()
+{
+    qint64 endUS = RenderTrace::getTimestampUS();
+    std::string nodeName;
+    if (_holder) {
+        nodeName = _holder->getScriptName_mt_safe();
+    }
+    RenderTrace::addEvent(_category, _name, nodeName, _frame, _beginUS, endUS);
+}
+
+NATRON_NAMESPACE_EXIT;
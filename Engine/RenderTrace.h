@@ -0,0 +1,145 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERTRACE_H
+#define NATRON_ENGINE_RENDERTRACE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+#include <limits>
+
+#include <QtCore/QtGlobal>
+
+#include "Engine/TimeValue.h"
+
+#include "Engine/EngineFwd.h"
+
+// Categories of the events recorded in the trace
+#define kRenderTraceCategoryAction "action"
+#define kRenderTraceCategoryCache "cache"
+#define kRenderTraceCategoryImage "image"
+#define kRenderTraceCategoryRender "render"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Records begin/end events of actions and cache operations for each render thread and writes them
+ * as a Chrome trace JSON file (readable by chrome://tracing or Perfetto).
+ * The trace is disabled by default and is enabled with the --render-trace command line option of NatronRenderer.
+ * When disabled, recording an event costs a single test of a boolean.
+ **/
+class RenderTrace
+{
+public:
+
+    /**
+     * @brief Enable tracing for the lifetime of the process. Must be called once, before any render is launched.
+     * If filePattern contains the '#' character, a file is written for each frame rendered, with the '#' characters
+     * replaced by the frame number. Otherwise a file is written when each render job finishes: the first job
+     * writes to filePattern and the next ones insert their index before the extension (e.g: trace.1.json).
+     **/
+    static void enable(const std::string& filePattern);
+
+    static bool isEnabled()
+    {
+        return _enabled;
+    }
+
+    /**
+     * @brief Returns the time in microseconds since tracing was enabled
+     **/
+    static qint64 getTimestampUS();
+
+    /**
+     * @brief Record an event that started at beginUS and ended at endUS. The category and name must be static strings.
+     * If frame is NaN, the event is not attributed to any frame.
+     **/
+    static void addEvent(const char* category,
+                         const char* name,
+                         const std::string& nodeName,
+                         double frame,
+                         qint64 beginUS,
+                         qint64 endUS);
+
+    /**
+     * @brief Called when a frame is done rendering. In per-frame mode, writes all the events recorded so far
+     * to the file for this frame. Note that when several frames are rendered concurrently, events of the
+     * other frames in flight are written in the same file: each action event holds the frame it was called for.
+     **/
+    static void onFrameRendered(TimeValue time);
+
+    /**
+     * @brief Called when a render job is finished. In per-job mode, writes the events recorded
+     * since the previous job finished to the file of this job, and clears them.
+     **/
+    static void onRenderJobFinished();
+
+private:
+
+    static bool _enabled;
+};
+
+/**
+ * @brief Records an event spanning the lifetime of this object.
+ **/
+class RenderTraceScope
+{
+    const char* _category;
+    const char* _name;
+    const NamedKnobHolder* _holder;
+    double _frame;
+
+    // -1 if tracing is disabled
+    qint64 _beginUS;
+
+public:
+
+    RenderTraceScope(const char* category,
+                     const char* name,
+                     const NamedKnobHolder* holder = 0,
+                     double frame = std::numeric_limits<double>::quiet_NaN())
+        : _category(category)
+        , _name(name)
+        , _holder(holder)
+        , _frame(frame)
+        , _beginUS(RenderTrace::isEnabled() ? RenderTrace::getTimestampUS() : -1)
+    {
+    }
+
+    ~RenderTraceScope()
+    {
+        if (_beginUS >= 0) {
+            finish();
+        }
+    }
+
+private:
+
+    void finish();
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERTRACE_H
@@ -0,0 +1,339 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderWorkers.h"
+
+#include <vector>
+#include <iostream>
+#include <algorithm> // max
+
+#include <QtCore/QProcess>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QStringList>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+// Time given to each worker to respond in the polling loop
+#define NATRON_RENDER_WORKERS_POLL_MS 20
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderWorker
+{
+    int index;
+
+    // The worker process
+    boost::shared_ptr<QProcess> process;
+
+    // The server the worker connects its output channel to
+    boost::shared_ptr<QLocalServer> server;
+
+    // The output channel of the worker, where it writes its progress
+    boost::shared_ptr<QLocalSocket> outputSocket;
+
+    // Connected to the input channel of the worker, once it notified us that its server is created
+    boost::shared_ptr<QLocalSocket> inputSocket;
+
+    // Progress of the worker in [0, 1]
+    double progress;
+
+    bool finished;
+    bool succeeded;
+
+    RenderWorker()
+        : index(0)
+        , process()
+        , server()
+        , outputSocket()
+        , inputSocket()
+        , progress(0.)
+        , finished(false)
+        , succeeded(false)
+    {
+    }
+};
+
+struct RenderWorkersPrivate
+{
+    Q_DECLARE_TR_FUNCTIONS(RenderWorkers)
+
+public:
+    int nWorkers;
+    std::vector<RenderWorker> workers;
+
+    RenderWorkersPrivate(int nWorkers)
+        : nWorkers(nWorkers)
+        , workers()
+    {
+    }
+
+    static QString makeServerName();
+
+    QStringList makeWorkerArgs(int index, const QString& serverName) const;
+
+    void processWorkerMessages(RenderWorker& worker);
+
+    void onWorkerFinished(RenderWorker& worker);
+
+    double getTotalProgress() const;
+};
+
+RenderWorkers::RenderWorkers(int nWorkers)
+    : _imp( new RenderWorkersPrivate(nWorkers) )
+{
+}
+
+RenderWorkers::~RenderWorkers()
+{
+}
+
+QString
+RenderWorkersPrivate::makeServerName()
+{
+    // Same naming as the pipes of ProcessHandler
+    QString tmpFileName;
+#if defined(Q_OS_WIN)
+    tmpFileName += QString::fromUtf8("//./pipe");
+    tmpFileName += QLatin1Char('/');
+    tmpFileName += QString::fromUtf8(NATRON_APPLICATION_NAME);
+    tmpFileName += QString::fromUtf8("_WORKER_SOCKET");
+#endif
+
+#if defined(Q_OS_UNIX)
+    QTemporaryFile tmpf(tmpFileName);
+    tmpf.open();
+    tmpFileName = tmpf.fileName();
+    tmpf.remove();
+#else
+    QTemporaryFile tmpf;
+    tmpf.open();
+    QString tmpFilePath = tmpf.fileName();
+    QString baseName;
+    int lastSlash = tmpFilePath.lastIndexOf( QLatin1Char('/') );
+    if ( (lastSlash != -1) && (lastSlash < tmpFilePath.size() - 1) ) {
+        baseName = tmpFilePath.mid(lastSlash + 1);
+    } else {
+        baseName = tmpFilePath;
+    }
+    tmpFileName += baseName;
+    tmpf.remove();
+#endif
+
+    return tmpFileName;
+}
+
+/**
+ * @brief Inserts .worker<index> before the extension of the given trace file name
+ **/
+static QString
+makeWorkerTraceFileName(const QString& filename,
+                        int index)
+{
+    QString suffix = QString::fromUtf8(".worker") + QString::number(index);
+    int lastDot = filename.lastIndexOf( QLatin1Char('.') );
+    int lastSeparator = std::max( filename.lastIndexOf( QLatin1Char('/') ), filename.lastIndexOf( QLatin1Char('\\') ) );
+    if ( (lastDot == -1) || (lastDot < lastSeparator) ) {
+        return filename + suffix;
+    }
+    QString ret = filename;
+    ret.insert(lastDot, suffix);
+
+    return ret;
+}
+
+QStringList
+RenderWorkersPrivate::makeWorkerArgs(int index,
+                                     const QString& serverName) const
+{
+    // Pass the command line of this process to the worker, except the options that were already
+    // applied by this process and must not be applied once per worker.
+    QStringList args = QCoreApplication::arguments();
+    if ( !args.isEmpty() ) {
+        // The executable
+        args.removeFirst();
+    }
+    for (int i = 0; i < args.size(); ) {
+        const QString& arg = args[i];
+        if ( ( arg == QString::fromUtf8("--workers") ) || ( arg == QString::fromUtf8("--worker-index") ) || ( arg == QString::fromUtf8("--IPCpipe") ) ) {
+            // Remove the option and its value
+            args.removeAt(i);
+            if ( i < args.size() ) {
+                args.removeAt(i);
+            }
+        } else if ( arg == QString::fromUtf8("--clear-cache") ) {
+            // The cache was cleared by this process before launching the workers
+            args.removeAt(i);
+        } else if ( arg == QString::fromUtf8("--render-trace") ) {
+            // Each worker writes its own trace, otherwise they would all overwrite the same file
+            ++i;
+            if ( i < args.size() ) {
+                args[i] = makeWorkerTraceFileName(args[i], index);
+                ++i;
+            }
+        } else {
+            ++i;
+        }
+    }
+    args << QString::fromUtf8("--workers") << QString::number(nWorkers);
+    args << QString::fromUtf8("--worker-index") << QString::number(index);
+    args << QString::fromUtf8("--IPCpipe") << serverName;
+
+    return args;
+}
+
+double
+RenderWorkersPrivate::getTotalProgress() const
+{
+    if ( workers.empty() ) {
+        return 0.;
+    }
+    double total = 0.;
+    for (std::vector<RenderWorker>::const_iterator it = workers.begin(); it != workers.end(); ++it) {
+        total += it->finished ? 1. : it->progress;
+    }
+
+    return total / workers.size();
+}
+
+void
+RenderWorkersPrivate::processWorkerMessages(RenderWorker& worker)
+{
+    if (!worker.outputSocket) {
+        if ( !worker.server->hasPendingConnections() ) {
+            worker.server->waitForNewConnection(NATRON_RENDER_WORKERS_POLL_MS);
+        }
+        if ( !worker.server->hasPendingConnections() ) {
+            return;
+        }
+        worker.outputSocket.reset( worker.server->nextPendingConnection() );
+        // We own the socket
+        worker.outputSocket->setParent(0);
+    }
+
+    if ( !worker.outputSocket->canReadLine() ) {
+        worker.outputSocket->waitForReadyRead(NATRON_RENDER_WORKERS_POLL_MS);
+    }
+
+    while ( worker.outputSocket->canReadLine() ) {
+        QString str = QString::fromUtf8( worker.outputSocket->readLine() );
+        while ( str.endsWith( QLatin1Char('\n') ) ) {
+            str.chop(1);
+        }
+        if ( str.startsWith( QString::fromUtf8(kBgProcessServerCreatedShort) ) ) {
+            str.remove( QString::fromUtf8(kBgProcessServerCreatedShort) );
+            // The worker wants us to connect to its input channel
+            if (!worker.inputSocket) {
+                worker.inputSocket.reset(new QLocalSocket);
+                worker.inputSocket->connectToServer(str, QLocalSocket::ReadWrite);
+                worker.inputSocket->waitForConnected(5000);
+            }
+        } else if ( str.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
+            str.remove( QString::fromUtf8(kFrameRenderedStringShort) );
+            int foundProgress = str.lastIndexOf( QString::fromUtf8(kProgressChangedStringShort) );
+            if (foundProgress != -1) {
+                QString progressStr = str.mid(foundProgress);
+                progressStr.remove( QString::fromUtf8(kProgressChangedStringShort) );
+                worker.progress = progressStr.toDouble();
+                str = str.mid(0, foundProgress);
+            }
+            std::cout << tr("Worker %1 ==> Frame: %2, Total progress: %3%")
+                .arg(worker.index)
+                .arg(str)
+                .arg(getTotalProgress() * 100, 0, 'f', 1).toStdString() << std::endl;
+        }
+        // Other messages (render started/finished) are not needed to monitor the workers
+    }
+} // processWorkerMessages
+
+void
+RenderWorkersPrivate::onWorkerFinished(RenderWorker& worker)
+{
+    // Read the last messages written before the worker quit
+    if (worker.outputSocket) {
+        processWorkerMessages(worker);
+    }
+    worker.finished = true;
+    worker.succeeded = worker.process->exitStatus() == QProcess::NormalExit && worker.process->exitCode() == 0;
+    if (!worker.succeeded) {
+        std::cerr << tr("Worker %1 failed with exit code %2.").arg(worker.index).arg( worker.process->exitCode() ).toStdString() << std::endl;
+    }
+}
+
+bool
+RenderWorkers::run()
+{
+    _imp->workers.resize(_imp->nWorkers);
+    for (int i = 0; i < _imp->nWorkers; ++i) {
+        RenderWorker& worker = _imp->workers[i];
+        worker.index = i;
+
+        QString serverName = RenderWorkersPrivate::makeServerName();
+        worker.server.reset(new QLocalServer);
+        worker.server->listen(serverName);
+
+        worker.process.reset(new QProcess);
+        // Let the output of the workers go to our standard output/error
+        worker.process->setProcessChannelMode(QProcess::ForwardedChannels);
+        worker.process->start( QCoreApplication::applicationFilePath(), _imp->makeWorkerArgs(i, serverName) );
+        if ( !worker.process->waitForStarted() ) {
+            std::cerr << tr("Failed to start worker %1.").arg(i).toStdString() << std::endl;
+            worker.finished = true;
+            worker.succeeded = false;
+        }
+    }
+
+    for (;;) {
+        bool allFinished = true;
+        for (std::vector<RenderWorker>::iterator it = _imp->workers.begin(); it != _imp->workers.end(); ++it) {
+            if (it->finished) {
+                continue;
+            }
+            _imp->processWorkerMessages(*it);
+            if ( it->process->waitForFinished(0) || (it->process->state() == QProcess::NotRunning) ) {
+                _imp->onWorkerFinished(*it);
+            } else {
+                allFinished = false;
+            }
+        }
+        if (allFinished) {
+            break;
+        }
+    }
+
+    bool ret = true;
+    for (std::vector<RenderWorker>::const_iterator it = _imp->workers.begin(); it != _imp->workers.end(); ++it) {
+        ret &= it->succeeded;
+    }
+
+    return ret;
+} // run
+
+NATRON_NAMESPACE_EXIT;
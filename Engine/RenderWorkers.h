@@ -0,0 +1,73 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_RenderWorkers_h
+#define Engine_RenderWorkers_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Launches and monitors the worker processes of a render started with the --workers command line option.
+ * Each worker is a copy of this process started with the same command line, plus the index of the worker:
+ * it loads the project and renders every N-th frame of the requested range (@see RenderQueue).
+ * Since all workers run on the same machine, they share the same cache: images produced upstream by a
+ * worker may be used by the others.
+ * Unlike a single process, plug-ins that are not thread-safe do not serialize the render of all frames
+ * since each worker holds its own instance of the plug-in.
+ *
+ * Each worker reports its progress to this process the same way a background render launched from the GUI
+ * reports to the GUI process (@see ProcessHandler and ProcessInputChannel): this process hosts a local server
+ * for each worker and the worker connects its output channel to it.
+ **/
+struct RenderWorkersPrivate;
+class RenderWorkers
+{
+public:
+
+    RenderWorkers(int nWorkers);
+
+    ~RenderWorkers();
+
+    /**
+     * @brief Launch the workers and block until they are all finished.
+     * @returns True if all workers succeeded.
+     **/
+    bool run();
+
+private:
+
+    boost::scoped_ptr<RenderWorkersPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_RenderWorkers_h
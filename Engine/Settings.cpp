@@ -131,6 +131,9 @@ public:
     KnobBoolPtr _convertNaNValues;
     KnobBoolPtr _activateRGBSupport;
     KnobBoolPtr _activateTransformConcatenationSupport;
+    KnobBoolPtr _bakeDistortions;
+    KnobDoublePtr _distortionWarpGridTolerance;
+    KnobBoolPtr _streamingRenderOnDisk;
 
     // General/GPU rendering
     KnobPagePtr _gpuPage;
@@ -178,6 +181,8 @@ public:
     // Caching
     KnobPagePtr _cachingTab;
     KnobBoolPtr _aggressiveCaching;
+    KnobBoolPtr _cacheFloatImagesAsHalf;
+    KnobIntPtr _tileSizeClass;
 
     // The total disk space allowed for all Natron's caches
     KnobIntPtr _maxDiskCacheSizeGb;
@@ -193,6 +198,10 @@ public:
     KnobBoolPtr _autoWipe;
     KnobBoolPtr _autoProxyWhenScrubbingTimeline;
     KnobChoicePtr _autoProxyLevel;
+    KnobBoolPtr _progressiveViewerPreview;
+    KnobIntPtr _speculativeRenderFrames;
+    KnobIntPtr _speculativeRenderCPUBudget;
+    KnobIntPtr _speculativeRenderCacheBudget;
     KnobIntPtr _maximumNodeViewerUIOpened;
     KnobBoolPtr _viewerKeys;
 
@@ -960,6 +969,33 @@ SettingsPrivate::initializeKnobsRendering()
                                                                "transformations.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
     _activateTransformConcatenationSupport->setName("transformCatSupport");
     _renderingPage->addKnob(_activateTransformConcatenationSupport);
+
+    _bakeDistortions = AppManager::createKnob<KnobBool>( thisShared, tr("Bake concatenated distortions") );
+    _bakeDistortions->setHintToolTip( tr("When checked, distortions concatenated with transforms or other distortions are sampled "
+                                         "on a grid that is refined until it is within the tolerance below, and the grid is interpolated "
+                                         "instead of evaluating each distortion for every pixel. This makes renders of lens distortions "
+                                         "chained with transforms much faster, at the expense of a small error.") );
+    _bakeDistortions->setName("bakeDistortions");
+    _bakeDistortions->setDefaultValue(false);
+    _bakeDistortions->setAddNewLine(false);
+    _renderingPage->addKnob(_bakeDistortions);
+
+    _distortionWarpGridTolerance = AppManager::createKnob<KnobDouble>( thisShared, tr("Tolerance") );
+    _distortionWarpGridTolerance->setHintToolTip( tr("The maximum error in pixels of the baked distortions.") );
+    _distortionWarpGridTolerance->setName("bakeDistortionsTolerance");
+    _distortionWarpGridTolerance->setRange(0.001, 10.);
+    _distortionWarpGridTolerance->setDisplayRange(0.01, 1.);
+    _distortionWarpGridTolerance->setDefaultValue(0.1);
+    _renderingPage->addKnob(_distortionWarpGridTolerance);
+
+    _streamingRenderOnDisk = AppManager::createKnob<KnobBool>( thisShared, tr("Streaming render on disk") );
+    _streamingRenderOnDisk->setHintToolTip( tr("When checked, renders on disk evaluate the image in input of the Write node in horizontal "
+                                               "bands, one after another, and the images of the intermediate nodes are not cached. "
+                                               "The memory used by a render no longer grows with the number of nodes, "
+                                               "at the expense of rendering again the borders needed by nodes such as blurs for each band.") );
+    _streamingRenderOnDisk->setName("streamingRenderOnDisk");
+    _streamingRenderOnDisk->setDefaultValue(false);
+    _renderingPage->addKnob(_streamingRenderOnDisk);
 }
 
 void
@@ -1935,6 +1971,43 @@ SettingsPrivate::initializeKnobsViewers()
 
     _viewersTab->addKnob(_autoProxyLevel);
 
+    _progressiveViewerPreview = AppManager::createKnob<KnobBool>( thisShared, tr("Show a low resolution preview first") );
+    _progressiveViewerPreview->setName("progressiveViewerPreview");
+    _progressiveViewerPreview->setHintToolTip( tr("When checked, the viewer first renders and displays the frame at the level "
+                                                  "indicated by the auto-proxy parameter, then renders it at full resolution. "
+                                                  "This gives a faster feedback on heavy compositions, at the cost of a slightly "
+                                                  "longer time to render the full resolution frame.") );
+    _progressiveViewerPreview->setDefaultValue(false);
+    _viewersTab->addKnob(_progressiveViewerPreview);
+
+    _speculativeRenderFrames = AppManager::createKnob<KnobInt>( thisShared, tr("Frames rendered ahead when idle") );
+    _speculativeRenderFrames->setName("speculativeRenderFrames");
+    _speculativeRenderFrames->setRange(0, 100);
+    _speculativeRenderFrames->disableSlider();
+    _speculativeRenderFrames->setHintToolTip( tr("When the viewer is idle, this many frames before and after the current frame "
+                                                 "are rendered in the background at the lowest thread priority and stored in the cache, so that "
+                                                 "moving to a neighbouring frame is immediate. These renders are stopped as soon as "
+                                                 "any other render starts. This is disabled (0) by default.") );
+    _speculativeRenderFrames->setDefaultValue(0);
+    _viewersTab->addKnob(_speculativeRenderFrames);
+
+    _speculativeRenderCPUBudget = AppManager::createKnob<KnobInt>( thisShared, tr("Idle rendering CPU budget (%)") );
+    _speculativeRenderCPUBudget->setName("speculativeRenderCPUBudget");
+    _speculativeRenderCPUBudget->setRange(0, 100);
+    _speculativeRenderCPUBudget->setHintToolTip( tr("A frame is rendered ahead only if less than this percentage of the "
+                                                    "render threads are busy.") );
+    _speculativeRenderCPUBudget->setDefaultValue(50);
+    _viewersTab->addKnob(_speculativeRenderCPUBudget);
+
+    _speculativeRenderCacheBudget = AppManager::createKnob<KnobInt>( thisShared, tr("Idle rendering cache budget (%)") );
+    _speculativeRenderCacheBudget->setName("speculativeRenderCacheBudget");
+    _speculativeRenderCacheBudget->setRange(0, 100);
+    _speculativeRenderCacheBudget->setHintToolTip( tr("Frames are rendered ahead only while the cache is filled below this "
+                                                      "percentage of its maximum size, so that they do not evict "
+                                                      "the images of the current frame.") );
+    _speculativeRenderCacheBudget->setDefaultValue(50);
+    _viewersTab->addKnob(_speculativeRenderCacheBudget);
+
     _maximumNodeViewerUIOpened = AppManager::createKnob<KnobInt>( thisShared, tr("Max. opened node viewer interface") );
     _maximumNodeViewerUIOpened->setName("maxNodeUiOpened");
     _maximumNodeViewerUIOpened->setRange(1, INT_MAX);
@@ -2045,6 +2118,30 @@ SettingsPrivate::initializeKnobsCaching()
 
     _cachingTab->addKnob(_aggressiveCaching);
 
+    _cacheFloatImagesAsHalf = AppManager::createKnob<KnobBool>( thisShared, tr("Cache Float Images As Half") );
+    _cacheFloatImagesAsHalf->setName("cacheFloatImagesAsHalf");
+    _cacheFloatImagesAsHalf->setHintToolTip( tr("When checked, the images rendered in 32-bit floating point by the nodes "
+                                                "are stored in the cache as 16-bit floating point (half) images. "
+                                                "This doubles the number of images that fit in the cache and halves the "
+                                                "memory bandwidth needed to read them back, at the cost of precision: "
+                                                "half has about 3 significant decimal digits and a maximum value of 65504.\n"
+                                                "Plug-ins still render and receive 32-bit floating point images.") );
+    _cacheFloatImagesAsHalf->setDefaultValue(false);
+
+    _cachingTab->addKnob(_cacheFloatImagesAsHalf);
+
+    _tileSizeClass = AppManager::createKnob<KnobInt>( thisShared, tr("Tile Size Class (-1 = Automatic)") );
+    _tileSizeClass->setName("tileSizeClass");
+    _tileSizeClass->disableSlider();
+    _tileSizeClass->setRange(-1, NATRON_TILE_SIZE_CLASSES_COUNT - 1);
+    _tileSizeClass->setHintToolTip( tr("The size of the tiles in which the images of all nodes are stored in the cache at full scale. "
+                                       "Each class doubles the size of the tiles of the previous one, the class 0 being 4KiB (32x32 pixels per channel in 32-bit floating point).\n"
+                                       "When automatic, the effects reading their inputs far beyond the pixels they render, such as blurs, "
+                                       "use larger tiles so that each tile does not read much more than itself.") );
+    _tileSizeClass->setDefaultValue(-1);
+
+    _cachingTab->addKnob(_tileSizeClass);
+
 
     _maxDiskCacheSizeGb = AppManager::createKnob<KnobInt>( thisShared, tr("Maximum Disk Cache Size (GiB)") );
     _maxDiskCacheSizeGb->setName("maxDiskCacheMb");
@@ -2645,8 +2742,9 @@ Settings::onKnobValueChanged(const KnobIPtr& k,
         appPTR->clearAllCaches();
     } else if ( ( k == _imp->_hideOptionalInputsAutomatically ) && !_imp->_restoringSettings && (reason == eValueChangedReasonUserEdited) ) {
         appPTR->toggleAutoHideGraphInputs();
-    } else if ( k == _imp->_autoProxyWhenScrubbingTimeline ) {
-        _imp->_autoProxyLevel->setSecret( !_imp->_autoProxyWhenScrubbingTimeline->getValue() );
+    } else if ( (k == _imp->_autoProxyWhenScrubbingTimeline) || (k == _imp->_progressiveViewerPreview) ) {
+        // The auto-proxy level is also the level of the viewer previews
+        _imp->_autoProxyLevel->setSecret( !_imp->_autoProxyWhenScrubbingTimeline->getValue() && !_imp->_progressiveViewerPreview->getValue() );
     }  else if ( k == _imp->_hostName ) {
         ChoiceOption hostName = _imp->_hostName->getActiveEntry();
         bool isCustom = hostName.id == NATRON_CUSTOM_HOST_NAME_ENTRY;
@@ -2761,6 +2859,30 @@ Settings::getAutoProxyMipMapLevel() const
     return (unsigned int)_imp->_autoProxyLevel->getValue() + 1;
 }
 
+bool
+Settings::isProgressiveViewerPreviewEnabled() const
+{
+    return _imp->_progressiveViewerPreview->getValue();
+}
+
+int
+Settings::getSpeculativeRenderFramesCount() const
+{
+    return _imp->_speculativeRenderFrames->getValue();
+}
+
+double
+Settings::getSpeculativeRenderCPUBudget() const
+{
+    return _imp->_speculativeRenderCPUBudget->getValue() / 100.;
+}
+
+double
+Settings::getSpeculativeRenderCacheBudget() const
+{
+    return _imp->_speculativeRenderCacheBudget->getValue() / 100.;
+}
+
 int
 Settings::getMaxOpenedNodesViewerContext() const
 {
@@ -2788,6 +2910,18 @@ Settings::isAggressiveCachingEnabled() const
     return _imp->_aggressiveCaching->getValue();
 }
 
+bool
+Settings::isCacheFloatImagesAsHalfEnabled() const
+{
+    return _imp->_cacheFloatImagesAsHalf->getValue();
+}
+
+int
+Settings::getTileSizeClass() const
+{
+    return _imp->_tileSizeClass->getValue();
+}
+
 std::size_t
 Settings::getMaximumDiskCacheSize() const
 {
@@ -3344,6 +3478,22 @@ Settings::isTransformConcatenationEnabled() const
     return _imp->_activateTransformConcatenationSupport->getValue();
 }
 
+double
+Settings::getDistortionWarpGridTolerance() const
+{
+    if ( !_imp->_bakeDistortions->getValue() ) {
+        return 0.;
+    }
+
+    return _imp->_distortionWarpGridTolerance->getValue();
+}
+
+bool
+Settings::isStreamingRenderOnDiskEnabled() const
+{
+    return _imp->_streamingRenderOnDisk->getValue();
+}
+
 bool
 Settings::isMergeAutoConnectingToAInput() const
 {
@@ -250,6 +250,11 @@ public:
     bool isAutoWipeEnabled() const;
     bool isAutoProxyEnabled() const;
     unsigned int getAutoProxyMipMapLevel() const;
+    bool isProgressiveViewerPreviewEnabled() const;
+    int getSpeculativeRenderFramesCount() const;
+    // Fractions in [0, 1]
+    double getSpeculativeRenderCPUBudget() const;
+    double getSpeculativeRenderCacheBudget() const;
     int getMaxOpenedNodesViewerContext() const;
     bool isViewerKeysEnabled() const;
     ///////////////////////////////////////////////////////
@@ -258,6 +263,14 @@ public:
 
     bool isTransformConcatenationEnabled() const;
 
+    /**
+     * @brief Returns the tolerance in pixels of the warp grids in which concatenated distortions are baked,
+     * or 0 if they should not be baked.
+     **/
+    double getDistortionWarpGridTolerance() const;
+
+    bool isStreamingRenderOnDiskEnabled() const;
+
     bool isMergeAutoConnectingToAInput() const;
 
     /**
@@ -272,6 +285,13 @@ public:
 
     bool isAggressiveCachingEnabled() const;
 
+    bool isCacheFloatImagesAsHalfEnabled() const;
+
+    /**
+     * @brief Returns the tile size class of the images cached at full scale, or -1 if it is chosen for each node
+     **/
+    int getTileSizeClass() const;
+
     bool isAutoTurboEnabled() const;
 
     void setAutoTurboModeEnabled(bool e);
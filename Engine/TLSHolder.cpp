@@ -25,6 +25,7 @@
 #include "TLSHolderImpl.h"
 
 #include <cassert>
+#include <map>
 #include <stdexcept>
 
 #include "Engine/OfxClipInstance.h"
@@ -32,6 +33,7 @@
 #include "Engine/OfxParamInstance.h"
 #include "Engine/Project.h"
 #include "Engine/ThreadPool.h"
+#include "Engine/ThreadStorage.h"
 
 #include <QtCore/QWaitCondition>
 #include <QtCore/QThread>
@@ -40,6 +42,144 @@
 
 NATRON_NAMESPACE_ENTER;
 
+// Must be a power of 2
+#define NATRON_TLS_HOLDER_THREAD_CACHE_SIZE 256
+
+struct TLSHolderThreadCacheEntry
+{
+    // 0 if the entry is not used: serials start at 1
+    U64 holderSerial;
+
+    // Points to the value stored in the per-thread data map of the holder, or NULL if the thread has no data
+    const void* data;
+};
+
+struct TLSHolderThreadCache;
+
+// The cache of each thread, so that other threads may invalidate it
+typedef std::map<const QThread*, TLSHolderThreadCache*> TLSHolderThreadCacheMap;
+static QMutex gThreadCachesMutex;
+static TLSHolderThreadCacheMap gThreadCaches;
+
+struct TLSHolderThreadCache
+{
+    TLSHolderThreadCacheEntry entries[NATRON_TLS_HOLDER_THREAD_CACHE_SIZE];
+
+    // Set by another thread that changed the TLS of this thread: the entries must be emptied before the next lookup.
+    // Only written when the TLS of this thread is copied, so reading it does not make the lookups of threads contend.
+    QAtomicInt invalidated;
+
+    const QThread* thread;
+
+    TLSHolderThreadCache()
+        : invalidated()
+        , thread( QThread::currentThread() )
+    {
+        clear();
+
+        QMutexLocker k(&gThreadCachesMutex);
+        gThreadCaches[thread] = this;
+    }
+
+    ~TLSHolderThreadCache()
+    {
+        QMutexLocker k(&gThreadCachesMutex);
+        TLSHolderThreadCacheMap::iterator found = gThreadCaches.find(thread);
+        if ( (found != gThreadCaches.end()) && (found->second == this) ) {
+            gThreadCaches.erase(found);
+        }
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < NATRON_TLS_HOLDER_THREAD_CACHE_SIZE; ++i) {
+            entries[i].holderSerial = 0;
+            entries[i].data = 0;
+        }
+    }
+};
+
+// QThreadStorage deletes the cache of a thread when it exits
+static ThreadStorage<TLSHolderThreadCache*> gThreadCache;
+
+static QMutex gHolderSerialMutex;
+static U64 gHolderSerial = 0;
+
+static U64
+generateHolderSerial()
+{
+    QMutexLocker k(&gHolderSerialMutex);
+
+    return ++gHolderSerial;
+}
+
+TLSHolderBase::TLSHolderBase()
+    : _serial( generateHolderSerial() )
+{
+}
+
+static TLSHolderThreadCacheEntry&
+getThreadCacheEntryForSerial(U64 holderSerial)
+{
+    TLSHolderThreadCache*& cache = gThreadCache.localData();
+
+    if (!cache) {
+        cache = new TLSHolderThreadCache;
+    } else if ( cache->invalidated.fetchAndAddAcquire(0) ) {
+        // Reset the flag before emptying the cache so that an invalidation made meanwhile is not lost
+        cache->invalidated.fetchAndStoreOrdered(0);
+        cache->clear();
+    }
+
+    return cache->entries[holderSerial & (NATRON_TLS_HOLDER_THREAD_CACHE_SIZE - 1)];
+}
+
+bool
+TLSHolderBase::getThreadCacheEntry(U64 holderSerial,
+                                   const void** data)
+{
+    const TLSHolderThreadCacheEntry& entry = getThreadCacheEntryForSerial(holderSerial);
+
+    if (entry.holderSerial != holderSerial) {
+        return false;
+    }
+    *data = entry.data;
+
+    return true;
+}
+
+void
+TLSHolderBase::setThreadCacheEntry(U64 holderSerial,
+                                   const void* data)
+{
+    TLSHolderThreadCacheEntry& entry = getThreadCacheEntryForSerial(holderSerial);
+
+    entry.holderSerial = holderSerial;
+    entry.data = data;
+}
+
+void
+TLSHolderBase::removeThreadCacheEntry(U64 holderSerial)
+{
+    TLSHolderThreadCacheEntry& entry = getThreadCacheEntryForSerial(holderSerial);
+
+    if (entry.holderSerial == holderSerial) {
+        entry.holderSerial = 0;
+        entry.data = 0;
+    }
+}
+
+void
+TLSHolderBase::invalidateThreadCache(const QThread* thread)
+{
+    QMutexLocker k(&gThreadCachesMutex);
+    TLSHolderThreadCacheMap::iterator found = gThreadCaches.find(thread);
+
+    // A thread without a cache has nothing to invalidate
+    if ( found != gThreadCaches.end() ) {
+        found->second->invalidated.fetchAndStoreOrdered(1);
+    }
+}
 
 AppTLS::AppTLS()
     : _objectMutex()
@@ -97,6 +237,10 @@ AppTLS::copyTLS(QThread* fromThread,
             p->copyTLS(fromThread, toThread);
         }
     }
+    // The cache of toThread may hold no data for the holders that were just copied
+    if ( toThread != QThread::currentThread() ) {
+        TLSHolderBase::invalidateThreadCache(toThread);
+    }
 }
 
 void
@@ -110,7 +254,12 @@ AppTLS::softCopy(QThread* fromThread,
     copyAbortInfo(fromThread, toThread);
 
     QWriteLocker k(&_spawnsMutex);
-    _spawns[toThread] = fromThread;
+    std::pair<ThreadSpawnMap::iterator, bool> ret = _spawns.insert( std::make_pair(toThread, fromThread) );
+    if (!ret.second) {
+        ret.first->second = fromThread;
+    }
+    // The cache of toThread may hold its data from before the spawn
+    TLSHolderBase::invalidateThreadCache(toThread);
 }
 
 void
@@ -45,6 +45,7 @@
 #include <QtCore/QReadWriteLock>
 #include <QMutex>
 #include <QtCore/QThread>
+#include <QtCore/QAtomicInt>
 
 #include "Engine/EngineFwd.h"
 
@@ -60,13 +61,36 @@ public:
     // TODO: enable_shared_from_this
     // constructors should be privatized in any class that derives from boost::enable_shared_from_this<>
 
-    TLSHolderBase() {}
+    TLSHolderBase();
 
 public:
     virtual ~TLSHolderBase() {}
 
 protected:
 
+    /**
+     * @brief Each thread has a small direct-mapped cache of the data held by the TLSHolder objects for this thread,
+     * indexed by the serial of the holder. This avoids looking up the per-thread data map of the holder under its lock
+     * for every access.
+     * The cache only ever holds what the map holds for the current thread: it must be updated by the thread itself
+     * whenever its entry in the map is inserted, replaced or removed. When another thread changes the TLS of a thread
+     * (copyTLS(), softCopy()) it must call invalidateThreadCache() so that the thread empties its cache.
+     * Returns true if the cache has an entry for the holder, in which case data is set to the data
+     * for this thread (possibly NULL if the thread has no data for the holder).
+     **/
+    static bool getThreadCacheEntry(U64 holderSerial, const void** data);
+    static void setThreadCacheEntry(U64 holderSerial, const void* data);
+    static void removeThreadCacheEntry(U64 holderSerial);
+
+    /**
+     * @brief Makes the given thread empty its cache on its next lookup, so that it goes through the per-thread data maps
+     * and copyTLSFromSpawnerThread(). Only the cache of that thread is touched, lookups of other threads are not slowed down.
+     **/
+    static void invalidateThreadCache(const QThread* thread);
+
+    // Unique identifier of this holder, never re-used even if the holder is destroyed
+    const U64 _serial;
+
     /**
      * @brief Returns true if cleanupPerThreadData would do anything OR would return true.
      * It does not return the same value as cleanupPerThreadData, since cleanupPerThreadData
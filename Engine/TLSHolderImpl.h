@@ -62,7 +62,12 @@ TLSHolder<EffectInstanceTLSData>::copyAndReturnNewTLS(const QThread* fromThread,
     ThreadData data;
     //Copy constructor
     data.value.reset( new EffectInstanceTLSData( *(found->second.value) ) );
-    perThreadData[toThread] = data;
+    ThreadData& toData = perThreadData[toThread];
+    toData = data;
+
+    if ( toThread == QThread::currentThread() ) {
+        setThreadCacheEntry( _serial, &toData.value );
+    }
 
     return data.value;
 }
@@ -124,6 +129,9 @@ TLSHolder<T>::cleanupPerThreadData(const QThread* curThread) const
     if ( found != perThreadData.end() ) {
         perThreadData.erase(found);
     }
+    if ( curThread == QThread::currentThread() ) {
+        removeThreadCacheEntry(_serial);
+    }
 
     return perThreadData.empty();
 }
@@ -132,10 +140,19 @@ template <typename T>
 boost::shared_ptr<T>
 TLSHolder<T>::getTLSData() const
 {
+    AppTLS* appTLS = appPTR->getAppTLS();
+
+    //Fast path: the map entry of this thread can only be modified by this thread, which keeps the cache up to date.
+    //If a thread is waiting to copy the TLS of its spawner, its cache was invalidated by softCopy() and it goes through copyTLSFromSpawnerThread.
+    const void* cachedData;
+    if ( getThreadCacheEntry(_serial, &cachedData) ) {
+        return cachedData ? *static_cast<const boost::shared_ptr<T>*>(cachedData) : boost::shared_ptr<T>();
+    }
+
     QThread* curThread  = QThread::currentThread();
 
     //This thread might be registered by a spawner thread, copy the TLS and attempt to find the TLS for this holder.
-    boost::shared_ptr<T> ret = appPTR->getAppTLS()->copyTLSFromSpawnerThread<T>(this, curThread);
+    boost::shared_ptr<T> ret = appTLS->copyTLSFromSpawnerThread<T>(this, curThread);
     if (ret) {
         return ret;
     }
@@ -148,6 +165,9 @@ TLSHolder<T>::getTLSData() const
         typename ThreadDataMap::const_iterator found = perThreadDataCRef.find(curThread);
         if ( found != perThreadDataCRef.end() ) {
             ret = found->second.value;
+            setThreadCacheEntry( _serial, &found->second.value );
+        } else {
+            setThreadCacheEntry(_serial, 0);
         }
     }
 
@@ -158,10 +178,18 @@ template <typename T>
 boost::shared_ptr<T>
 TLSHolder<T>::getOrCreateTLSData() const
 {
+    AppTLS* appTLS = appPTR->getAppTLS();
+
+    //Fast path, see getTLSData()
+    const void* cachedData;
+    if ( getThreadCacheEntry(_serial, &cachedData) && cachedData ) {
+        return *static_cast<const boost::shared_ptr<T>*>(cachedData);
+    }
+
     QThread* curThread  = QThread::currentThread();
 
     //This thread might be registered by a spawner thread, copy the TLS and attempt to find the TLS for this holder.
-    boost::shared_ptr<T> ret = appPTR->getAppTLS()->copyTLSFromSpawnerThread<T>(this, curThread);
+    boost::shared_ptr<T> ret = appTLS->copyTLSFromSpawnerThread<T>(this, curThread);
 
     if (ret) {
         return ret;
@@ -175,6 +203,7 @@ TLSHolder<T>::getOrCreateTLSData() const
         typename ThreadDataMap::const_iterator found = perThreadDataCRef.find(curThread);
         if ( found != perThreadDataCRef.end() ) {
             assert(found->second.value);
+            setThreadCacheEntry( _serial, &found->second.value );
 
             return found->second.value;
         }
@@ -183,11 +212,12 @@ TLSHolder<T>::getOrCreateTLSData() const
     //getOrCreateTLSData() has never been called on the thread, lookup the TLS
     ThreadData data;
     boost::shared_ptr<const TLSHolderBase> thisShared = shared_from_this();
-    appPTR->getAppTLS()->registerTLSHolder(thisShared);
+    appTLS->registerTLSHolder(thisShared);
     data.value.reset(new T);
     {
         QWriteLocker k(&perThreadDataMutex);
-        perThreadData.insert( std::make_pair(curThread, data) );
+        typename ThreadDataMap::iterator it = perThreadData.insert( std::make_pair(curThread, data) ).first;
+        setThreadCacheEntry( _serial, &it->second.value );
     }
     assert(data.value);
     return data.value;
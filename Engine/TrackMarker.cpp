@@ -704,6 +704,9 @@ TrackMarker::getMarkerImage(TimeValue time,
         args->draftMode = false;
         args->playback = false;
         args->byPassCache = false;
+        args->streaming = false;
+        args->priorityPoint = 0;
+        args->lowPriority = false;
     }
 
     std::map<ImagePlaneDesc, ImagePtr> planes;
@@ -190,6 +190,9 @@ natronImageToLibMvFloatImageForNComps(const Image::CPUTileData& source,
         case eImageBitDepthFloat:
             natronImageToLibMvFloatImageForDepth<doR, doG, doB, srcNComps, float, 1>(source, roi, mvImg);
             break;
+        case eImageBitDepthHalf:
+            natronImageToLibMvFloatImageForDepth<doR, doG, doB, srcNComps, Half, 1>(source, roi, mvImg);
+            break;
 
         default:
             assert(false);
@@ -410,6 +413,9 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
         args->draftMode = false;
         args->playback = false;
         args->byPassCache = false;
+        args->streaming = false;
+        args->priorityPoint = 0;
+        args->lowPriority = false;
     }
 
     std::map<ImagePlaneDesc, ImagePtr> planes;
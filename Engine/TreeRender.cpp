@@ -37,6 +37,7 @@
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/RotoStrokeItem.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
 #include "Engine/ThreadPool.h"
@@ -54,6 +55,43 @@ NATRON_NAMESPACE_ENTER;
 
 typedef std::set<AbortableThread*> ThreadSet;
 
+// The low priority renders being launched, aborted as soon as another render is launched
+static QMutex lowPriorityRendersMutex;
+static std::set<TreeRender*> lowPriorityRenders;
+
+/**
+ * @brief Registers a low priority render for the duration of its launch, or aborts all the
+ * low priority renders if the render is a regular one.
+ **/
+class LowPriorityRenderRegistration
+{
+    TreeRender* _render;
+
+public:
+
+    LowPriorityRenderRegistration(TreeRender* render)
+    : _render(0)
+    {
+        QMutexLocker k(&lowPriorityRendersMutex);
+        if ( render->isLowPriorityRender() ) {
+            _render = render;
+            lowPriorityRenders.insert(render);
+        } else {
+            for (std::set<TreeRender*>::const_iterator it = lowPriorityRenders.begin(); it != lowPriorityRenders.end(); ++it) {
+                (*it)->setRenderAborted();
+            }
+        }
+    }
+
+    ~LowPriorityRenderRegistration()
+    {
+        if (_render) {
+            QMutexLocker k(&lowPriorityRendersMutex);
+            lowPriorityRenders.erase(_render);
+        }
+    }
+};
+
 enum TreeRenderStateEnum
 {
     eTreeRenderStateOK,
@@ -88,6 +126,10 @@ struct TreeRenderPrivate
 
     // The RoI to render
     RectD canonicalRoI;
+
+    // The point around which rectangles are rendered first, if priorityPointSet
+    Point priorityPoint;
+    bool priorityPointSet;
     
     // The list of layers to ender
     std::list<ImagePlaneDesc> layers;
@@ -128,8 +170,11 @@ struct TreeRenderPrivate
     bool isPlayback;
     bool isDraft;
     bool byPassCache;
+    bool streaming;
+    bool lowPriority;
     bool handleNaNs;
     bool useConcatenations;
+    double distortionWarpGridTolerance;
 
 
     TreeRenderPrivate(TreeRender* publicInterface)
@@ -142,6 +187,8 @@ struct TreeRenderPrivate
     , time(0)
     , view()
     , canonicalRoI()
+    , priorityPoint()
+    , priorityPointSet(false)
     , layers()
     , proxyScale()
     , mipMapLevel(0)
@@ -159,8 +206,11 @@ struct TreeRenderPrivate
     , isPlayback(false)
     , isDraft(false)
     , byPassCache(false)
+    , streaming(false)
+    , lowPriority(false)
     , handleNaNs(true)
     , useConcatenations(true)
+    , distortionWarpGridTolerance(0.)
     {
         aborted.fetchAndStoreAcquire(0);
 
@@ -290,6 +340,18 @@ TreeRender::isByPassCacheEnabled() const
     return _imp->byPassCache;
 }
 
+bool
+TreeRender::isStreamingRender() const
+{
+    return _imp->streaming;
+}
+
+bool
+TreeRender::isLowPriorityRender() const
+{
+    return _imp->lowPriority;
+}
+
 bool
 TreeRender::isNaNHandlingEnabled() const
 {
@@ -303,6 +365,12 @@ TreeRender::isConcatenationEnabled() const
     return _imp->useConcatenations;
 }
 
+double
+TreeRender::getDistortionWarpGridTolerance() const
+{
+    return _imp->distortionWarpGridTolerance;
+}
+
 TimeValue
 TreeRender::getTime() const
 {
@@ -345,6 +413,16 @@ TreeRender::getCanonicalRoI() const
     return _imp->canonicalRoI;
 }
 
+bool
+TreeRender::getPriorityPoint(Point* point) const
+{
+    if (!_imp->priorityPointSet) {
+        return false;
+    }
+    *point = _imp->priorityPoint;
+    return true;
+}
+
 void
 TreeRender::registerThreadForRender(AbortableThread* thread)
 {
@@ -608,6 +686,10 @@ TreeRenderPrivate::init(const TreeRender::CtorArgsPtr& inArgs, const TreeRenderP
     if (inArgs->canonicalRoI) {
         canonicalRoI = *inArgs->canonicalRoI;
     }
+    if (inArgs->priorityPoint) {
+        priorityPoint = *inArgs->priorityPoint;
+        priorityPointSet = true;
+    }
     if (inArgs->layers) {
         layers = *inArgs->layers;
     }
@@ -621,7 +703,10 @@ TreeRenderPrivate::init(const TreeRender::CtorArgsPtr& inArgs, const TreeRenderP
     isPlayback = inArgs->playback;
     isDraft = inArgs->draftMode;
     byPassCache = inArgs->byPassCache;
+    streaming = inArgs->streaming;
+    lowPriority = inArgs->lowPriority;
     handleNaNs = appPTR->getCurrentSettings()->isNaNHandlingEnabled();
+    distortionWarpGridTolerance = appPTR->getCurrentSettings()->getDistortionWarpGridTolerance();
 
 
     // If abortable thread, set abort info on the thread, to make the render abortable faster
@@ -714,12 +799,15 @@ TreeRender::create(const CtorArgsPtr& inArgs)
 ActionRetCodeEnum
 TreeRender::launchRender(std::map<ImagePlaneDesc, ImagePtr>* outputPlanes)
 {
+    RenderTraceScope traceScope(kRenderTraceCategoryRender, "LaunchRender", 0, _imp->time);
 
     if (isFailureRetCode(_imp->state)) {
         appPTR->getAppTLS()->cleanupTLSForThread();
         return _imp->state;
     }
-    
+
+    LowPriorityRenderRegistration lowPriorityRegistration(this);
+
     EffectInstancePtr effectToRender = _imp->treeRoot->getEffectInstance();
     TreeRenderNodeArgsPtr rootNodeRenderArgs = _imp->rootNodeRenderArgs.lock();
     
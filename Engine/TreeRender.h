@@ -105,6 +105,19 @@ public:
 
         // Make sure each node in the tree gets rendered at least once
         bool byPassCache;
+
+        // If true, the inputs of the tree root are rendered in horizontal bands one after another
+        // and the intermediate images are not cached, see TreeRenderNodeArgs::preRenderInputImages
+        bool streaming;
+
+        // If non null, the rectangles closest to this point (in canonical coordinates) are rendered first.
+        // The viewer sets it to the point the user is looking at.
+        const Point* priorityPoint;
+
+        // If true, the render only fills the cache ahead of time (see ViewerSpeculativeFrameRenderer):
+        // its tiles are rendered at the lowest thread priority and it is aborted as soon as
+        // any other render is launched.
+        bool lowPriority;
     };
 
     typedef boost::shared_ptr<CtorArgs> CtorArgsPtr;
@@ -189,6 +202,16 @@ public:
      **/
     bool isByPassCacheEnabled() const;
 
+    /**
+     * @brief If true, the inputs of the tree root are rendered in bands and intermediate images are not cached
+     **/
+    bool isStreamingRender() const;
+
+    /**
+     * @brief If true, this render only fills the cache ahead of time and gives way to any other render
+     **/
+    bool isLowPriorityRender() const;
+
     /**
      * @brief Should nodes check for NaN pixels ?
      **/
@@ -199,6 +222,12 @@ public:
      **/
     bool isConcatenationEnabled() const;
 
+    /**
+     * @brief The tolerance in pixels of the warp grids in which concatenated distortions are baked, or 0 if
+     * the distortions must be evaluated exactly.
+     **/
+    double getDistortionWarpGridTolerance() const;
+
     /**
      * @brief Returns arguments that are specific to the given node by that remain the same throughout the render of the frame, even if multiple time/view
      * are rendered.
@@ -231,6 +260,12 @@ public:
      **/
     RectD getCanonicalRoI() const;
 
+    /**
+     * @brief Returns true if the render has a priority point and set it in canonical coordinates.
+     * Rectangles closest to this point should be rendered first.
+     **/
+    bool getPriorityPoint(Point* point) const;
+
 private Q_SLOTS:
 
     /**
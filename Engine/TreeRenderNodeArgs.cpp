@@ -24,6 +24,7 @@
 
 #include "TreeRenderNodeArgs.h"
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -137,6 +138,9 @@ struct FrameViewRequestPrivate
     // The pre-rendered input images
     PreRenderedDataMap inputImages;
 
+    // Images of this frame/view converted from the cache to the layout of a consumer
+    std::list<ImagePtr> convertedCachedImages;
+
     // The RoD of the effect at this frame/view
     GetRegionOfDefinitionResultsPtr rod;
 
@@ -155,6 +159,9 @@ struct FrameViewRequestPrivate
     // True if the frameViewHash at least is valid
     bool hashValid;
 
+    // The size class of the tiles of the cached images at mipmap level 0, -1 until computed
+    int tileSizeClass;
+
 
     FrameViewRequestPrivate()
     : lock()
@@ -163,12 +170,14 @@ struct FrameViewRequestPrivate
     , frameViewsNeeded()
     , frameViewHash(0)
     , inputImages()
+    , convertedCachedImages()
     , rod()
     , identityData()
     , neededComps()
     , distortion()
     , byPassCache()
     , hashValid(false)
+    , tileSizeClass(-1)
     {
         
     }
@@ -293,6 +302,33 @@ FrameViewRequest::clearPreRenderedInputs()
     _imp->inputImages.clear();
 } // clearPreRenderedInputs
 
+void
+FrameViewRequest::appendConvertedCachedImage(const ImagePtr& image)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->convertedCachedImages.push_back(image);
+}
+
+ImagePtr
+FrameViewRequest::getConvertedCachedImage(const ImagePlaneDesc& layer,
+                                          ImageBufferLayoutEnum bufferFormat,
+                                          ImageBitDepthEnum bitdepth,
+                                          unsigned int mipMapLevel,
+                                          const RectI& roi) const
+{
+    QMutexLocker k(&_imp->lock);
+    for (std::list<ImagePtr>::const_iterator it = _imp->convertedCachedImages.begin(); it != _imp->convertedCachedImages.end(); ++it) {
+        if ( ( (*it)->getLayer() == layer ) &&
+             ( (*it)->getBufferFormat() == bufferFormat ) &&
+             ( (*it)->getBitDepth() == bitdepth ) &&
+             ( (*it)->getMipMapLevel() == mipMapLevel ) &&
+             (*it)->getBounds().contains(roi) ) {
+            return *it;
+        }
+    }
+    return ImagePtr();
+} // getConvertedCachedImage
+
 RectD
 FrameViewRequest::getCurrentRoI() const
 {
@@ -364,6 +400,24 @@ FrameViewRequest::setHash(U64 hash)
     _imp->hashValid = true;
 }
 
+bool
+FrameViewRequest::getTileSizeClass(int* tileSizeClass) const
+{
+    QMutexLocker k(&_imp->lock);
+    if (_imp->tileSizeClass < 0) {
+        return false;
+    }
+    *tileSizeClass = _imp->tileSizeClass;
+    return true;
+}
+
+void
+FrameViewRequest::setTileSizeClass(int tileSizeClass)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->tileSizeClass = tileSizeClass;
+}
+
 
 IsIdentityResultsPtr
 FrameViewRequest::getIdentityResults() const
@@ -1039,6 +1093,52 @@ TreeRenderNodeArgs::roiVisitFunctor(TimeValue time,
     return eActionStatusOK;
 } // roiVisitFunctor
 
+void
+TreeRenderNodeArgs::clearFrameViewRoIsRecursive(std::set<TreeRenderNodeArgsPtr>* visitedNodes)
+{
+    if ( !visitedNodes->insert( shared_from_this() ).second ) {
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->lock);
+        for (NodeFrameViewRequestData::const_iterator it = _imp->frames.begin(); it != _imp->frames.end(); ++it) {
+            it->second->setCurrentRoI( RectD() );
+        }
+    }
+    for (std::size_t i = 0; i < _imp->inputRenderArgs.size(); ++i) {
+        TreeRenderNodeArgsPtr inputArgs = _imp->inputRenderArgs[i].lock();
+        if (inputArgs) {
+            inputArgs->clearFrameViewRoIsRecursive(visitedNodes);
+        }
+    }
+} // clearFrameViewRoIsRecursive
+
+ActionRetCodeEnum
+TreeRenderNodeArgs::setInputBandRoI(int inputNb,
+                                    TimeValue time,
+                                    ViewIdx view,
+                                    const RectD & canonicalBand)
+{
+    TreeRenderNodeArgsPtr inputArgs = getInputRenderArgs(inputNb);
+    if (!inputArgs) {
+        return eActionStatusInputDisconnected;
+    }
+
+    // The regions of interest upstream were merged for the whole image of the input: start over from the band.
+    // The requesters of each frame/view are kept, they do not depend on the region of interest.
+    std::set<TreeRenderNodeArgsPtr> visitedNodes;
+    inputArgs->clearFrameViewRoIsRecursive(&visitedNodes);
+
+    return inputArgs->roiVisitFunctor(time, view, canonicalBand, getNode()->getEffectInstance());
+} // setInputBandRoI
+
+// The size in bytes of an RGBA float band when streaming the render of the tree, see TreeRender::isStreamingRender().
+// The band of a node and the bands of its inputs should stay in the L2 cache while it renders.
+#define NATRON_STREAMING_BAND_SIZE_BYTES (1024 * 1024)
+
+// The minimum height in pixels of a band when streaming the render of the tree
+#define NATRON_STREAMING_MIN_BAND_HEIGHT 16
+
 struct PreRenderFrame
 {
     EffectInstancePtr caller;
@@ -1075,6 +1175,78 @@ preRenderFrameFunctor(const PreRenderFrame& args)
     return results;
 }
 
+static
+PreRenderResult
+preRenderFrameInBandsFunctor(const PreRenderFrame& args)
+{
+    EffectInstance::NotifyInputNRenderingStarted_RAII inputNIsRendering_RAII(args.caller->getNode().get(), args.inputNb);
+
+    PreRenderResult results;
+    results.renderArgs = args.renderArgs;
+    results.inputNb = args.inputNb;
+    results.stat = eActionStatusOK;
+    EffectInstancePtr inputNode = args.caller->getInput(args.inputNb);
+    const TreeRenderNodeArgsPtr& inputRenderArgs = args.renderArgs->renderArgs;
+    TreeRenderNodeArgsPtr callerRenderArgs = inputRenderArgs->getParentRender()->getNodeRenderArgs( args.caller->getNode() );
+    const RenderScale& renderCombinedScale = inputRenderArgs->getParentRender()->getProxyMipMapScale();
+    const double inputPar = inputNode->getAspectRatio(inputRenderArgs, -1);
+
+    // Size the bands so that the RGBA float bands a node reads and writes fit in the processor cache
+    const RectI& roi = args.renderArgs->roi;
+    const int bandHeight = std::max( NATRON_STREAMING_MIN_BAND_HEIGHT, (int)( NATRON_STREAMING_BAND_SIZE_BYTES / ( (std::size_t)roi.width() * 4 * sizeof(float) ) ) );
+
+    for (int y = roi.y1; y < roi.y2; y += bandHeight) {
+
+        EffectInstance::RenderRoIArgs bandArgs(*args.renderArgs);
+        bandArgs.roi.y1 = y;
+        bandArgs.roi.y2 = std::min(y + bandHeight, roi.y2);
+
+        // Each node upstream must only render what is needed for this band
+        RectD canonicalBand;
+        bandArgs.roi.toCanonical_noClipping(renderCombinedScale, inputPar, &canonicalBand);
+        results.stat = callerRenderArgs->setInputBandRoI(args.inputNb, bandArgs.time, bandArgs.view, canonicalBand);
+        if (isFailureRetCode(results.stat)) {
+            return results;
+        }
+
+        EffectInstance::RenderRoIResults bandResults;
+        results.stat = inputNode->renderRoI(bandArgs, &bandResults);
+        if (isFailureRetCode(results.stat)) {
+            return results;
+        }
+
+        // Gather the bands in an image covering the whole RoI: the band images and the intermediate images
+        // they were rendered from are released before rendering the next band.
+        for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it = bandResults.outputPlanes.begin(); it != bandResults.outputPlanes.end(); ++it) {
+            RectI bandRoI;
+            if ( !it->second || !bandArgs.roi.intersect(it->second->getBounds(), &bandRoI) ) {
+                continue;
+            }
+            ImagePtr& fullImage = results.results.outputPlanes[it->first];
+            try {
+                if (!fullImage) {
+                    Image::InitStorageArgs initArgs;
+                    initArgs.bounds = roi;
+                    initArgs.bitdepth = it->second->getBitDepth();
+                    initArgs.layer = it->first;
+                    initArgs.proxyScale = it->second->getProxyScale();
+                    initArgs.mipMapLevel = it->second->getMipMapLevel();
+                    initArgs.renderArgs = args.renderArgs->renderArgs;
+                    fullImage = Image::create(initArgs);
+                }
+                Image::CopyPixelsArgs cpyArgs;
+                cpyArgs.roi = bandRoI;
+                fullImage->copyPixels(*it->second, cpyArgs);
+            } catch (const std::bad_alloc &) {
+                results.stat = eActionStatusOutOfMemory;
+                return results;
+            }
+        }
+    }
+
+    return results;
+} // preRenderFrameInBandsFunctor
+
 ActionRetCodeEnum
 TreeRenderNodeArgs::preRenderInputImages(TimeValue time,
                                          ViewIdx view,
@@ -1210,30 +1382,42 @@ TreeRenderNodeArgs::preRenderInputImages(TimeValue time,
         return eActionStatusOK;
     }
 
-    // Launch all pre-renders in concurrent threads using the global thread pool.
-    // If the current thread is a thread-pool thread, make it also do an iteration instead
-    // of waiting for other threads
-    bool isThreadPoolThread = isRunningInThreadPoolThread();
-    PreRenderFrame currentThreadPreRender;
+    std::vector<PreRenderResult> allResults;
 
-    if (isThreadPoolThread) {
-        currentThreadPreRender = preRenderFrames.back();
-        preRenderFrames.pop_back();
-    }
+    if ( getParentRender()->isStreamingRender() && (getParentRender()->getTreeRoot() == node) ) {
+        // Render each input image in bands, one image after another: each band is itself rendered
+        // with multiple threads and only one band of each intermediate image is alive at once.
+        for (std::size_t i = 0; i < preRenderFrames.size(); ++i) {
+            allResults.push_back( preRenderFrameInBandsFunctor(preRenderFrames[i]) );
+            if ( isFailureRetCode(allResults.back().stat) || isRenderAborted() ) {
+                break;
+            }
+        }
+    } else {
+        // Launch all pre-renders in concurrent threads using the global thread pool.
+        // If the current thread is a thread-pool thread, make it also do an iteration instead
+        // of waiting for other threads
+        bool isThreadPoolThread = isRunningInThreadPoolThread();
+        PreRenderFrame currentThreadPreRender;
+
+        if (isThreadPoolThread) {
+            currentThreadPreRender = preRenderFrames.back();
+            preRenderFrames.pop_back();
+        }
 
-    std::vector<PreRenderResult> allResults;
-    QFuture<PreRenderResult> future = QtConcurrent::mapped(preRenderFrames, boost::bind(&preRenderFrameFunctor, _1));
+        QFuture<PreRenderResult> future = QtConcurrent::mapped(preRenderFrames, boost::bind(&preRenderFrameFunctor, _1));
 
-    if (isThreadPoolThread) {
-        PreRenderResult thisThreadResults = preRenderFrameFunctor(currentThreadPreRender);
-        allResults.push_back(thisThreadResults);
-    }
+        if (isThreadPoolThread) {
+            PreRenderResult thisThreadResults = preRenderFrameFunctor(currentThreadPreRender);
+            allResults.push_back(thisThreadResults);
+        }
 
-    // Wait for other threads to be finished
-    future.waitForFinished();
+        // Wait for other threads to be finished
+        future.waitForFinished();
 
-    for (QFuture<PreRenderResult>::const_iterator it = future.begin(); it != future.end(); ++it) {
-        allResults.push_back(*it);
+        for (QFuture<PreRenderResult>::const_iterator it = future.begin(); it != future.end(); ++it) {
+            allResults.push_back(*it);
+        }
     }
 
     // Check if we are aborted
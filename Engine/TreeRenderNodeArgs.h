@@ -139,6 +139,22 @@ public:
      **/
     void clearPreRenderedInputs();
 
+    /**
+     * @brief Holds an image of this frame/view converted from its cache image (mono-channel tiles) to the layout
+     * and bit depth of a consumer, so that the other consumers wanting the same layout get it without
+     * converting the cached tiles again.
+     **/
+    void appendConvertedCachedImage(const ImagePtr& image);
+
+    /**
+     * @brief Returns an image appended with appendConvertedCachedImage with the given properties that contains the roi, if any.
+     **/
+    ImagePtr getConvertedCachedImage(const ImagePlaneDesc& layer,
+                                     ImageBufferLayoutEnum bufferFormat,
+                                     ImageBitDepthEnum bitdepth,
+                                     unsigned int mipMapLevel,
+                                     const RectI& roi) const;
+
 
 
     /**
@@ -185,6 +201,16 @@ public:
      **/
     void setHash(U64 hash);
 
+    /**
+     * @brief Returns the size class of the tiles of the cached images of this frame/view at mipmap level 0, if it was computed
+     **/
+    bool getTileSizeClass(int* tileSizeClass) const;
+
+    /**
+     * @brief Set the size class of the tiles of the cached images of this frame/view at mipmap level 0
+     **/
+    void setTileSizeClass(int tileSizeClass);
+
     /**
      * @brief Returns the identity action results for this frame/view
      **/
@@ -404,6 +430,17 @@ public:
                                       const RectD & canonicalRenderWindow,
                                       const EffectInstancePtr& caller);
 
+    /**
+     * @brief Recompute the regions of interest of the nodes upstream of the given input for a band of the image of this input,
+     * as if roiVisitFunctor had been called with the band only. This is used when streaming the render
+     * (see TreeRender::isStreamingRender()) so that each upstream node renders only the part of its image needed
+     * for the band, plus the margins added by the regions of interest of the nodes in-between.
+     **/
+    ActionRetCodeEnum setInputBandRoI(int inputNb,
+                                      TimeValue time,
+                                      ViewIdx view,
+                                      const RectD & canonicalBand);
+
 
     /**
      * @brief Recurse on inputs of the current node using the results of getFramesNeeded
@@ -416,6 +453,11 @@ public:
 
 private:
 
+    /**
+     * @brief Clear the regions of interest of all frame/view requests of this node and of the nodes upstream.
+     **/
+    void clearFrameViewRoIsRecursive(std::set<TreeRenderNodeArgsPtr>* visitedNodes);
+
     boost::scoped_ptr<TreeRenderNodeArgsPrivate> _imp;
 };
 
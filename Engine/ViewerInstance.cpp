@@ -840,6 +840,7 @@ findAutoContrastVminVmax(const Image::CPUTileData& colorImage,
         case eImageBitDepthFloat:
             return findAutoContrastVminVmaxForDepth<float, 1>(colorImage, renderArgs, channels, roi);
         case eImageBitDepthHalf:
+            return findAutoContrastVminVmaxForDepth<Half, 1>(colorImage, renderArgs, channels, roi);
         case eImageBitDepthNone:
             return MinMaxVal(0,0);
         case eImageBitDepthShort:
@@ -947,9 +948,9 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
 
     // If the image has a color space, convert to linear float first
     if (args.srcColorspace) {
-        tmpPix[0] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[0]);
-        tmpPix[1] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[1]);
-        tmpPix[2] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[2]);
+        tmpPix[0] = args.srcColorspace->fromColorSpaceFloatToLinearFloatFast(tmpPix[0]);
+        tmpPix[1] = args.srcColorspace->fromColorSpaceFloatToLinearFloatFast(tmpPix[1]);
+        tmpPix[2] = args.srcColorspace->fromColorSpaceFloatToLinearFloatFast(tmpPix[2]);
     }
 
 
@@ -982,7 +983,7 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
             *alphaMatteValue = Image::convertPixelDepth<PIX, float>(*alpha_pixels[args.alphaChannelIndex]);
             // If the image has a color space, convert to linear float first
             if (args.srcColorspace) {
-                *alphaMatteValue = args.srcColorspace->fromColorSpaceFloatToLinearFloat(*alphaMatteValue);
+                *alphaMatteValue = args.srcColorspace->fromColorSpaceFloatToLinearFloatFast(*alphaMatteValue);
             }
         }
     }
@@ -1153,7 +1154,7 @@ applyViewerProcess8bit(const RenderViewerArgs& args, const RectI & roi)
             applyViewerProcess8bitForDepth<unsigned short, 65535>(args, roi);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            applyViewerProcess8bitForDepth<Half, 1>(args, roi);
             break;
         case eImageBitDepthNone:
             break;
@@ -1282,7 +1283,7 @@ applyViewerProcess32bit(const RenderViewerArgs& args, const RectI & roi)
             applyViewerProcess32bitForDepth<unsigned short, 65535>(args, roi);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            applyViewerProcess32bitForDepth<Half, 1>(args, roi);
             break;
         case eImageBitDepthNone:
             break;
@@ -96,6 +96,8 @@ namespace NATRON_PYTHON_NAMESPACE { }
 // - tools/linux/include/qs/natron.qs
 #define NATRON_PROJECT_FILE_EXT "ntp"
 #define NATRON_PROJECT_FILE_HEADER "# Natron Project File"
+#define NATRON_PROJECT_AUTOSAVE_JOURNAL_EXT "journal"
+#define NATRON_PROJECT_AUTOSAVE_JOURNAL_ENTRY_HEADER "# Natron Auto-Save Journal Entry"
 #define NATRON_PROJECT_FILE_MIME_TYPE "application/vnd.natron.project"
 #define NATRON_PROJECT_UNTITLED "Untitled." NATRON_PROJECT_FILE_EXT
 #define NATRON_CACHE_FILE_EXT "ntc"
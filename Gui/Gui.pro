@@ -220,6 +220,7 @@ SOURCES += \
     VerticalColorBar.cpp \
     ViewerGL.cpp \
     ViewerGLPrivate.cpp \
+    ViewerTextureUpload.cpp \
     ViewerTab.cpp \
     ViewerTab10.cpp \
     ViewerTabOverlays.cpp \
@@ -362,6 +363,7 @@ HEADERS += \
     VerticalColorBar.h \
     ViewerGL.h \
     ViewerGLPrivate.h \
+    ViewerTextureUpload.h \
     ViewerTab.h \
     ViewerTabPrivate.h \
     ViewerToolButton.h \
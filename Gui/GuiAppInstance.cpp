@@ -431,6 +431,10 @@ GuiAppInstance::findAndTryLoadUntitledAutoSave()
         if (suffixPos == -1) {
             continue;
         }
+        // Journals are replayed when loading the auto-save they belong to
+        if ( entry.endsWith( QLatin1Char('.') + QString::fromUtf8(NATRON_PROJECT_AUTOSAVE_JOURNAL_EXT) ) ) {
+            continue;
+        }
 
         foundAutosaves << entry;
     }
@@ -1058,9 +1058,10 @@ GuiApplicationManager::getKnobClipBoard(KnobClipBoardType *type,
 
 void
 GuiApplicationManager::appendTaskToPreviewThread(const NodeGuiPtr& node,
-                                                 TimeValue time)
+                                                 TimeValue time,
+                                                 bool visibleInViewport)
 {
-    _imp->previewRenderThread.appendToQueue(node, time);
+    _imp->previewRenderThread.appendToQueue(node, time, visibleInViewport);
 }
 
 int
@@ -140,7 +140,7 @@ public:
 
     bool handleImageFileOpenRequest(const std::string& imageFile);
 
-    void appendTaskToPreviewThread(const NodeGuiPtr& node, TimeValue time);
+    void appendTaskToPreviewThread(const NodeGuiPtr& node, TimeValue time, bool visibleInViewport);
 
     int getDocumentationServerPort();
 
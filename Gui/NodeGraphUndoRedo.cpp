@@ -33,6 +33,11 @@ CLANG_DIAG_OFF(uninitialized)
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/AppInstance.h"
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/GroupInput.h"
 #include "Engine/GroupOutput.h"
@@ -1063,6 +1068,7 @@ DisableNodesCommand::DisableNodesCommand(const std::list<NodeGuiPtr > & nodes,
 void
 DisableNodesCommand::undo()
 {
+    KnobChangesTransaction_RAII transaction( _nodes.empty() ? AppInstancePtr() : _nodes.front().lock()->getNode()->getApp() );
     for (std::list<boost::weak_ptr<NodeGui> >::iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
         it->lock()->getNode()->setNodeDisabled(false);
     }
@@ -1072,6 +1078,7 @@ DisableNodesCommand::undo()
 void
 DisableNodesCommand::redo()
 {
+    KnobChangesTransaction_RAII transaction( _nodes.empty() ? AppInstancePtr() : _nodes.front().lock()->getNode()->getApp() );
     for (std::list<boost::weak_ptr<NodeGui> >::iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
         it->lock()->getNode()->setNodeDisabled(true);
     }
@@ -1091,6 +1098,7 @@ EnableNodesCommand::EnableNodesCommand(const std::list<NodeGuiPtr > & nodes,
 void
 EnableNodesCommand::undo()
 {
+    KnobChangesTransaction_RAII transaction( _nodes.empty() ? AppInstancePtr() : _nodes.front().lock()->getNode()->getApp() );
     for (std::list<boost::weak_ptr<NodeGui> >::iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
         it->lock()->getNode()->setNodeDisabled(true);
     }
@@ -1100,6 +1108,7 @@ EnableNodesCommand::undo()
 void
 EnableNodesCommand::redo()
 {
+    KnobChangesTransaction_RAII transaction( _nodes.empty() ? AppInstancePtr() : _nodes.front().lock()->getNode()->getApp() );
     for (std::list<boost::weak_ptr<NodeGui> >::iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
         it->lock()->getNode()->setNodeDisabled(false);
     }
@@ -1918,6 +1927,7 @@ RestoreNodeToDefaultCommand::~RestoreNodeToDefaultCommand()
 void
 RestoreNodeToDefaultCommand::undo()
 {
+    boost::scoped_ptr<KnobChangesTransaction_RAII> transaction;
     for (std::list<NodeDefaults>::const_iterator it = _nodes.begin(); it!=_nodes.end(); ++it) {
         NodeGuiPtr node = it->node.lock();
         if (!node) {
@@ -1927,6 +1937,9 @@ RestoreNodeToDefaultCommand::undo()
         if (!internalNode) {
             continue;
         }
+        if (!transaction) {
+            transaction.reset( new KnobChangesTransaction_RAII( internalNode->getApp() ) );
+        }
         internalNode->loadKnobsFromSerialization(*it->serialization);
     }
 }
@@ -1934,6 +1947,7 @@ RestoreNodeToDefaultCommand::undo()
 void
 RestoreNodeToDefaultCommand::redo()
 {
+    boost::scoped_ptr<KnobChangesTransaction_RAII> transaction;
     for (std::list<NodeDefaults>::const_iterator it = _nodes.begin(); it!=_nodes.end(); ++it) {
         NodeGuiPtr node = it->node.lock();
         if (!node) {
@@ -1943,6 +1957,9 @@ RestoreNodeToDefaultCommand::redo()
         if (!internalNode) {
             continue;
         }
+        if (!transaction) {
+            transaction.reset( new KnobChangesTransaction_RAII( internalNode->getApp() ) );
+        }
         internalNode->restoreNodeToDefaultState(CreateNodeArgsPtr());
     }
 }
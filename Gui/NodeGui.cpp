@@ -1229,6 +1229,16 @@ NodeGui::markInputNull(Edge* e)
     }
 }
 
+bool
+NodeGui::isVisibleInNodeGraphViewport() const
+{
+    if (!_graph) {
+        return false;
+    }
+
+    return _graph->visibleSceneRect().intersects( sceneBoundingRect() );
+}
+
 void
 NodeGui::updatePreviewImage(TimeValue time)
 {
@@ -1244,7 +1254,7 @@ NodeGui::updatePreviewImage(TimeValue time)
 
         NodeGuiPtr thisShared = shared_from_this();
         assert(thisShared);
-        appPTR->appendTaskToPreviewThread(thisShared, time);
+        appPTR->appendTaskToPreviewThread(thisShared, time, isVisibleInNodeGraphViewport());
     }
 }
 
@@ -1265,7 +1275,7 @@ NodeGui::forceComputePreview(TimeValue time)
         ensurePreviewCreated();
         NodeGuiPtr thisShared = shared_from_this();
         assert(thisShared);
-        appPTR->appendTaskToPreviewThread(thisShared, time);
+        appPTR->appendTaskToPreviewThread(thisShared, time, isVisibleInNodeGraphViewport());
     }
 }
 
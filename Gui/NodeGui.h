@@ -178,6 +178,11 @@ public:
     virtual bool isSettingsPanelMinimized() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     void getPosition(double *x, double* y) const;
     void getSize(double* w, double* h) const;
+
+    /**
+     * @brief Returns true if the node intersects the visible part of the NodeGraph. Used to prioritize previews.
+     **/
+    bool isVisibleInNodeGraphViewport() const;
     void getColor(double* r, double *g, double* b) const;
 
     virtual void setPosition(double x, double y) OVERRIDE FINAL;
@@ -25,7 +25,10 @@
 #include "PreviewThread.h"
 
 #include <list>
+#include <map>
+#include <set>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <cstring> // for std::memcpy, std::memset
 
@@ -36,37 +39,98 @@
 #include "Gui/NodeGui.h"
 
 #include "Engine/Node.h"
+#include "Engine/Timer.h"
 
+// Amount of time (in milliseconds) without any new preview request after which pending previews are rendered.
+// This avoids rendering a preview for each intermediate value of a slider drag.
+#define NATRON_PREVIEW_DEBOUNCE_MS 150
+
+// Maximum amount of time (in milliseconds) a preview request waits, so that previews are still refreshed
+// while the user keeps editing a parameter continuously.
+#define NATRON_PREVIEW_MAX_WAIT_MS (4 * NATRON_PREVIEW_DEBOUNCE_MS)
 
 NATRON_NAMESPACE_ENTER;
 
-class ComputePreviewRequest
-    : public GenericThreadStartArgs
+struct PendingPreviewRequest
 {
-public:
-
     TimeValue time;
-    NodeGuiWPtr node;
+    bool visibleInViewport;
 
-    ComputePreviewRequest()
-        : GenericThreadStartArgs()
-        , time(0)
-        , node()
+    PendingPreviewRequest()
+        : time(0)
+        , visibleInViewport(false)
     {}
+};
 
-    virtual ~ComputePreviewRequest()
-    {
-    }
+// Indexed by NodeGui: successive requests on the same node are coalesced
+typedef std::map<NodeGuiWPtr, PendingPreviewRequest> PendingPreviewsMap;
+
+/**
+ * @brief A set of previews that can be computed with a single tree render: the root is the most
+ * downstream pending node, the other nodes are pending nodes upstream of it. Once the root has rendered,
+ * the images of the upstream nodes whose preview is rendered at the same mipmap level are in the cache.
+ **/
+struct PreviewBranch
+{
+    NodeGuiPtr root;
+    std::list<NodeGuiPtr> upstreamNodes;
+    TimeValue time;
+    bool visibleInViewport;
+};
+
+struct ResolvedPreviewRequest
+{
+    NodeGuiPtr gui;
+    NodePtr node;
+    PendingPreviewRequest request;
+    std::set<NodePtr> downstream;
+    PreviewBranch* branch;
 };
 
 struct PreviewThreadPrivate
 {
     std::vector<unsigned int> data;
 
+    // Protects pendingPreviews, lastRequestTimer and firstRequestTimer
+    QMutex pendingPreviewsMutex;
+    PendingPreviewsMap pendingPreviews;
+
+    // Reset each time a preview is requested
+    TimeLapse lastRequestTimer;
+
+    // Reset when a preview is requested while none is pending
+    TimeLapse firstRequestTimer;
+
     PreviewThreadPrivate()
         : data( NATRON_PREVIEW_HEIGHT * NATRON_PREVIEW_WIDTH * sizeof(unsigned int) )
+        , pendingPreviewsMutex()
+        , pendingPreviews()
+        , lastRequestTimer()
+        , firstRequestTimer()
+    {
+    }
+
+    /**
+     * @brief Returns how long to wait (in milliseconds) before rendering the pending previews: until no new request
+     * was made for NATRON_PREVIEW_DEBOUNCE_MS, but no longer than NATRON_PREVIEW_MAX_WAIT_MS after the oldest pending request.
+     **/
+    double getRemainingWaitMS()
     {
+        QMutexLocker k(&pendingPreviewsMutex);
+        double debounceWaitMS = NATRON_PREVIEW_DEBOUNCE_MS - lastRequestTimer.getTimeSinceCreation() * 1000.;
+        double maxWaitMS = NATRON_PREVIEW_MAX_WAIT_MS - firstRequestTimer.getTimeSinceCreation() * 1000.;
+        return std::min(debounceWaitMS, maxWaitMS);
     }
+
+    bool isPending(const NodeGuiPtr& node)
+    {
+        QMutexLocker k(&pendingPreviewsMutex);
+        return pendingPreviews.find(node) != pendingPreviews.end();
+    }
+
+    void buildBranches(const PendingPreviewsMap& requests, std::list<PreviewBranch>* branches);
+
+    void renderPreview(const NodeGuiPtr& node, TimeValue time);
 };
 
 PreviewThread::PreviewThread()
@@ -84,49 +148,194 @@ PreviewThread::~PreviewThread()
 
 void
 PreviewThread::appendToQueue(const NodeGuiPtr& node,
-                             TimeValue time)
+                             TimeValue time,
+                             bool visibleInViewport)
 {
-    boost::shared_ptr<ComputePreviewRequest> r( new ComputePreviewRequest() );
+    {
+        QMutexLocker k(&_imp->pendingPreviewsMutex);
+        if ( _imp->pendingPreviews.empty() ) {
+            _imp->firstRequestTimer = TimeLapse();
+        }
+        PendingPreviewRequest& r = _imp->pendingPreviews[node];
+        r.time = time;
+        r.visibleInViewport = visibleInViewport;
+        _imp->lastRequestTimer = TimeLapse();
+    }
 
-    r->node = node;
-    r->time = time;
-    startTask(r);
+    // The task itself does not hold anything, it just wakes up the thread
+    startTask( GenericThreadStartArgsPtr( new GenericThreadStartArgs() ) );
 }
 
-GenericSchedulerThread::ThreadStateEnum
-PreviewThread::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
+static void
+getNodesDownstreamRecursive(const NodePtr& node,
+                            std::set<NodePtr>* visited)
 {
-    boost::shared_ptr<ComputePreviewRequest> args = boost::dynamic_pointer_cast<ComputePreviewRequest>(inArgs);
+    NodesList outputs;
+    node->getOutputsWithGroupRedirection(outputs);
+    for (NodesList::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+        if ( visited->insert(*it).second ) {
+            getNodesDownstreamRecursive(*it, visited);
+        }
+    }
+}
 
-    assert(args);
+void
+PreviewThreadPrivate::buildBranches(const PendingPreviewsMap& requests,
+                                    std::list<PreviewBranch>* branches)
+{
+    std::vector<ResolvedPreviewRequest> resolved;
+    for (PendingPreviewsMap::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+        ResolvedPreviewRequest r;
+        r.gui = it->first.lock();
+        if (!r.gui) {
+            continue;
+        }
+        r.node = r.gui->getNode();
+        if (!r.node) {
+            continue;
+        }
+        r.request = it->second;
+        r.branch = 0;
+        getNodesDownstreamRecursive(r.node, &r.downstream);
+        resolved.push_back(r);
+    }
 
+    // A request is the root of a branch if no other request at the same time is downstream of it
+    std::vector<bool> isRoot( resolved.size() );
+    for (std::size_t i = 0; i < resolved.size(); ++i) {
+        isRoot[i] = true;
+        for (std::size_t j = 0; j < resolved.size(); ++j) {
+            if ( (i != j) && (resolved[i].request.time == resolved[j].request.time) && ( resolved[i].downstream.find(resolved[j].node) != resolved[i].downstream.end() ) ) {
+                isRoot[i] = false;
+                break;
+            }
+        }
+        if (isRoot[i]) {
+            PreviewBranch b;
+            b.root = resolved[i].gui;
+            b.time = resolved[i].request.time;
+            b.visibleInViewport = resolved[i].request.visibleInViewport;
+            branches->push_back(b);
+            resolved[i].branch = &branches->back();
+        }
+    }
 
-    NodeGuiPtr node = args->node.lock();
-    if (node) {
+    // Attach other requests to a root downstream, preferably one that is visible
+    for (std::size_t i = 0; i < resolved.size(); ++i) {
+        if (isRoot[i]) {
+            continue;
+        }
+        PreviewBranch* branch = 0;
+        for (std::size_t j = 0; j < resolved.size(); ++j) {
+            if ( !isRoot[j] || (resolved[i].request.time != resolved[j].request.time) || ( resolved[i].downstream.find(resolved[j].node) == resolved[i].downstream.end() ) ) {
+                continue;
+            }
+            if ( !branch || (!branch->visibleInViewport && resolved[j].branch->visibleInViewport) ) {
+                branch = resolved[j].branch;
+            }
+        }
+        assert(branch);
+        if (!branch) {
+            continue;
+        }
+        branch->upstreamNodes.push_back(resolved[i].gui);
+        branch->visibleInViewport |= resolved[i].request.visibleInViewport;
+    }
 
-        //process the request if valid
-        int w = NATRON_PREVIEW_WIDTH;
-        int h = NATRON_PREVIEW_HEIGHT;
+    // Branches visible in the NodeGraph viewport are rendered first
+    std::list<PreviewBranch> visibleBranches, hiddenBranches;
+    for (std::list<PreviewBranch>::const_iterator it = branches->begin(); it != branches->end(); ++it) {
+        if (it->visibleInViewport) {
+            visibleBranches.push_back(*it);
+        } else {
+            hiddenBranches.push_back(*it);
+        }
+    }
+    branches->clear();
+    branches->insert( branches->end(), visibleBranches.begin(), visibleBranches.end() );
+    branches->insert( branches->end(), hiddenBranches.begin(), hiddenBranches.end() );
+} // buildBranches
 
-        //set buffer to 0
+void
+PreviewThreadPrivate::renderPreview(const NodeGuiPtr& node,
+                                    TimeValue time)
+{
+    int w = NATRON_PREVIEW_WIDTH;
+    int h = NATRON_PREVIEW_HEIGHT;
+
+    //set buffer to 0
 #ifndef __NATRON_WIN32__
-        std::memset( &_imp->data.front(), 0, _imp->data.size() * sizeof(unsigned int) );
+    std::memset( &data.front(), 0, data.size() * sizeof(unsigned int) );
 #else
-        for (std::size_t i = 0; i < _imp->data.size(); ++i) {
-            _imp->data[i] = qRgba(0, 0, 0, 255);
-        }
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = qRgba(0, 0, 0, 255);
+    }
 #endif
-        NodePtr internalNode = node->getNode();
-        if (internalNode) {
-            bool ok = internalNode->makePreviewImage( args->time, &w, &h, &_imp->data.front() );
-            Q_UNUSED(ok);
-            node->copyPreviewImageBuffer(_imp->data, w, h);
+    NodePtr internalNode = node->getNode();
+    if (internalNode) {
+        bool ok = internalNode->makePreviewImage( time, &w, &h, &data.front() );
+        Q_UNUSED(ok);
+        node->copyPreviewImageBuffer(data, w, h);
+    }
+}
+
+GenericSchedulerThread::ThreadStateEnum
+PreviewThread::threadLoopOnce(const GenericThreadStartArgsPtr& /*inArgs*/)
+{
+    // Wait until no new request was made for NATRON_PREVIEW_DEBOUNCE_MS, or the oldest request waited NATRON_PREVIEW_MAX_WAIT_MS
+    for (;;) {
+        double remainingMS = _imp->getRemainingWaitMS();
+        if (remainingMS <= 0) {
+            break;
+        }
+        ThreadStateEnum state = resolveState();
+        if (state != eThreadStateActive) {
+            return state;
+        }
+        msleep( std::max(1, (int)remainingMS) );
+    }
+
+    PendingPreviewsMap requests;
+    {
+        QMutexLocker k(&_imp->pendingPreviewsMutex);
+        requests.swap(_imp->pendingPreviews);
+    }
+    if ( requests.empty() ) {
+        return eThreadStateActive;
+    }
+
+    std::list<PreviewBranch> branches;
+    _imp->buildBranches(requests, &branches);
+
+    for (std::list<PreviewBranch>::const_iterator it = branches.begin(); it != branches.end(); ++it) {
+        ThreadStateEnum state = resolveState();
+        if (state != eThreadStateActive) {
+            return state;
+        }
+
+        // If the root was requested again meanwhile, it will be processed by the next loop with the most recent time
+        if ( _imp->isPending(it->root) ) {
+            continue;
         }
 
+        // Render the root first so that it fills the cache with the images that upstream previews
+        // rendered at the same mipmap level will need. Each preview is rendered at the mipmap level
+        // that fits its own region of definition in the preview.
+        _imp->renderPreview(it->root, it->time);
+
+        for (std::list<NodeGuiPtr>::const_iterator it2 = it->upstreamNodes.begin(); it2 != it->upstreamNodes.end(); ++it2) {
+            state = resolveState();
+            if (state != eThreadStateActive) {
+                return state;
+            }
+            if ( _imp->isPending(*it2) ) {
+                continue;
+            }
+            _imp->renderPreview(*it2, it->time);
+        }
     }
 
     return eThreadStateActive;
 } // PreviewThread::threadLoopOnce
 
 NATRON_NAMESPACE_EXIT;
-
@@ -51,13 +51,22 @@ public:
 
     virtual ~PreviewThread();
 
-    void appendToQueue(const NodeGuiPtr& node, TimeValue time);
+    /**
+     * @brief Requests the preview of the given node to be refreshed at the given time.
+     * Requests are not processed immediately: they are debounced so that a slider drag
+     * does not trigger a render for each intermediate value, and successive requests for
+     * the same node are coalesced into a single one for the most recent time.
+     * @param visibleInViewport If true, the node is currently visible in the NodeGraph
+     * and its preview will be processed before the previews of nodes that are not.
+     **/
+    void appendToQueue(const NodeGuiPtr& node, TimeValue time, bool visibleInViewport);
 
 private:
 
     virtual TaskQueueBehaviorEnum tasksQueueBehaviour() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
-        return eTaskQueueBehaviorProcessInOrder;
+        // Pending previews are held in PreviewThreadPrivate, tasks are only used to wake-up the thread
+        return eTaskQueueBehaviorSkipToMostRecent;
     }
 
     virtual ThreadStateEnum threadLoopOnce(const GenericThreadStartArgsPtr& inArgs) OVERRIDE FINAL WARN_UNUSED_RETURN;
@@ -51,8 +51,9 @@
 #define COL_NAME 0
 #define COL_PLUGIN_ID 1
 #define COL_TIME 2
+#define COL_CACHE 3
 
-#define NUM_COLS 3
+#define NUM_COLS 4
 
 NATRON_NAMESPACE_ENTER;
 
@@ -219,6 +220,20 @@ public:
             item->setText(COL_TIME, Timer::printAsTime(timeSoFar, false) );
         }
 
+        if ( stats.hasCacheAccessMode() ) {
+            if (!exists) {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("How the output of this node went through the cache during the last render. "
+                                                                      "Nodes whose cached outputs are measured to be rarely re-read are not cached."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_CACHE, tt);
+                item->setFlags(COL_CACHE, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_CACHE, Qt::black);
+                item->setBackgroundColor(COL_CACHE, c);
+            }
+            item->setText(COL_CACHE, QString::fromUtf8( stats.getCacheAccessModeDescription().c_str() ) );
+        }
+
         if (!exists) {
             rows.push_back(node);
         }
@@ -429,7 +444,8 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     dimensionNames
     << tr("Node")
     << tr("Plugin ID")
-    << tr("Time Spent");
+    << tr("Time Spent")
+    << tr("Cache");
     _imp->model = StatsTableModel::create(dimensionNames.size());
     _imp->view->setTableModel(_imp->model);
 
@@ -1017,6 +1017,7 @@ ViewerGL::clearLastRenderedImage()
 {
     for (int i = 0; i < 2; ++i) {
         _imp->displayTextures[i].image.reset();
+        _imp->displayTextures[i].imageIsPrivateCopy = false;
     }
 }
 
@@ -1060,8 +1061,9 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     GL_GPU::GetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING_ARB, &currentBoundPBO);
     glCheckError(GL_GPU);
 
-    // We use 2 PBOs to make use of asynchronous data uploading
-    GLuint pboId = getPboID(_imp->updateViewerPboIndex);
+    // We use a ring of PBOs to make use of asynchronous data uploading
+    const int pboIndex = _imp->pboRing.getCurrentSlot();
+    GLuint pboId = getPboID(pboIndex);
 
     assert(textureIndex == 0 || textureIndex == 1);
 
@@ -1093,11 +1095,34 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     
 
     GLTexturePtr tex;
+
+    // If set, only this portion of tex is updated
+    RectI texSubRect;
+    bool updateSubRect = false;
     if (isPartialRect) {
 
         assert(image);
 
-        // For small partial updates overlays, we make new textures
+        // Time must be updated otherwise overlays won't refresh since we are not updating the displayTextures
+        _imp->displayTextures[0].time = time;
+        _imp->displayTextures[1].time = time;
+
+        // If the partial rectangle lies within the displayed texture, just update that sub-rectangle of the texture
+        TextureInfo& displayed = _imp->displayTextures[textureIndex];
+        if ( displayed.isVisible && displayed.texture && (displayed.texture->type() == bitdepth) &&
+             ( displayed.mipMapLevel == image->getMipMapLevel() ) && displayed.texture->getBounds().contains(imageData.tileBounds) ) {
+            tex = displayed.texture;
+            texSubRect = imageData.tileBounds;
+            updateSubRect = true;
+
+            // The color picker reads the image of the texture: it must have the pixels of the partial rectangle as well
+            displayed.image = updateViewerImageSubRect(displayed.image, &displayed.imageIsPrivateCopy, image);
+        }
+    }
+
+    if (isPartialRect && !updateSubRect) {
+
+        // For small partial updates overlays outside of the displayed texture, we make new textures
         int format, internalFormat, glType;
 
         if (bitdepth == eImageBitDepthFloat) {
@@ -1117,13 +1142,10 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
         info.originalCanonicalRoi = originalCanonicalRoi;
         info.isVisible = true;
         _imp->partialUpdateTextures.push_back(info);
-
-        // Update time otherwise overlays won't refresh since we are not updating the displayTextures
-        _imp->displayTextures[0].time = time;
-        _imp->displayTextures[1].time = time;
-    } else {
+    } else if (!isPartialRect) {
 
         _imp->displayTextures[textureIndex].image = image;
+        _imp->displayTextures[textureIndex].imageIsPrivateCopy = false;
         _imp->displayTextures[textureIndex].originalCanonicalRoi = originalCanonicalRoi;
         // re-use the existing texture if possible
         if (!image) {
@@ -1173,9 +1195,12 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     // If you do that, the previous data in PBO will be discarded and
     // glMapBufferARB() returns a new allocated pointer immediately
     // even if GPU is still working with the previous data.
+    // The data store is only grown, never shrunk (see ViewerPboRing).
+    // Partial updates only upload the bytes of the partial rectangle.
     std::size_t bytesCount = imageData.tileBounds.area() * imageData.nComps * getSizeOfForBitDepth(imageData.bitDepth);
+    std::size_t pboSize = _imp->pboRing.reserve(bytesCount);
 
-    GL_GPU::BufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, bytesCount, NULL, GL_DYNAMIC_DRAW_ARB);
+    GL_GPU::BufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, pboSize, NULL, GL_STREAM_DRAW_ARB);
 
     // map the buffer object into client's memory
     GLvoid *ret = GL_GPU::MapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
@@ -1193,14 +1218,18 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     // copy pixels from PBO to texture object
     // using glBindTexture followed by glTexSubImage2D.
     // Use offset instead of pointer (last parameter is 0).
-    tex->fillOrAllocateTexture(imageData.tileBounds, 0, 0);
+    if (updateSubRect) {
+        tex->fillOrAllocateTexture(tex->getBounds(), &texSubRect, 0);
+    } else {
+        tex->fillOrAllocateTexture(imageData.tileBounds, 0, 0);
+    }
 
     // restore previously bound PBO
     GL_GPU::BindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, currentBoundPBO);
     //glBindTexture(GL_TEXTURE_2D, 0); // why should we bind texture 0?
     glCheckError(GL_GPU);
 
-    _imp->updateViewerPboIndex = (_imp->updateViewerPboIndex + 1) % 2;
+    _imp->pboRing.rotate();
 
 
 
@@ -3167,6 +3196,14 @@ ViewerGL::getColorAt(double x,
                                                      dstColorSpace,
                                                      r, g, b, a);
             break;
+        case eImageBitDepthHalf:
+            gotval = getColorAtSinglePixel<Half, 1>(imageData,
+                                                    xPixel, yPixel,
+                                                    forceLinear,
+                                                    srcColorSpace,
+                                                    dstColorSpace,
+                                                    r, g, b, a);
+            break;
         default:
             gotval = false;
             break;
@@ -3335,6 +3372,8 @@ ViewerGL::getColorAtRect(const RectD &roi, // rectangle in canonical coordinates
             getColorAtRectForDepth<float, 1>(imageData, roiPixels, forceLinear, srcColorSpace, dstColorSpace, pixelSums);
             break;
         case eImageBitDepthHalf:
+            getColorAtRectForDepth<Half, 1>(imageData, roiPixels, forceLinear, srcColorSpace, dstColorSpace, pixelSums);
+            break;
         case eImageBitDepthNone:
             break;
     }
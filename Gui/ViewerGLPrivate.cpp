@@ -69,6 +69,7 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
                                          ViewerTab* parent)
     : _this(this_)
     , pboIds()
+    , pboRing(NATRON_VIEWER_PBO_RING_SIZE)
     , vboVerticesId(0)
     , vboTexturesId(0)
     , iboTriangleStripId(0)
@@ -111,7 +112,6 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
     , wheelDeltaSeekFrame(0)
     , isUpdatingTexture(false)
     , renderOnPenUp(false)
-    , updateViewerPboIndex(0)
 {
     infoViewer[0] = 0;
     infoViewer[1] = 0;
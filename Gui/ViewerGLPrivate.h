@@ -37,11 +37,16 @@ CLANG_DIAG_ON(uninitialized)
 
 #include "Gui/TextRenderer.h"
 #include "Gui/ViewerGL.h"
+#include "Gui/ViewerTextureUpload.h"
 #include "Gui/ZoomContext.h"
 #include "Gui/GuiFwd.h"
 
 #define MAX_MIP_MAP_LEVELS 20
 
+// Number of PBOs the uploads cycle through: a PBO is only written again once the uploads of the
+// other PBOs of the ring were submitted, by which time the GPU is usually done reading it.
+#define NATRON_VIEWER_PBO_RING_SIZE 3
+
 NATRON_NAMESPACE_ENTER;
 
 /*This class is the the core of the viewer : what displays images, overlays, etc...
@@ -77,6 +82,7 @@ struct TextureInfo
     TextureInfo()
     : texture()
     , image()
+    , imageIsPrivateCopy(false)
     , mipMapLevel(0)
     , premult(eImagePremultiplicationOpaque)
     , time(0)
@@ -93,6 +99,9 @@ struct TextureInfo
 
     ImagePtr image;
 
+    // True if image is a copy owned by the viewer, updated with the partial rectangles uploaded to the texture
+    bool imageIsPrivateCopy;
+
     unsigned int mipMapLevel;
 
     // These are meta-datas at the time the texture was uploaded
@@ -121,6 +130,7 @@ struct ViewerGL::Implementation
     /////////////////////////////////////////////////////////
     // The following are only accessed from the main thread:
     std::vector<GLuint> pboIds; //!< PBO's id's used by the OpenGL context
+    ViewerPboRing pboRing; //!< Which PBO of pboIds the next upload uses and the size of their data store
     GLuint vboVerticesId; //!< VBO holding the vertices for the texture mapping.
     GLuint vboTexturesId; //!< VBO holding texture coordinates.
     GLuint iboTriangleStripId; /*!< IBOs holding vertices indexes for triangle strip sets*/
@@ -175,7 +185,6 @@ struct ViewerGL::Implementation
     int wheelDeltaSeekFrame; // accumulated wheel delta for frame seeking (crtl+wheel)
     bool isUpdatingTexture;
     bool renderOnPenUp;
-    int updateViewerPboIndex;  // always accessed in the main thread: initialized in the constructor, then always accessed and modified by updateViewer()
 
     // A map storing the hash of the viewerProcess A node accross time.
     // This is used to display the timeline cache bar.
@@ -0,0 +1,112 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ViewerTextureUpload.h"
+
+#include <cassert>
+
+#include "Engine/Image.h"
+
+NATRON_NAMESPACE_ENTER;
+
+ViewerPboRing::ViewerPboRing(int ringSize)
+    : _slotSizes(ringSize, 0)
+    , _currentSlot(0)
+{
+    assert(ringSize > 0);
+}
+
+int
+ViewerPboRing::getRingSize() const
+{
+    return (int)_slotSizes.size();
+}
+
+int
+ViewerPboRing::getCurrentSlot() const
+{
+    return _currentSlot;
+}
+
+std::size_t
+ViewerPboRing::reserve(std::size_t nBytes)
+{
+    std::size_t& slotSize = _slotSizes[_currentSlot];
+    if (slotSize < nBytes) {
+        slotSize = nBytes;
+    }
+
+    return slotSize;
+}
+
+std::size_t
+ViewerPboRing::getSlotSize(int slot) const
+{
+    assert(slot >= 0 && slot < (int)_slotSizes.size());
+
+    return _slotSizes[slot];
+}
+
+void
+ViewerPboRing::rotate()
+{
+    _currentSlot = (_currentSlot + 1) % (int)_slotSizes.size();
+}
+
+ImagePtr
+updateViewerImageSubRect(const ImagePtr& displayedImage,
+                         bool* isPrivateCopy,
+                         const ImagePtr& partialImage)
+{
+    if (!displayedImage || !partialImage) {
+        return displayedImage;
+    }
+
+    ImagePtr ret = displayedImage;
+    Image::CopyPixelsArgs copyArgs;
+    if (!*isPrivateCopy) {
+        Image::InitStorageArgs initArgs;
+        initArgs.bounds = displayedImage->getBounds();
+        initArgs.bitdepth = displayedImage->getBitDepth();
+        initArgs.layer = displayedImage->getLayer();
+        initArgs.bufferFormat = displayedImage->getBufferFormat();
+        initArgs.proxyScale = displayedImage->getProxyScale();
+        initArgs.mipMapLevel = displayedImage->getMipMapLevel();
+        ret = Image::create(initArgs);
+        if (!ret) {
+            return ImagePtr();
+        }
+        copyArgs.roi = initArgs.bounds;
+        ret->copyPixels(*displayedImage, copyArgs);
+        *isPrivateCopy = true;
+    }
+
+    if ( partialImage->getBounds().intersect(ret->getBounds(), &copyArgs.roi) ) {
+        ret->copyPixels(*partialImage, copyArgs);
+    }
+
+    return ret;
+} // updateViewerImageSubRect
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,87 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Gui_ViewerTextureUpload_h
+#define Gui_ViewerTextureUpload_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+#include <cstddef>
+
+#include "Engine/EngineFwd.h"
+
+#include "Gui/GuiFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Bookkeeping of the ring of pixel buffer objects used by the viewer to upload images to its textures:
+ * which slot the next upload uses and the size of the data store of each slot.
+ * The data store of a slot is only grown, never shrunk: when it is large enough, orphaning it with the same size
+ * lets the driver recycle the previous allocation instead of creating a new one.
+ * This does not hold any OpenGL object, the viewer maps each slot to its buffer.
+ **/
+class ViewerPboRing
+{
+public:
+
+    ViewerPboRing(int ringSize);
+
+    int getRingSize() const;
+
+    /**
+     * @brief The slot used by the next upload
+     **/
+    int getCurrentSlot() const;
+
+    /**
+     * @brief Returns the size to give to the data store of the current slot so that it holds nBytes.
+     **/
+    std::size_t reserve(std::size_t nBytes);
+
+    std::size_t getSlotSize(int slot) const;
+
+    /**
+     * @brief Called once an upload is done, the next upload uses the next slot of the ring
+     **/
+    void rotate();
+
+private:
+
+    std::vector<std::size_t> _slotSizes;
+    int _currentSlot;
+};
+
+/**
+ * @brief Returns the image to keep for the color picker of a viewer texture once the pixels of partialImage
+ * were uploaded to a sub-rectangle of the texture which was displaying displayedImage.
+ * displayedImage may be shared (e.g: with the cache) so it is copied the first time, isPrivateCopy tells
+ * whether displayedImage is already a copy made by this function and is set to true.
+ **/
+ImagePtr updateViewerImageSubRect(const ImagePtr& displayedImage, bool* isPrivateCopy, const ImagePtr& partialImage);
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Gui_ViewerTextureUpload_h
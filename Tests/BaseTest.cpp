@@ -24,11 +24,18 @@
 
 #include "Global/Macros.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <iostream>
+#include <vector>
 
 #include "BaseTest.h"
 
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
+#include <QtCore/QElapsedTimer>
 
 // ofxhPropertySuite.h:565:37: warning: 'this' pointer cannot be null in well-defined C++ code; comparison may be assumed to always evaluate to true [-Wtautological-undefined-compare]
 CLANG_DIAG_OFF(unknown-pragmas)
@@ -47,15 +54,22 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/Project.h"
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/CacheReuseStats.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
 #include "Engine/Plugin.h"
 #include "Engine/Curve.h"
 #include "Engine/CLArgs.h"
 #include "Engine/RenderQueue.h"
 #include "Engine/Settings.h"
+#include "Engine/TLSHolder.h"
+#include "Engine/TreeRender.h"
+#include "Engine/TreeRenderNodeArgs.h"
 #include "Engine/ViewIdx.h"
 
+#include "Serialization/NodeSerialization.h"
+
 NATRON_NAMESPACE_USING
 
 static AppManager* g_manager = 0;
@@ -305,6 +319,326 @@ TEST_F(BaseTest, SetValues)
     }
 }
 
+class GetValueThread
+    : public QThread
+{
+public:
+
+    GetValueThread(const KnobDoublePtr& knob,
+                   int nIterations)
+        : QThread()
+        , _knob(knob)
+        , _nIterations(nIterations)
+        , _sum(0.)
+    {
+    }
+
+    double getSum() const
+    {
+        return _sum;
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        for (int i = 0; i < _nIterations; ++i) {
+            _sum += _knob->getValue();
+        }
+        appPTR->getAppTLS()->cleanupTLSForThread();
+    }
+
+    KnobDoublePtr _knob;
+    int _nIterations;
+    double _sum;
+};
+
+///Micro-benchmark of knob reads from many threads, which go through the thread-local storage of the holder:
+///the lookups of the threads must not contend, so reading from many threads must scale with the number of cores.
+static qint64
+timeConcurrentGetValue(const KnobDoublePtr& knob,
+                       int nThreads,
+                       int nIterations)
+{
+    std::vector<boost::shared_ptr<GetValueThread> > threads;
+    for (int i = 0; i < nThreads; ++i) {
+        threads.push_back( boost::shared_ptr<GetValueThread>( new GetValueThread(knob, nIterations) ) );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->start();
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->wait();
+    }
+    qint64 elapsedMS = timer.elapsed();
+
+    for (int i = 0; i < nThreads; ++i) {
+        EXPECT_EQ(nIterations * 0.5, threads[i]->getSum());
+    }
+
+    return elapsedMS;
+}
+
+TEST_F(BaseTest, ConcurrentGetValue)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+
+    assert(generator);
+    KnobDoublePtr knob = boost::dynamic_pointer_cast<KnobDouble>( generator->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE(knob != 0);
+    knob->setValue(0.5);
+
+    const int nThreads = 32;
+    const int nIterations = 100000;
+    qint64 singleThreadMS = timeConcurrentGetValue(knob, 1, nIterations);
+    qint64 concurrentMS = timeConcurrentGetValue(knob, nThreads, nIterations);
+
+    // Each core runs nThreads / nCores threads one after the other. Allow twice that, and some slack for the
+    // timer resolution, before considering that the threads contend.
+    const int nCores = std::max(1, QThread::idealThreadCount());
+    const int nThreadsPerCore = (nThreads + nCores - 1) / nCores;
+    EXPECT_LE( concurrentMS, 2 * nThreadsPerCore * singleThreadMS + 20 );
+}
+
+///Benchmark of node and knob name resolution: creating and resolving nodes used to scan all the nodes of the group
+TEST_F(BaseTest, NodeNameResolution)
+{
+    const int nNodes = 10000;
+    ProjectPtr project = getApp()->getProject();
+    std::vector<NodePtr> nodes;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < nNodes; ++i) {
+        CreateNodeArgsPtr args(CreateNodeArgs::create( PLUGINID_NATRON_DOT, project ));
+        args->setProperty<bool>(kCreateNodeArgsPropAutoConnect, false);
+        NodePtr node = getApp()->createNode(args);
+        ASSERT_TRUE(node != 0);
+        nodes.push_back(node);
+    }
+    qint64 createMS = timer.elapsed();
+
+    timer.restart();
+    for (int i = 0; i < nNodes; ++i) {
+        EXPECT_EQ( nodes[i], project->getNodeByName( nodes[i]->getScriptName_mt_safe() ) );
+    }
+    qint64 resolveMS = timer.elapsed();
+
+    // All the nodes have the same knobs
+    const KnobsVec& knobs = nodes[0]->getKnobs();
+    timer.restart();
+    for (int i = 0; i < nNodes; ++i) {
+        for (KnobsVec::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+            KnobIPtr knob = nodes[i]->getKnobByName( (*it)->getName() );
+            ASSERT_TRUE(knob != 0);
+            EXPECT_EQ( (*it)->getName(), knob->getName() );
+        }
+    }
+    qint64 resolveKnobsMS = timer.elapsed();
+
+    // A renamed node is found under its new name only and its previous name is given to the next node
+    std::string firstName = nodes[0]->getScriptName_mt_safe();
+    nodes[0]->setScriptName("renamedNode");
+    EXPECT_EQ( nodes[0], project->getNodeByName("renamedNode") );
+    EXPECT_TRUE( !project->getNodeByName(firstName) );
+    {
+        CreateNodeArgsPtr args(CreateNodeArgs::create( PLUGINID_NATRON_DOT, project ));
+        args->setProperty<bool>(kCreateNodeArgsPropAutoConnect, false);
+        NodePtr node = getApp()->createNode(args);
+        ASSERT_TRUE(node != 0);
+        EXPECT_EQ( firstName, node->getScriptName_mt_safe() );
+    }
+
+    std::cout << "Created " << nNodes << " nodes in " << createMS << " ms, resolved their names in " << resolveMS << " ms and "
+              << nNodes * knobs.size() << " knob names in " << resolveKnobsMS << " ms" << std::endl;
+
+    project->clearNodesBlocking();
+}
+
+///Changes made after a full auto-save are appended to its journal and replayed when the auto-save is loaded
+TEST_F(BaseTest, AutoSaveJournal)
+{
+    ProjectPtr project = getApp()->getProject();
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator != 0);
+    KnobDoublePtr knob = toKnobDouble( generator->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE(knob != 0);
+
+    const QString path = QDir::tempPath() + QLatin1Char('/');
+    const QString name = QString::fromUtf8("AutoSaveJournalTest." NATRON_PROJECT_FILE_EXT);
+
+    // A node was created: the first auto-save writes the whole project
+    QString autoSaveFilePath;
+    ASSERT_TRUE( project->saveProject_imp(path, name, true, true, &autoSaveFilePath) );
+    ASSERT_TRUE( QFile::exists(autoSaveFilePath) );
+    const qint64 autoSaveSize = QFileInfo(autoSaveFilePath).size();
+    const QString journalFilePath = autoSaveFilePath + QString::fromUtf8("." NATRON_PROJECT_AUTOSAVE_JOURNAL_EXT);
+    EXPECT_FALSE( QFile::exists(journalFilePath) );
+
+    // Only a knob of the generator changed: the auto-save file is left untouched and the change is journaled
+    const double journaledValue = knob->getValue() + 0.25;
+    knob->setValue(journaledValue);
+    QString journaledFilePath;
+    ASSERT_TRUE( project->saveProject_imp(path, name, true, true, &journaledFilePath) );
+    EXPECT_EQ(autoSaveFilePath, journaledFilePath);
+    EXPECT_EQ( autoSaveSize, QFileInfo(autoSaveFilePath).size() );
+
+    // The value is only in the journal: loading the auto-save must replay it
+    ASSERT_TRUE( QFile::exists(journalFilePath) );
+    const std::string generatorName = generator->getFullyQualifiedName();
+    generator.reset();
+    knob.reset();
+    const QFileInfo autoSaveInfo(autoSaveFilePath);
+    ASSERT_TRUE( project->loadProject(autoSaveInfo.path() + QLatin1Char('/'), autoSaveInfo.fileName(), true) );
+    NodePtr loadedGenerator = getApp()->getNodeByFullySpecifiedName(generatorName);
+    ASSERT_TRUE(loadedGenerator != 0);
+    KnobDoublePtr loadedKnob = toKnobDouble( loadedGenerator->getKnobByName("noiseZSlope") );
+    ASSERT_TRUE(loadedKnob != 0);
+    EXPECT_EQ( journaledValue, loadedKnob->getValue() );
+
+    project->removeLastAutosave();
+    EXPECT_FALSE( QFile::exists(autoSaveFilePath) );
+    EXPECT_FALSE( QFile::exists(journalFilePath) );
+
+    project->clearNodesBlocking();
+}
+
+static void
+expectSameMetadata(const NodePtr& upstream,
+                   const NodePtr& downstream)
+{
+    EffectInstancePtr upstreamEffect = upstream->getEffectInstance();
+    EffectInstancePtr downstreamEffect = downstream->getEffectInstance();
+
+    EXPECT_EQ( upstreamEffect->getOutputFormat( TreeRenderNodeArgsPtr() ), downstreamEffect->getOutputFormat( TreeRenderNodeArgsPtr() ) );
+    EXPECT_EQ( upstreamEffect->getFrameRate( TreeRenderNodeArgsPtr() ), downstreamEffect->getFrameRate( TreeRenderNodeArgsPtr() ) );
+    EXPECT_EQ( upstreamEffect->getAspectRatio( TreeRenderNodeArgsPtr(), -1 ), downstreamEffect->getAspectRatio( TreeRenderNodeArgsPtr(), -1 ) );
+    // The time-invariance of the upstream node must have reached the end of the chain
+    EXPECT_EQ( upstreamEffect->isFrameVarying( TreeRenderNodeArgsPtr() ), downstreamEffect->isFrameVarying( TreeRenderNodeArgsPtr() ) );
+}
+
+///Connecting nodes within a knob changes transaction must leave the downstream nodes with the same meta-datas as
+///connecting them one by one, but is expected not to be slower
+TEST_F(BaseTest, KnobChangesTransaction)
+{
+    const int nNodes = 200;
+    AppInstancePtr app = getApp();
+    ProjectPtr project = app->getProject();
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator);
+    std::vector<NodePtr> nodes;
+    nodes.push_back(generator);
+
+    for (int i = 1; i < nNodes; ++i) {
+        CreateNodeArgsPtr args(CreateNodeArgs::create( PLUGINID_NATRON_DOT, project ));
+        args->setProperty<bool>(kCreateNodeArgsPropAutoConnect, false);
+        NodePtr node = app->createNode(args);
+        ASSERT_TRUE(node != 0);
+        nodes.push_back(node);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = nNodes - 1; i > 0; --i) {
+        ASSERT_TRUE( Project::connectNodes(0, nodes[i - 1], nodes[i]) );
+    }
+    qint64 connectMS = timer.elapsed();
+    expectSameMetadata(generator, nodes.back());
+
+    for (int i = 1; i < nNodes; ++i) {
+        ASSERT_TRUE( Project::disconnectNodes(nodes[i - 1], nodes[i]) );
+    }
+
+    timer.restart();
+    {
+        KnobChangesTransaction_RAII transaction(app);
+        EXPECT_TRUE( app->isKnobChangesTransactionOpened() );
+        for (int i = nNodes - 1; i > 0; --i) {
+            ASSERT_TRUE( Project::connectNodes(0, nodes[i - 1], nodes[i]) );
+        }
+    }
+    qint64 transactionMS = timer.elapsed();
+    EXPECT_FALSE( app->isKnobChangesTransactionOpened() );
+
+    for (int i = 1; i < nNodes; ++i) {
+        EXPECT_EQ( nodes[i - 1], nodes[i]->getInput(0) );
+    }
+
+    // The meta-datas were refreshed once in topological order when the transaction was committed
+    expectSameMetadata(generator, nodes.back());
+    EXPECT_LE( transactionMS, connectMS + 50 );
+
+    project->clearNodesBlocking();
+} // KnobChangesTransaction
+
+///Pasting nodes opens a knob changes transaction: the pasted nodes must be connected and have their meta-datas
+///refreshed once the transaction is committed
+TEST_F(BaseTest, KnobChangesTransactionPaste)
+{
+    AppInstancePtr app = getApp();
+    ProjectPtr project = app->getProject();
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr dot = createNode( QString::fromUtf8(PLUGINID_NATRON_DOT) );
+    ASSERT_TRUE(generator && dot);
+    connectNodes(generator, dot, 0, true);
+
+    SERIALIZATION_NAMESPACE::NodeSerializationList serializedNodes;
+    NodesList toCopy;
+    toCopy.push_back(generator);
+    toCopy.push_back(dot);
+    for (NodesList::const_iterator it = toCopy.begin(); it != toCopy.end(); ++it) {
+        SERIALIZATION_NAMESPACE::NodeSerializationPtr serialization(new SERIALIZATION_NAMESPACE::NodeSerialization);
+        (*it)->toSerialization( serialization.get() );
+        serializedNodes.push_back(serialization);
+    }
+    project->clearNodesBlocking();
+
+    std::list<std::pair<NodePtr, SERIALIZATION_NAMESPACE::NodeSerializationPtr > > createdNodes;
+    Project::restoreGroupFromSerialization(serializedNodes, project, &createdNodes);
+    EXPECT_FALSE( app->isKnobChangesTransactionOpened() );
+    ASSERT_EQ( (std::size_t)2, createdNodes.size() );
+
+    NodePtr pastedGenerator = createdNodes.front().first;
+    NodePtr pastedDot = createdNodes.back().first;
+    ASSERT_TRUE(pastedGenerator && pastedDot);
+    EXPECT_EQ( pastedGenerator, pastedDot->getInput(0) );
+    expectSameMetadata(pastedGenerator, pastedDot);
+
+    project->clearNodesBlocking();
+}
+
+///Python batch edits (App.beginChanges()/App.endChanges()) open a knob changes transaction that is committed by
+///the matching endChanges() call
+TEST_F(BaseTest, KnobChangesTransactionPython)
+{
+    AppInstancePtr app = getApp();
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr dot = createNode( QString::fromUtf8(PLUGINID_NATRON_DOT) );
+    ASSERT_TRUE(generator && dot);
+
+    const std::string appID = app->getAppIDString();
+    std::string script = appID + ".beginChanges()\n" +
+                         appID + ".getNode(\"" + dot->getScriptName_mt_safe() + "\").connectInput(0, " +
+                         appID + ".getNode(\"" + generator->getScriptName_mt_safe() + "\"))\n";
+    std::string err, output;
+    ASSERT_TRUE( NATRON_PYTHON_NAMESPACE::interpretPythonScript(script, &err, &output) ) << err;
+    EXPECT_TRUE( app->isKnobChangesTransactionOpened() );
+    EXPECT_EQ( generator, dot->getInput(0) );
+
+    ASSERT_TRUE( NATRON_PYTHON_NAMESPACE::interpretPythonScript(appID + ".endChanges()\n", &err, &output) ) << err;
+    EXPECT_FALSE( app->isKnobChangesTransactionOpened() );
+    expectSameMetadata(generator, dot);
+
+    // An endChanges() without a matching beginChanges() raises
+    EXPECT_FALSE( NATRON_PYTHON_NAMESPACE::interpretPythonScript(appID + ".endChanges()\n", &err, &output) );
+    EXPECT_FALSE( app->isKnobChangesTransactionOpened() );
+
+    getApp()->getProject()->clearNodesBlocking();
+}
+
 ///High level test: simple node connections test
 TEST_F(BaseTest, SimpleNodeConnections) {
     ///create the generator
@@ -320,3 +654,118 @@ TEST_F(BaseTest, SimpleNodeConnections) {
     disconnectNodes(generator, writer, false);
     connectNodes(generator, writer, 0, true);
 }
+
+///When streaming a render, the nodes upstream of the writer must be asked for one band of their image at a time
+TEST_F(BaseTest, StreamingBandRoIs)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    NodePtr dot = createNode( QString::fromUtf8(PLUGINID_NATRON_DOT) );
+    NodePtr writer = createNode(_writeOIIOPluginID);
+    ASSERT_TRUE(generator && dot && writer);
+    connectNodes(generator, dot, 0, true);
+    connectNodes(dot, writer, 0, true);
+
+    const TimeValue time(1);
+    const RectD frameRoI(0, 0, 1024, 1024);
+    TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
+    rargs->time = time;
+    rargs->view = ViewIdx(0);
+    rargs->treeRoot = writer;
+    rargs->canonicalRoI = &frameRoI;
+    rargs->proxyScale = RenderScale(1.);
+    rargs->mipMapLevel = 0;
+    rargs->layers = 0;
+    rargs->draftMode = false;
+    rargs->playback = true;
+    rargs->byPassCache = false;
+    rargs->streaming = true;
+    rargs->priorityPoint = 0;
+    rargs->lowPriority = false;
+    TreeRenderPtr render = TreeRender::create(rargs);
+    ASSERT_TRUE(render != 0);
+
+    TreeRenderNodeArgsPtr writerArgs = render->getNodeRenderArgs(writer);
+    TreeRenderNodeArgsPtr dotArgs = render->getNodeRenderArgs(dot);
+    TreeRenderNodeArgsPtr generatorArgs = render->getNodeRenderArgs(generator);
+    ASSERT_TRUE(writerArgs && dotArgs && generatorArgs);
+
+    // Before the bands are rendered, the upstream nodes are asked for the whole frame
+    RectD roi;
+    ASSERT_TRUE( generatorArgs->getFrameViewCanonicalRoI(time, ViewIdx(0), &roi) );
+    EXPECT_TRUE( roi.contains(frameRoI) );
+
+    // Each band replaces the region of interest of all the nodes upstream, it does not add to it
+    for (int y = 0; y < 1024; y += 256) {
+        const RectD band(0, y, 1024, y + 256);
+        ASSERT_EQ( eActionStatusOK, writerArgs->setInputBandRoI(0, time, ViewIdx(0), band) );
+
+        ASSERT_TRUE( dotArgs->getFrameViewCanonicalRoI(time, ViewIdx(0), &roi) );
+        EXPECT_EQ(band, roi);
+        ASSERT_TRUE( generatorArgs->getFrameViewCanonicalRoI(time, ViewIdx(0), &roi) );
+        EXPECT_EQ(band, roi);
+    }
+
+    render.reset();
+    appPTR->getAppTLS()->cleanupTLSForThread();
+    getApp()->getProject()->clearNodesBlocking();
+}
+
+///The image handed back by a render must be at the requested scale, whether it is the buffer the plug-in
+///rendered to or the image read from the cache
+TEST_F(BaseTest, RenderAtMipMapLevel)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator != 0);
+
+    const RectD frameRoI(0, 0, 512, 512);
+    for (int i = 0; i < 2; ++i) {
+        TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
+        rargs->time = TimeValue(1);
+        rargs->view = ViewIdx(0);
+        rargs->treeRoot = generator;
+        rargs->canonicalRoI = &frameRoI;
+        rargs->proxyScale = RenderScale(1.);
+        rargs->mipMapLevel = 1;
+        rargs->layers = 0;
+        rargs->draftMode = false;
+        rargs->playback = false;
+        rargs->byPassCache = false;
+        rargs->streaming = false;
+        rargs->priorityPoint = 0;
+        rargs->lowPriority = false;
+        TreeRenderPtr render = TreeRender::create(rargs);
+        ASSERT_TRUE(render != 0);
+
+        std::map<ImagePlaneDesc, ImagePtr> planes;
+        ASSERT_EQ( eActionStatusOK, render->launchRender(&planes) );
+        ASSERT_FALSE( planes.empty() );
+        for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
+            EXPECT_EQ( 1u, it->second->getMipMapLevel() );
+            EXPECT_EQ( 1., it->second->getProxyScale().x );
+            EXPECT_EQ( 1., it->second->getProxyScale().y );
+            // At level 0 the image would be 512 pixels wide
+            EXPECT_LT( it->second->getBounds().width(), 512 );
+            EXPECT_LT( it->second->getBounds().height(), 512 );
+        }
+    }
+
+    appPTR->getAppTLS()->cleanupTLSForThread();
+    getApp()->getProject()->clearNodesBlocking();
+}
+
+///The key of a node in the cache reuse statistics is computed once and follows the renames of the node
+TEST_F(BaseTest, CacheReuseKey)
+{
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator != 0);
+
+    U64 key = generator->getCacheReuseKey();
+    EXPECT_EQ( CacheReuseStats::getNodeKey(generator), key );
+    EXPECT_EQ( key, generator->getCacheReuseKey() );
+
+    generator->setScriptName("CacheReuseKeyRenamed");
+    EXPECT_NE( key, generator->getCacheReuseKey() );
+    EXPECT_EQ( CacheReuseStats::getNodeKey(generator), generator->getCacheReuseKey() );
+
+    getApp()->getProject()->clearNodesBlocking();
+}
@@ -0,0 +1,124 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QTemporaryDir>
+
+#include "Engine/CacheReuseStats.h"
+
+NATRON_NAMESPACE_USING
+
+TEST(CacheReuseStats,
+     BypassRarelyReadOutputs)
+{
+    CacheReuseStats stats;
+    const U64 cheapNode = 1;
+    const U64 reusedNode = 2;
+    const U64 expensiveNode = 3;
+
+    double reuseRatio;
+    EXPECT_FALSE( stats.shouldBypassCache(cheapNode, &reuseRatio) ) << "Nodes never measured remain cached";
+    EXPECT_EQ(-1, reuseRatio);
+
+    // 100 different outputs of a 2 megapixels image, each rendered in 10ms
+    for (int i = 0; i < 100; ++i) {
+        stats.notifyOutputRendered(cheapNode, i, true, 0.01, 2e6);
+        stats.notifyOutputRendered(reusedNode, i, true, 0.01, 2e6);
+        stats.notifyOutputRendered(expensiveNode, i, true, 2., 2e6);
+        stats.notifyOutputReadFromCache(reusedNode);
+    }
+
+    EXPECT_TRUE( stats.shouldBypassCache(cheapNode, &reuseRatio) );
+    EXPECT_EQ(0, reuseRatio);
+    EXPECT_FALSE( stats.shouldBypassCache(reusedNode, &reuseRatio) );
+    EXPECT_EQ(1, reuseRatio);
+    EXPECT_FALSE( stats.shouldBypassCache(expensiveNode, &reuseRatio) ) << "Expensive nodes remain cached";
+
+    // While bypassed, the node starts being requested the same 500 outputs over and over (e.g: looped playback
+    // of a 500 frames sequence): the outputs rendered again count as reads and the node goes back to the cache
+    const int nLoopedOutputs = 500;
+    for (int loop = 0; loop < 3; ++loop) {
+        for (int i = 0; i < nLoopedOutputs; ++i) {
+            stats.notifyOutputRendered(cheapNode, 1000 + i, false, 0.01, 2e6);
+        }
+    }
+    CacheReuseNodeStats nodeStats;
+    ASSERT_TRUE( stats.getNodeStats(cheapNode, &nodeStats) );
+    EXPECT_EQ(2 * nLoopedOutputs, nodeStats.nCachedReads);
+    EXPECT_FALSE( stats.shouldBypassCache(cheapNode, &reuseRatio) );
+    EXPECT_GT(reuseRatio, 0.5);
+}
+
+TEST(CacheReuseStats,
+     ForgetOldOutputs)
+{
+    CacheReuseStats stats;
+    const U64 node = 1;
+
+    // The outputs remembered are bounded: an output rendered again after many others is not counted as a read,
+    // except for the few false positives of the filters
+    const int nOutputs = 20000;
+    for (int loop = 0; loop < 2; ++loop) {
+        for (int i = 0; i < nOutputs; ++i) {
+            stats.notifyOutputRendered(node, i, false, 0.01, 1e6);
+        }
+    }
+    CacheReuseNodeStats nodeStats;
+    ASSERT_TRUE( stats.getNodeStats(node, &nodeStats) );
+    EXPECT_LT(nodeStats.nCachedReads, 0.01 * nOutputs);
+}
+
+TEST(CacheReuseStats,
+     PersistAcrossSessions)
+{
+    QTemporaryDir temporaryDir;
+    ASSERT_TRUE( temporaryDir.isValid() );
+    const std::string directory = temporaryDir.path().toStdString();
+    const U64 node = 42;
+    {
+        CacheReuseStats stats;
+        for (int i = 0; i < 100; ++i) {
+            stats.notifyOutputRendered(node, i, true, 0.01, 1e6);
+        }
+        stats.saveToDirectory(directory);
+    }
+
+    // The previous sessions weigh less than the current one, but enough to decide right away
+    CacheReuseStats stats;
+    stats.loadFromDirectory(directory);
+    CacheReuseNodeStats nodeStats;
+    ASSERT_TRUE( stats.getNodeStats(node, &nodeStats) );
+    EXPECT_GT(nodeStats.nCachedWrites, 0);
+    EXPECT_LT(nodeStats.nCachedWrites, 100);
+    EXPECT_EQ(0, nodeStats.nCachedReads);
+
+    double reuseRatio;
+    EXPECT_TRUE( stats.shouldBypassCache(node, &reuseRatio) );
+
+    stats.clear();
+    EXPECT_FALSE( stats.getNodeStats(node, &nodeStats) );
+}
@@ -28,6 +28,7 @@
 #include <gtest/gtest.h>
 
 #include "Engine/Hash64.h"
+#include "Engine/CacheEntryKeyBase.h"
 
 NATRON_NAMESPACE_USING
 
@@ -90,3 +91,33 @@ TEST(Hash64,
     EXPECT_NE(hash1, hash2);
 } // TEST
 
+
+TEST(Hash64,
+     PrefixState)
+{
+    Hash64 prefix;
+    Hash64 full;
+    for (int i = 0; i < 10; ++i) {
+        prefix.append<int>(i);
+        full.append<int>(i);
+    }
+    full.append<int>(42);
+    full.append<double>(0.5);
+    full.computeHash();
+
+    Hash64 suffix;
+    suffix.append<int>(42);
+    suffix.append<double>(0.5);
+    suffix.computeHashFromPrefixState( prefix.getPrefixState() );
+
+    EXPECT_EQ( full.value(), suffix.value() ) << "Hashing from a prefix state should give the same result as hashing all values.";
+
+    // The hash of tile keys computed from the prefix must be the same as the one of the key
+    U64 tilesPrefix = ImageTileKey::computeTilesHashPrefixState(1234, TimeValue(3), ViewIdx(1), "Color.RGBA.R", RenderScale(0.5), 1, false, eImageBitDepthFloat, 0);
+    for (int ty = 0; ty < 4; ++ty) {
+        for (int tx = 0; tx < 4; ++tx) {
+            ImageTileKey key(1234, TimeValue(3), ViewIdx(1), "Color.RGBA.R", RenderScale(0.5), 1, false, eImageBitDepthFloat, 0, tx, ty);
+            EXPECT_EQ( key.getHash(), ImageTileKey::computeTileHash(tilesPrefix, tx, ty) );
+        }
+    }
+}
@@ -24,11 +24,31 @@
 
 #include "Global/Macros.h"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
 #include <gtest/gtest.h>
 
+#include <QtCore/QElapsedTimer>
+
+#include "BaseTest.h"
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Half.h"
 #include "Engine/Image.h"
+#include "Engine/ImagePlaneDesc.h"
 #include "Engine/CacheEntryKeyBase.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/Settings.h"
+#include "Engine/TLSHolder.h"
+#include "Engine/TreeRender.h"
 #include "Engine/ViewIdx.h"
 
 NATRON_NAMESPACE_USING
@@ -39,7 +59,7 @@ TEST(ImageKeyTest, Equality) {
     int randomHashKey1 = rand();
     TimeValue time1(0);
     ViewIdx view1(0);
-    ImageTileKey key1(randomHashKey1, time1, view1, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0);
+    ImageTileKey key1(randomHashKey1, time1, view1, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0, 0);
     U64 keyHash1 = key1.getHash();
 
 
@@ -47,7 +67,7 @@ TEST(ImageKeyTest, Equality) {
     int randomHashKey2 = randomHashKey1;
     TimeValue time2(time1);
     ViewIdx view2(view1);
-    ImageTileKey key2(randomHashKey2, time2, view2, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0);
+    ImageTileKey key2(randomHashKey2, time2, view2, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0, 0);
     U64 keyHash2 = key2.getHash();
     ASSERT_TRUE(keyHash1 == keyHash2);
 }
@@ -58,7 +78,7 @@ TEST(ImageKeyTest, Difference) {
     int randomHashKey1 = rand() % 100;
     TimeValue time1(0);
     ViewIdx view1(0);
-    ImageTileKey key1(randomHashKey1, time1, view1, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0);
+    ImageTileKey key1(randomHashKey1, time1, view1, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0, 0);
     U64 keyHash1 = key1.getHash();
 
 
@@ -67,9 +87,355 @@ TEST(ImageKeyTest, Difference) {
     int randomHashKey2 = rand() % 1000  + 150;
     TimeValue time2(time1);
     ViewIdx view2(view1);
-    ImageTileKey key2(randomHashKey2, time2, view2, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0);
+    ImageTileKey key2(randomHashKey2, time2, view2, std::string(), RenderScale(1.), 0, false, eImageBitDepthFloat, 0, 0, 0);
     U64 keyHash2 = key2.getHash();
 
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+
+static ImagePtr
+createTiledImage(const RectI& bounds,
+                 ImageBitDepthEnum bitdepth,
+                 int tileSizeClass = 0)
+{
+    Image::InitStorageArgs args;
+
+    args.bounds = bounds;
+    args.storage = eStorageModeDisk;
+    args.bufferFormat = eImageBufferLayoutMonoChannelTiled;
+    args.bitdepth = bitdepth;
+    args.tileSizeClass = tileSizeClass;
+    args.layer = ImagePlaneDesc::getRGBAComponents();
+
+    return Image::create(args);
+}
+
+// Size of the cells of the pattern used by the copy tests, not a multiple of the tile sizes
+#define PATTERN_CELL_SIZE 48
+
+// Value of the given channel of the pattern cell containing (x,y): a multiple of 1/5 so that it converts
+// exactly to 8-bit
+static int
+patternCellValue(int x,
+                 int y,
+                 int c)
+{
+    return ( (x / PATTERN_CELL_SIZE) + 3 * (y / PATTERN_CELL_SIZE) + c ) % 5;
+}
+
+static void
+fillPattern(const ImagePtr& image,
+            const RectI& bounds)
+{
+    for (int y = bounds.y1; y < bounds.y2; y += PATTERN_CELL_SIZE) {
+        for (int x = bounds.x1; x < bounds.x2; x += PATTERN_CELL_SIZE) {
+            RectI cell(x, y, std::min(x + PATTERN_CELL_SIZE, bounds.x2), std::min(y + PATTERN_CELL_SIZE, bounds.y2));
+            image->fill(cell,
+                        patternCellValue(x, y, 0) / 5.,
+                        patternCellValue(x, y, 1) / 5.,
+                        patternCellValue(x, y, 2) / 5.,
+                        patternCellValue(x, y, 3) / 5.);
+        }
+    }
+}
+
+// Check that every pixel of the 8-bit tiled image holds the pattern
+static void
+checkBytePattern(const ImagePtr& image,
+                 const RectI& bounds)
+{
+    for (int i = 0; i < image->getNumTiles(); ++i) {
+        Image::Tile tile;
+        ASSERT_TRUE( image->getTileAt(i, &tile) );
+        Image::CPUTileData tileData;
+        image->getCPUTileData(tile, &tileData);
+        ASSERT_EQ(4, tileData.nComps);
+        RectI tileRoI;
+        ASSERT_TRUE( tile.tileBounds.intersect(bounds, &tileRoI) );
+        for (int c = 0; c < 4; ++c) {
+            for (int y = tileRoI.y1; y < tileRoI.y2; ++y) {
+                for (int x = tileRoI.x1; x < tileRoI.x2; ++x) {
+                    const unsigned char* pix = (const unsigned char*)Image::pixelAtStatic(x, y, tileData.tileBounds, 1, sizeof(unsigned char), (unsigned char*)tileData.ptrs[c]);
+                    ASSERT_TRUE(pix != 0);
+                    ASSERT_EQ(patternCellValue(x, y, c) * 51, (int)*pix) << "x = " << x << " y = " << y << " c = " << c;
+                }
+            }
+        }
+    }
+}
+
+///Copy between 2 tiled images whose tiles are not aligned (32x32 float tiles to 64x64 byte tiles),
+///directly and through a temporary packed image as copyPixels used to do for tiled images.
+TEST_F(BaseTest, TiledToTiledCopy)
+{
+    const RectI bounds(0, 0, 1000, 700);
+    ImagePtr srcImage = createTiledImage(bounds, eImageBitDepthFloat);
+    ImagePtr dstImage = createTiledImage(bounds, eImageBitDepthByte);
+
+    fillPattern(srcImage, bounds);
+
+    Image::CopyPixelsArgs copyArgs;
+    copyArgs.roi = bounds;
+
+    // Direct copy: each pixel is read once from the source tiles and written once to the destination tiles
+    dstImage->fill(bounds, 0., 0., 0., 0.);
+    dstImage->copyPixels(*srcImage, copyArgs);
+    checkBytePattern(dstImage, bounds);
+
+    // Copy through a temporary packed float image
+    dstImage->fill(bounds, 0., 0., 0., 0.);
+    {
+        Image::InitStorageArgs tmpArgs;
+        tmpArgs.bounds = bounds;
+        tmpArgs.layer = ImagePlaneDesc::getRGBAComponents();
+        ImagePtr tmpImage = Image::create(tmpArgs);
+        tmpImage->copyPixels(*srcImage, copyArgs);
+        dstImage->copyPixels(*tmpImage, copyArgs);
+    }
+    checkBytePattern(dstImage, bounds);
+}
+
+TEST(TileSizeClassTest, ClassForImage)
+{
+    for (int c = 0; c < NATRON_TILE_SIZE_CLASSES_COUNT; ++c) {
+        int tx, ty;
+        Cache::getTileSizePx(eImageBitDepthFloat, c, &tx, &ty);
+        EXPECT_EQ( Cache::getTileSizeBytes(c), tx * ty * sizeof(float) );
+        Cache::getTileSizePx(eImageBitDepthByte, c, &tx, &ty);
+        EXPECT_EQ( Cache::getTileSizeBytes(c), tx * ty * sizeof(unsigned char) );
+    }
+
+    // Point effects get the default class, kernels get larger tiles but the image must still span enough tiles
+    const RectI hd(0, 0, 1920, 1080);
+    EXPECT_EQ( 0, Cache::getTileSizeClassForImage(eImageBitDepthFloat, hd, 0) );
+    EXPECT_EQ( 4, Cache::getTileSizeClassForImage(eImageBitDepthFloat, hd, 20) );
+    EXPECT_EQ( 4, Cache::getTileSizeClassForImage(eImageBitDepthFloat, hd, 500) );
+    EXPECT_EQ( 0, Cache::getTileSizeClassForImage(eImageBitDepthFloat, RectI(0, 0, 100, 100), 20) );
+}
+
+///Time the render of a blur, a transform and a point effect with the tiles of each size class and with the class
+///chosen automatically: the automatic choice must be about as fast as the fastest class for each effect, and larger
+///tiles than the default must pay off for the blur, which reads far around each tile.
+static qint64
+timeTileSizeClassRender(const NodePtr& root,
+                        const RectD& roi)
+{
+    // Keep the fastest of a few renders to reduce the noise
+    qint64 bestMS = -1;
+    for (int i = 0; i < 3; ++i) {
+        TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
+        rargs->time = TimeValue(1);
+        rargs->view = ViewIdx(0);
+        rargs->treeRoot = root;
+        rargs->canonicalRoI = &roi;
+        rargs->proxyScale = RenderScale(1.);
+        rargs->mipMapLevel = 0;
+        rargs->layers = 0;
+        rargs->draftMode = false;
+        rargs->playback = false;
+        // Do not read the images rendered by the previous iteration from the cache
+        rargs->byPassCache = true;
+        rargs->streaming = false;
+        rargs->priorityPoint = 0;
+        rargs->lowPriority = false;
+        TreeRenderPtr render = TreeRender::create(rargs);
+        EXPECT_TRUE(render != 0);
+        if (!render) {
+            return -1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        std::map<ImagePlaneDesc, ImagePtr> planes;
+        EXPECT_EQ( eActionStatusOK, render->launchRender(&planes) );
+        qint64 elapsedMS = timer.elapsed();
+        EXPECT_FALSE( planes.empty() );
+        if ( (bestMS < 0) || (elapsedMS < bestMS) ) {
+            bestMS = elapsedMS;
+        }
+    }
+
+    return bestMS;
+}
+
+TEST_F(BaseTest, TileSizeClassBenchmark)
+{
+    KnobIntPtr tileSizeClassKnob = toKnobInt( appPTR->getCurrentSettings()->getKnobByName("tileSizeClass") );
+    ASSERT_TRUE(tileSizeClassKnob);
+
+    NodePtr generator = createNode(_generatorPluginID);
+    ASSERT_TRUE(generator);
+
+    enum EffectKindEnum
+    {
+        eEffectKindBlur = 0,
+        eEffectKindTransform,
+        eEffectKindPoint
+    };
+    const char* pluginIDs[] = { PLUGINID_OFX_BLURCIMG, PLUGINID_OFX_TRANSFORM, PLUGINID_OFX_INVERT };
+    const RectD roi(0, 0, 1920, 1080);
+
+    for (int e = 0; e < 3; ++e) {
+        // The plug-ins bundle may not be installed
+        if ( !appPTR->getPluginBinary(QString::fromUtf8(pluginIDs[e]), -1, -1) ) {
+            continue;
+        }
+        NodePtr effect = createNode( QString::fromUtf8(pluginIDs[e]) );
+        ASSERT_TRUE(effect);
+        connectNodes(generator, effect, 0, true);
+        if (e == eEffectKindBlur) {
+            KnobDoublePtr size = toKnobDouble( effect->getKnobByName("size") );
+            ASSERT_TRUE(size);
+            size->setValue(100., ViewSetSpec::all(), DimIdx(0));
+            size->setValue(100., ViewSetSpec::all(), DimIdx(1));
+        } else if (e == eEffectKindTransform) {
+            KnobDoublePtr rotate = toKnobDouble( effect->getKnobByName("rotate") );
+            ASSERT_TRUE(rotate);
+            rotate->setValue(30.);
+        }
+
+        std::vector<qint64> classMS(NATRON_TILE_SIZE_CLASSES_COUNT);
+        qint64 fastestMS = -1;
+        for (int c = 0; c < NATRON_TILE_SIZE_CLASSES_COUNT; ++c) {
+            tileSizeClassKnob->setValue(c);
+            classMS[c] = timeTileSizeClassRender(effect, roi);
+            if ( (fastestMS < 0) || (classMS[c] < fastestMS) ) {
+                fastestMS = classMS[c];
+            }
+        }
+        tileSizeClassKnob->setValue(-1);
+        qint64 automaticMS = timeTileSizeClassRender(effect, roi);
+
+        // Allow some slack for the timer resolution and the noise of the machine
+        EXPECT_LE( automaticMS, fastestMS + fastestMS / 2 + 10 );
+        if (e == eEffectKindBlur) {
+            EXPECT_LT( automaticMS, classMS[0] );
+        }
+
+        effect->destroyNode(true, false);
+    }
+
+    tileSizeClassKnob->setValue(-1);
+    appPTR->getAppTLS()->cleanupTLSForThread();
+    getApp()->getProject()->clearNodesBlocking();
+}
+
+TEST(HalfTest, Conversion)
+{
+    // Values exactly representable in half
+    const float exact[] = { 0.f, -0.f, 1.f, -2.f, 0.5f, 0.25f, 65504.f, 1024.f, 6.103515625e-05f /*smallest normal*/, 5.9604644775390625e-08f /*smallest denormal*/ };
+
+    for (std::size_t i = 0; i < sizeof(exact) / sizeof(exact[0]); ++i) {
+        EXPECT_EQ( exact[i], (float)Half(exact[i]) );
+    }
+
+    // Overflow goes to infinity, NaN stays NaN
+    EXPECT_EQ( 0x7c00, Half(1e6f).bits() );
+    EXPECT_EQ( 0xfc00, Half(-1e6f).bits() );
+    float nan = (float)Half( std::numeric_limits<float>::quiet_NaN() );
+    EXPECT_TRUE(nan != nan);
+
+    // Round to nearest even: 1 + 2^-11 is halfway between 1 and the next half, rounds to 1
+    EXPECT_EQ( 1.f, (float)Half(1.f + 1.f / 2048.f) );
+
+    // Every half value survives a round trip through float
+    for (unsigned int bits = 0; bits < 0x10000; ++bits) {
+        if ( (bits & 0x7c00) == 0x7c00 && (bits & 0x3ff) ) {
+            continue; // NaN
+        }
+        Half h = Half::fromBits( (U16)bits );
+        ASSERT_EQ( bits, (unsigned int)Half( (float)h ).bits() );
+    }
+
+    // The buffer conversions give the same result as the scalar ones, including the non vectorized tail
+    const std::size_t count = 37;
+    float src[count], back[count];
+    Half halves[count];
+    for (std::size_t i = 0; i < count; ++i) {
+        src[i] = i * 0.37f - 3.f;
+    }
+    Half::fromFloat(src, halves, count);
+    Half::toFloat(halves, back, count);
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ( Half(src[i]).bits(), halves[i].bits() );
+        EXPECT_EQ( (float)Half(src[i]), back[i] );
+    }
+}
+
+///The F16C and the software buffer conversions give the same results as the scalar conversions
+TEST_F(BaseTest, HalfBufferConversionPaths)
+{
+    const bool hardwareEnabled = Half::isHardwareConversionEnabled();
+    const std::size_t count = 0x10000;
+    std::vector<Half> halves(count), converted(count);
+    std::vector<float> floats(count), back(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        halves[i] = Half::fromBits( (U16)i );
+        // Cover normal values, denormals, overflows and the halfway cases
+        U32 bits = (U32)( (i * 2654435761u) ^ (i << 13) );
+        std::memcpy( &floats[i], &bits, sizeof(float) );
+        if (floats[i] != floats[i]) {
+            floats[i] = 0.f; // NaN payloads are not preserved the same way
+        }
+        if (i % 3 == 0) {
+            floats[i] *= 1e-30f;
+        }
+    }
+
+    for (int useHardware = 0; useHardware < 2; ++useHardware) {
+        bool enabled = Half::setHardwareConversionEnabled(useHardware == 1);
+        if (useHardware == 0) {
+            EXPECT_FALSE(enabled);
+        }
+
+        Half::toFloat(&halves[0], &back[0], count);
+        for (std::size_t i = 0; i < count; ++i) {
+            if ( (i & 0x7c00) == 0x7c00 && (i & 0x3ff) ) {
+                continue; // NaN
+            }
+            ASSERT_EQ( Half::bitsToFloat( (U16)i ), back[i] ) << "F16C: " << enabled;
+        }
+
+        Half::fromFloat(&floats[0], &converted[0], count);
+        for (std::size_t i = 0; i < count; ++i) {
+            ASSERT_EQ( Half::floatToBits(floats[i]), converted[i].bits() ) << "F16C: " << enabled;
+        }
+    }
+
+    Half::setHardwareConversionEnabled(hardwareEnabled);
+}
+
+///Copy a float image to a half tiled image, as done when caching float images as half, and back
+TEST_F(BaseTest, HalfTiledImage)
+{
+    const RectI bounds(0, 0, 300, 200);
+    const int nComps = 4;
+
+    Image::InitStorageArgs floatArgs;
+    floatArgs.bounds = bounds;
+    floatArgs.layer = ImagePlaneDesc::getRGBAComponents();
+    ImagePtr srcImage = Image::create(floatArgs);
+    srcImage->fill(bounds, 0.25, 0.5, 2., 1.);
+
+    ImagePtr halfImage = createTiledImage(bounds, eImageBitDepthHalf);
+    Image::CopyPixelsArgs copyArgs;
+    copyArgs.roi = bounds;
+    halfImage->copyPixels(*srcImage, copyArgs);
+
+    ImagePtr dstImage = Image::create(floatArgs);
+    dstImage->fill(bounds, 0., 0., 0., 0.);
+    dstImage->copyPixels(*halfImage, copyArgs);
+
+    Image::Tile tile;
+    ASSERT_TRUE( dstImage->getTileAt(0, &tile) );
+    Image::CPUTileData tileData;
+    dstImage->getCPUTileData(tile, &tileData);
+    const float expected[4] = {0.25f, 0.5f, 2.f, 1.f};
+    const float* pix = (const float*)Image::pixelAtStatic(bounds.x2 - 1, bounds.y2 - 1, tileData.tileBounds, nComps, sizeof(float), (float*)tileData.ptrs[0]);
+    ASSERT_TRUE(pix != 0);
+    for (int c = 0; c < nComps; ++c) {
+        EXPECT_EQ(expected[c], pix[c]);
+    }
+}
@@ -24,8 +24,17 @@
 
 #include "Global/Macros.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
 #include <gtest/gtest.h>
+
+#include <QtCore/QElapsedTimer>
+
 #include "Engine/Lut.h"
 
 NATRON_NAMESPACE_USING
@@ -51,3 +60,103 @@ TEST(Lut, IntConversions) {
         EXPECT_EQ( i, uint8xxToChar( charToUint8xx(i) ) );
     }
 }
+
+static const Lut*
+getBuiltinLut(int i)
+{
+    switch (i) {
+    case 0:
+        return LutManager::sRGBLut();
+    case 1:
+        return LutManager::Rec709Lut();
+    case 2:
+        return LutManager::CineonLut();
+    case 3:
+        return LutManager::Gamma1_8Lut();
+    case 4:
+        return LutManager::Gamma2_2Lut();
+    case 5:
+        return LutManager::PanalogLut();
+    case 6:
+        return LutManager::ViperLogLut();
+    case 7:
+        return LutManager::REDLogLut();
+    case 8:
+        return LutManager::AlexaV3LogCLut();
+    case 9:
+        return LutManager::SLog1Lut();
+    case 10:
+        return LutManager::SLog2Lut();
+    default:
+        return 0;
+    }
+}
+
+// Error relative to the magnitude of the exact value, absolute under 1
+static double
+lutError(float approx,
+         float exact)
+{
+    return std::fabs( (double)approx - exact ) / std::max( 1., std::fabs( (double)exact ) );
+}
+
+TEST(Lut, FloatTablesAccuracy) {
+    const int nSamples = 1000000;
+
+    for (int l = 0; getBuiltinLut(l); ++l) {
+        const Lut* lut = getBuiltinLut(l);
+        lut->validate();
+
+        double maxFromError = 0., maxToError = 0.;
+        for (int i = 0; i <= nSamples; ++i) {
+            // Color-space values, including some super-whites and negative values
+            float v = -0.1f + 1.3f * i / nSamples;
+            maxFromError = std::max( maxFromError, lutError( lut->fromColorSpaceFloatToLinearFloatFast(v), lut->fromColorSpaceFloatToLinearFloat(v) ) );
+
+            // Linear values from 1e-4 to 1e4, log distributed
+            float lin = std::pow(10.f, -4.f + 8.f * i / nSamples);
+            maxToError = std::max( maxToError, lutError( lut->toColorSpaceFloatFromLinearFloatFast(lin), lut->toColorSpaceFloatFromLinearFloat(lin) ) );
+        }
+        EXPECT_LT(maxFromError, 1e-5) << lut->getName();
+        EXPECT_LT(maxToError, 1e-5) << lut->getName();
+
+        // Out of the tables range
+        EXPECT_EQ( lut->fromColorSpaceFloatToLinearFloat(4.f), lut->fromColorSpaceFloatToLinearFloatFast(4.f) ) << lut->getName();
+        float nan = std::numeric_limits<float>::quiet_NaN();
+        EXPECT_TRUE( lut->toColorSpaceFloatFromLinearFloatFast(nan) != lut->toColorSpaceFloatFromLinearFloatFast(nan) ) << lut->getName();
+    }
+}
+
+TEST(Lut, FloatRowConversions) {
+    const Lut* lut = LutManager::sRGBLut();
+    const int width = 1 << 20;
+    std::vector<float> src(width * 4), dst(width * 4);
+
+    for (int i = 0; i < width * 4; ++i) {
+        src[i] = (float)(i % 4096) / 4095;
+    }
+
+    // Converting the red channel of a packed RGBA row into a planar row
+    lut->from_float_planar(&dst[0], &src[0], width, NULL, 4, 1);
+    for (int x = 0; x < width; ++x) {
+        EXPECT_EQ( lut->fromColorSpaceFloatToLinearFloatFast(src[x * 4]), dst[x] );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int x = 0; x < width * 4; ++x) {
+        dst[x] = lut->fromColorSpaceFloatToLinearFloat(src[x]);
+    }
+    qint64 exactMS = timer.elapsed();
+
+    timer.restart();
+    lut->from_float_planar(&dst[0], &src[0], width * 4);
+    qint64 tableMS = timer.elapsed();
+
+    timer.restart();
+    lut->to_float_planar(&src[0], &dst[0], width * 4);
+    qint64 tableToMS = timer.elapsed();
+
+    std::cout << "sRGB to linear of " << width * 4 << " floats: " << exactMS << " ms with the transfer function, "
+              << tableMS << " ms with the tables (" << tableToMS << " ms back to sRGB)" << std::endl;
+}
@@ -49,12 +49,14 @@ SOURCES += \
     google-test/src/gtest_main.cc \
     google-mock/src/gmock-all.cc \
     BaseTest.cpp \
+    CacheReuseStats_Test.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
     Lut_Test.cpp \
     KnobFile_Test.cpp \
     Curve_Test.cpp \
     Tracker_Test.cpp \
+    ViewerTextureUpload_Test.cpp \
     wmain.cpp
 
 HEADERS += \
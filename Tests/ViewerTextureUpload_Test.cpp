@@ -0,0 +1,117 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <gtest/gtest.h>
+
+#include "BaseTest.h"
+
+#include "Engine/Image.h"
+#include "Engine/ImagePlaneDesc.h"
+
+#include "Gui/ViewerTextureUpload.h"
+
+NATRON_NAMESPACE_USING
+
+TEST(ViewerPboRing, RotationAndGrowOnlySizes)
+{
+    ViewerPboRing ring(3);
+    ASSERT_EQ(3, ring.getRingSize());
+
+    // Each upload uses the next slot of the ring, then wraps around
+    const std::size_t uploads[] = { 1000, 500, 2000, 100, 3000, 1000 };
+    const int expectedSlots[] = { 0, 1, 2, 0, 1, 2 };
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ( expectedSlots[i], ring.getCurrentSlot() );
+        std::size_t size = ring.reserve(uploads[i]);
+        EXPECT_GE(size, uploads[i]);
+        ring.rotate();
+    }
+    EXPECT_EQ( 0, ring.getCurrentSlot() );
+
+    // A slot keeps the size of its largest upload: smaller uploads re-use the data store
+    EXPECT_EQ( (std::size_t)1000, ring.getSlotSize(0) );
+    EXPECT_EQ( (std::size_t)3000, ring.getSlotSize(1) );
+    EXPECT_EQ( (std::size_t)2000, ring.getSlotSize(2) );
+    EXPECT_EQ( (std::size_t)1000, ring.reserve(10) );
+}
+
+static ImagePtr
+createViewerImage(const RectI& bounds,
+                  float value)
+{
+    Image::InitStorageArgs args;
+    args.bounds = bounds;
+    args.layer = ImagePlaneDesc::getRGBAComponents();
+    args.mipMapLevel = 1;
+    ImagePtr ret = Image::create(args);
+    if (ret) {
+        ret->fill(bounds, value, value, value, value);
+    }
+
+    return ret;
+}
+
+static float
+getViewerImagePixel(const ImagePtr& image,
+                    int x,
+                    int y)
+{
+    Image::Tile tile;
+    image->getTileAt(0, &tile);
+    Image::CPUTileData data;
+    image->getCPUTileData(tile, &data);
+    const float* pix = (const float*)Image::pixelAtStatic(x, y, data.tileBounds, data.nComps, sizeof(float), (unsigned char*)data.ptrs[0]);
+
+    return pix ? *pix : -1.f;
+}
+
+///A partial rectangle uploaded to a sub-rectangle of the viewer texture must also update the image read by the
+///color picker, without modifying the image the viewer was given since it may be shared
+TEST_F(BaseTest, ViewerImageSubRectUpdate)
+{
+    const RectI bounds(0, 0, 256, 256);
+    ImagePtr displayed = createViewerImage(bounds, 0.25f);
+    ASSERT_TRUE(displayed);
+
+    bool isPrivateCopy = false;
+    ImagePtr partial = createViewerImage( RectI(16, 16, 48, 48), 1.f );
+    ImagePtr updated = updateViewerImageSubRect(displayed, &isPrivateCopy, partial);
+    ASSERT_TRUE(updated);
+    EXPECT_TRUE(isPrivateCopy);
+    EXPECT_NE( displayed.get(), updated.get() );
+    EXPECT_EQ( bounds, updated->getBounds() );
+    EXPECT_EQ( 1u, updated->getMipMapLevel() );
+    EXPECT_EQ( 1.f, getViewerImagePixel(updated, 20, 20) );
+    EXPECT_EQ( 0.25f, getViewerImagePixel(updated, 100, 100) );
+    EXPECT_EQ( 0.25f, getViewerImagePixel(displayed, 20, 20) );
+
+    // Once copied, the next partial rectangles are written to the same copy, even partly outside of the image
+    ImagePtr partial2 = createViewerImage( RectI(240, 240, 300, 300), 0.5f );
+    ImagePtr updated2 = updateViewerImageSubRect(updated, &isPrivateCopy, partial2);
+    EXPECT_EQ( updated.get(), updated2.get() );
+    EXPECT_EQ( 0.5f, getViewerImagePixel(updated2, 250, 250) );
+    EXPECT_EQ( 1.f, getViewerImagePixel(updated2, 20, 20) );
+}